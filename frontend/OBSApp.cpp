@@ -996,7 +996,13 @@ static bool StartupOBS(const char *locale, profiler_name_store_t *store)
 	if (GetAppConfigPath(path, sizeof(path), "obs-studio/plugin_config") <= 0)
 		return false;
 
-	return obs_startup(locale, path, store);
+	if (!obs_startup(locale, path, store))
+		return false;
+
+	if (GetAppConfigPath(path, sizeof(path), "obs-studio/effect-cache") > 0)
+		obs_set_effect_cache_path(path);
+
+	return true;
 }
 
 inline void OBSApp::ResetHotkeyState(bool inFocus)
@@ -0,0 +1,65 @@
+#include "SceneCollectionWriter.hpp"
+
+#include <util/base.h>
+#include <util/platform.h>
+
+SceneCollectionWriter::SceneCollectionWriter() : thread(&SceneCollectionWriter::Run, this) {}
+
+SceneCollectionWriter::~SceneCollectionWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	jobsChanged.notify_all();
+	thread.join();
+}
+
+void SceneCollectionWriter::Queue(const std::string &path, std::string json)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (!jobs.empty() && jobs.back().path == path) {
+			jobs.back().json = std::move(json);
+		} else {
+			jobs.push_back({path, std::move(json)});
+		}
+	}
+
+	jobsChanged.notify_all();
+}
+
+void SceneCollectionWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	jobsChanged.wait(lock, [this] { return jobs.empty() && !writing; });
+}
+
+void SceneCollectionWriter::Run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;) {
+		jobsChanged.wait(lock, [this] { return stopping || !jobs.empty(); });
+		if (jobs.empty())
+			break;
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		writing = true;
+		lock.unlock();
+
+		/* Written to a temporary file first and then swapped in, so a crash
+		 * while saving never leaves a partial collection behind. */
+		bool success = os_quick_write_utf8_file_safe(job.path.c_str(), job.json.c_str(), job.json.size(),
+							     false, "tmp", "bak");
+		if (!success)
+			blog(LOG_ERROR, "Could not save scene data to %s", job.path.c_str());
+
+		lock.lock();
+		writing = false;
+		jobsChanged.notify_all();
+	}
+}
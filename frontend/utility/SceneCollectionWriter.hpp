@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/* Writes scene collection files on a background thread. Queued writes to the
+ * same file replace each other if they have not started yet, so a burst of
+ * saves results in a single write of the newest data. */
+class SceneCollectionWriter {
+	struct Job {
+		std::string path;
+		std::string json;
+	};
+
+	std::mutex mutex;
+	std::condition_variable jobsChanged;
+	std::deque<Job> jobs;
+	bool writing = false;
+	bool stopping = false;
+	std::thread thread;
+
+	void Run();
+
+public:
+	SceneCollectionWriter();
+	~SceneCollectionWriter();
+
+	void Queue(const std::string &path, std::string json);
+
+	/* Waits until all queued data is written to disk */
+	void Flush();
+};
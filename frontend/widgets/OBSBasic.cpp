@@ -392,6 +392,12 @@ OBSBasic::OBSBasic(QWidget *parent) : OBSMainWindow(parent), undo_s(ui), ui(new
 	diskFullTimer = new QTimer(this);
 	connect(diskFullTimer, &QTimer::timeout, this, &OBSBasic::CheckDiskSpaceRemaining);
 
+	/* Coalesces bursts of changes into a single save */
+	saveTimer = new QTimer(this);
+	saveTimer->setSingleShot(true);
+	saveTimer->setInterval(500);
+	connect(saveTimer, &QTimer::timeout, this, &OBSBasic::SaveProjectDeferred);
+
 	renameScene = new QAction(QTStr("Rename"), ui->scenesDock);
 	renameScene->setShortcutContext(Qt::WidgetWithChildrenShortcut);
 	connect(renameScene, &QAction::triggered, this, &OBSBasic::EditSceneName);
@@ -24,6 +24,7 @@
 #include <oauth/Auth.hpp>
 #include <utility/BasicOutputHandler.hpp>
 #include <utility/OBSCanvas.hpp>
+#include <utility/SceneCollectionWriter.hpp>
 #include <utility/VCamConfig.hpp>
 #include <utility/platform.hpp>
 #include <utility/undo_stack.hpp>
@@ -1045,6 +1046,9 @@ private:
 	bool projectChanged = false;
 	bool clearingFailed = false;
 
+	QPointer<QTimer> saveTimer;
+	SceneCollectionWriter collectionWriter;
+
 	QPointer<OBSMissingFiles> missDialog;
 
 	OBSSceneCollectionCache collections;
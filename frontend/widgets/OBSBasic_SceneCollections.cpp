@@ -952,10 +952,14 @@ void OBSBasic::Save(SceneCollection &collection)
 		obs_data_set_obj(saveData, DataKeys::MigrationResolution.data(), resolutionData);
 	}
 
+	/* Only the file is written on the background thread, the json has to
+	 * be generated here as the save data references live source settings. */
 	const std::string collectionFileName = collection.getFilePathString();
-	bool success = obs_data_save_json_pretty_safe(saveData, collectionFileName.c_str(), "tmp", "bak");
+	const char *json = obs_data_get_json_pretty(saveData);
 
-	if (!success) {
+	if (json && *json) {
+		collectionWriter.Queue(collectionFileName, json);
+	} else {
 		blog(LOG_ERROR, "Could not save scene data to %s", collectionFileName.c_str());
 	}
 }
@@ -1293,7 +1297,7 @@ void OBSBasic::LoadData(obs_data_t *data, SceneCollection &collection)
 	updateRemigrationMenuItem(collection.getCoordinateMode(), ui->actionRemigrateSceneCollection);
 
 	obs_missing_files_t *files = obs_missing_files_create();
-	obs_load_sources(sources, AddMissingFiles, files);
+	obs_load_sources_parallel(sources, AddMissingFiles, files);
 
 	if (resetVideo)
 		ResetVideo();
@@ -1459,6 +1463,7 @@ void OBSBasic::SaveProjectNow()
 
 	projectChanged = true;
 	SaveProjectDeferred();
+	collectionWriter.Flush();
 }
 
 void OBSBasic::SaveProject()
@@ -1467,7 +1472,15 @@ void OBSBasic::SaveProject()
 		return;
 
 	projectChanged = true;
-	QMetaObject::invokeMethod(this, "SaveProjectDeferred", Qt::QueuedConnection);
+
+	/* Can be called from any thread through the frontend API */
+	QMetaObject::invokeMethod(
+		saveTimer,
+		[this]() {
+			if (!saveTimer->isActive())
+				saveTimer->start();
+		},
+		Qt::QueuedConnection);
 }
 
 void OBSBasic::SaveProjectDeferred()
@@ -1479,6 +1492,7 @@ void OBSBasic::SaveProjectDeferred()
 		return;
 
 	projectChanged = false;
+	saveTimer->stop();
 
 	try {
 		OBS::SceneCollection &currentCollection = GetCurrentSceneCollection();
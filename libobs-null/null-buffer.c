@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "null-subsystem.h"
+
+gs_vertbuffer_t *device_vertexbuffer_create(gs_device_t *device, struct gs_vb_data *data, uint32_t flags)
+{
+	struct gs_vertex_buffer *vb;
+
+	if (!data) {
+		blog(LOG_ERROR, "device_vertexbuffer_create (null): No data");
+		return NULL;
+	}
+
+	vb = bzalloc(sizeof(struct gs_vertex_buffer));
+	vb->device = device;
+	vb->data = data;
+	vb->num = data->num;
+	vb->dynamic = (flags & GS_DYNAMIC) != 0;
+
+	device->stats.live[NULL_RESOURCE_VERTEXBUFFER]++;
+	return vb;
+}
+
+void gs_vertexbuffer_destroy(gs_vertbuffer_t *vb)
+{
+	if (!vb)
+		return;
+
+	if (vb->device->cur_vertex_buffer == vb)
+		vb->device->cur_vertex_buffer = NULL;
+
+	vb->device->stats.live[NULL_RESOURCE_VERTEXBUFFER]--;
+	gs_vbdata_destroy(vb->data);
+	bfree(vb);
+}
+
+#define COPY_VAL(val)                                                                   \
+	do {                                                                            \
+		if (vb->data->val && data->val)                                         \
+			memcpy(vb->data->val, data->val, sizeof(*data->val) * vb->num); \
+	} while (false)
+
+void gs_vertexbuffer_flush_direct(gs_vertbuffer_t *vb, const struct gs_vb_data *data)
+{
+	if (!vb->dynamic) {
+		blog(LOG_ERROR, "gs_vertexbuffer_flush (null): Vertex buffer is not dynamic");
+		return;
+	}
+
+	/* the rasterizer reads the data of the buffer itself */
+	if (data == vb->data)
+		return;
+
+	COPY_VAL(points);
+	COPY_VAL(normals);
+	COPY_VAL(tangents);
+	COPY_VAL(colors);
+
+	for (size_t i = 0; i < vb->data->num_tex && i < data->num_tex; i++) {
+		struct gs_tvertarray *dst = vb->data->tvarray + i;
+		const struct gs_tvertarray *src = data->tvarray + i;
+
+		if (dst->width == src->width)
+			memcpy(dst->array, src->array, sizeof(float) * src->width * vb->num);
+	}
+}
+
+#undef COPY_VAL
+
+void gs_vertexbuffer_flush(gs_vertbuffer_t *vb)
+{
+	gs_vertexbuffer_flush_direct(vb, vb->data);
+}
+
+struct gs_vb_data *gs_vertexbuffer_get_data(const gs_vertbuffer_t *vb)
+{
+	return vb->data;
+}
+
+void device_load_vertexbuffer(gs_device_t *device, gs_vertbuffer_t *vb)
+{
+	device->cur_vertex_buffer = vb;
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_indexbuffer_t *device_indexbuffer_create(gs_device_t *device, enum gs_index_type type, void *indices, size_t num,
+					    uint32_t flags)
+{
+	struct gs_index_buffer *ib = bzalloc(sizeof(struct gs_index_buffer));
+
+	ib->device = device;
+	ib->type = type;
+	ib->data = indices;
+	ib->num = num;
+	ib->width = type == GS_UNSIGNED_LONG ? 4 : 2;
+	ib->dynamic = (flags & GS_DYNAMIC) != 0;
+
+	device->stats.live[NULL_RESOURCE_INDEXBUFFER]++;
+	return ib;
+}
+
+void gs_indexbuffer_destroy(gs_indexbuffer_t *ib)
+{
+	if (!ib)
+		return;
+
+	if (ib->device->cur_index_buffer == ib)
+		ib->device->cur_index_buffer = NULL;
+
+	ib->device->stats.live[NULL_RESOURCE_INDEXBUFFER]--;
+	bfree(ib->data);
+	bfree(ib);
+}
+
+void gs_indexbuffer_flush_direct(gs_indexbuffer_t *ib, const void *data)
+{
+	if (!ib->dynamic) {
+		blog(LOG_ERROR, "gs_indexbuffer_flush (null): Index buffer is not dynamic");
+		return;
+	}
+
+	if (data != ib->data)
+		memcpy(ib->data, data, ib->num * ib->width);
+}
+
+void gs_indexbuffer_flush(gs_indexbuffer_t *ib)
+{
+	gs_indexbuffer_flush_direct(ib, ib->data);
+}
+
+void *gs_indexbuffer_get_data(const gs_indexbuffer_t *ib)
+{
+	return ib->data;
+}
+
+size_t gs_indexbuffer_get_num_indices(const gs_indexbuffer_t *ib)
+{
+	return ib->num;
+}
+
+enum gs_index_type gs_indexbuffer_get_type(const gs_indexbuffer_t *ib)
+{
+	return ib->type;
+}
+
+void device_load_indexbuffer(gs_device_t *device, gs_indexbuffer_t *ib)
+{
+	device->cur_index_buffer = ib;
+}
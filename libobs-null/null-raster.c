@@ -0,0 +1,394 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <math.h>
+
+#include "null-subsystem.h"
+
+/*
+ * CPU rasterizer
+ *
+ *   Shaders can't be run, so every pixel shader is treated as sampling its
+ * first texture parameter with the first texture coordinate, multiplied by a
+ * "color" parameter if there is one.  That covers the default, solid and
+ * opaque effects used to draw sprites, which is what benchmarks and tests need
+ * to check scene composition.
+ */
+
+struct raster_vertex {
+	float x, y;
+	float u, v;
+};
+
+struct raster_state {
+	gs_texture_t *target;
+	uint8_t *target_data;
+	uint32_t target_pixel_size;
+
+	gs_texture_t *texture;
+	const uint8_t *texture_data;
+	uint32_t texture_pixel_size;
+	enum gs_address_mode address_u;
+	enum gs_address_mode address_v;
+
+	struct vec4 color;
+	const struct null_blend_state *blend;
+
+	int min_x, min_y;
+	int max_x, max_y;
+
+	uint64_t pixels;
+};
+
+static inline float blend_factor(enum gs_blend_type type, const float *src, const float *dst, int channel)
+{
+	switch (type) {
+	case GS_BLEND_ZERO:
+		return 0.0f;
+	case GS_BLEND_ONE:
+		return 1.0f;
+	case GS_BLEND_SRCCOLOR:
+		return src[channel];
+	case GS_BLEND_INVSRCCOLOR:
+		return 1.0f - src[channel];
+	case GS_BLEND_SRCALPHA:
+		return src[3];
+	case GS_BLEND_INVSRCALPHA:
+		return 1.0f - src[3];
+	case GS_BLEND_DSTCOLOR:
+		return dst[channel];
+	case GS_BLEND_INVDSTCOLOR:
+		return 1.0f - dst[channel];
+	case GS_BLEND_DSTALPHA:
+		return dst[3];
+	case GS_BLEND_INVDSTALPHA:
+		return 1.0f - dst[3];
+	case GS_BLEND_SRCALPHASAT:
+		return channel == 3 ? 1.0f : fminf(src[3], 1.0f - dst[3]);
+	}
+
+	return 1.0f;
+}
+
+static inline float blend_op(enum gs_blend_op_type op, float src, float dst)
+{
+	switch (op) {
+	case GS_BLEND_OP_ADD:
+		return src + dst;
+	case GS_BLEND_OP_SUBTRACT:
+		return src - dst;
+	case GS_BLEND_OP_REVERSE_SUBTRACT:
+		return dst - src;
+	case GS_BLEND_OP_MIN:
+		return fminf(src, dst);
+	case GS_BLEND_OP_MAX:
+		return fmaxf(src, dst);
+	}
+
+	return src + dst;
+}
+
+static void blend_pixel(const struct null_blend_state *blend, const struct vec4 *src_color, struct vec4 *dst_color)
+{
+	const float *src = src_color->ptr;
+	float *dst = dst_color->ptr;
+	float result[4];
+
+	for (int i = 0; i < 4; i++) {
+		bool alpha = i == 3;
+		enum gs_blend_type src_type = alpha ? blend->src_a : blend->src_c;
+		enum gs_blend_type dst_type = alpha ? blend->dest_a : blend->dest_c;
+		float src_factor = blend_factor(src_type, src, dst, i);
+		float dst_factor = blend_factor(dst_type, src, dst, i);
+
+		if (blend->op == GS_BLEND_OP_MIN || blend->op == GS_BLEND_OP_MAX)
+			result[i] = blend_op(blend->op, src[i], dst[i]);
+		else
+			result[i] = blend_op(blend->op, src[i] * src_factor, dst[i] * dst_factor);
+	}
+
+	for (int i = 0; i < 4; i++) {
+		if (blend->write[i])
+			dst[i] = result[i];
+	}
+}
+
+static inline void write_pixel(const struct null_blend_state *blend, const struct vec4 *src, struct vec4 *dst)
+{
+	for (int i = 0; i < 4; i++) {
+		if (blend->write[i])
+			dst->ptr[i] = src->ptr[i];
+	}
+}
+
+static inline int wrap_coord(int coord, int size, enum gs_address_mode mode)
+{
+	if (mode == GS_ADDRESS_WRAP) {
+		coord %= size;
+		return coord < 0 ? coord + size : coord;
+	}
+
+	return coord < 0 ? 0 : (coord >= size ? size - 1 : coord);
+}
+
+static void sample(const struct raster_state *state, float u, float v, struct vec4 *color)
+{
+	const gs_texture_t *tex = state->texture;
+	int x, y;
+
+	if (!tex) {
+		*color = state->color;
+		return;
+	}
+
+	x = wrap_coord((int)floorf(u * (float)tex->width), (int)tex->width, state->address_u);
+	y = wrap_coord((int)floorf(v * (float)tex->height), (int)tex->height, state->address_v);
+
+	null_read_pixel(tex->format, state->texture_data + y * tex->linesize + x * state->texture_pixel_size, color);
+	vec4_mul(color, color, &state->color);
+}
+
+static inline float edge(const struct raster_vertex *a, const struct raster_vertex *b, float x, float y)
+{
+	return (b->x - a->x) * (y - a->y) - (b->y - a->y) * (x - a->x);
+}
+
+/* Pixels exactly on an edge shared by two triangles are only drawn by one of
+ * them, so sprites made of two triangles don't blend the diagonal twice */
+static inline bool edge_owns_pixels(const struct raster_vertex *a, const struct raster_vertex *b)
+{
+	float dx = b->x - a->x;
+	float dy = b->y - a->y;
+	return dy > 0.0f || (dy == 0.0f && dx < 0.0f);
+}
+
+static inline bool inside(float w, bool owns_edge)
+{
+	return w > 0.0f || (w == 0.0f && owns_edge);
+}
+
+static void raster_triangle(struct raster_state *state, const struct raster_vertex *v0,
+			    const struct raster_vertex *v1, const struct raster_vertex *v2)
+{
+	float area = edge(v0, v1, v2->x, v2->y);
+	if (area == 0.0f)
+		return;
+
+	/* culling is not supported, both windings are drawn */
+	if (area < 0.0f) {
+		const struct raster_vertex *temp = v1;
+		v1 = v2;
+		v2 = temp;
+		area = -area;
+	}
+
+	int min_x = (int)floorf(fminf(v0->x, fminf(v1->x, v2->x)));
+	int min_y = (int)floorf(fminf(v0->y, fminf(v1->y, v2->y)));
+	int max_x = (int)ceilf(fmaxf(v0->x, fmaxf(v1->x, v2->x)));
+	int max_y = (int)ceilf(fmaxf(v0->y, fmaxf(v1->y, v2->y)));
+
+	if (min_x < state->min_x)
+		min_x = state->min_x;
+	if (min_y < state->min_y)
+		min_y = state->min_y;
+	if (max_x > state->max_x)
+		max_x = state->max_x;
+	if (max_y > state->max_y)
+		max_y = state->max_y;
+
+	bool owns0 = edge_owns_pixels(v1, v2);
+	bool owns1 = edge_owns_pixels(v2, v0);
+	bool owns2 = edge_owns_pixels(v0, v1);
+
+	for (int y = min_y; y < max_y; y++) {
+		uint8_t *row = state->target_data + (size_t)y * state->target->linesize;
+		float py = (float)y + 0.5f;
+
+		for (int x = min_x; x < max_x; x++) {
+			float px = (float)x + 0.5f;
+			float w0 = edge(v1, v2, px, py);
+			float w1 = edge(v2, v0, px, py);
+			float w2 = edge(v0, v1, px, py);
+
+			if (!inside(w0, owns0) || !inside(w1, owns1) || !inside(w2, owns2))
+				continue;
+
+			w0 /= area;
+			w1 /= area;
+			w2 /= area;
+
+			float u = v0->u * w0 + v1->u * w1 + v2->u * w2;
+			float v = v0->v * w0 + v1->v * w1 + v2->v * w2;
+			uint8_t *pixel = row + x * state->target_pixel_size;
+			struct vec4 src, dst;
+
+			sample(state, u, v, &src);
+
+			null_read_pixel(state->target->format, pixel, &dst);
+			if (state->blend->enabled)
+				blend_pixel(state->blend, &src, &dst);
+			else
+				write_pixel(state->blend, &src, &dst);
+
+			null_write_pixel(state->target->format, &dst, pixel);
+			state->pixels++;
+		}
+	}
+}
+
+static bool get_pixel_shader_inputs(gs_device_t *device, struct raster_state *state)
+{
+	gs_shader_t *ps = device->cur_pixel_shader;
+	bool has_texture_param = false;
+
+	vec4_set(&state->color, 1.0f, 1.0f, 1.0f, 1.0f);
+
+	for (size_t i = 0; i < ps->params.num; i++) {
+		struct gs_shader_param *param = ps->params.array + i;
+
+		if (param->type == GS_SHADER_PARAM_TEXTURE && !has_texture_param) {
+			has_texture_param = true;
+			state->texture = param->texture;
+
+		} else if (param->type == GS_SHADER_PARAM_VEC4 && strcmp(param->name, "color") == 0 &&
+			   param->cur_value.num == sizeof(struct vec4)) {
+			memcpy(state->color.ptr, param->cur_value.array, sizeof(struct vec4));
+		}
+	}
+
+	/* nothing to sample from */
+	if (has_texture_param && !state->texture)
+		return false;
+
+	if (state->texture) {
+		gs_samplerstate_t *sampler = device->cur_samplers[0];
+
+		if (state->texture->type != GS_TEXTURE_2D || gs_is_compressed_format(state->texture->format))
+			return false;
+
+		state->texture_data = null_texture_get_data(state->texture);
+		state->texture_pixel_size = gs_get_format_bpp(state->texture->format) / 8;
+		state->address_u = sampler ? sampler->info.address_u : GS_ADDRESS_CLAMP;
+		state->address_v = sampler ? sampler->info.address_v : GS_ADDRESS_CLAMP;
+	}
+
+	return true;
+}
+
+static bool get_target(gs_device_t *device, struct raster_state *state)
+{
+	gs_texture_t *target = null_get_render_target(device);
+	const struct gs_rect *vp = &device->cur_viewport;
+
+	if (!target || target->type != GS_TEXTURE_2D || gs_is_compressed_format(target->format))
+		return false;
+
+	state->target = target;
+	state->target_data = null_texture_get_data(target);
+	state->target_pixel_size = gs_get_format_bpp(target->format) / 8;
+	state->blend = &device->blend;
+
+	state->min_x = vp->x > 0 ? vp->x : 0;
+	state->min_y = vp->y > 0 ? vp->y : 0;
+	state->max_x = vp->x + vp->cx < (int)target->width ? vp->x + vp->cx : (int)target->width;
+	state->max_y = vp->y + vp->cy < (int)target->height ? vp->y + vp->cy : (int)target->height;
+
+	if (device->scissor_enabled) {
+		const struct gs_rect *rect = &device->cur_scissor;
+
+		if (state->min_x < rect->x)
+			state->min_x = rect->x;
+		if (state->min_y < rect->y)
+			state->min_y = rect->y;
+		if (state->max_x > rect->x + rect->cx)
+			state->max_x = rect->x + rect->cx;
+		if (state->max_y > rect->y + rect->cy)
+			state->max_y = rect->y + rect->cy;
+	}
+
+	return state->min_x < state->max_x && state->min_y < state->max_y;
+}
+
+static void transform_vertex(gs_device_t *device, const struct gs_vb_data *data, size_t idx,
+			     struct raster_vertex *out)
+{
+	const struct gs_rect *vp = &device->cur_viewport;
+	struct vec4 pos;
+
+	vec4_set(&pos, data->points[idx].x, data->points[idx].y, data->points[idx].z, 1.0f);
+	vec4_transform(&pos, &pos, &device->cur_viewproj);
+
+	if (pos.w != 0.0f && pos.w != 1.0f) {
+		pos.x /= pos.w;
+		pos.y /= pos.w;
+	}
+
+	out->x = (float)vp->x + (pos.x + 1.0f) * 0.5f * (float)vp->cx;
+	out->y = (float)vp->y + (1.0f - pos.y) * 0.5f * (float)vp->cy;
+
+	if (data->num_tex && data->tvarray[0].width >= 2) {
+		const float *uv = (const float *)data->tvarray[0].array + idx * data->tvarray[0].width;
+		out->u = uv[0];
+		out->v = uv[1];
+	} else {
+		out->u = 0.0f;
+		out->v = 0.0f;
+	}
+}
+
+static inline size_t get_index(gs_device_t *device, uint32_t i)
+{
+	const gs_indexbuffer_t *ib = device->cur_index_buffer;
+
+	if (!ib)
+		return i;
+	if (ib->type == GS_UNSIGNED_LONG)
+		return ((const uint32_t *)ib->data)[i];
+	return ((const uint16_t *)ib->data)[i];
+}
+
+void null_rasterize(gs_device_t *device, enum gs_draw_mode draw_mode, uint32_t start_vert, uint32_t num_verts)
+{
+	const gs_vertbuffer_t *vb = device->cur_vertex_buffer;
+	struct raster_state state = {0};
+	struct raster_vertex tri[3];
+	size_t max_idx;
+
+	/* points and lines are not rasterized */
+	if (draw_mode != GS_TRIS && draw_mode != GS_TRISTRIP)
+		return;
+	if (!vb || !vb->data || !vb->data->points)
+		return;
+	if (!get_target(device, &state) || !get_pixel_shader_inputs(device, &state))
+		return;
+
+	max_idx = device->cur_index_buffer ? device->cur_index_buffer->num : vb->num;
+	if (!num_verts)
+		num_verts = (uint32_t)max_idx;
+	if (start_vert >= max_idx)
+		return;
+	if (num_verts > max_idx - start_vert)
+		num_verts = (uint32_t)(max_idx - start_vert);
+
+	for (uint32_t i = 0; i + 2 < num_verts; i += draw_mode == GS_TRIS ? 3 : 1) {
+		bool valid = true;
+
+		for (uint32_t j = 0; j < 3; j++) {
+			size_t idx = get_index(device, start_vert + i + j);
+
+			if (idx >= vb->num) {
+				valid = false;
+				break;
+			}
+
+			transform_vertex(device, vb->data, idx, &tri[j]);
+		}
+
+		if (valid)
+			raster_triangle(&state, &tri[0], &tri[1], &tri[2]);
+	}
+
+	if (state.pixels)
+		device->stats.rasterized_draws++;
+}
@@ -0,0 +1,939 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <util/platform.h>
+#include "null-subsystem.h"
+
+/* Goofy Windows.h macros need to be removed */
+#ifdef near
+#undef near
+#endif
+#ifdef far
+#undef far
+#endif
+
+static const char *resource_names[NULL_RESOURCE_COUNT] = {
+	"textures",       "stage surfaces", "zstencil buffers", "sampler states", "shaders",
+	"vertex buffers", "index buffers",  "timers",           "timer ranges",   "swap chains",
+};
+
+const char *device_get_name(void)
+{
+	return "Null";
+}
+
+int device_get_type(void)
+{
+	return GS_DEVICE_NULL;
+}
+
+const char *device_preprocessor_name(void)
+{
+	return "_NULL";
+}
+
+const char *gpu_get_driver_version(void)
+{
+	return "none";
+}
+
+const char *gpu_get_renderer(void)
+{
+	return "Null renderer";
+}
+
+uint64_t gpu_get_dmem(void)
+{
+	return 0;
+}
+
+uint64_t gpu_get_smem(void)
+{
+	return 0;
+}
+
+static inline bool rasterize_enabled(void)
+{
+	const char *rasterize = getenv("OBS_NULL_RENDERER_RASTERIZE");
+	return rasterize && *rasterize && strcmp(rasterize, "0") != 0;
+}
+
+int device_create(gs_device_t **p_device, uint32_t adapter)
+{
+	struct gs_device *device = bzalloc(sizeof(struct gs_device));
+
+	blog(LOG_INFO, "---------------------------------");
+	blog(LOG_INFO, "Initializing null renderer...");
+
+	device->rasterize = rasterize_enabled();
+	device->cur_cull_mode = GS_BACK;
+	device->blend.enabled = true;
+	device->blend.src_c = GS_BLEND_SRCALPHA;
+	device->blend.dest_c = GS_BLEND_INVSRCALPHA;
+	device->blend.src_a = GS_BLEND_ONE;
+	device->blend.dest_a = GS_BLEND_INVSRCALPHA;
+	device->blend.op = GS_BLEND_OP_ADD;
+	for (size_t i = 0; i < 4; i++)
+		device->blend.write[i] = true;
+
+	matrix4_identity(&device->cur_proj);
+	matrix4_identity(&device->cur_view);
+	matrix4_identity(&device->cur_viewproj);
+
+	blog(LOG_INFO, "Null renderer loaded (adapter %u ignored), draws are %s", adapter,
+	     device->rasterize ? "rasterized on the CPU" : "not rasterized");
+
+	*p_device = device;
+	return GS_SUCCESS;
+}
+
+void device_destroy(gs_device_t *device)
+{
+	if (!device)
+		return;
+
+	const struct null_stats *stats = &device->stats;
+
+	for (size_t i = 0; i < NULL_RESOURCE_COUNT; i++) {
+		if (stats->live[i])
+			blog(LOG_WARNING, "Null renderer: %ld %s were not destroyed", stats->live[i],
+			     resource_names[i]);
+	}
+
+	blog(LOG_INFO,
+	     "Null renderer: %" PRIu64 " draws (%" PRIu64 " rasterized), %" PRIu64 " clears, %" PRIu64
+	     " copies, %" PRIu64 " stages, %" PRIu64 " MB peak texture memory",
+	     stats->draws, stats->rasterized_draws, stats->clears, stats->copies, stats->stages,
+	     stats->peak_texture_bytes / (1024 * 1024));
+
+	da_free(device->proj_stack);
+	bfree(device);
+}
+
+void device_enter_context(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_leave_context(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void *device_get_device_obj(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline enum gs_color_format get_swap_format(const struct gs_init_data *data)
+{
+	return data->format == GS_UNKNOWN ? GS_BGRA : data->format;
+}
+
+gs_swapchain_t *device_swapchain_create(gs_device_t *device, const struct gs_init_data *data)
+{
+	struct gs_swap_chain *swap = bzalloc(sizeof(struct gs_swap_chain));
+
+	swap->device = device;
+	swap->info = *data;
+	swap->backbuffer = null_texture_create(device, GS_TEXTURE_2D, data->cx ? data->cx : 1,
+					       data->cy ? data->cy : 1, 1, get_swap_format(data), 1,
+					       GS_RENDER_TARGET);
+	if (!swap->backbuffer) {
+		blog(LOG_ERROR, "device_swapchain_create (null) failed");
+		bfree(swap);
+		return NULL;
+	}
+
+	device->stats.live[NULL_RESOURCE_SWAPCHAIN]++;
+	return swap;
+}
+
+void gs_swapchain_destroy(gs_swapchain_t *swapchain)
+{
+	if (!swapchain)
+		return;
+
+	if (swapchain->device->cur_swap == swapchain)
+		swapchain->device->cur_swap = NULL;
+
+	swapchain->device->stats.live[NULL_RESOURCE_SWAPCHAIN]--;
+	null_texture_destroy(swapchain->backbuffer);
+	bfree(swapchain);
+}
+
+void device_resize(gs_device_t *device, uint32_t cx, uint32_t cy)
+{
+	struct gs_swap_chain *swap = device->cur_swap;
+	gs_texture_t *backbuffer;
+
+	if (!swap) {
+		blog(LOG_WARNING, "device_resize (null): No active swap");
+		return;
+	}
+
+	backbuffer = null_texture_create(device, GS_TEXTURE_2D, cx ? cx : 1, cy ? cy : 1, 1,
+					 get_swap_format(&swap->info), 1, GS_RENDER_TARGET);
+	if (!backbuffer)
+		return;
+
+	null_texture_destroy(swap->backbuffer);
+	swap->backbuffer = backbuffer;
+	swap->info.cx = cx;
+	swap->info.cy = cy;
+}
+
+enum gs_color_space device_get_color_space(gs_device_t *device)
+{
+	return device->cur_color_space;
+}
+
+void device_update_color_space(gs_device_t *device)
+{
+	if (!device->cur_swap)
+		blog(LOG_WARNING, "device_update_color_space (null): No active swap");
+}
+
+void device_get_size(const gs_device_t *device, uint32_t *cx, uint32_t *cy)
+{
+	if (device->cur_swap) {
+		*cx = device->cur_swap->info.cx;
+		*cy = device->cur_swap->info.cy;
+	} else {
+		blog(LOG_WARNING, "device_get_size (null): No active swap");
+		*cx = 0;
+		*cy = 0;
+	}
+}
+
+uint32_t device_get_width(const gs_device_t *device)
+{
+	if (device->cur_swap) {
+		return device->cur_swap->info.cx;
+	} else {
+		blog(LOG_WARNING, "device_get_width (null): No active swap");
+		return 0;
+	}
+}
+
+uint32_t device_get_height(const gs_device_t *device)
+{
+	if (device->cur_swap) {
+		return device->cur_swap->info.cy;
+	} else {
+		blog(LOG_WARNING, "device_get_height (null): No active swap");
+		return 0;
+	}
+}
+
+void device_load_swapchain(gs_device_t *device, gs_swapchain_t *swapchain)
+{
+	device->cur_swap = swapchain;
+}
+
+bool device_is_present_ready(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return true;
+}
+
+void device_present(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_flush(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+bool device_is_monitor_hdr(gs_device_t *device, void *monitor)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(monitor);
+	return false;
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_samplerstate_t *device_samplerstate_create(gs_device_t *device, const struct gs_sampler_info *info)
+{
+	struct gs_sampler_state *sampler = bzalloc(sizeof(struct gs_sampler_state));
+
+	sampler->device = device;
+	sampler->info = *info;
+
+	device->stats.live[NULL_RESOURCE_SAMPLER]++;
+	return sampler;
+}
+
+void gs_samplerstate_destroy(gs_samplerstate_t *samplerstate)
+{
+	if (!samplerstate)
+		return;
+
+	for (int i = 0; i < GS_MAX_TEXTURES; i++)
+		if (samplerstate->device->cur_samplers[i] == samplerstate)
+			samplerstate->device->cur_samplers[i] = NULL;
+
+	samplerstate->device->stats.live[NULL_RESOURCE_SAMPLER]--;
+	bfree(samplerstate);
+}
+
+void device_load_samplerstate(gs_device_t *device, gs_samplerstate_t *samplerstate, int unit)
+{
+	device->cur_samplers[unit] = samplerstate;
+}
+
+void device_load_default_samplerstate(gs_device_t *device, bool b_3d, int unit)
+{
+	UNUSED_PARAMETER(b_3d);
+	device->cur_samplers[unit] = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_timer_t *device_timer_create(gs_device_t *device)
+{
+	struct gs_timer *timer = bzalloc(sizeof(struct gs_timer));
+	timer->device = device;
+
+	device->stats.live[NULL_RESOURCE_TIMER]++;
+	return timer;
+}
+
+gs_timer_range_t *device_timer_range_create(gs_device_t *device)
+{
+	struct gs_timer_range *range = bzalloc(sizeof(struct gs_timer_range));
+	range->device = device;
+
+	device->stats.live[NULL_RESOURCE_TIMER_RANGE]++;
+	return range;
+}
+
+void gs_timer_destroy(gs_timer_t *timer)
+{
+	if (!timer)
+		return;
+
+	timer->device->stats.live[NULL_RESOURCE_TIMER]--;
+	bfree(timer);
+}
+
+/* timers measure CPU time spent between begin and end */
+void gs_timer_begin(gs_timer_t *timer)
+{
+	timer->begin = os_gettime_ns();
+}
+
+void gs_timer_end(gs_timer_t *timer)
+{
+	timer->end = os_gettime_ns();
+}
+
+bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks)
+{
+	*ticks = timer->end - timer->begin;
+	return true;
+}
+
+void gs_timer_range_destroy(gs_timer_range_t *range)
+{
+	if (!range)
+		return;
+
+	range->device->stats.live[NULL_RESOURCE_TIMER_RANGE]--;
+	bfree(range);
+}
+
+void gs_timer_range_begin(gs_timer_range_t *range)
+{
+	range->active = true;
+}
+
+void gs_timer_range_end(gs_timer_range_t *range)
+{
+	range->active = false;
+}
+
+bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint, uint64_t *frequency)
+{
+	UNUSED_PARAMETER(range);
+
+	*disjoint = false;
+	*frequency = 1000000000;
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void device_load_texture(gs_device_t *device, gs_texture_t *tex, int unit)
+{
+	device->cur_textures[unit] = tex;
+}
+
+void device_load_texture_srgb(gs_device_t *device, gs_texture_t *tex, int unit)
+{
+	device_load_texture(device, tex, unit);
+}
+
+void device_load_vertexshader(gs_device_t *device, gs_shader_t *vertshader)
+{
+	if (vertshader && vertshader->type != GS_SHADER_VERTEX) {
+		blog(LOG_ERROR, "device_load_vertexshader (null): Specified shader is not a vertex shader");
+		return;
+	}
+
+	device->cur_vertex_shader = vertshader;
+}
+
+void device_load_pixelshader(gs_device_t *device, gs_shader_t *pixelshader)
+{
+	if (pixelshader && pixelshader->type != GS_SHADER_PIXEL) {
+		blog(LOG_ERROR, "device_load_pixelshader (null): Specified shader is not a pixel shader");
+		return;
+	}
+
+	device->cur_pixel_shader = pixelshader;
+
+	/* samplers declared in the shader are the defaults */
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++)
+		device->cur_samplers[i] = pixelshader && i < pixelshader->samplers.num ? pixelshader->samplers.array[i]
+										       : NULL;
+}
+
+gs_shader_t *device_get_vertex_shader(const gs_device_t *device)
+{
+	return device->cur_vertex_shader;
+}
+
+gs_shader_t *device_get_pixel_shader(const gs_device_t *device)
+{
+	return device->cur_pixel_shader;
+}
+
+gs_texture_t *device_get_render_target(const gs_device_t *device)
+{
+	return device->cur_render_target;
+}
+
+gs_zstencil_t *device_get_zstencil_target(const gs_device_t *device)
+{
+	return device->cur_zstencil_buffer;
+}
+
+gs_texture_t *null_get_render_target(gs_device_t *device)
+{
+	if (device->cur_render_target)
+		return device->cur_render_target;
+	return device->cur_swap ? device->cur_swap->backbuffer : NULL;
+}
+
+static void set_target(gs_device_t *device, gs_texture_t *tex, int side, gs_zstencil_t *zstencil,
+		       enum gs_color_space space)
+{
+	if (tex && !tex->is_render_target) {
+		blog(LOG_ERROR, "device_set_render_target (null): Texture is not a render target");
+		return;
+	}
+
+	device->cur_render_target = tex;
+	device->cur_render_side = side;
+	device->cur_zstencil_buffer = zstencil;
+	device->cur_color_space = space;
+}
+
+void device_set_render_target(gs_device_t *device, gs_texture_t *tex, gs_zstencil_t *zstencil)
+{
+	device_set_render_target_with_color_space(device, tex, zstencil, GS_CS_SRGB);
+}
+
+void device_set_render_target_with_color_space(gs_device_t *device, gs_texture_t *tex, gs_zstencil_t *zstencil,
+					       enum gs_color_space space)
+{
+	if (tex && tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_set_render_target (null): Texture is not a 2D texture");
+		return;
+	}
+
+	set_target(device, tex, 0, zstencil, space);
+}
+
+void device_set_cube_render_target(gs_device_t *device, gs_texture_t *cubetex, int side, gs_zstencil_t *zstencil)
+{
+	if (cubetex && cubetex->type != GS_TEXTURE_CUBE) {
+		blog(LOG_ERROR, "device_set_cube_render_target (null): Texture is not a cube texture");
+		return;
+	}
+
+	set_target(device, cubetex, side, zstencil, GS_CS_SRGB);
+}
+
+void device_enable_framebuffer_srgb(gs_device_t *device, bool enable)
+{
+	device->framebuffer_srgb = enable;
+}
+
+bool device_framebuffer_srgb_enabled(gs_device_t *device)
+{
+	return device->framebuffer_srgb;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void device_begin_frame(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_begin_scene(gs_device_t *device)
+{
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++)
+		device->cur_textures[i] = NULL;
+}
+
+void device_end_scene(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+static inline bool can_render(const gs_device_t *device, uint32_t num_verts)
+{
+	if (!device->cur_vertex_shader) {
+		blog(LOG_ERROR, "No vertex shader specified");
+		return false;
+	}
+
+	if (!device->cur_pixel_shader) {
+		blog(LOG_ERROR, "No pixel shader specified");
+		return false;
+	}
+
+	if (!device->cur_vertex_buffer && (num_verts == 0)) {
+		blog(LOG_ERROR, "No vertex buffer specified");
+		return false;
+	}
+
+	if (!device->cur_swap && !device->cur_render_target) {
+		blog(LOG_ERROR, "No active swap chain or render target");
+		return false;
+	}
+
+	return true;
+}
+
+static void update_viewproj_matrix(struct gs_device *device)
+{
+	struct gs_shader *vs = device->cur_vertex_shader;
+	struct matrix4 viewproj;
+
+	gs_matrix_get(&device->cur_view);
+	matrix4_mul(&device->cur_viewproj, &device->cur_view, &device->cur_proj);
+
+	/* the shader gets the same transposed matrix as with other renderers */
+	matrix4_transpose(&viewproj, &device->cur_viewproj);
+
+	if (vs->viewproj)
+		gs_shader_set_matrix4(vs->viewproj, &viewproj);
+}
+
+/* Binds the textures and samplers of the pixel shader parameters like other
+ * renderers do when uploading parameters */
+static void load_shader_textures(struct gs_device *device)
+{
+	struct gs_shader *ps = device->cur_pixel_shader;
+	int unit = 0;
+
+	for (size_t i = 0; i < ps->params.num && unit < GS_MAX_TEXTURES; i++) {
+		struct gs_shader_param *param = ps->params.array + i;
+
+		if (param->type != GS_SHADER_PARAM_TEXTURE)
+			continue;
+
+		if (param->next_sampler) {
+			device->cur_samplers[unit] = param->next_sampler;
+			param->next_sampler = NULL;
+		}
+
+		device_load_texture(device, param->texture, unit++);
+	}
+}
+
+void device_draw(gs_device_t *device, enum gs_draw_mode draw_mode, uint32_t start_vert, uint32_t num_verts)
+{
+	gs_effect_t *effect = gs_get_effect();
+
+	if (!can_render(device, num_verts)) {
+		blog(LOG_ERROR, "device_draw (null) failed");
+		return;
+	}
+
+	if (effect)
+		gs_effect_update_params(effect);
+
+	update_viewproj_matrix(device);
+	load_shader_textures(device);
+
+	device->stats.draws++;
+
+	if (device->rasterize)
+		null_rasterize(device, draw_mode, start_vert, num_verts);
+}
+
+void device_clear(gs_device_t *device, uint32_t clear_flags, const struct vec4 *color, float depth, uint8_t stencil)
+{
+	gs_texture_t *target = null_get_render_target(device);
+
+	UNUSED_PARAMETER(depth);
+	UNUSED_PARAMETER(stencil);
+
+	device->stats.clears++;
+
+	if ((clear_flags & GS_CLEAR_COLOR) != 0 && target) {
+		uint32_t layer = target->type == GS_TEXTURE_CUBE ? (uint32_t)device->cur_render_side : 0;
+		null_texture_clear(target, layer, color);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+void device_set_cull_mode(gs_device_t *device, enum gs_cull_mode mode)
+{
+	device->cur_cull_mode = mode;
+}
+
+enum gs_cull_mode device_get_cull_mode(const gs_device_t *device)
+{
+	return device->cur_cull_mode;
+}
+
+void device_enable_blending(gs_device_t *device, bool enable)
+{
+	device->blend.enabled = enable;
+}
+
+void device_enable_depth_test(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_stencil_test(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_stencil_write(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_color(gs_device_t *device, bool red, bool green, bool blue, bool alpha)
+{
+	device->blend.write[0] = red;
+	device->blend.write[1] = green;
+	device->blend.write[2] = blue;
+	device->blend.write[3] = alpha;
+}
+
+void device_blend_function(gs_device_t *device, enum gs_blend_type src, enum gs_blend_type dest)
+{
+	device_blend_function_separate(device, src, dest, src, dest);
+}
+
+void device_blend_function_separate(gs_device_t *device, enum gs_blend_type src_c, enum gs_blend_type dest_c,
+				    enum gs_blend_type src_a, enum gs_blend_type dest_a)
+{
+	device->blend.src_c = src_c;
+	device->blend.dest_c = dest_c;
+	device->blend.src_a = src_a;
+	device->blend.dest_a = dest_a;
+}
+
+void device_blend_op(gs_device_t *device, enum gs_blend_op_type op)
+{
+	device->blend.op = op;
+}
+
+void device_depth_function(gs_device_t *device, enum gs_depth_test test)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(test);
+}
+
+void device_stencil_function(gs_device_t *device, enum gs_stencil_side side, enum gs_depth_test test)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(side);
+	UNUSED_PARAMETER(test);
+}
+
+void device_stencil_op(gs_device_t *device, enum gs_stencil_side side, enum gs_stencil_op_type fail,
+		       enum gs_stencil_op_type zfail, enum gs_stencil_op_type zpass)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(side);
+	UNUSED_PARAMETER(fail);
+	UNUSED_PARAMETER(zfail);
+	UNUSED_PARAMETER(zpass);
+}
+
+void device_set_viewport(gs_device_t *device, int x, int y, int width, int height)
+{
+	device->cur_viewport.x = x;
+	device->cur_viewport.y = y;
+	device->cur_viewport.cx = width;
+	device->cur_viewport.cy = height;
+}
+
+void device_get_viewport(const gs_device_t *device, struct gs_rect *rect)
+{
+	*rect = device->cur_viewport;
+}
+
+void device_set_scissor_rect(gs_device_t *device, const struct gs_rect *rect)
+{
+	device->scissor_enabled = rect != NULL;
+	if (rect)
+		device->cur_scissor = *rect;
+}
+
+/* Same projections as Direct3D, so render targets are stored top-down */
+void device_ortho(gs_device_t *device, float left, float right, float top, float bottom, float near, float far)
+{
+	struct matrix4 *dst = &device->cur_proj;
+
+	float rml = right - left;
+	float bmt = bottom - top;
+	float fmn = far - near;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x = 2.0f / rml;
+	dst->t.x = (left + right) / -rml;
+
+	dst->y.y = 2.0f / -bmt;
+	dst->t.y = (bottom + top) / bmt;
+
+	dst->z.z = 1.0f / fmn;
+	dst->t.z = near / -fmn;
+
+	dst->t.w = 1.0f;
+}
+
+void device_frustum(gs_device_t *device, float left, float right, float top, float bottom, float near, float far)
+{
+	struct matrix4 *dst = &device->cur_proj;
+
+	float rml = right - left;
+	float bmt = bottom - top;
+	float fmn = far - near;
+	float nearx2 = 2.0f * near;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x = nearx2 / rml;
+	dst->z.x = (left + right) / -rml;
+
+	dst->y.y = nearx2 / -bmt;
+	dst->z.y = (bottom + top) / bmt;
+
+	dst->z.z = far / fmn;
+	dst->t.z = (near * far) / -fmn;
+
+	dst->z.w = 1.0f;
+}
+
+void device_projection_push(gs_device_t *device)
+{
+	da_push_back(device->proj_stack, &device->cur_proj);
+}
+
+void device_projection_pop(gs_device_t *device)
+{
+	struct matrix4 *end;
+	if (!device->proj_stack.num)
+		return;
+
+	end = da_end(device->proj_stack);
+	device->cur_proj = *end;
+	da_pop_back(device->proj_stack);
+}
+
+void device_debug_marker_begin(gs_device_t *device, const char *markername, const float color[4])
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(markername);
+	UNUSED_PARAMETER(color);
+}
+
+void device_debug_marker_end(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+/* ------------------------------------------------------------------------- */
+
+bool device_shared_texture_available(void)
+{
+	return false;
+}
+
+bool device_nv12_available(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return false;
+}
+
+bool device_p010_available(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return false;
+}
+
+#ifdef __APPLE__
+gs_texture_t *device_texture_create_from_iosurface(gs_device_t *device, void *iosurf)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(iosurf);
+	return NULL;
+}
+
+gs_texture_t *device_texture_open_shared(gs_device_t *device, uint32_t handle)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(handle);
+	return NULL;
+}
+
+bool gs_texture_rebind_iosurface(gs_texture_t *texture, void *iosurf)
+{
+	UNUSED_PARAMETER(texture);
+	UNUSED_PARAMETER(iosurf);
+	return false;
+}
+
+#elif _WIN32
+EXPORT bool device_gdi_texture_available(void)
+{
+	return false;
+}
+
+#elif defined(__linux__) || defined(__FreeBSD__) || defined(__DragonFly__)
+gs_texture_t *device_texture_create_from_dmabuf(gs_device_t *device, unsigned int width, unsigned int height,
+						uint32_t drm_format, enum gs_color_format color_format,
+						uint32_t n_planes, const int *fds, const uint32_t *strides,
+						const uint32_t *offsets, const uint64_t *modifiers)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(width);
+	UNUSED_PARAMETER(height);
+	UNUSED_PARAMETER(drm_format);
+	UNUSED_PARAMETER(color_format);
+	UNUSED_PARAMETER(n_planes);
+	UNUSED_PARAMETER(fds);
+	UNUSED_PARAMETER(strides);
+	UNUSED_PARAMETER(offsets);
+	UNUSED_PARAMETER(modifiers);
+	return NULL;
+}
+
+bool device_query_dmabuf_capabilities(gs_device_t *device, enum gs_dmabuf_flags *dmabuf_flags,
+				      uint32_t **drm_formats, size_t *n_formats)
+{
+	UNUSED_PARAMETER(device);
+	*dmabuf_flags = GS_DMABUF_FLAG_NONE;
+	*drm_formats = NULL;
+	*n_formats = 0;
+	return false;
+}
+
+bool device_query_dmabuf_modifiers_for_format(gs_device_t *device, uint32_t drm_format, uint64_t **modifiers,
+					      size_t *n_modifiers)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(drm_format);
+	*modifiers = NULL;
+	*n_modifiers = 0;
+	return false;
+}
+
+gs_texture_t *device_texture_create_from_pixmap(gs_device_t *device, uint32_t width, uint32_t height,
+						enum gs_color_format color_format, uint32_t target, void *pixmap)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(width);
+	UNUSED_PARAMETER(height);
+	UNUSED_PARAMETER(color_format);
+	UNUSED_PARAMETER(target);
+	UNUSED_PARAMETER(pixmap);
+	return NULL;
+}
+
+bool device_query_sync_capabilities(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return false;
+}
+
+gs_sync_t *device_sync_create(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+	return NULL;
+}
+
+gs_sync_t *device_sync_create_from_syncobj_timeline_point(gs_device_t *device, int syncobj_fd,
+							  uint64_t timeline_point)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(syncobj_fd);
+	UNUSED_PARAMETER(timeline_point);
+	return NULL;
+}
+
+void device_sync_destroy(gs_device_t *device, gs_sync_t *sync)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(sync);
+}
+
+bool device_sync_export_syncobj_timeline_point(gs_device_t *device, gs_sync_t *sync, int syncobj_fd,
+					       uint64_t timeline_point)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(sync);
+	UNUSED_PARAMETER(syncobj_fd);
+	UNUSED_PARAMETER(timeline_point);
+	return false;
+}
+
+bool device_sync_signal_syncobj_timeline_point(gs_device_t *device, int syncobj_fd, uint64_t timeline_point)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(syncobj_fd);
+	UNUSED_PARAMETER(timeline_point);
+	return false;
+}
+
+bool device_sync_wait(gs_device_t *device, gs_sync_t *sync)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(sync);
+	return false;
+}
+#endif
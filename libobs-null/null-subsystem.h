@@ -0,0 +1,206 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <util/darray.h>
+#include <graphics/graphics.h>
+#include <graphics/device-exports.h>
+#include <graphics/matrix4.h>
+
+/*
+ * Null renderer
+ *
+ *   Implements the device exports without a GPU.  Resources are kept in
+ * system memory and tracked so leaks can be reported when the device is
+ * destroyed.  Texture contents are kept up to date for uploads, maps, clears,
+ * copies and staging, so readback works as expected.  Draws are only counted
+ * unless the OBS_NULL_RENDERER_RASTERIZE environment variable is set, in which
+ * case triangles are rasterized on the CPU with point sampling.
+ */
+
+enum null_resource_type {
+	NULL_RESOURCE_TEXTURE,
+	NULL_RESOURCE_STAGESURF,
+	NULL_RESOURCE_ZSTENCIL,
+	NULL_RESOURCE_SAMPLER,
+	NULL_RESOURCE_SHADER,
+	NULL_RESOURCE_VERTEXBUFFER,
+	NULL_RESOURCE_INDEXBUFFER,
+	NULL_RESOURCE_TIMER,
+	NULL_RESOURCE_TIMER_RANGE,
+	NULL_RESOURCE_SWAPCHAIN,
+	NULL_RESOURCE_COUNT,
+};
+
+struct null_stats {
+	long live[NULL_RESOURCE_COUNT];
+	uint64_t texture_bytes;
+	uint64_t peak_texture_bytes;
+
+	uint64_t draws;
+	uint64_t rasterized_draws;
+	uint64_t clears;
+	uint64_t copies;
+	uint64_t stages;
+};
+
+struct gs_sampler_state {
+	gs_device_t *device;
+	struct gs_sampler_info info;
+};
+
+struct gs_timer {
+	gs_device_t *device;
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct gs_timer_range {
+	gs_device_t *device;
+	bool active;
+};
+
+struct gs_shader_param {
+	enum gs_shader_param_type type;
+
+	char *name;
+	gs_shader_t *shader;
+	gs_samplerstate_t *next_sampler;
+	int array_count;
+
+	struct gs_texture *texture;
+	bool srgb;
+
+	DARRAY(uint8_t) cur_value;
+	DARRAY(uint8_t) def_value;
+};
+
+struct gs_shader {
+	gs_device_t *device;
+	enum gs_shader_type type;
+
+	struct gs_shader_param *viewproj;
+	struct gs_shader_param *world;
+
+	DARRAY(struct gs_shader_param) params;
+	DARRAY(gs_samplerstate_t *) samplers;
+};
+
+struct gs_vertex_buffer {
+	gs_device_t *device;
+	size_t num;
+	bool dynamic;
+	struct gs_vb_data *data;
+};
+
+struct gs_index_buffer {
+	gs_device_t *device;
+	enum gs_index_type type;
+	void *data;
+	size_t num;
+	size_t width;
+	bool dynamic;
+};
+
+/* Cube textures are stored as six layers, volume textures as one layer per
+ * depth slice.  Only the first mip level is kept. */
+struct gs_texture {
+	gs_device_t *device;
+	enum gs_texture_type type;
+	enum gs_color_format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t layers;
+	uint32_t levels;
+	bool is_dynamic;
+	bool is_render_target;
+	bool is_mapped;
+
+	uint32_t linesize;
+	uint32_t rows;
+
+	/* allocated on first write, reads of unwritten textures are zero */
+	uint8_t *data;
+};
+
+struct gs_stage_surface {
+	gs_device_t *device;
+	enum gs_color_format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t linesize;
+	bool is_mapped;
+	uint8_t *data;
+};
+
+struct gs_zstencil_buffer {
+	gs_device_t *device;
+	enum gs_zstencil_format format;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct gs_swap_chain {
+	gs_device_t *device;
+	struct gs_init_data info;
+	gs_texture_t *backbuffer;
+};
+
+struct null_blend_state {
+	bool enabled;
+	enum gs_blend_type src_c;
+	enum gs_blend_type dest_c;
+	enum gs_blend_type src_a;
+	enum gs_blend_type dest_a;
+	enum gs_blend_op_type op;
+	bool write[4];
+};
+
+struct gs_device {
+	bool rasterize;
+
+	gs_texture_t *cur_render_target;
+	gs_zstencil_t *cur_zstencil_buffer;
+	int cur_render_side;
+	enum gs_color_space cur_color_space;
+	gs_texture_t *cur_textures[GS_MAX_TEXTURES];
+	gs_samplerstate_t *cur_samplers[GS_MAX_TEXTURES];
+	gs_vertbuffer_t *cur_vertex_buffer;
+	gs_indexbuffer_t *cur_index_buffer;
+	gs_shader_t *cur_vertex_shader;
+	gs_shader_t *cur_pixel_shader;
+	gs_swapchain_t *cur_swap;
+	bool framebuffer_srgb;
+
+	enum gs_cull_mode cur_cull_mode;
+	struct gs_rect cur_viewport;
+	struct gs_rect cur_scissor;
+	bool scissor_enabled;
+	struct null_blend_state blend;
+
+	struct matrix4 cur_proj;
+	struct matrix4 cur_view;
+	struct matrix4 cur_viewproj;
+
+	DARRAY(struct matrix4) proj_stack;
+
+	struct null_stats stats;
+};
+
+/* textures */
+extern gs_texture_t *null_texture_create(gs_device_t *device, enum gs_texture_type type, uint32_t width,
+					 uint32_t height, uint32_t layers, enum gs_color_format format, uint32_t levels,
+					 uint32_t flags);
+extern void null_texture_destroy(gs_texture_t *tex);
+extern uint8_t *null_texture_get_data(gs_texture_t *tex);
+extern void null_texture_clear(gs_texture_t *tex, uint32_t layer, const struct vec4 *color);
+
+/* pixel conversion, returns false for compressed formats */
+extern bool null_read_pixel(enum gs_color_format format, const uint8_t *src, struct vec4 *color);
+extern bool null_write_pixel(enum gs_color_format format, const struct vec4 *color, uint8_t *dst);
+
+/* draws */
+extern gs_texture_t *null_get_render_target(gs_device_t *device);
+extern void null_rasterize(gs_device_t *device, enum gs_draw_mode draw_mode, uint32_t start_vert, uint32_t num_verts);
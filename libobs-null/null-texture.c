@@ -0,0 +1,668 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "null-subsystem.h"
+#include <graphics/half.h>
+
+static inline float half_to_float(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1F;
+	uint32_t mantissa = h & 0x3FF;
+	uint32_t bits;
+	float f;
+
+	if (exponent == 0x1F) {
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	} else if (exponent) {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	} else {
+		f = (float)mantissa / 16777216.0f;
+		return sign ? -f : f;
+	}
+
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static inline uint32_t to_unorm(float f, uint32_t max)
+{
+	if (!(f > 0.0f))
+		return 0;
+	if (f >= 1.0f)
+		return max;
+	return (uint32_t)(f * (float)max + 0.5f);
+}
+
+static inline uint8_t to_unorm8(float f)
+{
+	return (uint8_t)to_unorm(f, 255);
+}
+
+static inline uint16_t to_unorm16(float f)
+{
+	return (uint16_t)to_unorm(f, 65535);
+}
+
+bool null_read_pixel(enum gs_color_format format, const uint8_t *src, struct vec4 *color)
+{
+	const uint16_t *src16 = (const uint16_t *)src;
+	const float *src32 = (const float *)src;
+	uint32_t packed;
+
+	vec4_set(color, 0.0f, 0.0f, 0.0f, 1.0f);
+
+	switch (format) {
+	case GS_A8:
+		color->w = (float)src[0] / 255.0f;
+		return true;
+	case GS_R8:
+		color->x = (float)src[0] / 255.0f;
+		return true;
+	case GS_R8G8:
+		color->x = (float)src[0] / 255.0f;
+		color->y = (float)src[1] / 255.0f;
+		return true;
+	case GS_RGBA:
+	case GS_RGBA_UNORM:
+		vec4_set(color, (float)src[0] / 255.0f, (float)src[1] / 255.0f, (float)src[2] / 255.0f,
+			 (float)src[3] / 255.0f);
+		return true;
+	case GS_BGRX:
+	case GS_BGRX_UNORM:
+		vec4_set(color, (float)src[2] / 255.0f, (float)src[1] / 255.0f, (float)src[0] / 255.0f, 1.0f);
+		return true;
+	case GS_BGRA:
+	case GS_BGRA_UNORM:
+		vec4_set(color, (float)src[2] / 255.0f, (float)src[1] / 255.0f, (float)src[0] / 255.0f,
+			 (float)src[3] / 255.0f);
+		return true;
+	case GS_R10G10B10A2:
+		memcpy(&packed, src, sizeof(packed));
+		vec4_set(color, (float)(packed & 0x3FF) / 1023.0f, (float)((packed >> 10) & 0x3FF) / 1023.0f,
+			 (float)((packed >> 20) & 0x3FF) / 1023.0f, (float)(packed >> 30) / 3.0f);
+		return true;
+	case GS_R16:
+		color->x = (float)src16[0] / 65535.0f;
+		return true;
+	case GS_RG16:
+		color->x = (float)src16[0] / 65535.0f;
+		color->y = (float)src16[1] / 65535.0f;
+		return true;
+	case GS_RGBA16:
+		vec4_set(color, (float)src16[0] / 65535.0f, (float)src16[1] / 65535.0f, (float)src16[2] / 65535.0f,
+			 (float)src16[3] / 65535.0f);
+		return true;
+	case GS_R16F:
+		color->x = half_to_float(src16[0]);
+		return true;
+	case GS_RG16F:
+		color->x = half_to_float(src16[0]);
+		color->y = half_to_float(src16[1]);
+		return true;
+	case GS_RGBA16F:
+		vec4_set(color, half_to_float(src16[0]), half_to_float(src16[1]), half_to_float(src16[2]),
+			 half_to_float(src16[3]));
+		return true;
+	case GS_R32F:
+		color->x = src32[0];
+		return true;
+	case GS_RG32F:
+		color->x = src32[0];
+		color->y = src32[1];
+		return true;
+	case GS_RGBA32F:
+		vec4_set(color, src32[0], src32[1], src32[2], src32[3]);
+		return true;
+	case GS_DXT1:
+	case GS_DXT3:
+	case GS_DXT5:
+	case GS_UNKNOWN:
+		break;
+	}
+
+	return false;
+}
+
+bool null_write_pixel(enum gs_color_format format, const struct vec4 *color, uint8_t *dst)
+{
+	uint16_t *dst16 = (uint16_t *)dst;
+	float *dst32 = (float *)dst;
+	uint32_t packed;
+
+	switch (format) {
+	case GS_A8:
+		dst[0] = to_unorm8(color->w);
+		return true;
+	case GS_R8:
+		dst[0] = to_unorm8(color->x);
+		return true;
+	case GS_R8G8:
+		dst[0] = to_unorm8(color->x);
+		dst[1] = to_unorm8(color->y);
+		return true;
+	case GS_RGBA:
+	case GS_RGBA_UNORM:
+		dst[0] = to_unorm8(color->x);
+		dst[1] = to_unorm8(color->y);
+		dst[2] = to_unorm8(color->z);
+		dst[3] = to_unorm8(color->w);
+		return true;
+	case GS_BGRX:
+	case GS_BGRX_UNORM:
+		dst[0] = to_unorm8(color->z);
+		dst[1] = to_unorm8(color->y);
+		dst[2] = to_unorm8(color->x);
+		dst[3] = 255;
+		return true;
+	case GS_BGRA:
+	case GS_BGRA_UNORM:
+		dst[0] = to_unorm8(color->z);
+		dst[1] = to_unorm8(color->y);
+		dst[2] = to_unorm8(color->x);
+		dst[3] = to_unorm8(color->w);
+		return true;
+	case GS_R10G10B10A2:
+		packed = to_unorm(color->x, 1023) | (to_unorm(color->y, 1023) << 10) |
+			 (to_unorm(color->z, 1023) << 20) | (to_unorm(color->w, 3) << 30);
+		memcpy(dst, &packed, sizeof(packed));
+		return true;
+	case GS_R16:
+		dst16[0] = to_unorm16(color->x);
+		return true;
+	case GS_RG16:
+		dst16[0] = to_unorm16(color->x);
+		dst16[1] = to_unorm16(color->y);
+		return true;
+	case GS_RGBA16:
+		dst16[0] = to_unorm16(color->x);
+		dst16[1] = to_unorm16(color->y);
+		dst16[2] = to_unorm16(color->z);
+		dst16[3] = to_unorm16(color->w);
+		return true;
+	case GS_R16F:
+		dst16[0] = half_from_float(color->x).u;
+		return true;
+	case GS_RG16F:
+		dst16[0] = half_from_float(color->x).u;
+		dst16[1] = half_from_float(color->y).u;
+		return true;
+	case GS_RGBA16F:
+		dst16[0] = half_from_float(color->x).u;
+		dst16[1] = half_from_float(color->y).u;
+		dst16[2] = half_from_float(color->z).u;
+		dst16[3] = half_from_float(color->w).u;
+		return true;
+	case GS_R32F:
+		dst32[0] = color->x;
+		return true;
+	case GS_RG32F:
+		dst32[0] = color->x;
+		dst32[1] = color->y;
+		return true;
+	case GS_RGBA32F:
+		dst32[0] = color->x;
+		dst32[1] = color->y;
+		dst32[2] = color->z;
+		dst32[3] = color->w;
+		return true;
+	case GS_DXT1:
+	case GS_DXT3:
+	case GS_DXT5:
+	case GS_UNKNOWN:
+		break;
+	}
+
+	return false;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline size_t layer_size(const struct gs_texture *tex)
+{
+	return (size_t)tex->linesize * tex->rows;
+}
+
+static inline size_t texture_size(const struct gs_texture *tex)
+{
+	return layer_size(tex) * tex->layers;
+}
+
+gs_texture_t *null_texture_create(gs_device_t *device, enum gs_texture_type type, uint32_t width, uint32_t height,
+				  uint32_t layers, enum gs_color_format format, uint32_t levels, uint32_t flags)
+{
+	struct gs_texture *tex;
+	uint32_t bpp = gs_get_format_bpp(format);
+
+	if (!bpp || !width || !height || !layers) {
+		blog(LOG_ERROR, "null_texture_create: Invalid texture (%ux%ux%u, format %d)", width, height, layers,
+		     (int)format);
+		return NULL;
+	}
+
+	tex = bzalloc(sizeof(struct gs_texture));
+	tex->device = device;
+	tex->type = type;
+	tex->format = format;
+	tex->width = width;
+	tex->height = height;
+	tex->layers = layers;
+	tex->levels = levels;
+	tex->is_dynamic = (flags & GS_DYNAMIC) != 0;
+	tex->is_render_target = (flags & GS_RENDER_TARGET) != 0;
+
+	/* compressed formats are stored as rows of 4x4 blocks */
+	if (gs_is_compressed_format(format)) {
+		tex->linesize = (width + 3) / 4 * bpp * 2;
+		tex->rows = (height + 3) / 4;
+	} else {
+		tex->linesize = (width * bpp / 8 + 3) & 0xFFFFFFFC;
+		tex->rows = height;
+	}
+
+	device->stats.live[NULL_RESOURCE_TEXTURE]++;
+	return tex;
+}
+
+void null_texture_destroy(gs_texture_t *tex)
+{
+	gs_device_t *device;
+
+	if (!tex)
+		return;
+
+	device = tex->device;
+
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++)
+		if (device->cur_textures[i] == tex)
+			device->cur_textures[i] = NULL;
+	if (device->cur_render_target == tex)
+		device->cur_render_target = NULL;
+
+	if (tex->data)
+		device->stats.texture_bytes -= texture_size(tex);
+	device->stats.live[NULL_RESOURCE_TEXTURE]--;
+
+	bfree(tex->data);
+	bfree(tex);
+}
+
+uint8_t *null_texture_get_data(gs_texture_t *tex)
+{
+	if (!tex->data) {
+		struct null_stats *stats = &tex->device->stats;
+
+		tex->data = bzalloc(texture_size(tex));
+		stats->texture_bytes += texture_size(tex);
+		if (stats->texture_bytes > stats->peak_texture_bytes)
+			stats->peak_texture_bytes = stats->texture_bytes;
+	}
+
+	return tex->data;
+}
+
+void null_texture_clear(gs_texture_t *tex, uint32_t layer, const struct vec4 *color)
+{
+	uint8_t pixel[16];
+	uint32_t pixel_size = gs_get_format_bpp(tex->format) / 8;
+	uint8_t *data;
+
+	if (!null_write_pixel(tex->format, color, pixel))
+		return;
+
+	data = null_texture_get_data(tex) + layer_size(tex) * layer;
+
+	for (uint32_t x = 0; x < tex->width; x++)
+		memcpy(data + x * pixel_size, pixel, pixel_size);
+	for (uint32_t y = 1; y < tex->rows; y++)
+		memcpy(data + y * tex->linesize, data, tex->width * pixel_size);
+}
+
+static void upload_layer(gs_texture_t *tex, uint32_t layer, const uint8_t *src)
+{
+	uint8_t *dst = null_texture_get_data(tex) + layer_size(tex) * layer;
+	uint32_t src_linesize;
+
+	if (gs_is_compressed_format(tex->format))
+		src_linesize = tex->linesize;
+	else
+		src_linesize = tex->width * gs_get_format_bpp(tex->format) / 8;
+
+	if (src_linesize == tex->linesize) {
+		memcpy(dst, src, layer_size(tex));
+		return;
+	}
+
+	for (uint32_t y = 0; y < tex->rows; y++)
+		memcpy(dst + y * tex->linesize, src + y * src_linesize, src_linesize);
+}
+
+gs_texture_t *device_texture_create(gs_device_t *device, uint32_t width, uint32_t height,
+				    enum gs_color_format color_format, uint32_t levels, const uint8_t **data,
+				    uint32_t flags)
+{
+	gs_texture_t *tex =
+		null_texture_create(device, GS_TEXTURE_2D, width, height, 1, color_format, levels, flags);
+
+	if (tex && data && data[0])
+		upload_layer(tex, 0, data[0]);
+	return tex;
+}
+
+gs_texture_t *device_cubetexture_create(gs_device_t *device, uint32_t size, enum gs_color_format color_format,
+					uint32_t levels, const uint8_t **data, uint32_t flags)
+{
+	gs_texture_t *tex = null_texture_create(device, GS_TEXTURE_CUBE, size, size, 6, color_format, levels, flags);
+
+	if (tex && data) {
+		uint32_t stride = levels ? levels : 1;
+
+		for (uint32_t i = 0; i < 6; i++) {
+			if (data[i * stride])
+				upload_layer(tex, i, data[i * stride]);
+		}
+	}
+
+	return tex;
+}
+
+gs_texture_t *device_voltexture_create(gs_device_t *device, uint32_t width, uint32_t height, uint32_t depth,
+				       enum gs_color_format color_format, uint32_t levels, const uint8_t *const *data,
+				       uint32_t flags)
+{
+	gs_texture_t *tex =
+		null_texture_create(device, GS_TEXTURE_3D, width, height, depth, color_format, levels, flags);
+
+	if (tex && data && data[0]) {
+		size_t src_layer_size = (size_t)width * height * gs_get_format_bpp(color_format) / 8;
+
+		for (uint32_t i = 0; i < depth; i++)
+			upload_layer(tex, i, data[0] + src_layer_size * i);
+	}
+
+	return tex;
+}
+
+enum gs_texture_type device_get_texture_type(const gs_texture_t *texture)
+{
+	return texture->type;
+}
+
+void gs_texture_destroy(gs_texture_t *tex)
+{
+	null_texture_destroy(tex);
+}
+
+uint32_t gs_texture_get_width(const gs_texture_t *tex)
+{
+	return tex->width;
+}
+
+uint32_t gs_texture_get_height(const gs_texture_t *tex)
+{
+	return tex->height;
+}
+
+enum gs_color_format gs_texture_get_color_format(const gs_texture_t *tex)
+{
+	return tex->format;
+}
+
+bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
+{
+	if (tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "gs_texture_map (null): Texture is not 2D");
+		return false;
+	}
+	if (!tex->is_dynamic) {
+		blog(LOG_ERROR, "gs_texture_map (null): Texture is not dynamic");
+		return false;
+	}
+	if (tex->is_mapped) {
+		blog(LOG_ERROR, "gs_texture_map (null): Texture is already mapped");
+		return false;
+	}
+
+	tex->is_mapped = true;
+	*ptr = null_texture_get_data(tex);
+	*linesize = tex->linesize;
+	return true;
+}
+
+void gs_texture_unmap(gs_texture_t *tex)
+{
+	if (!tex->is_mapped)
+		blog(LOG_WARNING, "gs_texture_unmap (null): Texture is not mapped");
+
+	tex->is_mapped = false;
+}
+
+bool gs_texture_is_rect(const gs_texture_t *tex)
+{
+	UNUSED_PARAMETER(tex);
+	return false;
+}
+
+void *gs_texture_get_obj(gs_texture_t *tex)
+{
+	/* there is no native object */
+	return tex;
+}
+
+void gs_cubetexture_destroy(gs_texture_t *cubetex)
+{
+	null_texture_destroy(cubetex);
+}
+
+uint32_t gs_cubetexture_get_size(const gs_texture_t *cubetex)
+{
+	return cubetex->width;
+}
+
+enum gs_color_format gs_cubetexture_get_color_format(const gs_texture_t *cubetex)
+{
+	return cubetex->format;
+}
+
+void gs_voltexture_destroy(gs_texture_t *voltex)
+{
+	null_texture_destroy(voltex);
+}
+
+uint32_t gs_voltexture_get_width(const gs_texture_t *voltex)
+{
+	return voltex->width;
+}
+
+uint32_t gs_voltexture_get_height(const gs_texture_t *voltex)
+{
+	return voltex->height;
+}
+
+uint32_t gs_voltexture_get_depth(const gs_texture_t *voltex)
+{
+	return voltex->layers;
+}
+
+enum gs_color_format gs_voltexture_get_color_format(const gs_texture_t *voltex)
+{
+	return voltex->format;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void device_copy_texture_region(gs_device_t *device, gs_texture_t *dst, uint32_t dst_x, uint32_t dst_y,
+				gs_texture_t *src, uint32_t src_x, uint32_t src_y, uint32_t src_w, uint32_t src_h)
+{
+	uint32_t pixel_size;
+
+	if (!src || !dst) {
+		blog(LOG_ERROR, "device_copy_texture (null): Source or destination is NULL");
+		return;
+	}
+	if (src->type != GS_TEXTURE_2D || dst->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_copy_texture (null): Source and destination must be 2D textures");
+		return;
+	}
+	if (src->format != dst->format || gs_is_compressed_format(src->format)) {
+		blog(LOG_ERROR, "device_copy_texture (null): Source and destination formats do not match");
+		return;
+	}
+
+	if (!src_w)
+		src_w = src->width - src_x;
+	if (!src_h)
+		src_h = src->height - src_y;
+
+	if (src_x + src_w > src->width || src_y + src_h > src->height || dst_x + src_w > dst->width ||
+	    dst_y + src_h > dst->height) {
+		blog(LOG_ERROR, "device_copy_texture (null): Region is out of bounds");
+		return;
+	}
+
+	device->stats.copies++;
+
+	/* nothing written to the source yet, it reads as zero */
+	if (!src->data && !dst->data)
+		return;
+
+	pixel_size = gs_get_format_bpp(src->format) / 8;
+
+	const uint8_t *src_data = null_texture_get_data(src);
+	uint8_t *dst_data = null_texture_get_data(dst);
+
+	for (uint32_t y = 0; y < src_h; y++)
+		memmove(dst_data + (dst_y + y) * dst->linesize + dst_x * pixel_size,
+			src_data + (src_y + y) * src->linesize + src_x * pixel_size, src_w * pixel_size);
+}
+
+void device_copy_texture(gs_device_t *device, gs_texture_t *dst, gs_texture_t *src)
+{
+	device_copy_texture_region(device, dst, 0, 0, src, 0, 0, 0, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_stagesurf_t *device_stagesurface_create(gs_device_t *device, uint32_t width, uint32_t height,
+					   enum gs_color_format color_format)
+{
+	struct gs_stage_surface *surf;
+	uint32_t bpp = gs_get_format_bpp(color_format);
+
+	if (!bpp || gs_is_compressed_format(color_format) || !width || !height) {
+		blog(LOG_ERROR, "device_stagesurface_create (null): Invalid surface");
+		return NULL;
+	}
+
+	surf = bzalloc(sizeof(struct gs_stage_surface));
+	surf->device = device;
+	surf->format = color_format;
+	surf->width = width;
+	surf->height = height;
+	surf->linesize = width * bpp / 8;
+	surf->data = bzalloc((size_t)surf->linesize * height);
+
+	device->stats.live[NULL_RESOURCE_STAGESURF]++;
+	return surf;
+}
+
+void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf)
+{
+	if (!stagesurf)
+		return;
+
+	stagesurf->device->stats.live[NULL_RESOURCE_STAGESURF]--;
+	bfree(stagesurf->data);
+	bfree(stagesurf);
+}
+
+uint32_t gs_stagesurface_get_width(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->width;
+}
+
+uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->height;
+}
+
+enum gs_color_format gs_stagesurface_get_color_format(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->format;
+}
+
+bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data, uint32_t *linesize)
+{
+	if (stagesurf->is_mapped) {
+		blog(LOG_ERROR, "gs_stagesurface_map (null): Surface is already mapped");
+		return false;
+	}
+
+	stagesurf->is_mapped = true;
+	*data = stagesurf->data;
+	*linesize = stagesurf->linesize;
+	return true;
+}
+
+void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
+{
+	if (!stagesurf->is_mapped)
+		blog(LOG_WARNING, "gs_stagesurface_unmap (null): Surface is not mapped");
+
+	stagesurf->is_mapped = false;
+}
+
+void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst, gs_texture_t *src)
+{
+	if (!src || src->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_stage_texture (null): Source texture must be 2D");
+		return;
+	}
+	if (src->format != dst->format || src->width != dst->width || src->height != dst->height) {
+		blog(LOG_ERROR, "device_stage_texture (null): Source and destination do not match");
+		return;
+	}
+	if (dst->is_mapped) {
+		blog(LOG_ERROR, "device_stage_texture (null): Destination is mapped");
+		return;
+	}
+
+	device->stats.stages++;
+
+	if (!src->data) {
+		memset(dst->data, 0, (size_t)dst->linesize * dst->height);
+		return;
+	}
+
+	for (uint32_t y = 0; y < dst->height; y++)
+		memcpy(dst->data + y * dst->linesize, src->data + y * src->linesize, dst->linesize);
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_zstencil_t *device_zstencil_create(gs_device_t *device, uint32_t width, uint32_t height,
+				      enum gs_zstencil_format format)
+{
+	struct gs_zstencil_buffer *zs = bzalloc(sizeof(struct gs_zstencil_buffer));
+
+	zs->device = device;
+	zs->format = format;
+	zs->width = width;
+	zs->height = height;
+
+	device->stats.live[NULL_RESOURCE_ZSTENCIL]++;
+	return zs;
+}
+
+void gs_zstencil_destroy(gs_zstencil_t *zstencil)
+{
+	if (!zstencil)
+		return;
+
+	if (zstencil->device->cur_zstencil_buffer == zstencil)
+		zstencil->device->cur_zstencil_buffer = NULL;
+
+	zstencil->device->stats.live[NULL_RESOURCE_ZSTENCIL]--;
+	bfree(zstencil);
+}
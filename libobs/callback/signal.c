@@ -15,7 +15,9 @@
  */
 
 #include "../util/darray.h"
+#include "../util/platform.h"
 #include "../util/threading.h"
+#include "../util/uthash.h"
 
 #include "decl.h"
 #include "signal.h"
@@ -23,31 +25,79 @@
 struct signal_callback {
 	signal_callback_t callback;
 	void *data;
-	bool remove;
 	bool keep_ref;
+
+	/* set when disconnected, emissions that still see the callback skip
+	 * it */
+	volatile bool remove;
+};
+
+/* Connected callbacks, never modified once published. Connecting and
+ * disconnecting publishes a copy and retires the old array, which is freed
+ * once no emission can still be reading it. */
+struct callback_array {
+	/* emissions currently reading the array */
+	volatile long readers;
+	/* readers whose thread is waiting in a disconnect */
+	volatile long blocked;
+	/* disconnects waiting for the readers of the retired array */
+	volatile long holds;
+	size_t num;
+	struct signal_callback **callbacks;
 };
 
 struct signal_info {
 	struct decl_info func;
-	DARRAY(struct signal_callback) callbacks;
+	struct signal_handler *handler;
+
+	struct callback_array *volatile callbacks;
+	/* emissions between getting the array and counting themselves as
+	 * readers of it */
+	volatile long emitting;
+
+	/* guards writers, the retired lists and the waiters */
 	pthread_mutex_t mutex;
-	bool signalling;
+	DARRAY(struct callback_array *) retired_arrays;
+	DARRAY(struct signal_callback *) retired_callbacks;
+	volatile bool has_retired;
 
-	struct signal_info *next;
+	/* events of disconnects waiting for the readers of retired arrays,
+	 * signaled whenever a reader finishes or becomes blocked */
+	DARRAY(os_event_t *) waiters;
+	volatile long waiting;
+
+	UT_hash_handle hh;
 };
 
-static inline struct signal_info *signal_info_create(struct decl_info *info)
+static inline struct callback_array *callback_array_create(size_t num)
+{
+	struct callback_array *array =
+		bmalloc(sizeof(struct callback_array) + sizeof(struct signal_callback *) * num);
+	array->readers = 0;
+	array->blocked = 0;
+	array->holds = 0;
+	array->num = num;
+	array->callbacks = (struct signal_callback **)(array + 1);
+	return array;
+}
+
+static inline struct callback_array *get_callbacks(struct signal_info *si)
+{
+	return os_atomic_load_ptr((void *const volatile *)&si->callbacks);
+}
+
+static inline struct signal_info *signal_info_create(struct signal_handler *handler, struct decl_info *info)
 {
-	struct signal_info *si = bmalloc(sizeof(struct signal_info));
+	struct signal_info *si = bzalloc(sizeof(struct signal_info));
 	si->func = *info;
-	si->next = NULL;
-	si->signalling = false;
-	da_init(si->callbacks);
+	si->handler = handler;
+	si->callbacks = callback_array_create(0);
 
-	if (pthread_mutex_init_recursive(&si->mutex) != 0) {
+	if (pthread_mutex_init(&si->mutex, NULL) != 0) {
 		blog(LOG_ERROR, "Could not create signal");
 
 		decl_info_free(&si->func);
+		bfree(si->callbacks);
 		bfree(si);
 		return NULL;
 	}
@@ -55,26 +105,96 @@ static inline struct signal_info *signal_info_create(struct decl_info *info)
 	return si;
 }
 
+/* Called with the signal mutex held. Once no emission is about to become a
+ * reader, retired arrays without readers or holds can no longer be
+ * referenced.
+ * Disconnected callbacks are freed once no retired array is left. */
+static void signal_info_free_retired(struct signal_info *si)
+{
+	if (!si->has_retired || os_atomic_load_long(&si->emitting) != 0)
+		return;
+
+	for (size_t i = si->retired_arrays.num; i > 0; i--) {
+		struct callback_array *array = si->retired_arrays.array[i - 1];
+
+		if (os_atomic_load_long(&array->readers) == 0 && os_atomic_load_long(&array->holds) == 0) {
+			bfree(array);
+			da_erase(si->retired_arrays, i - 1);
+		}
+	}
+
+	if (si->retired_arrays.num)
+		return;
+
+	for (size_t i = 0; i < si->retired_callbacks.num; i++)
+		bfree(si->retired_callbacks.array[i]);
+
+	da_resize(si->retired_callbacks, 0);
+	os_atomic_set_bool(&si->has_retired, false);
+}
+
 static inline void signal_info_destroy(struct signal_info *si)
 {
 	if (si) {
+		struct callback_array *callbacks = si->callbacks;
+
+		for (size_t i = 0; i < callbacks->num; i++)
+			bfree(callbacks->callbacks[i]);
+		bfree(callbacks);
+
+		for (size_t i = 0; i < si->retired_arrays.num; i++)
+			bfree(si->retired_arrays.array[i]);
+		for (size_t i = 0; i < si->retired_callbacks.num; i++)
+			bfree(si->retired_callbacks.array[i]);
+		da_free(si->retired_arrays);
+		da_free(si->retired_callbacks);
+		da_free(si->waiters);
+
 		pthread_mutex_destroy(&si->mutex);
 		decl_info_free(&si->func);
-		da_free(si->callbacks);
 		bfree(si);
 	}
 }
 
-static inline size_t signal_get_callback_idx(struct signal_info *si, signal_callback_t callback, void *data)
+/* Called with the signal mutex held */
+static void signal_info_publish(struct signal_info *si, struct callback_array *callbacks)
 {
-	for (size_t i = 0; i < si->callbacks.num; i++) {
-		struct signal_callback *sc = si->callbacks.array + i;
+	struct callback_array *old = os_atomic_exchange_ptr((void *volatile *)&si->callbacks, callbacks);
+
+	da_push_back(si->retired_arrays, &old);
+	os_atomic_set_bool(&si->has_retired, true);
+}
+
+static inline struct signal_callback *signal_find_callback(struct signal_info *si, signal_callback_t callback,
+							   void *data)
+{
+	struct callback_array *callbacks = get_callbacks(si);
+
+	for (size_t i = 0; i < callbacks->num; i++) {
+		struct signal_callback *sc = callbacks->callbacks[i];
 
 		if (sc->callback == callback && sc->data == data)
-			return i;
+			return sc;
 	}
 
-	return DARRAY_INVALID;
+	return NULL;
+}
+
+/* Called with the signal mutex held */
+static void signal_info_remove(struct signal_info *si, struct signal_callback *sc)
+{
+	struct callback_array *old = get_callbacks(si);
+	struct callback_array *callbacks = callback_array_create(old->num - 1);
+	size_t num = 0;
+
+	for (size_t i = 0; i < old->num; i++) {
+		if (old->callbacks[i] != sc)
+			callbacks->callbacks[num++] = old->callbacks[i];
+	}
+
+	os_atomic_set_bool(&sc->remove, true);
+	signal_info_publish(si, callbacks);
+	da_push_back(si->retired_callbacks, &sc);
 }
 
 struct global_callback_info {
@@ -84,30 +204,30 @@ struct global_callback_info {
 	bool remove;
 };
 
+/* Must be a power of two */
+#define SIGNAL_NAME_CACHE_SIZE 32
+
 struct signal_handler {
-	struct signal_info *first;
+	struct signal_info *signals;
 	pthread_mutex_t mutex;
 	volatile long refs;
 
+	/* Signals looked up by name, indexed by the address of the name.
+	 * Names are mostly string literals, so repeated lookups of a name hit
+	 * the same entry and skip the mutex and the hash table.  Signals are
+	 * never removed before the handler is destroyed. */
+	struct signal_info *volatile name_cache[SIGNAL_NAME_CACHE_SIZE];
+
 	DARRAY(struct global_callback_info) global_callbacks;
 	pthread_mutex_t global_callbacks_mutex;
+	volatile bool has_global_callbacks;
 };
 
-static struct signal_info *getsignal(signal_handler_t *handler, const char *name, struct signal_info **p_last)
+static inline struct signal_info *getsignal(signal_handler_t *handler, const char *name)
 {
-	struct signal_info *signal, *last = NULL;
-
-	signal = handler->first;
-	while (signal != NULL) {
-		if (strcmp(signal->func.name, name) == 0)
-			break;
-
-		last = signal;
-		signal = signal->next;
-	}
+	struct signal_info *signal;
 
-	if (p_last)
-		*p_last = last;
+	HASH_FIND_STR(handler->signals, name, signal);
 	return signal;
 }
 
@@ -116,7 +236,7 @@ static struct signal_info *getsignal(signal_handler_t *handler, const char *name
 signal_handler_t *signal_handler_create(void)
 {
 	struct signal_handler *handler = bzalloc(sizeof(struct signal_handler));
-	handler->first = NULL;
+	handler->signals = NULL;
 	handler->refs = 1;
 
 	if (pthread_mutex_init(&handler->mutex, NULL) != 0) {
@@ -137,11 +257,11 @@ signal_handler_t *signal_handler_create(void)
 
 static void signal_handler_actually_destroy(signal_handler_t *handler)
 {
-	struct signal_info *sig = handler->first;
-	while (sig != NULL) {
-		struct signal_info *next = sig->next;
+	struct signal_info *sig, *tmp;
+
+	HASH_ITER (hh, handler->signals, sig, tmp) {
+		HASH_DEL(handler->signals, sig);
 		signal_info_destroy(sig);
-		sig = next;
 	}
 
 	da_free(handler->global_callbacks);
@@ -160,7 +280,7 @@ void signal_handler_destroy(signal_handler_t *handler)
 bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 {
 	struct decl_info func = {0};
-	struct signal_info *sig, *last;
+	struct signal_info *sig;
 	bool success = true;
 
 	if (!parse_decl_string(&func, signal_decl)) {
@@ -170,17 +290,17 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 
 	pthread_mutex_lock(&handler->mutex);
 
-	sig = getsignal(handler, func.name, &last);
+	sig = getsignal(handler, func.name);
 	if (sig) {
 		blog(LOG_WARNING, "Signal declaration '%s' exists", func.name);
 		decl_info_free(&func);
 		success = false;
 	} else {
-		sig = signal_info_create(&func);
-		if (!last)
-			handler->first = sig;
+		sig = signal_info_create(handler, &func);
+		if (sig)
+			HASH_ADD_KEYPTR(hh, handler->signals, sig->func.name, strlen(sig->func.name), sig);
 		else
-			last->next = sig;
+			success = false;
 	}
 
 	pthread_mutex_unlock(&handler->mutex);
@@ -188,20 +308,49 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 	return success;
 }
 
-static void signal_handler_connect_internal(signal_handler_t *handler, const char *signal, signal_callback_t callback,
-					    void *data, bool keep_ref)
+static inline size_t name_cache_idx(const char *name)
 {
-	struct signal_info *sig, *last;
-	struct signal_callback cb_data = {callback, data, false, keep_ref};
+	uint64_t hash = (uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ULL;
+	return (size_t)(hash >> 32) & (SIGNAL_NAME_CACHE_SIZE - 1);
+}
+
+static inline struct signal_info *getsignal_locked(signal_handler_t *handler, const char *name)
+{
+	struct signal_info *sig;
 	size_t idx;
 
 	if (!handler)
-		return;
+		return NULL;
+
+	idx = name_cache_idx(name);
+	sig = os_atomic_load_ptr((void *const volatile *)&handler->name_cache[idx]);
+	if (sig && strcmp(sig->func.name, name) == 0)
+		return sig;
 
 	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, signal, &last);
+	sig = getsignal(handler, name);
 	pthread_mutex_unlock(&handler->mutex);
 
+	if (sig)
+		os_atomic_store_ptr((void *volatile *)&handler->name_cache[idx], sig);
+
+	return sig;
+}
+
+signal_t *signal_handler_get_signal(signal_handler_t *handler, const char *signal)
+{
+	return getsignal_locked(handler, signal);
+}
+
+static void signal_handler_connect_internal(signal_handler_t *handler, const char *signal, signal_callback_t callback,
+					    void *data, bool keep_ref)
+{
+	struct signal_info *sig;
+
+	if (!handler)
+		return;
+
+	sig = getsignal_locked(handler, signal);
 	if (!sig) {
 		blog(LOG_WARNING,
 		     "signal_handler_connect: "
@@ -217,9 +366,21 @@ static void signal_handler_connect_internal(signal_handler_t *handler, const cha
 	if (keep_ref)
 		os_atomic_inc_long(&handler->refs);
 
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (keep_ref || idx == DARRAY_INVALID)
-		da_push_back(sig->callbacks, &cb_data);
+	if (keep_ref || !signal_find_callback(sig, callback, data)) {
+		struct callback_array *old = get_callbacks(sig);
+		struct callback_array *callbacks = callback_array_create(old->num + 1);
+		struct signal_callback *sc = bzalloc(sizeof(struct signal_callback));
+
+		sc->callback = callback;
+		sc->data = data;
+		sc->keep_ref = keep_ref;
+
+		memcpy(callbacks->callbacks, old->callbacks, sizeof(struct signal_callback *) * old->num);
+		callbacks->callbacks[old->num] = sc;
+
+		signal_info_publish(sig, callbacks);
+		signal_info_free_retired(sig);
+	}
 
 	pthread_mutex_unlock(&sig->mutex);
 }
@@ -234,120 +395,246 @@ void signal_handler_connect_ref(signal_handler_t *handler, const char *signal, s
 	signal_handler_connect_internal(handler, signal, callback, data, true);
 }
 
-static inline struct signal_info *getsignal_locked(signal_handler_t *handler, const char *name)
-{
+/* Emissions currently calling callbacks on this thread */
+struct signal_emit_frame {
 	struct signal_info *sig;
+	struct callback_array *callbacks;
+	bool remove;
+	struct signal_emit_frame *prev;
+};
 
-	if (!handler)
-		return NULL;
+static THREAD_LOCAL struct signal_emit_frame *current_signal_frame = NULL;
+static THREAD_LOCAL struct global_callback_info *current_global_cb = NULL;
 
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, name, NULL);
-	pthread_mutex_unlock(&handler->mutex);
+static void signal_info_wake_waiters(struct signal_info *sig)
+{
+	if (!os_atomic_load_long(&sig->waiting))
+		return;
 
-	return sig;
+	pthread_mutex_lock(&sig->mutex);
+	for (size_t i = 0; i < sig->waiters.num; i++)
+		os_event_signal(sig->waiters.array[i]);
+	pthread_mutex_unlock(&sig->mutex);
+}
+
+static inline void set_frames_blocked(bool blocked)
+{
+	for (struct signal_emit_frame *frame = current_signal_frame; frame; frame = frame->prev) {
+		if (blocked) {
+			os_atomic_inc_long(&frame->callbacks->blocked);
+			signal_info_wake_waiters(frame->sig);
+		} else {
+			os_atomic_dec_long(&frame->callbacks->blocked);
+		}
+	}
+}
+
+static inline void signal_info_try_free_retired(struct signal_info *sig)
+{
+	if (os_atomic_load_bool(&sig->has_retired) && pthread_mutex_trylock(&sig->mutex) == 0) {
+		signal_info_free_retired(sig);
+		pthread_mutex_unlock(&sig->mutex);
+	}
+}
+
+static inline void signal_info_end_read(struct signal_info *sig, struct callback_array *callbacks)
+{
+	long readers = os_atomic_dec_long(&callbacks->readers);
+
+	signal_info_wake_waiters(sig);
+	if (readers == 0)
+		signal_info_try_free_retired(sig);
+}
+
+static inline void signal_info_end_hold(struct signal_info *sig, struct callback_array *callbacks)
+{
+	if (os_atomic_dec_long(&callbacks->holds) == 0)
+		signal_info_try_free_retired(sig);
+}
+
+/* Only readers that are not blocked in a disconnect count */
+static bool readers_done(struct callback_array *const *arrays, size_t num)
+{
+	for (size_t i = 0; i < num; i++) {
+		if (os_atomic_load_long(&arrays[i]->readers) > os_atomic_load_long(&arrays[i]->blocked))
+			return false;
+	}
+
+	return true;
+}
+
+static void wait_for_readers(struct signal_info *sig, struct callback_array *const *arrays, size_t num)
+{
+	os_event_t *event;
+
+	if (readers_done(arrays, num))
+		return;
+
+	if (os_event_init(&event, OS_EVENT_TYPE_AUTO) != 0) {
+		blog(LOG_ERROR, "signal_handler_disconnect: Could not create event");
+		while (!readers_done(arrays, num))
+			os_sleep_ms(1);
+		return;
+	}
+
+	pthread_mutex_lock(&sig->mutex);
+	da_push_back(sig->waiters, &event);
+	os_atomic_inc_long(&sig->waiting);
+	pthread_mutex_unlock(&sig->mutex);
+
+	/* readers signal the event after they finished, so a reader that
+	 * finishes after the check below always wakes this wait */
+	while (!readers_done(arrays, num))
+		os_event_wait(event);
+
+	pthread_mutex_lock(&sig->mutex);
+	da_erase_item(sig->waiters, &event);
+	os_atomic_dec_long(&sig->waiting);
+	pthread_mutex_unlock(&sig->mutex);
+
+	os_event_destroy(event);
 }
 
 void signal_handler_disconnect(signal_handler_t *handler, const char *signal, signal_callback_t callback, void *data)
 {
 	struct signal_info *sig = getsignal_locked(handler, signal);
+	DARRAY(struct callback_array *) retired;
+	struct signal_callback *sc;
 	bool keep_ref = false;
-	size_t idx;
 
 	if (!sig)
 		return;
 
+	da_init(retired);
 	pthread_mutex_lock(&sig->mutex);
 
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (idx != DARRAY_INVALID) {
-		if (sig->signalling) {
-			sig->callbacks.array[idx].remove = true;
-		} else {
-			keep_ref = sig->callbacks.array[idx].keep_ref;
-			da_erase(sig->callbacks, idx);
-		}
+	sc = signal_find_callback(sig, callback, data);
+	if (sc) {
+		keep_ref = sc->keep_ref;
+		signal_info_remove(sig, sc);
+
+		/* holding the retired arrays keeps them from being freed
+		 * while waiting */
+		da_copy(retired, sig->retired_arrays);
+		for (size_t i = 0; i < retired.num; i++)
+			os_atomic_inc_long(&retired.array[i]->holds);
 	}
 
 	pthread_mutex_unlock(&sig->mutex);
 
+	if (!sc)
+		return;
+
+	/* Once disconnected, the callback is no longer called by emissions
+	 * that start later, so only the readers of the retired arrays are
+	 * waited for. Emissions on this thread are not waited for, and
+	 * neither are emissions on threads that are themselves waiting in a
+	 * disconnect, as those would in turn wait for this one. */
+	set_frames_blocked(true);
+	wait_for_readers(sig, retired.array, retired.num);
+	set_frames_blocked(false);
+
+	for (size_t i = 0; i < retired.num; i++)
+		signal_info_end_hold(sig, retired.array[i]);
+	da_free(retired);
+
 	if (keep_ref && os_atomic_dec_long(&handler->refs) == 0) {
 		signal_handler_actually_destroy(handler);
 	}
 }
 
-static THREAD_LOCAL struct signal_callback *current_signal_cb = NULL;
-static THREAD_LOCAL struct global_callback_info *current_global_cb = NULL;
-
 void signal_handler_remove_current(void)
 {
-	if (current_signal_cb)
-		current_signal_cb->remove = true;
+	if (current_signal_frame)
+		current_signal_frame->remove = true;
 	else if (current_global_cb)
 		current_global_cb->remove = true;
 }
 
-void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+static void signal_global_callbacks(signal_handler_t *handler, const char *signal, calldata_t *params)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
-	long remove_refs = 0;
-
-	if (!sig)
-		return;
+	pthread_mutex_lock(&handler->global_callbacks_mutex);
 
-	pthread_mutex_lock(&sig->mutex);
-	sig->signalling = true;
+	for (size_t i = 0; i < handler->global_callbacks.num; i++) {
+		struct global_callback_info *cb = handler->global_callbacks.array + i;
 
-	for (size_t i = 0; i < sig->callbacks.num; i++) {
-		struct signal_callback *cb = sig->callbacks.array + i;
 		if (!cb->remove) {
-			current_signal_cb = cb;
-			cb->callback(cb->data, params);
-			current_signal_cb = NULL;
+			cb->signaling++;
+			current_global_cb = cb;
+			cb->callback(cb->data, signal, params);
+			current_global_cb = NULL;
+			cb->signaling--;
 		}
 	}
 
-	for (size_t i = sig->callbacks.num; i > 0; i--) {
-		struct signal_callback *cb = sig->callbacks.array + i - 1;
-		if (cb->remove) {
-			if (cb->keep_ref)
-				remove_refs++;
+	for (size_t i = handler->global_callbacks.num; i > 0; i--) {
+		struct global_callback_info *cb = handler->global_callbacks.array + (i - 1);
 
-			da_erase(sig->callbacks, i - 1);
-		}
+		if (cb->remove && !cb->signaling)
+			da_erase(handler->global_callbacks, i - 1);
 	}
 
-	sig->signalling = false;
-	pthread_mutex_unlock(&sig->mutex);
+	os_atomic_set_bool(&handler->has_global_callbacks, handler->global_callbacks.num != 0);
 
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
+	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+}
 
-	if (handler->global_callbacks.num) {
-		for (size_t i = 0; i < handler->global_callbacks.num; i++) {
-			struct global_callback_info *cb = handler->global_callbacks.array + i;
+void signal_emit(signal_t *sig, calldata_t *params)
+{
+	struct signal_emit_frame frame;
+	struct callback_array *callbacks;
+	signal_handler_t *handler;
+	long remove_refs = 0;
 
-			if (!cb->remove) {
-				cb->signaling++;
-				current_global_cb = cb;
-				cb->callback(cb->data, signal, params);
-				current_global_cb = NULL;
-				cb->signaling--;
-			}
-		}
+	if (!sig)
+		return;
+
+	handler = sig->handler;
+
+	os_atomic_inc_long(&sig->emitting);
+	callbacks = get_callbacks(sig);
+	os_atomic_inc_long(&callbacks->readers);
+	os_atomic_dec_long(&sig->emitting);
+
+	frame.sig = sig;
+	frame.callbacks = callbacks;
+	frame.prev = current_signal_frame;
+
+	for (size_t i = 0; i < callbacks->num; i++) {
+		struct signal_callback *sc = callbacks->callbacks[i];
+
+		if (os_atomic_load_bool(&sc->remove))
+			continue;
 
-		for (size_t i = handler->global_callbacks.num; i > 0; i--) {
-			struct global_callback_info *cb = handler->global_callbacks.array + (i - 1);
+		frame.remove = false;
 
-			if (cb->remove && !cb->signaling)
-				da_erase(handler->global_callbacks, i - 1);
+		current_signal_frame = &frame;
+		sc->callback(sc->data, params);
+		current_signal_frame = frame.prev;
+
+		if (frame.remove) {
+			pthread_mutex_lock(&sig->mutex);
+			if (!os_atomic_load_bool(&sc->remove)) {
+				if (sc->keep_ref)
+					remove_refs++;
+				signal_info_remove(sig, sc);
+			}
+			pthread_mutex_unlock(&sig->mutex);
 		}
 	}
 
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	signal_info_end_read(sig, callbacks);
 
-	if (remove_refs) {
-		os_atomic_set_long(&handler->refs, os_atomic_load_long(&handler->refs) - remove_refs);
-	}
+	if (os_atomic_load_bool(&handler->has_global_callbacks))
+		signal_global_callbacks(handler, sig->func.name, params);
+
+	while (remove_refs--)
+		os_atomic_dec_long(&handler->refs);
+}
+
+void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+{
+	signal_emit(getsignal_locked(handler, signal), params);
 }
 
 void signal_handler_connect_global(signal_handler_t *handler, global_signal_callback_t callback, void *data)
@@ -364,6 +651,8 @@ void signal_handler_connect_global(signal_handler_t *handler, global_signal_call
 	if (idx == DARRAY_INVALID)
 		da_push_back(handler->global_callbacks, &cb_data);
 
+	os_atomic_set_bool(&handler->has_global_callbacks, true);
+
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 }
 
@@ -32,7 +32,9 @@ extern "C" {
  */
 
 struct signal_handler;
+struct signal_info;
 typedef struct signal_handler signal_handler_t;
+typedef struct signal_info signal_t;
 typedef void (*global_signal_callback_t)(void *, const char *, calldata_t *);
 typedef void (*signal_callback_t)(void *, calldata_t *);
 
@@ -68,6 +70,11 @@ EXPORT void signal_handler_remove_current(void);
 
 EXPORT void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params);
 
+/* Looks up a signal once so that it can be emitted without being looked up by
+ * name every time. The signal is valid for as long as the handler is. */
+EXPORT signal_t *signal_handler_get_signal(signal_handler_t *handler, const char *signal);
+EXPORT void signal_emit(signal_t *signal, calldata_t *params);
+
 #ifdef __cplusplus
 }
 #endif
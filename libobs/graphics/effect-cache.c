@@ -0,0 +1,488 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <inttypes.h>
+
+#include "../util/platform.h"
+#include "../util/file-serializer.h"
+#include "effect-cache.h"
+#include "effect.h"
+
+/* Increment if the on-disk format changes */
+#define EFFECT_CACHE_VERSION 1
+#define EFFECT_CACHE_MAGIC 0x4346454FU /* "OEFC" */
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+extern const char *gs_preprocessor_name(void);
+
+static uint64_t fnv1a_hash(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (uint64_t)bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/* hashes the null terminator too, so consecutive strings cannot run together */
+static inline uint64_t hash_string(uint64_t hash, const char *str)
+{
+	return fnv1a_hash(hash, str, strlen(str) + 1);
+}
+
+/* includes are resolved relative to the effect, so the file name is part of
+ * the key as well */
+static uint64_t get_file_key(const char *file)
+{
+	const char *backend = gs_preprocessor_name();
+	uint64_t hash = FNV_OFFSET;
+
+	hash = hash_string(hash, backend ? backend : "");
+	return hash_string(hash, file);
+}
+
+static bool hash_file(const char *path, uint64_t *hash)
+{
+	char *str = os_quick_read_utf8_file(path);
+	if (!str)
+		return false;
+
+	*hash = fnv1a_hash(FNV_OFFSET, str, strlen(str));
+	bfree(str);
+	return true;
+}
+
+/* entry names start with the file key, so the entries of older versions of an
+ * effect can be found and removed */
+static inline void get_cache_file(struct dstr *path, const char *cache_path, const char *effect_string,
+				  const char *file)
+{
+	uint64_t file_key = get_file_key(file);
+	uint64_t text_key = hash_string(file_key, effect_string);
+
+	dstr_printf(path, "%s/%016" PRIx64 "-%016" PRIx64 ".v%d", cache_path, file_key, text_key,
+		    EFFECT_CACHE_VERSION);
+}
+
+/* ------------------------------------------------------------------------- */
+/* reading, all values are little endian */
+
+struct cache_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	bool error;
+};
+
+static inline bool reader_check(struct cache_reader *r, size_t size)
+{
+	if (r->error || (size_t)(r->end - r->pos) < size)
+		r->error = true;
+	return !r->error;
+}
+
+static uint32_t read_u32(struct cache_reader *r)
+{
+	uint32_t val = 0;
+
+	if (reader_check(r, sizeof(val))) {
+		for (size_t i = 0; i < sizeof(val); i++)
+			val |= (uint32_t)r->pos[i] << (i * 8);
+		r->pos += sizeof(val);
+	}
+
+	return val;
+}
+
+static uint64_t read_u64(struct cache_reader *r)
+{
+	uint64_t low = read_u32(r);
+	uint64_t high = read_u32(r);
+	return low | (high << 32);
+}
+
+/* counts are checked against the remaining size so a damaged entry cannot
+ * cause huge allocations */
+static size_t read_count(struct cache_reader *r)
+{
+	size_t count = read_u32(r);
+
+	if (count > (size_t)(r->end - r->pos) / sizeof(uint32_t))
+		r->error = true;
+	return r->error ? 0 : count;
+}
+
+static const uint8_t *read_data(struct cache_reader *r, size_t *size)
+{
+	const uint8_t *data;
+
+	*size = read_u32(r);
+	data = r->pos;
+
+	if (!reader_check(r, *size))
+		return NULL;
+
+	r->pos += *size;
+	return data;
+}
+
+/* strings are stored with their null terminator so they can be used in place
+ * from the mapped file, an empty entry is a NULL string */
+static const char *read_string(struct cache_reader *r)
+{
+	size_t size;
+	const char *str = (const char *)read_data(r, &size);
+
+	if (!str || !size)
+		return NULL;
+
+	if (str[size - 1] != 0) {
+		r->error = true;
+		return NULL;
+	}
+
+	return str;
+}
+
+static bool check_dependencies(struct cache_reader *r, const char *file)
+{
+	size_t num = read_count(r);
+
+	for (size_t i = 0; i < num; i++) {
+		const char *path = read_string(r);
+		uint64_t hash = read_u64(r);
+		uint64_t cur_hash;
+
+		if (r->error || !path)
+			return false;
+
+		if (!hash_file(path, &cur_hash) || cur_hash != hash) {
+			blog(LOG_DEBUG, "Effect cache entry for '%s' is out of date, '%s' changed", file, path);
+			return false;
+		}
+	}
+
+	return !r->error;
+}
+
+static bool read_param(struct cache_reader *r, gs_effect_t *effect, struct gs_effect_param *param,
+		       enum effect_section section)
+{
+	const char *name = read_string(r);
+	uint32_t type = read_u32(r);
+	const uint8_t *default_val;
+	size_t size;
+
+	default_val = read_data(r, &size);
+	if (r->error || !name || type > GS_SHADER_PARAM_TEXTURE) {
+		r->error = true;
+		return false;
+	}
+
+	param->name = bstrdup(name);
+	param->section = section;
+	param->effect = effect;
+	param->type = (enum gs_shader_param_type)type;
+
+	if (size)
+		da_copy_array(param->default_val, default_val, size);
+
+	return true;
+}
+
+static bool read_params(struct cache_reader *r, gs_effect_t *effect)
+{
+	da_resize(effect->params, read_count(r));
+
+	for (size_t i = 0; i < effect->params.num; i++) {
+		struct gs_effect_param *param = effect->params.array + i;
+
+		if (!read_param(r, effect, param, EFFECT_PARAM))
+			return false;
+
+		da_resize(param->annotations, read_count(r));
+		for (size_t j = 0; j < param->annotations.num; j++) {
+			if (!read_param(r, effect, param->annotations.array + j, EFFECT_ANNOTATION))
+				return false;
+		}
+
+		if (strcmp(param->name, "ViewProj") == 0)
+			effect->view_proj = param;
+		else if (strcmp(param->name, "World") == 0)
+			effect->world = param;
+	}
+
+	return !r->error;
+}
+
+static bool read_pass_shader(struct cache_reader *r, gs_effect_t *effect, struct gs_effect_pass *pass,
+			     enum gs_shader_type type)
+{
+	const char *location = read_string(r);
+	const char *source = read_string(r);
+	pass_shaderparam_array_t *pass_params;
+	gs_shader_t *shader;
+	char *errors = NULL;
+
+	if (r->error || !source)
+		return false;
+
+	if (type == GS_SHADER_VERTEX) {
+		pass->vertshader = gs_vertexshader_create(source, location, &errors);
+		shader = pass->vertshader;
+		pass_params = &pass->vertshader_params;
+	} else {
+		pass->pixelshader = gs_pixelshader_create(source, location, &errors);
+		shader = pass->pixelshader;
+		pass_params = &pass->pixelshader_params;
+	}
+
+	bfree(errors);
+
+	/* let the effect parser report shader errors */
+	if (!shader)
+		return false;
+
+	da_resize(*pass_params, read_count(r));
+
+	for (size_t i = 0; i < pass_params->num; i++) {
+		struct pass_shaderparam *param = pass_params->array + i;
+		const char *name = read_string(r);
+
+		if (!name)
+			return false;
+
+		param->eparam = gs_effect_get_param_by_name(effect, name);
+		param->sparam = gs_shader_get_param_by_name(shader, name);
+		if (!param->eparam || !param->sparam)
+			return false;
+	}
+
+	return !r->error;
+}
+
+static bool read_techniques(struct cache_reader *r, gs_effect_t *effect)
+{
+	da_resize(effect->techniques, read_count(r));
+
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		struct gs_effect_technique *tech = effect->techniques.array + i;
+		const char *name = read_string(r);
+
+		if (!name)
+			return false;
+
+		tech->name = bstrdup(name);
+		tech->section = EFFECT_TECHNIQUE;
+		tech->effect = effect;
+
+		da_resize(tech->passes, read_count(r));
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			struct gs_effect_pass *pass = tech->passes.array + j;
+
+			pass->name = bstrdup(read_string(r));
+			pass->section = EFFECT_PASS;
+
+			if (!read_pass_shader(r, effect, pass, GS_SHADER_VERTEX))
+				return false;
+			if (!read_pass_shader(r, effect, pass, GS_SHADER_PIXEL))
+				return false;
+		}
+	}
+
+	return !r->error;
+}
+
+static void effect_clear(gs_effect_t *effect)
+{
+	for (size_t i = 0; i < effect->params.num; i++)
+		effect_param_free(effect->params.array + i);
+	for (size_t i = 0; i < effect->techniques.num; i++)
+		effect_technique_free(effect->techniques.array + i);
+
+	da_free(effect->params);
+	da_free(effect->techniques);
+	effect->view_proj = NULL;
+	effect->world = NULL;
+}
+
+bool effect_cache_load(const char *cache_path, gs_effect_t *effect, const char *effect_string, const char *file)
+{
+	struct cache_reader r = {0};
+	struct dstr path = {0};
+	bool success = false;
+	size_t size = 0;
+	void *data;
+
+	if (!cache_path || !file)
+		return false;
+
+	get_cache_file(&path, cache_path, effect_string, file);
+
+	data = os_mmap_file(path.array, &size);
+	if (!data)
+		goto exit;
+
+	r.pos = data;
+	r.end = r.pos + size;
+
+	if (read_u32(&r) != EFFECT_CACHE_MAGIC || read_u32(&r) != EFFECT_CACHE_VERSION)
+		r.error = true;
+
+	success = !r.error && check_dependencies(&r, file) && read_params(&r, effect) && read_techniques(&r, effect);
+	if (!success)
+		effect_clear(effect);
+
+	os_munmap_file(data, size);
+
+	if (r.error) {
+		blog(LOG_WARNING, "Effect cache entry for '%s' is damaged, removing it", file);
+		os_unlink(path.array);
+	}
+
+exit:
+	dstr_free(&path);
+	return success;
+}
+
+/* ------------------------------------------------------------------------- */
+/* writing */
+
+static inline void write_data(struct serializer *s, const void *data, size_t size)
+{
+	s_wl32(s, (uint32_t)size);
+	if (size)
+		s_write(s, data, size);
+}
+
+static inline void write_string(struct serializer *s, const char *str)
+{
+	write_data(s, str, str ? strlen(str) + 1 : 0);
+}
+
+static void write_param(struct serializer *s, const struct gs_effect_param *param)
+{
+	write_string(s, param->name);
+	s_wl32(s, (uint32_t)param->type);
+	write_data(s, param->default_val.array, param->default_val.num);
+}
+
+static void write_shader(struct serializer *s, const struct ep_shader *shader)
+{
+	write_string(s, shader->location);
+	write_string(s, shader->source);
+
+	s_wl32(s, (uint32_t)shader->params.num);
+	for (size_t i = 0; i < shader->params.num; i++)
+		write_string(s, shader->params.array[i]);
+}
+
+/* removes the entries of the same file for other effect text or versions */
+static void remove_stale_entries(const char *cache_path, const char *entry)
+{
+	const char *name = strrchr(entry, '/') + 1;
+	const size_t prefix_len = 17; /* file key and dash */
+	struct dstr path = {0};
+	struct os_dirent *ent;
+	os_dir_t *dir;
+
+	dir = os_opendir(cache_path);
+	if (!dir)
+		return;
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		if (ent->directory || strncmp(ent->d_name, name, prefix_len) != 0 || strcmp(ent->d_name, name) == 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", cache_path, ent->d_name);
+		os_unlink(path.array);
+	}
+
+	os_closedir(dir);
+	dstr_free(&path);
+}
+
+static size_t count_passes(const gs_effect_t *effect)
+{
+	size_t passes = 0;
+
+	for (size_t i = 0; i < effect->techniques.num; i++)
+		passes += effect->techniques.array[i].passes.num;
+
+	return passes;
+}
+
+void effect_cache_save(const char *cache_path, struct effect_parser *ep, const char *effect_string, const char *file)
+{
+	const gs_effect_t *effect = ep->effect;
+	struct cf_preprocessor *pp = &ep->cfp.pp;
+	const struct ep_shader *shader = ep->shaders.array;
+	struct dstr path = {0};
+	struct serializer s;
+
+	if (!cache_path || !file)
+		return;
+
+	/* every pass has a vertex and a pixel shader */
+	if (ep->shaders.num != count_passes(effect) * 2) {
+		blog(LOG_DEBUG, "Effect '%s' is missing pass shaders, not caching it", file);
+		return;
+	}
+
+	get_cache_file(&path, cache_path, effect_string, file);
+	os_mkdirs(cache_path);
+
+	if (!file_output_serializer_init_safe(&s, path.array, "tmp")) {
+		blog(LOG_WARNING, "Could not write effect cache entry '%s'", path.array);
+		dstr_free(&path);
+		return;
+	}
+
+	s_wl32(&s, EFFECT_CACHE_MAGIC);
+	s_wl32(&s, EFFECT_CACHE_VERSION);
+
+	s_wl32(&s, (uint32_t)pp->dependencies.num);
+	for (size_t i = 0; i < pp->dependencies.num; i++) {
+		const char *dep = pp->dependencies.array[i].file;
+		uint64_t hash = 0;
+
+		hash_file(dep, &hash);
+		write_string(&s, dep);
+		s_wl64(&s, hash);
+	}
+
+	s_wl32(&s, (uint32_t)effect->params.num);
+	for (size_t i = 0; i < effect->params.num; i++) {
+		const struct gs_effect_param *param = effect->params.array + i;
+
+		write_param(&s, param);
+
+		s_wl32(&s, (uint32_t)param->annotations.num);
+		for (size_t j = 0; j < param->annotations.num; j++)
+			write_param(&s, param->annotations.array + j);
+	}
+
+	s_wl32(&s, (uint32_t)effect->techniques.num);
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		const struct gs_effect_technique *tech = effect->techniques.array + i;
+
+		write_string(&s, tech->name);
+		s_wl32(&s, (uint32_t)tech->passes.num);
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			write_string(&s, tech->passes.array[j].name);
+			write_shader(&s, shader++);
+			write_shader(&s, shader++);
+		}
+	}
+
+	file_output_serializer_free(&s);
+	remove_stale_entries(cache_path, path.array);
+	dstr_free(&path);
+}
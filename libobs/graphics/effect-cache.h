@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "effect-parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Effect cache
+ *
+ *   Stores the result of parsing an effect (parameters, techniques, passes
+ * and the generated shader text of each pass) in the effect cache directory.
+ * Entries are keyed by a hash of the graphics backend, the effect file name
+ * and the effect text, and record a hash of every included file so edits to
+ * includes invalidate them.  Saving an entry removes the entries of the same
+ * file for other effect text.  Entries are mapped into memory when loading, and
+ * the shaders are created directly from the mapped shader text.
+ */
+
+/* returns false if the effect is not cached, the effect is left empty */
+extern bool effect_cache_load(const char *cache_path, gs_effect_t *effect, const char *effect_string,
+			      const char *file);
+
+/* the parser must have been run with keep_shaders set */
+extern void effect_cache_save(const char *cache_path, struct effect_parser *ep, const char *effect_string,
+			      const char *file);
+
+#ifdef __cplusplus
+}
+#endif
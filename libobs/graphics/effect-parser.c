@@ -68,6 +68,8 @@ void ep_free(struct effect_parser *ep)
 		ep_sampler_free(ep->samplers.array + i);
 	for (i = 0; i < ep->techniques.num; i++)
 		ep_technique_free(ep->techniques.array + i);
+	for (i = 0; i < ep->shaders.num; i++)
+		ep_shader_free(ep->shaders.array + i);
 
 	ep->cur_pass = NULL;
 	cf_parser_free(&ep->cfp);
@@ -76,6 +78,7 @@ void ep_free(struct effect_parser *ep)
 	da_free(ep->funcs);
 	da_free(ep->samplers);
 	da_free(ep->techniques);
+	da_free(ep->shaders);
 }
 
 static inline struct ep_func *ep_getfunc(struct effect_parser *ep, const char *name)
@@ -1864,6 +1867,20 @@ static inline bool ep_compile_pass_shader(struct effect_parser *ep, struct gs_ef
 	else
 		success = false;
 
+	if (success && ep->keep_shaders) {
+		struct ep_shader *eps = da_push_back_new(ep->shaders);
+
+		eps->type = type;
+		eps->location = location.array;
+		eps->source = shader_str.array;
+		for (size_t i = 0; i < used_params.num; i++)
+			da_push_back(eps->params, &used_params.array[i].array);
+
+		dstr_init(&location);
+		dstr_init(&shader_str);
+		da_free(used_params);
+	}
+
 	dstr_free(&location);
 	dstr_array_free(used_params.array, used_params.num);
 	da_free(used_params);
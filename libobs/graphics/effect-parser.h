@@ -248,6 +248,26 @@ static inline void ep_func_free(struct ep_func *epf)
 	da_free(epf->sampler_deps);
 }
 
+/* ------------------------------------------------------------------------- */
+/* generated pass shaders, kept for the effect cache */
+
+struct ep_shader {
+	enum gs_shader_type type;
+	char *location;
+	char *source;
+	DARRAY(char *) params;
+};
+
+static inline void ep_shader_free(struct ep_shader *eps)
+{
+	for (size_t i = 0; i < eps->params.num; i++)
+		bfree(eps->params.array[i]);
+
+	bfree(eps->location);
+	bfree(eps->source);
+	da_free(eps->params);
+}
+
 /* ------------------------------------------------------------------------- */
 
 struct effect_parser {
@@ -259,6 +279,10 @@ struct effect_parser {
 	DARRAY(struct ep_sampler) samplers;
 	DARRAY(struct ep_technique) techniques;
 
+	/* in technique/pass order, only filled if keep_shaders is set */
+	bool keep_shaders;
+	DARRAY(struct ep_shader) shaders;
+
 	/* internal vars */
 	DARRAY(struct cf_lexer) files;
 	cf_token_array_t tokens;
@@ -274,9 +298,11 @@ static inline void ep_init(struct effect_parser *ep)
 	da_init(ep->funcs);
 	da_init(ep->samplers);
 	da_init(ep->techniques);
+	da_init(ep->shaders);
 	da_init(ep->files);
 	da_init(ep->tokens);
 
+	ep->keep_shaders = false;
 	ep->cur_pass = NULL;
 	cf_parser_init(&ep->cfp);
 }
@@ -324,6 +324,7 @@ struct graphics_subsystem {
 
 	pthread_mutex_t effect_mutex;
 	struct gs_effect *first_effect;
+	char *effect_cache_path;
 
 	pthread_mutex_t mutex;
 	volatile long ref;
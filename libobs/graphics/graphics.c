@@ -26,6 +26,7 @@
 #include "quat.h"
 #include "axisang.h"
 #include "effect-parser.h"
+#include "effect-cache.h"
 #include "effect.h"
 
 #ifdef near
@@ -262,6 +263,7 @@ void gs_destroy(graphics_t *graphics)
 
 	pthread_mutex_destroy(&graphics->mutex);
 	pthread_mutex_destroy(&graphics->effect_mutex);
+	bfree(graphics->effect_cache_path);
 	da_free(graphics->matrix_stack);
 	da_free(graphics->viewport_stack);
 	da_free(graphics->blend_state_stack);
@@ -872,7 +874,15 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, c
 	effect->effect_path = bstrdup(filename);
 
 	ep_init(&parser);
-	success = ep_parse(&parser, effect, effect_string, filename);
+	parser.keep_shaders = thread_graphics->effect_cache_path != NULL;
+
+	success = effect_cache_load(thread_graphics->effect_cache_path, effect, effect_string, filename);
+	if (!success) {
+		success = ep_parse(&parser, effect, effect_string, filename);
+		if (success)
+			effect_cache_save(thread_graphics->effect_cache_path, &parser, effect_string, filename);
+	}
+
 	if (!success) {
 		if (error_string)
 			*error_string = error_data_buildstring(&parser.cfp.error_list);
@@ -896,6 +906,15 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, c
 	return effect;
 }
 
+void gs_set_effect_cache_path(const char *path)
+{
+	if (!gs_valid("gs_set_effect_cache_path"))
+		return;
+
+	bfree(thread_graphics->effect_cache_path);
+	thread_graphics->effect_cache_path = path && *path ? bstrdup(path) : NULL;
+}
+
 gs_shader_t *gs_vertexshader_create_from_file(const char *file, char **error_string)
 {
 	if (!gs_valid_p("gs_vertexshader_create_from_file", file))
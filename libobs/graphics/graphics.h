@@ -500,6 +500,7 @@ struct gs_init_data {
 
 #define GS_DEVICE_OPENGL 1
 #define GS_DEVICE_DIRECT3D_11 2
+#define GS_DEVICE_NULL 3
 
 EXPORT const char *gs_get_device_name(void);
 EXPORT const char *gs_get_driver_version(void);
@@ -553,6 +554,9 @@ EXPORT gs_effect_t *gs_get_effect(void);
 EXPORT gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string);
 EXPORT gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, char **error_string);
 
+/** Sets the directory parsed effects are cached in, NULL disables the cache */
+EXPORT void gs_set_effect_cache_path(const char *path);
+
 EXPORT gs_shader_t *gs_vertexshader_create_from_file(const char *file, char **error_string);
 EXPORT gs_shader_t *gs_pixelshader_create_from_file(const char *file, char **error_string);
 
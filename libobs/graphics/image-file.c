@@ -19,6 +19,7 @@
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
+#include "../util/threading.h"
 #include "vec4.h"
 
 #define blog(level, format, ...) blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
@@ -60,6 +61,204 @@ static inline int get_full_decoded_gif_size(gs_image_file_t *image)
 	return image->gif.width * image->gif.height * 4 * image->gif.frame_count;
 }
 
+static inline void premultiply_frame(uint8_t *data, size_t area, enum gs_image_alpha_mode alpha_mode)
+{
+	if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop(data, area);
+	} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop(data, area);
+	}
+}
+
+static inline void copy_frame(uint8_t *dst, const uint8_t *src, size_t area, enum gs_image_alpha_mode alpha_mode)
+{
+	if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop_restrict(dst, src, area);
+	} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop_restrict(dst, src, area);
+	} else {
+		memcpy(dst, src, area * 4);
+	}
+}
+
+/* number of frames a streamed gif decodes ahead */
+#define STREAM_MIN_FRAMES 2
+#define STREAM_MAX_FRAMES 8
+
+struct gs_image_stream {
+	gs_image_file_t *image;
+	enum gs_image_alpha_mode alpha_mode;
+
+	pthread_t thread;
+	os_event_t *wake;
+	volatile bool stop;
+
+	/* frames are numbered in the order the animation shows them, frames
+	 * read_seq to write_seq are decoded and waiting to be shown */
+	pthread_mutex_t mutex;
+	uint8_t *frames;
+	size_t frame_size;
+	size_t num_frames;
+	uint64_t read_seq;
+	uint64_t write_seq;
+	uint64_t wanted_seq;
+
+	/* only used by the graphics thread */
+	uint64_t shown_seq;
+	bool pending;
+};
+
+static void *stream_thread(void *param)
+{
+	struct gs_image_stream *stream = param;
+	gif_animation *gif = &stream->image->gif;
+	const uint64_t count = gif->frame_count;
+	const size_t area = (size_t)gif->width * gif->height;
+
+	os_set_thread_name("image-file: gif stream");
+
+	while (!os_atomic_load_bool(&stream->stop)) {
+		uint64_t seq;
+		bool full, store;
+
+		pthread_mutex_lock(&stream->mutex);
+
+		/* frame 0 doesn't depend on the frames before it, so when the
+		 * wanted frame is a loop or more ahead, skip to its loop */
+		uint64_t loop_start = stream->wanted_seq - stream->wanted_seq % count;
+		if (loop_start > stream->write_seq) {
+			stream->write_seq = loop_start;
+			stream->read_seq = loop_start;
+		}
+
+		seq = stream->write_seq;
+		full = seq - stream->read_seq >= stream->num_frames;
+		store = seq >= stream->wanted_seq;
+		pthread_mutex_unlock(&stream->mutex);
+
+		if (full) {
+			os_event_wait(stream->wake);
+			continue;
+		}
+
+		/* frames are drawn on top of the previous ones, so every frame
+		 * is decoded even if it is too late to be shown */
+		gif_decode_frame(gif, (int)(seq % count));
+
+		if (store) {
+			uint8_t *frame = stream->frames + (seq % stream->num_frames) * stream->frame_size;
+			copy_frame(frame, gif->frame_image, area, stream->alpha_mode);
+		}
+
+		pthread_mutex_lock(&stream->mutex);
+		stream->write_seq = seq + 1;
+		if (!store)
+			stream->read_seq = seq + 1;
+		pthread_mutex_unlock(&stream->mutex);
+	}
+
+	return NULL;
+}
+
+static void gs_image_stream_destroy(struct gs_image_stream *stream)
+{
+	if (!stream)
+		return;
+
+	os_atomic_set_bool(&stream->stop, true);
+	os_event_signal(stream->wake);
+	pthread_join(stream->thread, NULL);
+
+	os_event_destroy(stream->wake);
+	pthread_mutex_destroy(&stream->mutex);
+	bfree(stream->frames);
+	bfree(stream);
+}
+
+/* The decoder thread owns the gif once started, so the first frame is kept in
+ * texture_data for creating the texture. */
+static struct gs_image_stream *gs_image_stream_create(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+						      uint64_t max_mem)
+{
+	struct gs_image_stream *stream = bzalloc(sizeof(struct gs_image_stream));
+	const size_t area = (size_t)image->gif.width * image->gif.height;
+	uint64_t num_frames;
+
+	gif_decode_frame(&image->gif, 0);
+	image->texture_data = bmalloc(area * 4);
+	copy_frame(image->texture_data, image->gif.frame_image, area, alpha_mode);
+
+	stream->image = image;
+	stream->alpha_mode = alpha_mode;
+	stream->frame_size = area * 4;
+
+	num_frames = max_mem / stream->frame_size;
+	if (num_frames < STREAM_MIN_FRAMES)
+		num_frames = STREAM_MIN_FRAMES;
+	else if (num_frames > STREAM_MAX_FRAMES)
+		num_frames = STREAM_MAX_FRAMES;
+
+	stream->num_frames = (size_t)num_frames;
+	stream->frames = bmalloc(stream->num_frames * stream->frame_size);
+
+	/* the first frame is already shown by the texture */
+	stream->read_seq = 1;
+	stream->write_seq = 1;
+
+	pthread_mutex_init(&stream->mutex, NULL);
+	os_event_init(&stream->wake, OS_EVENT_TYPE_AUTO);
+
+	if (pthread_create(&stream->thread, NULL, stream_thread, stream) != 0) {
+		os_event_destroy(stream->wake);
+		pthread_mutex_destroy(&stream->mutex);
+		bfree(stream->frames);
+		bfree(stream);
+		return NULL;
+	}
+
+	return stream;
+}
+
+static void gs_image_stream_update_texture(struct gs_image_stream *stream)
+{
+	gs_image_file_t *image = stream->image;
+	const uint64_t count = image->gif.frame_count;
+	uint64_t seq = stream->shown_seq;
+	bool ready;
+
+	/* the next time the animation reaches the current frame */
+	seq += ((uint64_t)image->cur_frame + count - seq % count) % count;
+	if (seq == stream->shown_seq) {
+		stream->pending = false;
+		return;
+	}
+
+	pthread_mutex_lock(&stream->mutex);
+	stream->wanted_seq = seq;
+	ready = seq < stream->write_seq;
+
+	/* frames before the wanted one won't be shown anymore */
+	if (stream->read_seq < seq)
+		stream->read_seq = ready ? seq : stream->write_seq;
+	pthread_mutex_unlock(&stream->mutex);
+	os_event_signal(stream->wake);
+
+	/* if the decoder fell behind, the previous frame stays up until the
+	 * wanted one is ready, without delaying the frames after it */
+	stream->pending = !ready;
+	if (!ready)
+		return;
+
+	const uint8_t *frame = stream->frames + (seq % stream->num_frames) * stream->frame_size;
+	gs_texture_set_image(image->texture, frame, image->cx * 4, false);
+	stream->shown_seq = seq;
+
+	pthread_mutex_lock(&stream->mutex);
+	stream->read_seq = seq + 1;
+	pthread_mutex_unlock(&stream->mutex);
+	os_event_signal(stream->wake);
+}
+
 static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_t size)
 {
 	UNUSED_PARAMETER(image);
@@ -70,9 +269,10 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_
 }
 
 static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t *mem_usage,
-			      enum gs_image_alpha_mode alpha_mode)
+			      enum gs_image_alpha_mode alpha_mode, uint64_t max_mem, struct gs_image_stream **stream)
 {
 	bool is_animated_gif = true;
+	bool streamed;
 	gif_result result;
 	uint64_t max_size;
 	size_t size, size_read;
@@ -121,14 +321,31 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 	}
 
 	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height * (uint64_t)image->gif.frame_count * 4LLU;
+	streamed = stream && max_size > max_mem;
 
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
+	if (!streamed && (uint64_t)get_full_decoded_gif_size(image) != max_size) {
 		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size", path);
 		goto fail;
 	}
 
 	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
-	if (image->is_animated_gif) {
+	if (image->is_animated_gif && streamed) {
+		image->cx = (uint32_t)image->gif.width;
+		image->cy = (uint32_t)image->gif.height;
+		image->format = GS_RGBA;
+
+		*stream = gs_image_stream_create(image, alpha_mode, max_mem);
+		if (!*stream) {
+			blog(LOG_WARNING, "Failed to create decoder thread for '%s'", path);
+			goto fail;
+		}
+
+		if (mem_usage) {
+			*mem_usage += (*stream)->num_frames * (*stream)->frame_size;
+			*mem_usage += (size_t)4 * image->cx * image->cy;
+			*mem_usage += size;
+		}
+	} else if (image->is_animated_gif) {
 		gif_decode_frame(&image->gif, 0);
 
 		image->animation_frame_cache = alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
@@ -153,11 +370,7 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 			*mem_usage += size;
 		}
 
-		if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
-			gs_premultiply_xyza_srgb_loop(image->gif.frame_image, (size_t)image->cx * image->cy);
-		} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
-			gs_premultiply_xyza_loop(image->gif.frame_image, (size_t)image->cx * image->cy);
-		}
+		premultiply_frame(image->gif.frame_image, (size_t)image->cx * image->cy, alpha_mode);
 	} else {
 		gif_finalise(&image->gif);
 		bfree(image->gif_data);
@@ -179,7 +392,8 @@ not_animated:
 }
 
 static void gs_image_file_init_internal(gs_image_file_t *image, const char *file, uint64_t *mem_usage,
-					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode)
+					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode, uint64_t max_mem,
+					struct gs_image_stream **stream)
 {
 	size_t len;
 
@@ -194,7 +408,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 	len = strlen(file);
 
 	if (len > 4 && astrcmpi(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file, mem_usage, alpha_mode)) {
+		if (init_animated_gif(image, file, mem_usage, alpha_mode, max_mem, stream)) {
 			return;
 		}
 	}
@@ -216,7 +430,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT, 0, NULL);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -242,31 +456,54 @@ void gs_image_file_free(gs_image_file_t *image)
 void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT, 0, NULL);
 }
 
 void gs_image_file3_init(gs_image_file3_t *if3, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode);
+	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode, 0, NULL);
 	if3->alpha_mode = alpha_mode;
 }
 
 void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
-				    alpha_mode);
+				    alpha_mode, 0, NULL);
+	if4->image3.alpha_mode = alpha_mode;
+}
+
+void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode,
+			 uint64_t max_mem)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+
+	if5->stream = NULL;
+	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
+				    alpha_mode, max_mem, &if5->stream);
 	if4->image3.alpha_mode = alpha_mode;
 }
 
+void gs_image_file5_free(gs_image_file5_t *if5)
+{
+	/* the decoder thread uses the gif until it is stopped */
+	gs_image_stream_destroy(if5->stream);
+	if5->stream = NULL;
+	gs_image_file4_free(&if5->image4);
+}
+
 void gs_image_file_init_texture(gs_image_file_t *image)
 {
 	if (!image->loaded)
 		return;
 
 	if (image->is_animated_gif) {
-		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1,
-						   (const uint8_t **)&image->gif.frame_image, GS_DYNAMIC);
+		/* streamed gifs keep their first frame in texture_data */
+		const uint8_t *data = image->texture_data ? image->texture_data : image->gif.frame_image;
+
+		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1, &data, GS_DYNAMIC);
+		bfree(image->texture_data);
+		image->texture_data = NULL;
 
 	} else {
 		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1,
@@ -328,11 +565,7 @@ static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_imag
 			size_t pos = new_frame * area * 4;
 			image->animation_frame_cache[new_frame] = image->animation_frame_data + pos;
 
-			if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
-				gs_premultiply_xyza_srgb_loop(image->gif.frame_image, area);
-			} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
-				gs_premultiply_xyza_loop(image->gif.frame_image, area);
-			}
+			premultiply_frame(image->gif.frame_image, area, alpha_mode);
 
 			memcpy(image->animation_frame_cache[new_frame], image->gif.frame_image, area * 4);
 
@@ -344,7 +577,7 @@ static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_imag
 }
 
 static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed_time_ns,
-					enum gs_image_alpha_mode alpha_mode)
+					enum gs_image_alpha_mode alpha_mode, struct gs_image_stream *stream)
 {
 	int loops;
 
@@ -359,39 +592,56 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 		int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
 
 		if (new_frame != image->cur_frame) {
-			decode_new_frame(image, new_frame, alpha_mode);
+			if (stream)
+				image->cur_frame = new_frame;
+			else
+				decode_new_frame(image, new_frame, alpha_mode);
 			return true;
 		}
 	}
 
-	return false;
+	/* streamed frames that weren't decoded in time are retried */
+	return stream && stream->pending;
 }
 
 bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(image, elapsed_time_ns, false, NULL);
 }
 
 bool gs_image_file2_tick(gs_image_file2_t *if2, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false, NULL);
 }
 
 bool gs_image_file3_tick(gs_image_file3_t *if3, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode);
+	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode, NULL);
 }
 
 bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode);
+	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode, NULL);
 }
 
-static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode)
+bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode,
+					   if5->stream);
+}
+
+static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+						  struct gs_image_stream *stream)
 {
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	if (stream) {
+		gs_image_stream_update_texture(stream);
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
 		decode_new_frame(image, image->cur_frame, alpha_mode);
 
@@ -401,20 +651,26 @@ static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum g
 
 void gs_image_file_update_texture(gs_image_file_t *image)
 {
-	gs_image_file_update_texture_internal(image, false);
+	gs_image_file_update_texture_internal(image, false, NULL);
 }
 
 void gs_image_file2_update_texture(gs_image_file2_t *if2)
 {
-	gs_image_file_update_texture_internal(&if2->image, false);
+	gs_image_file_update_texture_internal(&if2->image, false, NULL);
 }
 
 void gs_image_file3_update_texture(gs_image_file3_t *if3)
 {
-	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode);
+	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode, NULL);
 }
 
 void gs_image_file4_update_texture(gs_image_file4_t *if4)
 {
-	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode);
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode, NULL);
+}
+
+void gs_image_file5_update_texture(gs_image_file5_t *if5)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode, if5->stream);
 }
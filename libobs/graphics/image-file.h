@@ -61,10 +61,21 @@ struct gs_image_file4 {
 	enum gs_color_space space;
 };
 
+struct gs_image_stream;
+
+/* Animated gifs whose decoded frames would take more memory than allowed
+ * are streamed: a background thread decodes a few frames ahead into a ring
+ * of buffers instead of decoding every frame up front. */
+struct gs_image_file5 {
+	struct gs_image_file4 image4;
+	struct gs_image_stream *stream;
+};
+
 typedef struct gs_image_file gs_image_file_t;
 typedef struct gs_image_file2 gs_image_file2_t;
 typedef struct gs_image_file3 gs_image_file3_t;
 typedef struct gs_image_file4 gs_image_file4_t;
+typedef struct gs_image_file5 gs_image_file5_t;
 
 EXPORT void gs_image_file_init(gs_image_file_t *image, const char *file);
 EXPORT void gs_image_file_free(gs_image_file_t *image);
@@ -88,6 +99,14 @@ EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
 
+/* max_mem limits the memory used for decoded frames of animated gifs */
+EXPORT void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode,
+				uint64_t max_mem);
+EXPORT void gs_image_file5_free(gs_image_file5_t *if5);
+
+EXPORT bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns);
+EXPORT void gs_image_file5_update_texture(gs_image_file5_t *if5);
+
 static inline void gs_image_file2_free(gs_image_file2_t *if2)
 {
 	gs_image_file_free(&if2->image);
@@ -119,6 +138,11 @@ static inline void gs_image_file4_init_texture(gs_image_file4_t *if4)
 	gs_image_file3_init_texture(&if4->image3);
 }
 
+static inline void gs_image_file5_init_texture(gs_image_file5_t *if5)
+{
+	gs_image_file4_init_texture(&if5->image4);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@
 #include "../util/util_uint64.h"
 
 #include "audio-io.h"
+#include "audio-kernels.h"
 #include "audio-resampler.h"
 
 #ifdef _WIN32
@@ -142,17 +143,10 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 
 		for (size_t plane = 0; plane < audio->planes; plane++) {
 			float *mix_data = mix->buffer[plane];
-			float *mix_end = &mix_data[float_size];
 			/* Unclamped mix is copied directly. */
 			memcpy(mix->buffer_unclamped[plane], mix_data, bytes);
 
-			while (mix_data < mix_end) {
-				float val = *mix_data;
-				val = (val == val) ? val : 0.0f;
-				val = (val > 1.0f) ? 1.0f : val;
-				val = (val < -1.0f) ? -1.0f : val;
-				*(mix_data++) = val;
-			}
+			audio_clamp(mix_data, float_size);
 		}
 	}
 }
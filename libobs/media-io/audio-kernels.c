@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <string.h>
+
+#include "audio-kernels.h"
+
+#include "../util/sse-intrin.h"
+
+/* every kernel does 8 floats per iteration and finishes the remainder with
+ * the scalar version of the same operation, in the same order, so the output
+ * matches the scalar loops exactly */
+
+void audio_add(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 b0 = _mm_loadu_ps(src + i);
+		__m128 b1 = _mm_loadu_ps(src + i + 4);
+
+		_mm_storeu_ps(dst + i, _mm_add_ps(a0, b0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(a1, b1));
+	}
+
+	for (; i < count; i++)
+		dst[i] += src[i];
+}
+
+void audio_mul(float *dst, float gain, size_t count)
+{
+	const __m128 g = _mm_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+
+		_mm_storeu_ps(dst + i, _mm_mul_ps(a0, g));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(a1, g));
+	}
+
+	for (; i < count; i++)
+		dst[i] *= gain;
+}
+
+void audio_mul_ramp(float *dst, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 g0 = _mm_loadu_ps(gain + i);
+		__m128 g1 = _mm_loadu_ps(gain + i + 4);
+
+		_mm_storeu_ps(dst + i, _mm_mul_ps(a0, g0));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(a1, g1));
+	}
+
+	for (; i < count; i++)
+		dst[i] *= gain[i];
+}
+
+void audio_mul_add_ramp(float *dst, const float *src, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	/* deliberately not fused, a fused multiply-add would round differently
+	 * from the scalar fallback */
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 s0 = _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(gain + i));
+		__m128 s1 = _mm_mul_ps(_mm_loadu_ps(src + i + 4), _mm_loadu_ps(gain + i + 4));
+
+		_mm_storeu_ps(dst + i, _mm_add_ps(a0, s0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(a1, s1));
+	}
+
+	for (; i < count; i++) {
+		float val = src[i] * gain[i];
+		dst[i] += val;
+	}
+}
+
+void audio_clamp(float *dst, size_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 neg_one = _mm_set1_ps(-1.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+
+		/* NaN never compares equal to itself, so this zeroes it */
+		a0 = _mm_and_ps(a0, _mm_cmpeq_ps(a0, a0));
+		a1 = _mm_and_ps(a1, _mm_cmpeq_ps(a1, a1));
+
+		a0 = _mm_max_ps(_mm_min_ps(a0, one), neg_one);
+		a1 = _mm_max_ps(_mm_min_ps(a1, one), neg_one);
+
+		_mm_storeu_ps(dst + i, a0);
+		_mm_storeu_ps(dst + i + 4, a1);
+	}
+
+	for (; i < count; i++) {
+		float val = dst[i];
+		val = (val == val) ? val : 0.0f;
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+		dst[i] = val;
+	}
+}
+
+void audio_downmix_mono(float *const planes[], size_t channels, size_t count)
+{
+	if (!channels)
+		return;
+
+	for (size_t ch = 1; ch < channels; ch++)
+		audio_add(planes[0], planes[ch], count);
+
+	audio_mul(planes[0], 1.0f / (float)channels, count);
+
+	for (size_t ch = 1; ch < channels; ch++)
+		memcpy(planes[ch], planes[0], count * sizeof(float));
+}
@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Vectorized kernels for planar float audio.  Buffers don't need any
+ * particular alignment, and the results are bit-identical to the plain scalar
+ * loops they replace.
+ */
+
+/* dst[i] += src[i] */
+EXPORT void audio_add(float *dst, const float *src, size_t count);
+
+/* dst[i] *= gain */
+EXPORT void audio_mul(float *dst, float gain, size_t count);
+
+/* dst[i] *= gain[i] */
+EXPORT void audio_mul_ramp(float *dst, const float *gain, size_t count);
+
+/* dst[i] += src[i] * gain[i] */
+EXPORT void audio_mul_add_ramp(float *dst, const float *src, const float *gain, size_t count);
+
+/* replaces NaN with 0 and clips to [-1.0, 1.0] */
+EXPORT void audio_clamp(float *dst, size_t count);
+
+/* averages every plane into all of the planes */
+EXPORT void audio_downmix_mono(float *const planes[], size_t channels, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
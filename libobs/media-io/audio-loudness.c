@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <math.h>
+#include <string.h>
+
+#include "audio-loudness.h"
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+/* Channel weights from ITU-R BS.1770, the LFE channel is not measured and
+ * surround channels count more */
+float audio_loudness_channel_weight(enum speaker_layout speakers, int channel)
+{
+	switch (speakers) {
+	case SPEAKERS_2POINT1:
+		return channel == 2 ? 0.0f : 1.0f;
+	case SPEAKERS_4POINT0:
+		return channel == 3 ? 1.41f : 1.0f;
+	case SPEAKERS_4POINT1:
+	case SPEAKERS_5POINT1:
+	case SPEAKERS_7POINT1:
+		return channel == 3 ? 0.0f : (channel > 3 ? 1.41f : 1.0f);
+	default:
+		return 1.0f;
+	}
+}
+
+/* K-weighting filter coefficients from ITU-R BS.1770, derived for any sample
+ * rate instead of only the 48 kHz coefficients given there */
+void audio_loudness_init(struct audio_loudness *loudness, uint32_t sample_rate, enum speaker_layout speakers)
+{
+	double f0 = 1681.974450955533;
+	double gain = 3.999843853973347;
+	double q = 0.7071752369554196;
+	double k = tan(M_PI * f0 / sample_rate);
+	double vh = pow(10.0, gain / 20.0);
+	double vb = pow(vh, 0.4996667741545416);
+	double a0 = 1.0 + k / q + k * k;
+
+	memset(loudness, 0, sizeof(*loudness));
+
+	loudness->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+	loudness->shelf.b1 = 2.0 * (k * k - vh) / a0;
+	loudness->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+	loudness->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+	loudness->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+	f0 = 38.13547087602444;
+	q = 0.5003270373238773;
+	k = tan(M_PI * f0 / sample_rate);
+	a0 = 1.0 + k / q + k * k;
+
+	loudness->high_pass.b0 = 1.0;
+	loudness->high_pass.b1 = -2.0;
+	loudness->high_pass.b2 = 1.0;
+	loudness->high_pass.a1 = 2.0 * (k * k - 1.0) / a0;
+	loudness->high_pass.a2 = (1.0 - k / q + k * k) / a0;
+
+	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++)
+		loudness->weights[i] = audio_loudness_channel_weight(speakers, i);
+
+	loudness->block_size = sample_rate / LOUDNESS_BLOCKS_PER_SEC;
+	loudness->momentary = -INFINITY;
+	loudness->short_term = -INFINITY;
+}
+
+static inline double biquad_process(const struct audio_biquad *bq, double *state, double in)
+{
+	/* transposed direct form II */
+	double out = bq->b0 * in + state[0];
+	state[0] = bq->b1 * in - bq->a1 * out + state[1];
+	state[1] = bq->b2 * in - bq->a2 * out;
+	return out;
+}
+
+static inline float blocks_to_lufs(const struct audio_loudness *loudness, size_t count)
+{
+	double sum = 0.0;
+
+	if (count > loudness->num_blocks)
+		count = loudness->num_blocks;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t idx = (loudness->block_idx + LOUDNESS_SHORT_TERM_BLOCKS - 1 - i) % LOUDNESS_SHORT_TERM_BLOCKS;
+		sum += loudness->blocks[idx];
+	}
+
+	return sum > 0.0 ? (float)(-0.691 + 10.0 * log10(sum / (double)count)) : -INFINITY;
+}
+
+static void end_block(struct audio_loudness *loudness)
+{
+	loudness->blocks[loudness->block_idx] = loudness->block_sum / (double)loudness->block_size;
+	loudness->block_idx = (loudness->block_idx + 1) % LOUDNESS_SHORT_TERM_BLOCKS;
+	if (loudness->num_blocks < LOUDNESS_SHORT_TERM_BLOCKS)
+		loudness->num_blocks++;
+
+	loudness->block_frames = 0;
+	loudness->block_sum = 0.0;
+
+	/* until enough audio was measured, the available blocks are used */
+	loudness->momentary = blocks_to_lufs(loudness, LOUDNESS_MOMENTARY_BLOCKS);
+	loudness->short_term = blocks_to_lufs(loudness, LOUDNESS_SHORT_TERM_BLOCKS);
+}
+
+bool audio_loudness_process(struct audio_loudness *loudness, const float *const planes[], size_t channels,
+			    size_t frames)
+{
+	size_t frame = 0;
+	bool updated = false;
+
+	if (channels > MAX_AUDIO_CHANNELS)
+		channels = MAX_AUDIO_CHANNELS;
+
+	while (frame < frames) {
+		size_t count = loudness->block_size - loudness->block_frames;
+		if (count > frames - frame)
+			count = frames - frame;
+
+		for (size_t ch = 0; ch < channels; ch++) {
+			const float *samples = planes[ch] + frame;
+			double *state = loudness->state[ch];
+			double sum = 0.0;
+
+			for (size_t i = 0; i < count; i++) {
+				double val = biquad_process(&loudness->shelf, state, samples[i]);
+				val = biquad_process(&loudness->high_pass, state + 2, val);
+				sum += val * val;
+			}
+
+			loudness->block_sum += sum * loudness->weights[ch];
+		}
+
+		frame += count;
+		loudness->block_frames += count;
+
+		if (loudness->block_frames == loudness->block_size) {
+			end_block(loudness);
+			updated = true;
+		}
+	}
+
+	return updated;
+}
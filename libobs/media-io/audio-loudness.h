@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "audio-io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Momentary and short-term loudness of planar float audio, in LUFS, as
+ * defined by ITU-R BS.1770 and EBU R128.
+ */
+
+/* EBU R128 loudness is measured in blocks of 100 ms, momentary loudness
+ * over the last 400 ms and short-term loudness over the last 3 s */
+#define LOUDNESS_BLOCKS_PER_SEC 10
+#define LOUDNESS_MOMENTARY_BLOCKS 4
+#define LOUDNESS_SHORT_TERM_BLOCKS 30
+
+struct audio_biquad {
+	double b0, b1, b2, a1, a2;
+};
+
+struct audio_loudness {
+	/* K-weighting: a high shelf followed by a high pass */
+	struct audio_biquad shelf;
+	struct audio_biquad high_pass;
+	double state[MAX_AUDIO_CHANNELS][4];
+	float weights[MAX_AUDIO_CHANNELS];
+
+	size_t block_size;
+	size_t block_frames;
+	double block_sum;
+
+	double blocks[LOUDNESS_SHORT_TERM_BLOCKS];
+	size_t num_blocks;
+	size_t block_idx;
+
+	/* -INFINITY until the first block ended */
+	float momentary;
+	float short_term;
+};
+
+/* Weight of a channel of a speaker layout, 0 for channels not measured */
+EXPORT float audio_loudness_channel_weight(enum speaker_layout speakers, int channel);
+
+EXPORT void audio_loudness_init(struct audio_loudness *loudness, uint32_t sample_rate, enum speaker_layout speakers);
+
+/* Returns true if a block ended and the loudness values changed */
+EXPORT bool audio_loudness_process(struct audio_loudness *loudness, const float *const planes[], size_t channels,
+				   size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,6 +18,9 @@
 #include "format-conversion.h"
 
 #include "../util/sse-intrin.h"
+#include "../util/threading.h"
+#include "../util/platform.h"
+#include "../util/task.h"
 
 /* ...surprisingly, if I don't use a macro to force inlining, it causes the
  * CPU usage to boost by a tremendous amount in debug builds. */
@@ -286,3 +289,194 @@ void decompress_422(const uint8_t *input, uint32_t in_linesize, uint32_t start_y
 		}
 	}
 }
+
+/* ------------------------------------------------------------------------- */
+/* slice-parallel conversion */
+
+#define MAX_AUTO_CONVERSION_THREADS 8
+#define MIN_SLICE_ROWS 32
+#define SLICES_PER_THREAD 4
+
+static pthread_mutex_t conversion_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static os_work_pool_t *conversion_pool = NULL;
+static volatile long conversion_threads = 0;
+
+void format_conversion_set_threads(size_t threads)
+{
+	pthread_mutex_lock(&conversion_pool_mutex);
+
+	os_atomic_set_long(&conversion_threads, (long)threads);
+	os_work_pool_destroy(conversion_pool);
+	conversion_pool = NULL;
+
+	pthread_mutex_unlock(&conversion_pool_mutex);
+}
+
+size_t format_conversion_get_threads(void)
+{
+	long threads = os_atomic_load_long(&conversion_threads);
+	if (threads > 0)
+		return (size_t)threads;
+
+	int cores = os_get_logical_cores();
+	if (cores < 1)
+		return 1;
+	return cores > MAX_AUTO_CONVERSION_THREADS ? MAX_AUTO_CONVERSION_THREADS : (size_t)cores;
+}
+
+void format_conversion_free_pool(void)
+{
+	pthread_mutex_lock(&conversion_pool_mutex);
+	os_work_pool_destroy(conversion_pool);
+	conversion_pool = NULL;
+	pthread_mutex_unlock(&conversion_pool_mutex);
+}
+
+struct slice_job {
+	uint32_t height;
+	uint32_t slice_rows;
+	format_conversion_slice_t slice;
+	void *param;
+};
+
+static void run_slice(void *param, size_t idx)
+{
+	struct slice_job *job = param;
+	uint32_t start_y = (uint32_t)idx * job->slice_rows;
+	uint32_t end_y = min_uint32(start_y + job->slice_rows, job->height);
+
+	job->slice(job->param, start_y, end_y);
+}
+
+void format_conversion_run_sliced(uint32_t height, format_conversion_slice_t slice, void *param)
+{
+	size_t threads = format_conversion_get_threads();
+
+	/* if another conversion currently owns the pool, converting on this
+	 * thread is cheaper than waiting for it */
+	if (threads <= 1 || height < MIN_SLICE_ROWS * 2 || pthread_mutex_trylock(&conversion_pool_mutex) != 0) {
+		slice(param, 0, height);
+		return;
+	}
+
+	if (!conversion_pool)
+		conversion_pool = os_work_pool_create("media-io: format conversion", threads - 1);
+
+	if (!conversion_pool) {
+		pthread_mutex_unlock(&conversion_pool_mutex);
+		slice(param, 0, height);
+		return;
+	}
+
+	size_t participants = os_work_pool_get_thread_count(conversion_pool) + 1;
+	uint32_t slice_rows = (uint32_t)((height + participants * SLICES_PER_THREAD - 1) /
+					 (participants * SLICES_PER_THREAD));
+	if (slice_rows < MIN_SLICE_ROWS)
+		slice_rows = MIN_SLICE_ROWS;
+	slice_rows = (slice_rows + 1) & ~1U;
+
+	struct slice_job job = {height, slice_rows, slice, param};
+	os_work_pool_run(conversion_pool, (height + slice_rows - 1) / slice_rows, run_slice, &job);
+
+	pthread_mutex_unlock(&conversion_pool_mutex);
+}
+
+struct packed_conversion {
+	const uint8_t *input;
+	uint32_t in_linesize;
+	uint8_t **output;
+	const uint32_t *out_linesize;
+};
+
+static void compress_uyvx_to_i420_slice(void *param, uint32_t start_y, uint32_t end_y)
+{
+	struct packed_conversion *c = param;
+	compress_uyvx_to_i420(c->input, c->in_linesize, start_y, end_y, c->output, c->out_linesize);
+}
+
+static void compress_uyvx_to_nv12_slice(void *param, uint32_t start_y, uint32_t end_y)
+{
+	struct packed_conversion *c = param;
+	compress_uyvx_to_nv12(c->input, c->in_linesize, start_y, end_y, c->output, c->out_linesize);
+}
+
+static void convert_uyvx_to_i444_slice(void *param, uint32_t start_y, uint32_t end_y)
+{
+	struct packed_conversion *c = param;
+	convert_uyvx_to_i444(c->input, c->in_linesize, start_y, end_y, c->output, c->out_linesize);
+}
+
+void compress_uyvx_to_i420_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height, uint8_t *output[],
+				    const uint32_t out_linesize[])
+{
+	struct packed_conversion c = {input, in_linesize, output, out_linesize};
+	format_conversion_run_sliced(height, compress_uyvx_to_i420_slice, &c);
+}
+
+void compress_uyvx_to_nv12_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height, uint8_t *output[],
+				    const uint32_t out_linesize[])
+{
+	struct packed_conversion c = {input, in_linesize, output, out_linesize};
+	format_conversion_run_sliced(height, compress_uyvx_to_nv12_slice, &c);
+}
+
+void convert_uyvx_to_i444_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height, uint8_t *output[],
+				   const uint32_t out_linesize[])
+{
+	struct packed_conversion c = {input, in_linesize, output, out_linesize};
+	format_conversion_run_sliced(height, convert_uyvx_to_i444_slice, &c);
+}
+
+struct planar_conversion {
+	const uint8_t *const *input;
+	const uint32_t *in_linesize;
+	uint8_t *output;
+	uint32_t out_linesize;
+};
+
+static void decompress_nv12_slice(void *param, uint32_t start_y, uint32_t end_y)
+{
+	struct planar_conversion *c = param;
+	decompress_nv12(c->input, c->in_linesize, start_y, end_y, c->output, c->out_linesize);
+}
+
+static void decompress_420_slice(void *param, uint32_t start_y, uint32_t end_y)
+{
+	struct planar_conversion *c = param;
+	decompress_420(c->input, c->in_linesize, start_y, end_y, c->output, c->out_linesize);
+}
+
+void decompress_nv12_threaded(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t height,
+			      uint8_t *output, uint32_t out_linesize)
+{
+	struct planar_conversion c = {input, in_linesize, output, out_linesize};
+	format_conversion_run_sliced(height, decompress_nv12_slice, &c);
+}
+
+void decompress_420_threaded(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t height,
+			     uint8_t *output, uint32_t out_linesize)
+{
+	struct planar_conversion c = {input, in_linesize, output, out_linesize};
+	format_conversion_run_sliced(height, decompress_420_slice, &c);
+}
+
+struct conversion_422 {
+	const uint8_t *input;
+	uint32_t in_linesize;
+	uint8_t *output;
+	uint32_t out_linesize;
+	bool leading_lum;
+};
+
+static void decompress_422_slice(void *param, uint32_t start_y, uint32_t end_y)
+{
+	struct conversion_422 *c = param;
+	decompress_422(c->input, c->in_linesize, start_y, end_y, c->output, c->out_linesize, c->leading_lum);
+}
+
+void decompress_422_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height, uint8_t *output,
+			     uint32_t out_linesize, bool leading_lum)
+{
+	struct conversion_422 c = {input, in_linesize, output, out_linesize, leading_lum};
+	format_conversion_run_sliced(height, decompress_422_slice, &c);
+}
@@ -45,6 +45,39 @@ EXPORT void decompress_420(const uint8_t *const input[], const uint32_t in_lines
 EXPORT void decompress_422(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 			   uint8_t *output, uint32_t out_linesize, bool leading_lum);
 
+/*
+ * Slice-parallel versions of the above.  The rows of the image are split
+ * between the threads of a shared conversion pool (each slice is a multiple of
+ * two rows), the call returns once the whole image has been converted.
+ */
+
+/* threads == 0 uses one thread per logical core (capped), 1 disables slicing */
+EXPORT void format_conversion_set_threads(size_t threads);
+EXPORT size_t format_conversion_get_threads(void);
+EXPORT void format_conversion_free_pool(void);
+
+typedef void (*format_conversion_slice_t)(void *param, uint32_t start_y, uint32_t end_y);
+
+EXPORT void format_conversion_run_sliced(uint32_t height, format_conversion_slice_t slice, void *param);
+
+EXPORT void compress_uyvx_to_i420_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height,
+					   uint8_t *output[], const uint32_t out_linesize[]);
+
+EXPORT void compress_uyvx_to_nv12_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height,
+					   uint8_t *output[], const uint32_t out_linesize[]);
+
+EXPORT void convert_uyvx_to_i444_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height,
+					  uint8_t *output[], const uint32_t out_linesize[]);
+
+EXPORT void decompress_nv12_threaded(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t height,
+				     uint8_t *output, uint32_t out_linesize);
+
+EXPORT void decompress_420_threaded(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t height,
+				    uint8_t *output, uint32_t out_linesize);
+
+EXPORT void decompress_422_threaded(const uint8_t *input, uint32_t in_linesize, uint32_t height, uint8_t *output,
+				    uint32_t out_linesize, bool leading_lum);
+
 #ifdef __cplusplus
 }
 #endif
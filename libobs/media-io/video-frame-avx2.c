@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <string.h>
+#include "../util/c99defs.h"
+
+/* AVX2 kernels of video-frame.c, only called once video_frame_cpu_has_avx2()
+ * has returned true */
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+TARGET_AVX2 void video_frame_copy_row_stream_avx2(uint8_t *dst, const uint8_t *src, size_t size)
+{
+	size_t head = (32 - ((uintptr_t)dst & 31)) & 31;
+	if (head > size)
+		head = size;
+
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	while (size >= 128) {
+		__m256i v0 = _mm256_loadu_si256((const __m256i *)src);
+		__m256i v1 = _mm256_loadu_si256((const __m256i *)(src + 32));
+		__m256i v2 = _mm256_loadu_si256((const __m256i *)(src + 64));
+		__m256i v3 = _mm256_loadu_si256((const __m256i *)(src + 96));
+		_mm256_stream_si256((__m256i *)dst, v0);
+		_mm256_stream_si256((__m256i *)(dst + 32), v1);
+		_mm256_stream_si256((__m256i *)(dst + 64), v2);
+		_mm256_stream_si256((__m256i *)(dst + 96), v3);
+		dst += 128;
+		src += 128;
+		size -= 128;
+	}
+
+	while (size >= 32) {
+		_mm256_stream_si256((__m256i *)dst, _mm256_loadu_si256((const __m256i *)src));
+		dst += 32;
+		src += 32;
+		size -= 32;
+	}
+
+	memcpy(dst, src, size);
+}
+
+bool video_frame_cpu_has_avx2(void)
+{
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+		return false;
+
+	/* OSXSAVE + AVX, and the OS must be saving the YMM state */
+	__cpuid(regs, 1);
+	if ((regs[2] & (1 << 27 | 1 << 28)) != (1 << 27 | 1 << 28))
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
@@ -16,6 +16,17 @@
 ******************************************************************************/
 #include <assert.h>
 #include "video-frame.h"
+#include "../util/threading.h"
+#include "../util/sse-intrin.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define VIDEO_COPY_AVX2 1
+
+/* in video-frame-avx2.c, kept apart so that immintrin.h is never mixed with
+ * the simde aliases of sse-intrin.h */
+extern bool video_frame_cpu_has_avx2(void);
+extern void video_frame_copy_row_stream_avx2(uint8_t *dst, const uint8_t *src, size_t size);
+#endif
 
 #define HALF(size) ((size + 1) / 2)
 #define ALIGN(size, alignment) *size = (*size + alignment - 1) & (~(alignment - 1));
@@ -232,32 +243,144 @@ void video_frame_init(struct video_frame *frame, enum video_format format, uint3
 	}
 }
 
+/* ------------------------------------------------------------------------- */
+/* plane copy kernels                                                        */
+
+/* frames at or above this size are written with non-temporal stores, which
+ * avoids the read-for-ownership traffic and keeps the copy from evicting the
+ * working set of the graphics thread. below it memcpy is faster even when the
+ * working set has to be reloaded afterwards: in the benchmark of
+ * test_video_frame, streaming was 5-20% slower up to 4K P010 and only came out
+ * even or ahead at 4K RGBA (31.6 MiB) */
+#define NON_TEMPORAL_THRESHOLD (3840 * 2160 * 4)
+
+typedef void (*copy_row_func)(uint8_t *dst, const uint8_t *src, size_t size);
+
+static void copy_row_stream_sse2(uint8_t *dst, const uint8_t *src, size_t size)
+{
+	size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+	if (head > size)
+		head = size;
+
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	while (size >= 64) {
+		__m128i v0 = _mm_loadu_si128((const __m128i *)src);
+		__m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+		__m128i v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+		__m128i v3 = _mm_loadu_si128((const __m128i *)(src + 48));
+		_mm_stream_si128((__m128i *)dst, v0);
+		_mm_stream_si128((__m128i *)(dst + 16), v1);
+		_mm_stream_si128((__m128i *)(dst + 32), v2);
+		_mm_stream_si128((__m128i *)(dst + 48), v3);
+		dst += 64;
+		src += 64;
+		size -= 64;
+	}
+
+	while (size >= 16) {
+		_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+		dst += 16;
+		src += 16;
+		size -= 16;
+	}
+
+	memcpy(dst, src, size);
+}
+
+static copy_row_func copy_row_stream = copy_row_stream_sse2;
+static pthread_once_t copy_row_once = PTHREAD_ONCE_INIT;
+
+static void select_copy_kernels(void)
+{
+#ifdef VIDEO_COPY_AVX2
+	if (video_frame_cpu_has_avx2())
+		copy_row_stream = video_frame_copy_row_stream_avx2;
+#endif
+}
+
+bool video_frame_use_non_temporal_copy(enum video_format format, uint32_t width, uint32_t height)
+{
+	uint32_t linesizes[MAX_AV_PLANES] = {0};
+	uint32_t heights[MAX_AV_PLANES] = {0};
+	size_t size = 0;
+
+	video_frame_get_linesizes(linesizes, format, width);
+	video_frame_get_plane_heights(heights, format, height);
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		size += (size_t)linesizes[i] * (size_t)heights[i];
+
+	return size >= NON_TEMPORAL_THRESHOLD;
+}
+
+const uint8_t *video_frame_copy_plane(uint8_t *dst, uint32_t dst_linesize, const uint8_t *src, uint32_t src_linesize,
+				      uint32_t row_size, uint32_t rows, bool non_temporal)
+{
+	if (!non_temporal) {
+		if (row_size == src_linesize && row_size == dst_linesize) {
+			size_t total = (size_t)row_size * (size_t)rows;
+			memcpy(dst, src, total);
+			return src + total;
+		}
+
+		for (uint32_t y = 0; y < rows; y++) {
+			memcpy(dst, src, row_size);
+			dst += dst_linesize;
+			src += src_linesize;
+		}
+		return src;
+	}
+
+	pthread_once(&copy_row_once, select_copy_kernels);
+
+	if (row_size == src_linesize && row_size == dst_linesize) {
+		size_t total = (size_t)row_size * (size_t)rows;
+		copy_row_stream(dst, src, total);
+		src += total;
+	} else {
+		for (uint32_t y = 0; y < rows; y++) {
+			copy_row_stream(dst, src, row_size);
+			dst += dst_linesize;
+			src += src_linesize;
+		}
+	}
+
+	/* streaming stores are weakly ordered, make them visible before the
+	 * frame is handed to another thread */
+	_mm_sfence();
+	return src;
+}
+
 void video_frame_copy(struct video_frame *dst, const struct video_frame *src, enum video_format format, uint32_t cy)
 {
 	uint32_t heights[MAX_AV_PLANES];
+	uint32_t linesizes[MAX_AV_PLANES];
+	size_t total = 0;
 
 	memset(heights, 0, sizeof(heights));
+	memset(linesizes, 0, sizeof(linesizes));
 
 	/* determine line count for each plane */
 	video_frame_get_plane_heights(heights, format, cy);
 
+	for (uint32_t i = 0; i < MAX_AV_PLANES; i++) {
+		/* determine how much we can write (frames with different line sizes require more) */
+		linesizes[i] = src->linesize[i] < dst->linesize[i] ? src->linesize[i] : dst->linesize[i];
+		total += (size_t)linesizes[i] * (size_t)heights[i];
+	}
+
+	const bool non_temporal = total >= NON_TEMPORAL_THRESHOLD;
+
 	/* copy each plane */
 	for (uint32_t i = 0; i < MAX_AV_PLANES; i++) {
 		if (!heights[i])
 			continue;
 
-		if (src->linesize[i] == dst->linesize[i]) {
-			memcpy(dst->data[i], src->data[i], src->linesize[i] * heights[i]);
-		} else { /* linesizes which do not match must be copied line-by-line */
-			size_t src_linesize = src->linesize[i];
-			size_t dst_linesize = dst->linesize[i];
-			/* determine how much we can write (frames with different line sizes require more )*/
-			size_t linesize = src_linesize < dst_linesize ? src_linesize : dst_linesize;
-			for (uint32_t y = 0; y < heights[i]; y++) {
-				uint8_t *src_pos = src->data[i] + (src_linesize * y);
-				uint8_t *dst_pos = dst->data[i] + (dst_linesize * y);
-				memcpy(dst_pos, src_pos, linesize);
-			}
-		}
+		video_frame_copy_plane(dst->data[i], dst->linesize[i], src->data[i], src->linesize[i], linesizes[i],
+				       heights[i], non_temporal);
 	}
 }
@@ -59,6 +59,17 @@ static inline void video_frame_destroy(struct video_frame *frame)
 EXPORT void video_frame_copy(struct video_frame *dst, const struct video_frame *src, enum video_format format,
 			     uint32_t height);
 
+/* Returns true if frames of this size are large enough that they should be
+ * copied with non-temporal (cache-bypassing) stores. */
+EXPORT bool video_frame_use_non_temporal_copy(enum video_format format, uint32_t width, uint32_t height);
+
+/* Copies row_size bytes of each of the given rows from src to dst, using the
+ * fastest kernel for the current CPU.  Returns the source pointer just past
+ * the last row that was copied. */
+EXPORT const uint8_t *video_frame_copy_plane(uint8_t *dst, uint32_t dst_linesize, const uint8_t *src,
+					     uint32_t src_linesize, uint32_t row_size, uint32_t rows,
+					     bool non_temporal);
+
 #ifdef __cplusplus
 }
 #endif
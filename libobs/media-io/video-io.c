@@ -38,6 +38,12 @@ struct cached_frame_info {
 	struct video_data frame;
 	int skipped;
 	int count;
+
+	/* set if the frame data is borrowed from the caller of
+	 * video_output_queue_external_frame rather than owned by the cache */
+	struct video_data external;
+	void (*release)(void *param);
+	void *release_param;
 };
 
 struct video_input {
@@ -123,9 +129,20 @@ static inline bool scale_video_output(struct video_input *input, struct video_da
 	return success;
 }
 
+static inline void take_external_frame(struct cached_frame_info *frame_info, void (**release)(void *param),
+				       void **param)
+{
+	*release = frame_info->release;
+	*param = frame_info->release_param;
+	frame_info->release = NULL;
+	frame_info->release_param = NULL;
+}
+
 static inline bool video_output_cur_frame(struct video_output *video)
 {
 	struct cached_frame_info *frame_info;
+	void (*release)(void *param) = NULL;
+	void *release_param = NULL;
 	bool complete;
 	bool skipped;
 
@@ -145,6 +162,11 @@ static inline bool video_output_cur_frame(struct video_output *video)
 		struct video_input *input = video->inputs.array + i;
 		struct video_data frame = frame_info->frame;
 
+		if (frame_info->release) {
+			memcpy(frame.data, frame_info->external.data, sizeof(frame.data));
+			memcpy(frame.linesize, frame_info->external.linesize, sizeof(frame.linesize));
+		}
+
 		// an explicit counter is used instead of remainder calculation
 		// to allow multiple encoders started at the same time to start on
 		// the same frame
@@ -170,6 +192,8 @@ static inline bool video_output_cur_frame(struct video_output *video)
 	skipped = frame_info->skipped > 0;
 
 	if (complete) {
+		take_external_frame(frame_info, &release, &release_param);
+
 		if (++video->first_added == video->info.cache_size)
 			video->first_added = 0;
 
@@ -184,6 +208,9 @@ static inline bool video_output_cur_frame(struct video_output *video)
 
 	/* -------------------------------- */
 
+	if (release)
+		release(release_param);
+
 	return complete;
 }
 
@@ -544,6 +571,42 @@ bool video_output_lock_frame(video_t *video, struct video_frame *frame, int coun
 	return locked;
 }
 
+bool video_output_queue_external_frame(video_t *video, const struct video_data *frame, int count,
+				       void (*release)(void *param), void *param)
+{
+	struct cached_frame_info *cfi;
+	bool queued = false;
+
+	if (!video || !frame || !release)
+		return false;
+
+	video = get_root(video);
+
+	pthread_mutex_lock(&video->data_mutex);
+
+	/* only hand off the frame if the video thread has caught up, otherwise
+	 * the caller would have to hold on to its buffer for several frames */
+	if (!video->stop && video->available_frames == video->info.cache_size) {
+		cfi = &video->cache[video->last_added];
+		cfi->frame.timestamp = frame->timestamp;
+		cfi->count = count;
+		cfi->skipped = 0;
+
+		memcpy(cfi->external.data, frame->data, sizeof(cfi->external.data));
+		memcpy(cfi->external.linesize, frame->linesize, sizeof(cfi->external.linesize));
+		cfi->release = release;
+		cfi->release_param = param;
+
+		video->available_frames--;
+		os_sem_post(video->update_semaphore);
+		queued = true;
+	}
+
+	pthread_mutex_unlock(&video->data_mutex);
+
+	return queued;
+}
+
 void video_output_unlock_frame(video_t *video)
 {
 	if (!video)
@@ -564,6 +627,21 @@ uint64_t video_output_get_frame_time(const video_t *video)
 	return video ? video->frame_time : 0;
 }
 
+static void release_external_frames(struct video_output *video)
+{
+	for (size_t i = 0; i < video->info.cache_size; i++) {
+		void (*release)(void *param);
+		void *release_param;
+
+		pthread_mutex_lock(&video->data_mutex);
+		take_external_frame(&video->cache[i], &release, &release_param);
+		pthread_mutex_unlock(&video->data_mutex);
+
+		if (release)
+			release(release_param);
+	}
+}
+
 void video_output_stop(video_t *video)
 {
 	void *thread_ret;
@@ -577,6 +655,10 @@ void video_output_stop(video_t *video)
 		video->stop = true;
 		os_sem_post(video->update_semaphore);
 		pthread_join(video->thread, &thread_ret);
+
+		/* frames that were never processed still have to be given
+		 * back to their owners */
+		release_external_frames(video);
 	}
 }
 
@@ -313,6 +313,18 @@ EXPORT bool video_output_active(const video_t *video);
 EXPORT const struct video_output_info *video_output_get_info(const video_t *video);
 EXPORT bool video_output_lock_frame(video_t *video, struct video_frame *frame, int count, uint64_t timestamp);
 EXPORT void video_output_unlock_frame(video_t *video);
+
+/**
+ * Queues a frame without copying it into the output's frame cache.  The data
+ * pointed to by the frame must stay valid until release is called from the
+ * video thread, which happens once every input has received the frame.
+ *
+ * The frame is only accepted if no other frames are waiting to be processed.
+ * If this returns false, the frame was not queued and release will not be
+ * called; the caller should fall back to video_output_lock_frame.
+ */
+EXPORT bool video_output_queue_external_frame(video_t *video, const struct video_data *frame, int count,
+					      void (*release)(void *param), void *param);
 EXPORT uint64_t video_output_get_frame_time(const video_t *video);
 EXPORT void video_output_stop(video_t *video);
 EXPORT bool video_output_stopped(video_t *video);
@@ -16,8 +16,10 @@
 ******************************************************************************/
 
 #include "../util/bmem.h"
+#include "format-conversion.h"
 #include "video-scaler.h"
 
+#include <libavutil/frame.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/opt.h>
 #include <libswscale/swscale.h>
@@ -28,6 +30,15 @@ struct video_scaler {
 	int dst_heights[4];
 	uint8_t *dst_pointers[4];
 	int dst_linesizes[4];
+
+	/* slice-threaded scaling goes through the frame API */
+	int threads;
+	int src_width;
+	int dst_width;
+	enum AVPixelFormat src_format;
+	enum AVPixelFormat dst_format;
+	AVFrame *src_frame;
+	AVFrame *dst_frame;
 };
 
 static inline enum AVPixelFormat get_ffmpeg_video_format(enum video_format format)
@@ -140,6 +151,41 @@ static inline int get_ffmpeg_range_type(enum video_range_type type)
 
 #define FIXED_1_0 (1 << 16)
 
+/* below this, the slice threads cost more than they save */
+#define MIN_THREADED_SCALE_HEIGHT 720
+
+static inline int get_scaler_threads(const struct video_scale_info *dst, const struct video_scale_info *src)
+{
+	if (dst->height < MIN_THREADED_SCALE_HEIGHT && src->height < MIN_THREADED_SCALE_HEIGHT)
+		return 1;
+
+	return (int)format_conversion_get_threads();
+}
+
+static void frame_buffer_free(void *opaque, uint8_t *data)
+{
+	UNUSED_PARAMETER(opaque);
+	UNUSED_PARAMETER(data);
+}
+
+/* wraps plane pointers in a frame that swscale can reference without copying
+ * or allocating the image */
+static bool wrap_frame(AVFrame *frame, int width, int height, enum AVPixelFormat format, uint8_t *const data[],
+		       const int linesize[])
+{
+	frame->width = width;
+	frame->height = height;
+	frame->format = format;
+
+	for (size_t i = 0; i < 4; i++) {
+		frame->data[i] = data[i];
+		frame->linesize[i] = linesize[i];
+	}
+
+	frame->buf[0] = av_buffer_create(data[0], 1, frame_buffer_free, NULL, 0);
+	return frame->buf[0] != NULL;
+}
+
 int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_info *dst,
 			const struct video_scale_info *src, enum video_scale_type type)
 {
@@ -161,6 +207,7 @@ int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_in
 
 	scaler = bzalloc(sizeof(struct video_scaler));
 	scaler->src_height = src->height;
+	scaler->threads = get_scaler_threads(dst, src);
 
 	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format_dst);
 	bool has_plane[4] = {0};
@@ -197,6 +244,22 @@ int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_in
 	av_opt_set_int(scaler->swscale, "dst_format", format_dst, 0);
 	av_opt_set_int(scaler->swscale, "src_range", range_src, 0);
 	av_opt_set_int(scaler->swscale, "dst_range", range_dst, 0);
+	if (scaler->threads > 1) {
+		av_opt_set_int(scaler->swscale, "threads", scaler->threads, 0);
+
+		scaler->src_frame = av_frame_alloc();
+		scaler->dst_frame = av_frame_alloc();
+		if (!scaler->src_frame || !scaler->dst_frame) {
+			blog(LOG_ERROR, "video_scaler_create: Could not allocate frames");
+			goto fail;
+		}
+
+		scaler->src_width = src->width;
+		scaler->dst_width = dst->width;
+		scaler->src_format = format_src;
+		scaler->dst_format = format_dst;
+	}
+
 	if (sws_init_context(scaler->swscale, NULL, NULL) < 0) {
 		blog(LOG_ERROR, "video_scaler_create: sws_init_context failed");
 		goto fail;
@@ -221,6 +284,8 @@ void video_scaler_destroy(video_scaler_t *scaler)
 {
 	if (scaler) {
 		sws_freeContext(scaler->swscale);
+		av_frame_free(&scaler->src_frame);
+		av_frame_free(&scaler->dst_frame);
 
 		if (scaler->dst_pointers[0])
 			av_freep(scaler->dst_pointers);
@@ -229,17 +294,50 @@ void video_scaler_destroy(video_scaler_t *scaler)
 	}
 }
 
+static bool scale_threaded(video_scaler_t *scaler, const uint8_t *const input[], const uint32_t in_linesize[])
+{
+	AVFrame *src = scaler->src_frame;
+	AVFrame *dst = scaler->dst_frame;
+	bool success = false;
+	int ret;
+
+	if (!wrap_frame(src, scaler->src_width, scaler->src_height, scaler->src_format, (uint8_t *const *)input,
+			(const int *)in_linesize))
+		goto finish;
+	if (!wrap_frame(dst, scaler->dst_width, scaler->dst_heights[0], scaler->dst_format, scaler->dst_pointers,
+			scaler->dst_linesizes))
+		goto finish;
+
+	ret = sws_scale_frame(scaler->swscale, dst, src);
+	if (ret < 0) {
+		blog(LOG_ERROR, "video_scaler_scale: sws_scale_frame failed: %d", ret);
+		goto finish;
+	}
+
+	success = true;
+
+finish:
+	av_frame_unref(src);
+	av_frame_unref(dst);
+	return success;
+}
+
 bool video_scaler_scale(video_scaler_t *scaler, uint8_t *output[], const uint32_t out_linesize[],
 			const uint8_t *const input[], const uint32_t in_linesize[])
 {
 	if (!scaler)
 		return false;
 
-	int ret = sws_scale(scaler->swscale, input, (const int *)in_linesize, 0, scaler->src_height,
-			    scaler->dst_pointers, scaler->dst_linesizes);
-	if (ret <= 0) {
-		blog(LOG_ERROR, "video_scaler_scale: sws_scale failed: %d", ret);
-		return false;
+	if (scaler->threads > 1) {
+		if (!scale_threaded(scaler, input, in_linesize))
+			return false;
+	} else {
+		int ret = sws_scale(scaler->swscale, input, (const int *)in_linesize, 0, scaler->src_height,
+				    scaler->dst_pointers, scaler->dst_linesizes);
+		if (ret <= 0) {
+			blog(LOG_ERROR, "video_scaler_scale: sws_scale failed: %d", ret);
+			return false;
+		}
 	}
 
 	for (size_t plane = 0; plane < 4; ++plane) {
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util/threading.h"
 #include "util/bmem.h"
 #include "media-io/audio-math.h"
+#include "media-io/audio-loudness.h"
 #include "obs.h"
 #include "obs-internal.h"
 
@@ -61,23 +62,73 @@ struct meter_cb {
 	void *param;
 };
 
+struct loudness_cb {
+	obs_volmeter_loudness_updated_t callback;
+	void *param;
+};
+
 struct obs_volmeter {
 	pthread_mutex_t mutex;
 	obs_source_t *source;
+	struct obs_audio_analysis *analysis;
 	enum obs_fader_type type;
 	float cur_db;
 
 	pthread_mutex_t callback_mutex;
 	DARRAY(struct meter_cb) callbacks;
+	DARRAY(struct loudness_cb) loudness_callbacks;
 
 	enum obs_peak_meter_type peak_meter_type;
 	unsigned int update_ms;
-	float prev_samples[MAX_AUDIO_CHANNELS][4];
+};
+
+/* Levels of one meter for one block of audio, adjusted by its volume */
+struct meter_levels {
+	/* cleared when the meter is detached before it was called */
+	struct obs_volmeter *volmeter;
 
 	float magnitude[MAX_AUDIO_CHANNELS];
 	float peak[MAX_AUDIO_CHANNELS];
+	float input_peak[MAX_AUDIO_CHANNELS];
+	float momentary;
+	float short_term;
 };
 
+/* Levels of a source are calculated once for all of its volume meters, from a
+ * single audio capture callback.  Created by the first meter attached to the
+ * source and destroyed with the last one. */
+struct obs_audio_analysis {
+	obs_source_t *source;
+	long refs;
+
+	/* held while processing audio */
+	pthread_mutex_t mutex;
+	DARRAY(struct obs_volmeter *) meters;
+
+	/* Held while calling the meters' callbacks, without the mutex above,
+	 * so callbacks can detach and destroy meters.  Detaching waits for it,
+	 * so meters detached from other threads are no longer called. */
+	pthread_mutex_t emit_mutex;
+	DARRAY(struct meter_levels) levels;
+	DARRAY(struct meter_cb) emit_callbacks;
+	DARRAY(struct loudness_cb) emit_loudness_callbacks;
+	bool destroy_after_emit;
+
+	float prev_samples[MAX_AUDIO_CHANNELS][4];
+	float magnitude[MAX_AUDIO_CHANNELS];
+	float sample_peak[MAX_AUDIO_CHANNELS];
+	float true_peak[MAX_AUDIO_CHANNELS];
+
+	bool loudness_active;
+	struct audio_loudness loudness;
+};
+
+/* guards source->audio_analysis and the reference counts */
+static pthread_mutex_t analysis_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* analysis whose meters are being called on this thread */
+static THREAD_LOCAL struct obs_audio_analysis *emitting_analysis = NULL;
+
 static float cubic_def_to_db(const float def)
 {
 	if (def == 1.0f)
@@ -194,15 +245,40 @@ static void signal_volume_changed(struct obs_fader *fader, const float db)
 	pthread_mutex_unlock(&fader->callback_mutex);
 }
 
-static void signal_levels_updated(struct obs_volmeter *volmeter, const float magnitude[MAX_AUDIO_CHANNELS],
-				  const float peak[MAX_AUDIO_CHANNELS], const float input_peak[MAX_AUDIO_CHANNELS])
+/* Called with the analysis' emit mutex held.  The callbacks are copied first,
+ * as a callback may destroy the meter, which stops calling the rest. */
+static void signal_levels_updated(struct obs_audio_analysis *analysis, size_t idx, bool loudness_updated)
 {
+	struct obs_volmeter *volmeter = analysis->levels.array[idx].volmeter;
+
+	if (!volmeter)
+		return;
+
 	pthread_mutex_lock(&volmeter->callback_mutex);
-	for (size_t i = volmeter->callbacks.num; i > 0; i--) {
-		struct meter_cb cb = volmeter->callbacks.array[i - 1];
-		cb.callback(cb.param, magnitude, peak, input_peak);
-	}
+	da_copy(analysis->emit_callbacks, volmeter->callbacks);
+	if (loudness_updated)
+		da_copy(analysis->emit_loudness_callbacks, volmeter->loudness_callbacks);
+	else
+		da_resize(analysis->emit_loudness_callbacks, 0);
 	pthread_mutex_unlock(&volmeter->callback_mutex);
+
+	for (size_t i = analysis->emit_callbacks.num; i > 0; i--) {
+		const struct meter_levels *levels = analysis->levels.array + idx;
+		struct meter_cb cb = analysis->emit_callbacks.array[i - 1];
+
+		if (!levels->volmeter)
+			return;
+		cb.callback(cb.param, levels->magnitude, levels->peak, levels->input_peak);
+	}
+
+	for (size_t i = analysis->emit_loudness_callbacks.num; i > 0; i--) {
+		const struct meter_levels *levels = analysis->levels.array + idx;
+		struct loudness_cb cb = analysis->emit_loudness_callbacks.array[i - 1];
+
+		if (!levels->volmeter)
+			return;
+		cb.callback(cb.param, levels->momentary, levels->short_term);
+	}
 }
 
 static void fader_source_volume_changed(void *vptr, calldata_t *calldata)
@@ -376,9 +452,11 @@ static float get_sample_peak(__m128 previous_samples, const float *samples, size
 	return r;
 }
 
-static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter, int channel_nr, float *samples,
+static void analysis_process_peak_last_samples(struct obs_audio_analysis *analysis, int channel_nr, float *samples,
 					       size_t nr_samples)
 {
+	float *prev_samples = analysis->prev_samples[channel_nr];
+
 	/* Take the last 4 samples that need to be used for the next peak
 	 * calculation. If there are less than 4 samples in total the new
 	 * samples shift out the old samples. */
@@ -387,32 +465,34 @@ static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter, int cha
 	case 0:
 		break;
 	case 1:
-		volmeter->prev_samples[channel_nr][0] = volmeter->prev_samples[channel_nr][1];
-		volmeter->prev_samples[channel_nr][1] = volmeter->prev_samples[channel_nr][2];
-		volmeter->prev_samples[channel_nr][2] = volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = prev_samples[1];
+		prev_samples[1] = prev_samples[2];
+		prev_samples[2] = prev_samples[3];
+		prev_samples[3] = samples[nr_samples - 1];
 		break;
 	case 2:
-		volmeter->prev_samples[channel_nr][0] = volmeter->prev_samples[channel_nr][2];
-		volmeter->prev_samples[channel_nr][1] = volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = prev_samples[2];
+		prev_samples[1] = prev_samples[3];
+		prev_samples[2] = samples[nr_samples - 2];
+		prev_samples[3] = samples[nr_samples - 1];
 		break;
 	case 3:
-		volmeter->prev_samples[channel_nr][0] = volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][1] = samples[nr_samples - 3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = prev_samples[3];
+		prev_samples[1] = samples[nr_samples - 3];
+		prev_samples[2] = samples[nr_samples - 2];
+		prev_samples[3] = samples[nr_samples - 1];
 		break;
 	default:
-		volmeter->prev_samples[channel_nr][0] = samples[nr_samples - 4];
-		volmeter->prev_samples[channel_nr][1] = samples[nr_samples - 3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = samples[nr_samples - 4];
+		prev_samples[1] = samples[nr_samples - 3];
+		prev_samples[2] = samples[nr_samples - 2];
+		prev_samples[3] = samples[nr_samples - 1];
 	}
 }
 
-static void volmeter_process_peak(obs_volmeter_t *volmeter, const struct audio_data *data, int nr_channels)
+/* Only the peak types used by the attached meters are calculated */
+static void analysis_process_peak(struct obs_audio_analysis *analysis, const struct audio_data *data, int nr_channels,
+				  bool sample_peak, bool true_peak)
 {
 	int nr_samples = data->frames;
 	int channel_nr = 0;
@@ -425,41 +505,35 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter, const struct audio_d
 			printf("Audio plane %i is not aligned %p skipping "
 			       "peak volume measurement.\n",
 			       plane_nr, samples);
-			volmeter->peak[channel_nr] = 1.0;
+			analysis->sample_peak[channel_nr] = 1.0;
+			analysis->true_peak[channel_nr] = 1.0;
 			channel_nr++;
 			continue;
 		}
 
-		/* volmeter->prev_samples may not be aligned to 16 bytes;
+		/* analysis->prev_samples may not be aligned to 16 bytes;
 		 * use unaligned load. */
-		__m128 previous_samples = _mm_loadu_ps(volmeter->prev_samples[channel_nr]);
-
-		float peak;
-		switch (volmeter->peak_meter_type) {
-		case TRUE_PEAK_METER:
-			peak = get_true_peak(previous_samples, samples, nr_samples);
-			break;
-
-		case SAMPLE_PEAK_METER:
-		default:
-			peak = get_sample_peak(previous_samples, samples, nr_samples);
-			break;
-		}
+		__m128 previous_samples = _mm_loadu_ps(analysis->prev_samples[channel_nr]);
 
-		volmeter_process_peak_last_samples(volmeter, channel_nr, samples, nr_samples);
+		if (true_peak)
+			analysis->true_peak[channel_nr] = get_true_peak(previous_samples, samples, nr_samples);
+		if (sample_peak)
+			analysis->sample_peak[channel_nr] = get_sample_peak(previous_samples, samples, nr_samples);
 
-		volmeter->peak[channel_nr] = peak;
+		analysis_process_peak_last_samples(analysis, channel_nr, samples, nr_samples);
 
 		channel_nr++;
 	}
 
 	/* Clear the peak of the channels that have not been handled. */
 	for (; channel_nr < MAX_AUDIO_CHANNELS; channel_nr++) {
-		volmeter->peak[channel_nr] = 0.0;
+		analysis->sample_peak[channel_nr] = 0.0;
+		analysis->true_peak[channel_nr] = 0.0;
 	}
 }
 
-static void volmeter_process_magnitude(obs_volmeter_t *volmeter, const struct audio_data *data, int nr_channels)
+static void analysis_process_magnitude(struct obs_audio_analysis *analysis, const struct audio_data *data,
+				       int nr_channels)
 {
 	size_t nr_samples = data->frames;
 
@@ -475,47 +549,199 @@ static void volmeter_process_magnitude(obs_volmeter_t *volmeter, const struct au
 			float sample = samples[i];
 			sum += sample * sample;
 		}
-		volmeter->magnitude[channel_nr] = sqrtf(sum / nr_samples);
+		analysis->magnitude[channel_nr] = sqrtf(sum / nr_samples);
 
 		channel_nr++;
 	}
 }
 
-static void volmeter_process_audio_data(obs_volmeter_t *volmeter, const struct audio_data *data)
+/* Returns true if a block ended and the loudness values changed */
+static bool analysis_process_loudness(struct obs_audio_analysis *analysis, const struct audio_data *data,
+				      int nr_channels)
 {
-	int nr_channels = get_nr_channels_from_audio_data(data);
+	const float *planes[MAX_AUDIO_CHANNELS];
+	size_t channels = 0;
 
-	volmeter_process_peak(volmeter, data, nr_channels);
-	volmeter_process_magnitude(volmeter, data, nr_channels);
+	for (int plane_nr = 0; channels < (size_t)nr_channels && plane_nr < MAX_AV_PLANES; plane_nr++) {
+		if (data->data[plane_nr])
+			planes[channels++] = (const float *)data->data[plane_nr];
+	}
+
+	return audio_loudness_process(&analysis->loudness, planes, channels, data->frames);
 }
 
-static void volmeter_source_data_received(void *vptr, obs_source_t *source, const struct audio_data *data, bool muted)
+static void volmeter_calc_levels(struct obs_volmeter *volmeter, struct obs_audio_analysis *analysis,
+				 obs_source_t *source, bool muted, struct meter_levels *out)
 {
-	struct obs_volmeter *volmeter = (struct obs_volmeter *)vptr;
 	float mul;
-	float magnitude[MAX_AUDIO_CHANNELS];
-	float peak[MAX_AUDIO_CHANNELS];
-	float input_peak[MAX_AUDIO_CHANNELS];
+	float *magnitude = out->magnitude;
+	float *peak = out->peak;
+	float *input_peak = out->input_peak;
+
+	out->volmeter = volmeter;
 
 	pthread_mutex_lock(&volmeter->mutex);
 
-	volmeter_process_audio_data(volmeter, data);
+	const float *levels = volmeter->peak_meter_type == TRUE_PEAK_METER ? analysis->true_peak
+									   : analysis->sample_peak;
 
 	// Adjust magnitude/peak based on the volume level set by the user.
 	// And convert to dB.
 	mul = muted && !obs_source_muted(source) ? 0.0f : db_to_mul(volmeter->cur_db);
 	for (int channel_nr = 0; channel_nr < MAX_AUDIO_CHANNELS; channel_nr++) {
-		magnitude[channel_nr] = mul_to_db(volmeter->magnitude[channel_nr] * mul);
-		peak[channel_nr] = mul_to_db(volmeter->peak[channel_nr] * mul);
+		magnitude[channel_nr] = mul_to_db(analysis->magnitude[channel_nr] * mul);
+		peak[channel_nr] = mul_to_db(levels[channel_nr] * mul);
 
 		/* The input-peak is NOT adjusted with volume, so that the user
 		 * can check the input-gain. */
-		input_peak[channel_nr] = mul_to_db(volmeter->peak[channel_nr]);
+		input_peak[channel_nr] = mul_to_db(levels[channel_nr]);
 	}
 
+	/* loudness is a power measurement, so the gain applies in dB */
+	out->momentary = analysis->loudness.momentary + mul_to_db(mul);
+	out->short_term = analysis->loudness.short_term + mul_to_db(mul);
+
 	pthread_mutex_unlock(&volmeter->mutex);
+}
+
+static void audio_analysis_free(struct obs_audio_analysis *analysis)
+{
+	da_free(analysis->meters);
+	da_free(analysis->levels);
+	da_free(analysis->emit_callbacks);
+	da_free(analysis->emit_loudness_callbacks);
+	pthread_mutex_destroy(&analysis->emit_mutex);
+	pthread_mutex_destroy(&analysis->mutex);
+	bfree(analysis);
+}
+
+static void analysis_data_received(void *vptr, obs_source_t *source, const struct audio_data *data, bool muted)
+{
+	struct obs_audio_analysis *analysis = vptr;
+	bool sample_peak = false;
+	bool true_peak = false;
+	bool loudness = false;
+	bool loudness_updated = false;
+
+	pthread_mutex_lock(&analysis->mutex);
+
+	for (size_t i = 0; i < analysis->meters.num; i++) {
+		struct obs_volmeter *volmeter = analysis->meters.array[i];
+
+		pthread_mutex_lock(&volmeter->mutex);
+		if (volmeter->peak_meter_type == TRUE_PEAK_METER)
+			true_peak = true;
+		else
+			sample_peak = true;
+		pthread_mutex_unlock(&volmeter->mutex);
+
+		pthread_mutex_lock(&volmeter->callback_mutex);
+		if (volmeter->loudness_callbacks.num)
+			loudness = true;
+		pthread_mutex_unlock(&volmeter->callback_mutex);
+	}
+
+	int nr_channels = get_nr_channels_from_audio_data(data);
+
+	analysis_process_peak(analysis, data, nr_channels, sample_peak, true_peak);
+	analysis_process_magnitude(analysis, data, nr_channels);
+
+	if (loudness) {
+		if (!analysis->loudness_active) {
+			struct obs_audio_info oai;
+			if (!obs_get_audio_info(&oai)) {
+				oai.samples_per_sec = 48000;
+				oai.speakers = SPEAKERS_STEREO;
+			}
+
+			audio_loudness_init(&analysis->loudness, oai.samples_per_sec, oai.speakers);
+			analysis->loudness_active = true;
+		}
+
+		loudness_updated = analysis_process_loudness(analysis, data, nr_channels);
+	} else {
+		analysis->loudness_active = false;
+	}
+
+	pthread_mutex_lock(&analysis->emit_mutex);
+
+	da_resize(analysis->levels, analysis->meters.num);
+	for (size_t i = 0; i < analysis->meters.num; i++)
+		volmeter_calc_levels(analysis->meters.array[i], analysis, source, muted, analysis->levels.array + i);
+
+	pthread_mutex_unlock(&analysis->mutex);
+
+	/* the callbacks are called without the analysis locked */
+	struct obs_audio_analysis *prev_analysis = emitting_analysis;
+	emitting_analysis = analysis;
+
+	for (size_t i = 0; i < analysis->levels.num; i++)
+		signal_levels_updated(analysis, i, loudness_updated);
+
+	emitting_analysis = prev_analysis;
+
+	/* the last meter was detached by one of the callbacks */
+	const bool destroy = analysis->destroy_after_emit;
+	pthread_mutex_unlock(&analysis->emit_mutex);
+
+	if (destroy)
+		audio_analysis_free(analysis);
+}
+
+static struct obs_audio_analysis *audio_analysis_get(obs_source_t *source)
+{
+	struct obs_audio_analysis *analysis;
+	bool created = false;
+
+	pthread_mutex_lock(&analysis_mutex);
+
+	analysis = source->audio_analysis;
+	if (!analysis) {
+		analysis = bzalloc(sizeof(struct obs_audio_analysis));
+		analysis->source = source;
+		pthread_mutex_init(&analysis->mutex, NULL);
+		pthread_mutex_init_recursive(&analysis->emit_mutex);
+
+		source->audio_analysis = analysis;
+		created = true;
+	}
+
+	analysis->refs++;
+
+	pthread_mutex_unlock(&analysis_mutex);
+
+	/* added without the global mutex, as meter callbacks called from
+	 * audio capture callbacks may attach meters */
+	if (created)
+		obs_source_add_audio_capture_callback(source, analysis_data_received, analysis);
+
+	return analysis;
+}
+
+static void audio_analysis_release(struct obs_audio_analysis *analysis)
+{
+	obs_source_t *source = analysis->source;
+	bool destroy;
+
+	pthread_mutex_lock(&analysis_mutex);
+	destroy = --analysis->refs == 0;
+	if (destroy)
+		source->audio_analysis = NULL;
+	pthread_mutex_unlock(&analysis_mutex);
 
-	signal_levels_updated(volmeter, magnitude, peak, input_peak);
+	if (!destroy)
+		return;
+
+	/* no longer called once removed */
+	obs_source_remove_audio_capture_callback(source, analysis_data_received, analysis);
+
+	/* released by a callback of its own meters, freed once they return */
+	if (emitting_analysis == analysis) {
+		analysis->destroy_after_emit = true;
+		return;
+	}
+
+	audio_analysis_free(analysis);
 }
 
 obs_fader_t *obs_fader_create(enum obs_fader_type type)
@@ -756,6 +982,7 @@ void obs_volmeter_destroy(obs_volmeter_t *volmeter)
 
 	obs_volmeter_detach_source(volmeter);
 	da_free(volmeter->callbacks);
+	da_free(volmeter->loudness_callbacks);
 	pthread_mutex_destroy(&volmeter->callback_mutex);
 	pthread_mutex_destroy(&volmeter->mutex);
 
@@ -764,6 +991,7 @@ void obs_volmeter_destroy(obs_volmeter_t *volmeter)
 
 bool obs_volmeter_attach_source(obs_volmeter_t *volmeter, obs_source_t *source)
 {
+	struct obs_audio_analysis *analysis;
 	signal_handler_t *sh;
 	float vol;
 
@@ -775,21 +1003,27 @@ bool obs_volmeter_attach_source(obs_volmeter_t *volmeter, obs_source_t *source)
 	sh = obs_source_get_signal_handler(source);
 	signal_handler_connect(sh, "volume", volmeter_source_volume_changed, volmeter);
 	signal_handler_connect(sh, "destroy", volmeter_source_destroyed, volmeter);
-	obs_source_add_audio_capture_callback(source, volmeter_source_data_received, volmeter);
+	analysis = audio_analysis_get(source);
 	vol = obs_source_get_volume(source);
 
 	pthread_mutex_lock(&volmeter->mutex);
 
 	volmeter->source = source;
+	volmeter->analysis = analysis;
 	volmeter->cur_db = mul_to_db(vol);
 
 	pthread_mutex_unlock(&volmeter->mutex);
 
+	pthread_mutex_lock(&analysis->mutex);
+	da_push_back(analysis->meters, &volmeter);
+	pthread_mutex_unlock(&analysis->mutex);
+
 	return true;
 }
 
 void obs_volmeter_detach_source(obs_volmeter_t *volmeter)
 {
+	struct obs_audio_analysis *analysis;
 	signal_handler_t *sh;
 	obs_source_t *source;
 
@@ -798,7 +1032,9 @@ void obs_volmeter_detach_source(obs_volmeter_t *volmeter)
 
 	pthread_mutex_lock(&volmeter->mutex);
 	source = volmeter->source;
+	analysis = volmeter->analysis;
 	volmeter->source = NULL;
+	volmeter->analysis = NULL;
 	pthread_mutex_unlock(&volmeter->mutex);
 
 	if (!source)
@@ -807,7 +1043,21 @@ void obs_volmeter_detach_source(obs_volmeter_t *volmeter)
 	sh = obs_source_get_signal_handler(source);
 	signal_handler_disconnect(sh, "volume", volmeter_source_volume_changed, volmeter);
 	signal_handler_disconnect(sh, "destroy", volmeter_source_destroyed, volmeter);
-	obs_source_remove_audio_capture_callback(source, volmeter_source_data_received, volmeter);
+
+	pthread_mutex_lock(&analysis->mutex);
+	da_erase_item(analysis->meters, &volmeter);
+	pthread_mutex_unlock(&analysis->mutex);
+
+	/* waits for callbacks being called on other threads, and keeps the
+	 * meter from being called by the rest of this block */
+	pthread_mutex_lock(&analysis->emit_mutex);
+	for (size_t i = 0; i < analysis->levels.num; i++) {
+		if (analysis->levels.array[i].volmeter == volmeter)
+			analysis->levels.array[i].volmeter = NULL;
+	}
+	pthread_mutex_unlock(&analysis->emit_mutex);
+
+	audio_analysis_release(analysis);
 }
 
 void obs_volmeter_set_peak_meter_type(obs_volmeter_t *volmeter, enum obs_peak_meter_type peak_meter_type)
@@ -862,6 +1112,32 @@ void obs_volmeter_remove_callback(obs_volmeter_t *volmeter, obs_volmeter_updated
 	pthread_mutex_unlock(&volmeter->callback_mutex);
 }
 
+void obs_volmeter_add_loudness_callback(obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+					void *param)
+{
+	struct loudness_cb cb = {callback, param};
+
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_add_loudness_callback"))
+		return;
+
+	pthread_mutex_lock(&volmeter->callback_mutex);
+	da_push_back(volmeter->loudness_callbacks, &cb);
+	pthread_mutex_unlock(&volmeter->callback_mutex);
+}
+
+void obs_volmeter_remove_loudness_callback(obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+					   void *param)
+{
+	struct loudness_cb cb = {callback, param};
+
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_remove_loudness_callback"))
+		return;
+
+	pthread_mutex_lock(&volmeter->callback_mutex);
+	da_erase_item(volmeter->loudness_callbacks, &cb);
+	pthread_mutex_unlock(&volmeter->callback_mutex);
+}
+
 float obs_mul_to_db(float mul)
 {
 	return mul_to_db(mul);
@@ -238,6 +238,28 @@ typedef void (*obs_volmeter_updated_t)(void *param, const float magnitude[MAX_AU
 EXPORT void obs_volmeter_add_callback(obs_volmeter_t *volmeter, obs_volmeter_updated_t callback, void *param);
 EXPORT void obs_volmeter_remove_callback(obs_volmeter_t *volmeter, obs_volmeter_updated_t callback, void *param);
 
+/**
+ * @brief Loudness callback
+ * @param momentary EBU R128 momentary loudness (400 ms) in LUFS
+ * @param short_term EBU R128 short-term loudness (3 s) in LUFS
+ *
+ * Called for every 100 ms of audio.  Like the levels, loudness is adjusted by
+ * the source volume.
+ */
+typedef void (*obs_volmeter_loudness_updated_t)(void *param, float momentary, float short_term);
+
+/**
+ * @brief Add a loudness callback
+ * @param volmeter pointer to the volume meter object
+ *
+ * Loudness of a source is only measured while a volume meter attached to it
+ * has loudness callbacks.
+ */
+EXPORT void obs_volmeter_add_loudness_callback(obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+					       void *param);
+EXPORT void obs_volmeter_remove_loudness_callback(obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+						  void *param);
+
 EXPORT float obs_mul_to_db(float mul);
 EXPORT float obs_db_to_mul(float db);
 
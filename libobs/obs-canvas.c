@@ -301,6 +301,9 @@ bool obs_canvas_reset_video_internal(obs_canvas_t *canvas, struct obs_video_info
 	if (ovi)
 		canvas->ovi = *ovi;
 
+	/* scene items save absolute positions based on the canvas size */
+	obs_save_changed_all();
+
 	canvas->mix = obs_create_video_mix(&canvas->ovi);
 	if (canvas->mix) {
 		canvas->mix->view = &canvas->view;
@@ -27,12 +27,17 @@
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <locale.h>
+#include <errno.h>
+#include <math.h>
+
+struct obs_data_arena;
 
 struct obs_data_item {
 	volatile long ref;
 	const char *name;
 	struct obs_data *parent;
+	struct obs_data_arena *arena;
 	UT_hash_handle hh;
 	enum obs_data_type type;
 	size_t name_len;
@@ -48,11 +53,13 @@ struct obs_data {
 	volatile long ref;
 	char *json;
 	struct obs_data_item *items;
+	struct obs_data_arena *arena;
 };
 
 struct obs_data_array {
 	volatile long ref;
 	DARRAY(obs_data_t *) objects;
+	struct obs_data_arena *arena;
 };
 
 struct obs_data_number {
@@ -73,9 +80,8 @@ static inline size_t get_align_size(size_t size)
 }
 
 /* ensures data after the name has alignment (in case of SSE) */
-static inline size_t get_name_align_size(const char *name)
+static inline size_t get_name_size_align_size(size_t name_size)
 {
-	size_t name_size = strlen(name) + 1;
 	size_t alignment = base_get_alignment();
 	size_t total_size;
 
@@ -85,6 +91,11 @@ static inline size_t get_name_align_size(const char *name)
 	return total_size - sizeof(struct obs_data_item);
 }
 
+static inline size_t get_name_align_size(const char *name)
+{
+	return get_name_size_align_size(strlen(name) + 1);
+}
+
 static inline char *get_item_name(struct obs_data_item *item)
 {
 	return (char *)item + sizeof(struct obs_data_item);
@@ -261,6 +272,86 @@ static inline void item_autoselect_data_addref(struct obs_data_item *item)
 	}
 }
 
+/* ------------------------------------------------------------------------- */
+/* Document arena
+ *
+ * Objects, arrays and items read from json are allocated from blocks owned by
+ * the document rather than one heap allocation each.  Every allocation holds a
+ * reference to the arena, the blocks are freed along with the last of them.
+ * Arena items that have to grow are moved to the heap. */
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+};
+
+struct obs_data_arena {
+	volatile long ref;
+	struct arena_block *blocks;
+};
+
+static struct obs_data_arena *obs_data_arena_create(void)
+{
+	struct obs_data_arena *arena = bzalloc(sizeof(struct obs_data_arena));
+	arena->ref = 1;
+
+	return arena;
+}
+
+static void obs_data_arena_release(struct obs_data_arena *arena)
+{
+	if (os_atomic_dec_long(&arena->ref) != 0)
+		return;
+
+	while (arena->blocks) {
+		struct arena_block *next = arena->blocks->next;
+		bfree(arena->blocks);
+		arena->blocks = next;
+	}
+
+	bfree(arena);
+}
+
+/* Only used by the parser, before any of the allocations are visible to other
+ * threads, so the reference does not have to be taken atomically. */
+static void *obs_data_arena_alloc(struct obs_data_arena *arena, size_t size)
+{
+	const size_t header_size = get_align_size(sizeof(struct arena_block));
+	struct arena_block *block = arena->blocks;
+	void *ptr;
+
+	size = get_align_size(size);
+
+	if (!block || block->used + size > block->size) {
+		bool dedicated = size > ARENA_BLOCK_SIZE / 4;
+		size_t block_size = dedicated ? size : ARENA_BLOCK_SIZE;
+		struct arena_block *new_block = bmalloc(header_size + block_size);
+
+		new_block->size = block_size;
+		new_block->used = 0;
+
+		/* large allocations get a block of their own, keep filling the
+		 * current block after it */
+		if (block && dedicated) {
+			new_block->next = block->next;
+			block->next = new_block;
+		} else {
+			new_block->next = block;
+			arena->blocks = new_block;
+		}
+
+		block = new_block;
+	}
+
+	ptr = (uint8_t *)block + header_size + block->used;
+	block->used += size;
+	arena->ref++;
+	return ptr;
+}
+
 static struct obs_data_item *obs_data_item_create(const char *name, const void *data, size_t size,
 						  enum obs_data_type type, bool default_data, bool autoselect_data)
 {
@@ -329,7 +420,15 @@ static struct obs_data_item *obs_data_item_ensure_capacity(struct obs_data_item
 	struct obs_data *parent = item->parent;
 	obs_data_item_detach(item);
 
-	new_item = brealloc(item, new_size);
+	if (item->arena) {
+		new_item = bmalloc(new_size);
+		memcpy(new_item, item, item->capacity);
+		obs_data_arena_release(item->arena);
+		new_item->arena = NULL;
+	} else {
+		new_item = brealloc(item, new_size);
+	}
+
 	new_item->capacity = new_size;
 	new_item->name = get_item_name(new_item);
 
@@ -347,7 +446,11 @@ static inline void obs_data_item_destroy(struct obs_data_item *item)
 	item_default_data_release(item);
 	item_autoselect_data_release(item);
 	obs_data_item_detach(item);
-	bfree(item);
+
+	if (item->arena)
+		obs_data_arena_release(item->arena);
+	else
+		bfree(item);
 }
 
 static inline void move_data(obs_data_item_t *old_item, void *old_data, obs_data_item_t *item, void *data, size_t len)
@@ -439,148 +542,881 @@ static inline void obs_data_item_set_autoselect_data(struct obs_data_item **p_it
 }
 
 /* ------------------------------------------------------------------------- */
+/* Json parser
+ *
+ * Reads the text in a single pass and creates objects, arrays and items as
+ * their values are read, without building a json tree first.  Accepts and
+ * rejects the same input as jansson did with JSON_REJECT_DUPLICATES. */
+
+#define JSON_MAX_DEPTH 2048
+
+struct json_parser {
+	const char *pos;
+	const char *error;
+	int line;
+	int depth;
+	char decimal_point;
+	struct obs_data_arena *arena;
+	struct dstr key;
+	struct dstr str;
+};
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json);
+static bool json_error(struct json_parser *p, const char *error)
+{
+	if (!p->error)
+		p->error = error;
+	return false;
+}
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+static inline void skip_whitespace(struct json_parser *p)
 {
-	const char *item_key;
-	json_t *jitem;
+	for (;;) {
+		char c = *p->pos;
+
+		if (c == '\n')
+			p->line++;
+		else if (c != ' ' && c != '\t' && c != '\r')
+			return;
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+		p->pos++;
 	}
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key, json_t *jobj)
+/* returns the length of the utf-8 sequence starting with a non-ascii byte,
+ * or 0 if it is invalid */
+static inline size_t utf8_sequence_len(const uint8_t *s)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	uint8_t c = s[0];
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+	if (c < 0xC2)
+		return 0;
+	if (c < 0xE0)
+		return (s[1] & 0xC0) == 0x80 ? 2 : 0;
+	if (c < 0xF0) {
+		if ((s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80)
+			return 0;
+		if ((c == 0xE0 && s[1] < 0xA0) || (c == 0xED && s[1] >= 0xA0))
+			return 0;
+		return 3;
+	}
+	if (c < 0xF5) {
+		if ((s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80)
+			return 0;
+		if ((c == 0xF0 && s[1] < 0x90) || (c == 0xF4 && s[1] >= 0x90))
+			return 0;
+		return 4;
+	}
+
+	return 0;
+}
+
+/* skips characters that can be copied as they are */
+static inline const char *scan_plain_chars(struct json_parser *p, const char *s)
+{
+	for (;;) {
+		uint8_t c = (uint8_t)*s;
+
+		if (c == '"' || c == '\\') {
+			return s;
+		} else if (c < 0x20) {
+			json_error(p, c ? "control character in string" : "premature end of input");
+			return NULL;
+		} else if (c < 0x80) {
+			s++;
+		} else {
+			size_t len = utf8_sequence_len((const uint8_t *)s);
+			if (!len) {
+				json_error(p, "invalid UTF-8 in string");
+				return NULL;
+			}
+			s += len;
+		}
+	}
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key, json_t *jarray)
+static inline void buf_append(struct dstr *buf, const char *data, size_t size)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	dstr_ensure_capacity(buf, buf->len + size + 1);
+	memcpy(buf->array + buf->len, data, size);
+	buf->len += size;
+}
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+static bool parse_hex4(const char *s, uint32_t *val)
+{
+	uint32_t v = 0;
 
-		if (!json_is_object(jitem))
-			continue;
+	for (int i = 0; i < 4; i++) {
+		char c = s[i];
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+		v <<= 4;
+		if (c >= '0' && c <= '9')
+			v |= (uint32_t)(c - '0');
+		else if (c >= 'a' && c <= 'f')
+			v |= (uint32_t)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			v |= (uint32_t)(c - 'A' + 10);
+		else
+			return false;
 	}
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
+	*val = v;
+	return true;
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json)
+static const char *parse_unicode_escape(struct json_parser *p, const char *s, struct dstr *buf)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
+	uint32_t cp, low;
+	char utf8[4];
+	size_t len;
+
+	if (!parse_hex4(s, &cp)) {
+		json_error(p, "invalid escape");
+		return NULL;
+	}
+	s += 4;
+
+	if (cp >= 0xD800 && cp <= 0xDBFF) {
+		if (s[0] != '\\' || s[1] != 'u' || !parse_hex4(s + 2, &low) || low < 0xDC00 || low > 0xDFFF) {
+			json_error(p, "invalid Unicode surrogate pair");
+			return NULL;
+		}
+		cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+		s += 6;
+
+	} else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+		json_error(p, "invalid Unicode surrogate pair");
+		return NULL;
+
+	} else if (cp == 0) {
+		json_error(p, "\\u0000 is not allowed");
+		return NULL;
+	}
+
+	if (cp < 0x80) {
+		utf8[0] = (char)cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		utf8[0] = (char)(0xC0 | (cp >> 6));
+		utf8[1] = (char)(0x80 | (cp & 0x3F));
+		len = 2;
+	} else if (cp < 0x10000) {
+		utf8[0] = (char)(0xE0 | (cp >> 12));
+		utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		utf8[2] = (char)(0x80 | (cp & 0x3F));
+		len = 3;
+	} else {
+		utf8[0] = (char)(0xF0 | (cp >> 18));
+		utf8[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		utf8[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		utf8[3] = (char)(0x80 | (cp & 0x3F));
+		len = 4;
+	}
+
+	buf_append(buf, utf8, len);
+	return s;
 }
 
-/* ------------------------------------------------------------------------- */
+/* Strings without escape sequences are returned in place, the others are
+ * unescaped into buf. */
+static bool parse_string(struct json_parser *p, struct dstr *buf, const char **str, size_t *len)
+{
+	const char *start = p->pos + 1;
+	const char *s = scan_plain_chars(p, start);
+
+	if (!s)
+		return false;
+
+	if (*s == '"') {
+		*str = start;
+		*len = (size_t)(s - start);
+		p->pos = s + 1;
+		return true;
+	}
+
+	buf->len = 0;
+	buf_append(buf, start, (size_t)(s - start));
+
+	while (*s == '\\') {
+		char c = s[1];
+		s += 2;
+
+		switch (c) {
+		case '"':
+		case '\\':
+		case '/':
+			buf_append(buf, &c, 1);
+			break;
+		case 'b':
+			buf_append(buf, "\b", 1);
+			break;
+		case 'f':
+			buf_append(buf, "\f", 1);
+			break;
+		case 'n':
+			buf_append(buf, "\n", 1);
+			break;
+		case 'r':
+			buf_append(buf, "\r", 1);
+			break;
+		case 't':
+			buf_append(buf, "\t", 1);
+			break;
+		case 'u':
+			s = parse_unicode_escape(p, s, buf);
+			if (!s)
+				return false;
+			break;
+		default:
+			return json_error(p, "invalid escape");
+		}
+
+		start = s;
+		s = scan_plain_chars(p, start);
+		if (!s)
+			return false;
+
+		buf_append(buf, start, (size_t)(s - start));
+	}
+
+	*str = buf->array;
+	*len = buf->len;
+	p->pos = s + 1;
+	return true;
+}
 
-static inline void set_json_string(json_t *json, const char *name, obs_data_item_t *item)
+static inline bool is_digit(char c)
 {
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	return c >= '0' && c <= '9';
 }
 
-static inline void set_json_number(json_t *json, const char *name, obs_data_item_t *item)
+static double parse_double(struct json_parser *p, const char *start, size_t len)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	char stack_buf[64];
+	char *buf = len < sizeof(stack_buf) ? stack_buf : bmalloc(len + 1);
+	double val;
+
+	memcpy(buf, start, len);
+	buf[len] = 0;
+
+	/* strtod uses the decimal point of the current locale */
+	if (p->decimal_point != '.') {
+		char *point = strchr(buf, '.');
+		if (point)
+			*point = p->decimal_point;
+	}
+
+	errno = 0;
+	val = strtod(buf, NULL);
+	if (errno == ERANGE && isinf(val))
+		json_error(p, "real number overflow");
+
+	if (buf != stack_buf)
+		bfree(buf);
+	return val;
+}
+
+static bool parse_number(struct json_parser *p, struct obs_data_number *num)
+{
+	const char *start = p->pos;
+	const char *s = start;
+	bool negative = *s == '-';
+	bool real = false;
+
+	if (negative)
+		s++;
+
+	if (*s == '0')
+		s++;
+	else if (is_digit(*s))
+		while (is_digit(*s))
+			s++;
+	else
+		return json_error(p, "invalid token");
+
+	size_t digits = (size_t)(s - start) - negative;
+
+	if (*s == '.') {
+		real = true;
+		if (!is_digit(*++s))
+			return json_error(p, "invalid token");
+		while (is_digit(*s))
+			s++;
+	}
+
+	if (*s == 'e' || *s == 'E') {
+		real = true;
+		s++;
+		if (*s == '+' || *s == '-')
+			s++;
+		if (!is_digit(*s))
+			return json_error(p, "invalid token");
+		while (is_digit(*s))
+			s++;
+	}
+
+	p->pos = s;
+
+	if (real) {
+		num->type = OBS_DATA_NUM_DOUBLE;
+		num->double_val = parse_double(p, start, (size_t)(s - start));
+		return !p->error;
+	}
+
+	num->type = OBS_DATA_NUM_INT;
+
+	/* up to 18 digits always fit */
+	if (digits <= 18) {
+		long long val = 0;
+		for (const char *d = start + negative; d < s; d++)
+			val = val * 10 + (*d - '0');
+		num->int_val = negative ? -val : val;
+		return true;
+	}
+
+	errno = 0;
+	num->int_val = strtoll(start, NULL, 10);
+	if (errno == ERANGE)
+		return json_error(p, "too big integer");
+
+	return true;
+}
+
+static obs_data_t *create_parsed_obj(struct json_parser *p)
+{
+	struct obs_data *data = obs_data_arena_alloc(p->arena, sizeof(struct obs_data));
+
+	memset(data, 0, sizeof(struct obs_data));
+	data->ref = 1;
+	data->arena = p->arena;
+	return data;
+}
+
+static obs_data_array_t *create_parsed_array(struct json_parser *p)
+{
+	struct obs_data_array *array = obs_data_arena_alloc(p->arena, sizeof(struct obs_data_array));
+
+	memset(array, 0, sizeof(struct obs_data_array));
+	array->ref = 1;
+	array->arena = p->arena;
+	return array;
+}
+
+/* Adds a user value item to the object, the value data is left for the caller
+ * to fill in */
+static void *add_parsed_item(struct json_parser *p, obs_data_t *data, const char *name, size_t name_len,
+			     enum obs_data_type type, size_t size)
+{
+	struct obs_data_item *item;
+	size_t name_size, total_size;
+	char *name_ptr;
+
+	HASH_FIND(hh, data->items, name, name_len, item);
+	if (item) {
+		json_error(p, "duplicate object key");
+		return NULL;
+	}
+
+	name_size = get_name_size_align_size(name_len + 1);
+	total_size = sizeof(struct obs_data_item) + name_size + size;
+
+	item = obs_data_arena_alloc(p->arena, total_size);
+	memset(item, 0, sizeof(struct obs_data_item));
+
+	item->ref = 1;
+	item->parent = data;
+	item->arena = p->arena;
+	item->capacity = total_size;
+	item->type = type;
+	item->name_len = name_size;
+	item->data_len = size;
+	item->data_size = size;
+
+	name_ptr = get_item_name(item);
+	memcpy(name_ptr, name, name_len);
+	name_ptr[name_len] = 0;
+	item->name = name_ptr;
+
+	HASH_ADD_KEYPTR(hh, data->items, item->name, name_len, item);
+	return get_data_ptr(item);
+}
+
+/* values without a parent are array elements that are not objects, they are
+ * validated but not stored */
+static bool add_parsed_value(struct json_parser *p, obs_data_t *parent, const char *name, size_t name_len,
+			     enum obs_data_type type, const void *val, size_t size)
+{
+	void *ptr;
+
+	if (!parent)
+		return true;
+
+	ptr = add_parsed_item(p, parent, name, name_len, type, size);
+	if (!ptr)
+		return false;
+
+	memcpy(ptr, val, size);
+	return true;
+}
+
+static bool parse_value(struct json_parser *p, obs_data_t *parent, const char *name, size_t name_len);
+
+static bool parse_object(struct json_parser *p, obs_data_t *data)
+{
+	if (++p->depth > JSON_MAX_DEPTH)
+		return json_error(p, "maximum parsing depth reached");
+
+	p->pos++;
+	skip_whitespace(p);
+
+	if (*p->pos == '}') {
+		p->pos++;
+		p->depth--;
+		return true;
+	}
+
+	for (;;) {
+		const char *name;
+		size_t name_len;
+
+		if (*p->pos != '"')
+			return json_error(p, "string or '}' expected");
+		if (!parse_string(p, &p->key, &name, &name_len))
+			return false;
+
+		skip_whitespace(p);
+		if (*p->pos != ':')
+			return json_error(p, "':' expected");
+
+		p->pos++;
+		skip_whitespace(p);
+
+		if (!parse_value(p, data, name, name_len))
+			return false;
+
+		skip_whitespace(p);
+		if (*p->pos == '}')
+			break;
+		if (*p->pos != ',')
+			return json_error(p, "'}' expected");
+
+		p->pos++;
+		skip_whitespace(p);
+	}
+
+	p->pos++;
+	p->depth--;
+	return true;
+}
+
+static bool parse_array(struct json_parser *p, obs_data_array_t *array)
+{
+	if (++p->depth > JSON_MAX_DEPTH)
+		return json_error(p, "maximum parsing depth reached");
+
+	p->pos++;
+	skip_whitespace(p);
+
+	if (*p->pos == ']') {
+		p->pos++;
+		p->depth--;
+		return true;
+	}
+
+	for (;;) {
+		if (*p->pos == '{') {
+			obs_data_t *obj = create_parsed_obj(p);
+			da_push_back(array->objects, &obj);
+
+			if (!parse_object(p, obj))
+				return false;
+
+		} else if (!parse_value(p, NULL, NULL, 0)) {
+			return false;
+		}
+
+		skip_whitespace(p);
+		if (*p->pos == ']')
+			break;
+		if (*p->pos != ',')
+			return json_error(p, "']' expected");
+
+		p->pos++;
+		skip_whitespace(p);
+	}
+
+	p->pos++;
+	p->depth--;
+	return true;
+}
+
+static bool parse_value(struct json_parser *p, obs_data_t *parent, const char *name, size_t name_len)
+{
+	const char *s = p->pos;
+
+	switch (*s) {
+	case '{': {
+		obs_data_t *obj = create_parsed_obj(p);
+		bool success;
+
+		if (!add_parsed_value(p, parent, name, name_len, OBS_DATA_OBJECT, &obj, sizeof(obj))) {
+			obs_data_release(obj);
+			return false;
+		}
+
+		success = parse_object(p, obj);
+		if (!parent)
+			obs_data_release(obj);
+		return success;
+	}
+
+	case '[': {
+		obs_data_array_t *array = create_parsed_array(p);
+		bool success;
+
+		if (!add_parsed_value(p, parent, name, name_len, OBS_DATA_ARRAY, &array, sizeof(array))) {
+			obs_data_array_release(array);
+			return false;
+		}
+
+		success = parse_array(p, array);
+		if (!parent)
+			obs_data_array_release(array);
+		return success;
+	}
+
+	case '"': {
+		const char *str;
+		size_t len;
+		char *ptr;
+
+		if (!parse_string(p, &p->str, &str, &len))
+			return false;
+		if (!parent)
+			return true;
+
+		ptr = add_parsed_item(p, parent, name, name_len, OBS_DATA_STRING, len + 1);
+		if (!ptr)
+			return false;
+
+		memcpy(ptr, str, len);
+		ptr[len] = 0;
+		return true;
+	}
+
+	case 't':
+	case 'f': {
+		bool val = *s == 't';
+		size_t len = val ? 4 : 5;
+
+		if (strncmp(s, val ? "true" : "false", len) != 0)
+			return json_error(p, "invalid token");
+
+		p->pos += len;
+		return add_parsed_value(p, parent, name, name_len, OBS_DATA_BOOLEAN, &val, sizeof(bool));
+	}
+
+	case 'n':
+		if (strncmp(s, "null", 4) != 0)
+			return json_error(p, "invalid token");
+
+		p->pos += 4;
+		return true;
+
+	case '\0':
+		return json_error(p, "premature end of input");
+
+	default: {
+		struct obs_data_number num;
+
+		if (!parse_number(p, &num))
+			return false;
+
+		return add_parsed_value(p, parent, name, name_len, OBS_DATA_NUMBER, &num,
+					sizeof(struct obs_data_number));
+	}
+	}
+}
+
+static obs_data_t *parse_json(const char *json_string, const char **error, int *line)
+{
+	struct json_parser p = {0};
+	obs_data_t *data;
+	bool success;
+
+	p.pos = json_string;
+	p.line = 1;
+	p.decimal_point = *localeconv()->decimal_point;
+	p.arena = obs_data_arena_create();
+
+	data = create_parsed_obj(&p);
+	skip_whitespace(&p);
+
+	if (*p.pos == '{') {
+		success = parse_object(&p, data);
+
+	} else if (*p.pos == '[') {
+		/* only objects map to obs_data, arrays read as empty objects */
+		obs_data_array_t *array = create_parsed_array(&p);
+		success = parse_array(&p, array);
+		obs_data_array_release(array);
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
 	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		success = json_error(&p, "'[' or '{' expected");
+	}
+
+	if (success) {
+		skip_whitespace(&p);
+		if (*p.pos)
+			success = json_error(&p, "end of file expected");
 	}
+
+	if (!success) {
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	*error = p.error;
+	*line = p.line;
+
+	obs_data_arena_release(p.arena);
+	dstr_free(&p.key);
+	dstr_free(&p.str);
+	return data;
 }
 
-static inline void set_json_bool(json_t *json, const char *name, obs_data_item_t *item)
+/* ------------------------------------------------------------------------- */
+/* Json writer
+ *
+ * Writes the items straight into the output string.  The output matches what
+ * jansson produced with JSON_PRESERVE_ORDER and either JSON_COMPACT or
+ * JSON_INDENT(4), values that jansson refused (invalid UTF-8, NaN and
+ * infinity) are left out the same way. */
+
+struct json_writer {
+	struct dstr out;
+	bool pretty;
+	bool with_defaults;
+};
+
+static inline void write_data(struct json_writer *w, const char *data, size_t size)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	buf_append(&w->out, data, size);
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults);
+static inline void write_char(struct json_writer *w, char c)
+{
+	dstr_ensure_capacity(&w->out, w->out.len + 2);
+	w->out.array[w->out.len++] = c;
+}
 
-static inline void set_json_obj(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+static inline void write_indent(struct json_writer *w, int depth)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj, with_defaults));
-	obs_data_release(obj);
+	if (!w->pretty)
+		return;
+
+	size_t size = 1 + (size_t)depth * 4;
+
+	dstr_ensure_capacity(&w->out, w->out.len + size + 1);
+	w->out.array[w->out.len] = '\n';
+	memset(w->out.array + w->out.len + 1, ' ', size - 1);
+	w->out.len += size;
 }
 
-static inline void set_json_array(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+/* validates the string and gets its length in the same pass */
+static bool utf8_check(const char *str, size_t *len)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t count = obs_data_array_count(array);
+	const char *s = str;
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item, with_defaults);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	while (*s) {
+		if ((uint8_t)*s < 0x80) {
+			s++;
+		} else {
+			size_t seq_len = utf8_sequence_len((const uint8_t *)s);
+			if (!seq_len)
+				return false;
+			s += seq_len;
+		}
 	}
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	*len = (size_t)(s - str);
+	return true;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults)
+static void write_string(struct json_writer *w, const char *str, size_t len)
 {
-	json_t *json = json_object();
+	static const char hex[] = "0123456789ABCDEF";
+	const char *end = str + len;
+	const char *run = str;
 
-	obs_data_item_t *item = NULL;
-	obs_data_item_t *temp = NULL;
+	write_char(w, '"');
 
-	HASH_ITER (hh, data->items, item, temp) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	for (const char *s = str; s < end; s++) {
+		uint8_t c = (uint8_t)*s;
+		char escape[6] = {'\\', 0};
+		size_t escape_len = 2;
 
-		if (!with_defaults && !obs_data_item_has_user_value(item))
+		if (c >= 0x20 && c != '"' && c != '\\')
 			continue;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item, with_defaults);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item, with_defaults);
+		switch (c) {
+		case '"':
+		case '\\':
+			escape[1] = (char)c;
+			break;
+		case '\b':
+			escape[1] = 'b';
+			break;
+		case '\f':
+			escape[1] = 'f';
+			break;
+		case '\n':
+			escape[1] = 'n';
+			break;
+		case '\r':
+			escape[1] = 'r';
+			break;
+		case '\t':
+			escape[1] = 't';
+			break;
+		default:
+			memcpy(escape + 1, "u00", 3);
+			escape[4] = hex[c >> 4];
+			escape[5] = hex[c & 0xF];
+			escape_len = 6;
+		}
+
+		write_data(w, run, (size_t)(s - run));
+		write_data(w, escape, escape_len);
+		run = s + 1;
+	}
+
+	write_data(w, run, (size_t)(end - run));
+	write_char(w, '"');
+}
+
+static size_t format_int(char *buf, long long val)
+{
+	unsigned long long uval = val < 0 ? 0ULL - (unsigned long long)val : (unsigned long long)val;
+	char digits[24];
+	size_t count = 0;
+	size_t len = 0;
+
+	do {
+		digits[count++] = (char)('0' + uval % 10);
+		uval /= 10;
+	} while (uval);
+
+	if (val < 0)
+		buf[len++] = '-';
+	while (count)
+		buf[len++] = digits[--count];
+
+	buf[len] = 0;
+	return len;
+}
+
+static void write_object(struct json_writer *w, obs_data_t *data, int depth);
+static void write_array(struct json_writer *w, obs_data_array_t *array, int depth);
+
+static bool write_item(struct json_writer *w, struct obs_data_item *item, int depth, bool first)
+{
+	const char *name = get_item_name(item);
+	const char *val = NULL;
+	size_t name_len, len = 0;
+	char num[64];
+
+	if (!utf8_check(name, &name_len))
+		return false;
+
+	switch (item->type) {
+	case OBS_DATA_STRING:
+		val = obs_data_item_get_string(item);
+		if (!utf8_check(val, &len))
+			return false;
+		break;
+
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT) {
+			len = format_int(num, obs_data_item_get_int(item));
+		} else {
+			double dval = obs_data_item_get_double(item);
+			int ret;
+
+			if (!isfinite(dval) || (ret = os_dtostr(dval, num, sizeof(num))) < 0)
+				return false;
+			len = (size_t)ret;
+		}
+		val = num;
+		break;
+
+	case OBS_DATA_BOOLEAN:
+		val = obs_data_item_get_bool(item) ? "true" : "false";
+		len = strlen(val);
+		break;
+
+	case OBS_DATA_OBJECT:
+	case OBS_DATA_ARRAY:
+		break;
+
+	default:
+		return false;
 	}
 
-	return json;
+	if (!first)
+		write_char(w, ',');
+	write_indent(w, depth);
+	write_string(w, name, name_len);
+	write_data(w, w->pretty ? ": " : ":", w->pretty ? 2 : 1);
+
+	if (item->type == OBS_DATA_STRING)
+		write_string(w, val, len);
+	else if (item->type == OBS_DATA_OBJECT)
+		write_object(w, get_item_obj(item), depth);
+	else if (item->type == OBS_DATA_ARRAY)
+		write_array(w, get_item_array(item), depth);
+	else
+		write_data(w, val, len);
+
+	return true;
+}
+
+static void write_object(struct json_writer *w, obs_data_t *data, int depth)
+{
+	struct obs_data_item *item, *temp;
+	bool first = true;
+
+	write_char(w, '{');
+
+	if (data) {
+		HASH_ITER (hh, data->items, item, temp) {
+			if (!w->with_defaults && !obs_data_item_has_user_value(item))
+				continue;
+			if (write_item(w, item, depth + 1, first))
+				first = false;
+		}
+	}
+
+	if (!first)
+		write_indent(w, depth);
+	write_char(w, '}');
+}
+
+static void write_array(struct json_writer *w, obs_data_array_t *array, int depth)
+{
+	size_t count = obs_data_array_count(array);
+
+	write_char(w, '[');
+
+	for (size_t idx = 0; idx < count; idx++) {
+		if (idx)
+			write_char(w, ',');
+		write_indent(w, depth + 1);
+		write_object(w, array->objects.array[idx], depth + 1);
+	}
+
+	if (count)
+		write_indent(w, depth);
+	write_char(w, ']');
 }
 
 /* ------------------------------------------------------------------------- */
@@ -595,21 +1431,18 @@ obs_data_t *obs_data_create()
 
 obs_data_t *obs_data_create_from_json(const char *json_string)
 {
-	obs_data_t *data = obs_data_create();
+	const char *error = "wrong arguments";
+	obs_data_t *data = NULL;
+	int line = -1;
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
+	if (json_string)
+		data = parse_json(json_string, &error, &line);
 
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
+	if (!data) {
 		blog(LOG_ERROR,
 		     "obs-data.c: [obs_data_create_from_json] "
 		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
-		obs_data_release(data);
-		data = NULL;
+		     line, error);
 	}
 
 	return data;
@@ -672,9 +1505,12 @@ static inline void obs_data_destroy(struct obs_data *data)
 		obs_data_item_release(&item);
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
-	bfree(data);
+	bfree(data->json);
+
+	if (data->arena)
+		obs_data_arena_release(data->arena);
+	else
+		bfree(data);
 }
 
 void obs_data_release(obs_data_t *data)
@@ -691,20 +1527,20 @@ static const char *obs_data_get_json_internal(obs_data_t *data, bool pretty, boo
 	if (!data)
 		return NULL;
 
-	size_t flags = JSON_PRESERVE_ORDER;
+	struct json_writer w = {0};
+	w.pretty = pretty;
+	w.with_defaults = with_defaults;
 
-	if (pretty)
-		flags |= JSON_INDENT(4);
-	else
-		flags |= JSON_COMPACT;
+	/* the previous output is usually a good estimate of the size */
+	if (data->json)
+		dstr_reserve(&w.out, strlen(data->json) + 1);
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
+	bfree(data->json);
 	data->json = NULL;
 
-	json_t *root = obs_data_to_json(data, with_defaults);
-	data->json = json_dumps(root, flags);
-	json_decref(root);
+	write_object(&w, data, 0);
+	w.out.array[w.out.len] = 0;
+	data->json = w.out.array;
 
 	return data->json;
 }
@@ -1282,6 +2118,150 @@ obs_data_array_t *obs_data_get_autoselect_array(obs_data_t *data, const char *na
 	return obs_data_item_get_autoselect_array(get_item(data, name));
 }
 
+/* ------------------------------------------------------------------------- */
+/* Keyed access */
+
+struct obs_data_key {
+	const char *name;
+	unsigned len;
+	unsigned hash;
+	UT_hash_handle hh;
+};
+
+static struct obs_data_key *interned_keys = NULL;
+static pthread_mutex_t interned_keys_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+const obs_data_key_t *obs_data_key(const char *name)
+{
+	struct obs_data_key *key;
+	unsigned len;
+
+	if (!name)
+		return NULL;
+
+	len = (unsigned)strlen(name);
+
+	pthread_mutex_lock(&interned_keys_mutex);
+	HASH_FIND(hh, interned_keys, name, len, key);
+
+	if (!key) {
+		key = bzalloc(sizeof(struct obs_data_key) + len + 1);
+		key->name = (char *)(key + 1);
+		key->len = len;
+		memcpy(key + 1, name, len + 1);
+
+		/* same hash uthash uses for the items */
+		HASH_VALUE(key->name, key->len, key->hash);
+		HASH_ADD_KEYPTR_BYHASHVALUE(hh, interned_keys, key->name, key->len, key->hash, key);
+	}
+
+	pthread_mutex_unlock(&interned_keys_mutex);
+	return key;
+}
+
+const char *obs_data_key_name(const obs_data_key_t *key)
+{
+	return key ? key->name : NULL;
+}
+
+void obs_data_free_keys(void)
+{
+	struct obs_data_key *key, *temp;
+
+	pthread_mutex_lock(&interned_keys_mutex);
+	HASH_ITER (hh, interned_keys, key, temp) {
+		HASH_DEL(interned_keys, key);
+		bfree(key);
+	}
+	pthread_mutex_unlock(&interned_keys_mutex);
+}
+
+static inline struct obs_data_item *get_item_by_key(struct obs_data *data, const struct obs_data_key *key)
+{
+	struct obs_data_item *item;
+
+	if (!data || !key)
+		return NULL;
+
+	HASH_FIND_BYHASHVALUE(hh, data->items, key->name, key->len, key->hash, item);
+	return item;
+}
+
+const char *obs_data_get_string_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_string(get_item_by_key(data, key));
+}
+
+long long obs_data_get_int_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_int(get_item_by_key(data, key));
+}
+
+double obs_data_get_double_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_double(get_item_by_key(data, key));
+}
+
+bool obs_data_get_bool_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_bool(get_item_by_key(data, key));
+}
+
+obs_data_t *obs_data_get_obj_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_obj(get_item_by_key(data, key));
+}
+
+obs_data_array_t *obs_data_get_array_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_array(get_item_by_key(data, key));
+}
+
+bool obs_data_has_user_value_by_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_has_user_value(get_item_by_key(data, key));
+}
+
+static void set_value(obs_data_t *data, const struct obs_data_value *value)
+{
+	obs_data_item_t *item = get_item_by_key(data, value->key);
+	const char *name = value->key->name;
+
+	switch (value->type) {
+	case OBS_DATA_STRING:
+		obs_set_string(data, &item, name, value->string, set_item);
+		break;
+	case OBS_DATA_NUMBER:
+		if (value->num_type == OBS_DATA_NUM_INT)
+			obs_set_int(data, &item, name, value->int_val, set_item);
+		else if (value->num_type == OBS_DATA_NUM_DOUBLE)
+			obs_set_double(data, &item, name, value->double_val, set_item);
+		break;
+	case OBS_DATA_BOOLEAN:
+		obs_set_bool(data, &item, name, value->bool_val, set_item);
+		break;
+	case OBS_DATA_OBJECT:
+		obs_set_obj(data, &item, name, value->obj, set_item);
+		break;
+	case OBS_DATA_ARRAY:
+		obs_set_array(data, &item, name, value->array, set_item);
+		break;
+	case OBS_DATA_NULL:
+		break;
+	}
+}
+
+void obs_data_set_values(obs_data_t *data, const struct obs_data_value *values, size_t count)
+{
+	if (!data || !values)
+		return;
+
+	for (size_t i = 0; i < count; i++) {
+		if (values[i].key)
+			set_value(data, &values[i]);
+	}
+}
+
 obs_data_array_t *obs_data_array_create()
 {
 	struct obs_data_array *array = bzalloc(sizeof(struct obs_data_array));
@@ -1302,7 +2282,11 @@ static inline void obs_data_array_destroy(obs_data_array_t *array)
 		for (size_t i = 0; i < array->objects.num; i++)
 			obs_data_release(array->objects.array[i]);
 		da_free(array->objects);
-		bfree(array);
+
+		if (array->arena)
+			obs_data_arena_release(array->arena);
+		else
+			bfree(array);
 	}
 }
 
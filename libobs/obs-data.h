@@ -138,6 +138,109 @@ EXPORT bool obs_data_get_autoselect_bool(obs_data_t *data, const char *name);
 EXPORT obs_data_t *obs_data_get_autoselect_obj(obs_data_t *data, const char *name);
 EXPORT obs_data_array_t *obs_data_get_autoselect_array(obs_data_t *data, const char *name);
 
+/* ------------------------------------------------------------------------- */
+/* Keyed access
+ *
+ *   Key handles are interned names with their hash computed up front, for
+ * settings that are read or written very often, such as in update callbacks.
+ * The same name always returns the same handle.  Handles can be kept around
+ * (for example in static variables) and stay valid until obs_shutdown.
+ */
+
+struct obs_data_key;
+typedef struct obs_data_key obs_data_key_t;
+
+EXPORT const obs_data_key_t *obs_data_key(const char *name);
+EXPORT const char *obs_data_key_name(const obs_data_key_t *key);
+
+EXPORT const char *obs_data_get_string_by_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT long long obs_data_get_int_by_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT double obs_data_get_double_by_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT bool obs_data_get_bool_by_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT obs_data_t *obs_data_get_obj_by_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT obs_data_array_t *obs_data_get_array_by_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT bool obs_data_has_user_value_by_key(obs_data_t *data, const obs_data_key_t *key);
+
+/*
+ * A value to set with obs_data_set_values, objects and arrays are referenced
+ * like with obs_data_set_obj/obs_data_set_array rather than copied.
+ */
+struct obs_data_value {
+	const obs_data_key_t *key;
+	enum obs_data_type type;
+	enum obs_data_number_type num_type;
+	union {
+		const char *string;
+		long long int_val;
+		double double_val;
+		bool bool_val;
+		obs_data_t *obj;
+		obs_data_array_t *array;
+	};
+};
+
+EXPORT void obs_data_set_values(obs_data_t *data, const struct obs_data_value *values, size_t count);
+
+static inline struct obs_data_value obs_data_value_string(const obs_data_key_t *key, const char *val)
+{
+	struct obs_data_value value;
+	value.key = key;
+	value.type = OBS_DATA_STRING;
+	value.num_type = OBS_DATA_NUM_INVALID;
+	value.string = val;
+	return value;
+}
+
+static inline struct obs_data_value obs_data_value_int(const obs_data_key_t *key, long long val)
+{
+	struct obs_data_value value;
+	value.key = key;
+	value.type = OBS_DATA_NUMBER;
+	value.num_type = OBS_DATA_NUM_INT;
+	value.int_val = val;
+	return value;
+}
+
+static inline struct obs_data_value obs_data_value_double(const obs_data_key_t *key, double val)
+{
+	struct obs_data_value value;
+	value.key = key;
+	value.type = OBS_DATA_NUMBER;
+	value.num_type = OBS_DATA_NUM_DOUBLE;
+	value.double_val = val;
+	return value;
+}
+
+static inline struct obs_data_value obs_data_value_bool(const obs_data_key_t *key, bool val)
+{
+	struct obs_data_value value;
+	value.key = key;
+	value.type = OBS_DATA_BOOLEAN;
+	value.num_type = OBS_DATA_NUM_INVALID;
+	value.bool_val = val;
+	return value;
+}
+
+static inline struct obs_data_value obs_data_value_obj(const obs_data_key_t *key, obs_data_t *val)
+{
+	struct obs_data_value value;
+	value.key = key;
+	value.type = OBS_DATA_OBJECT;
+	value.num_type = OBS_DATA_NUM_INVALID;
+	value.obj = val;
+	return value;
+}
+
+static inline struct obs_data_value obs_data_value_array(const obs_data_key_t *key, obs_data_array_t *val)
+{
+	struct obs_data_value value;
+	value.key = key;
+	value.type = OBS_DATA_ARRAY;
+	value.num_type = OBS_DATA_NUM_INVALID;
+	value.array = val;
+	return value;
+}
+
 /* Array functions */
 EXPORT obs_data_array_t *obs_data_array_create();
 EXPORT void obs_data_array_addref(obs_data_array_t *array);
@@ -17,6 +17,7 @@
 
 #include "obs.h"
 #include "obs-internal.h"
+#include "obs-packet-pool.h"
 #include "util/util_uint64.h"
 
 #define encoder_active(encoder) os_atomic_load_bool(&encoder->active)
@@ -25,6 +26,7 @@
 #define get_weak(encoder) ((obs_weak_encoder_t *)encoder->context.control)
 
 static void encoder_set_video(obs_encoder_t *encoder, video_t *video);
+static struct packet_pool packet_pool = {.mutex = PTHREAD_MUTEX_INITIALIZER};
 
 struct obs_encoder_info *find_encoder(const char *id)
 {
@@ -1227,7 +1229,6 @@ static void send_first_video_packet(struct obs_encoder *encoder, struct encoder_
 				    struct encoder_packet *packet, struct encoder_packet_time *packet_time)
 {
 	struct encoder_packet first_packet;
-	DARRAY(uint8_t) data;
 	uint8_t *sei;
 	size_t size;
 
@@ -1235,25 +1236,22 @@ static void send_first_video_packet(struct obs_encoder *encoder, struct encoder_
 	if (!packet->keyframe)
 		return;
 
-	da_init(data);
-
 	if (!get_sei(encoder, &sei, &size) || !sei || !size) {
 		cb->new_packet(cb->param, packet, packet_time);
 		cb->sent_first_packet = true;
 		return;
 	}
 
-	da_push_back_array(data, sei, size);
-	da_push_back_array(data, packet->data, packet->size);
-
 	first_packet = *packet;
-	first_packet.data = data.array;
-	first_packet.size = data.num;
+	first_packet.size = size + packet->size;
+	first_packet.data = packet_pool_alloc(&packet_pool, first_packet.size);
+	memcpy(first_packet.data, sei, size);
+	memcpy(first_packet.data + size, packet->data, packet->size);
 
 	cb->new_packet(cb->param, &first_packet, packet_time);
 	cb->sent_first_packet = true;
 
-	da_free(data);
+	obs_encoder_packet_release(&first_packet);
 }
 
 static const char *send_packet_name = "send_packet";
@@ -1338,10 +1336,19 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
-		for (size_t i = encoder->callbacks.num; i > 0; i--) {
-			struct encoder_callback *cb;
-			cb = encoder->callbacks.array + (i - 1);
-			send_packet(encoder, cb, pkt, found_ept ? &ept_local : NULL);
+		/* copy the packet out of the encoder once, every output then
+		 * holds a reference to the same buffer */
+		if (encoder->callbacks.num) {
+			struct encoder_packet shared;
+			obs_encoder_packet_create_instance(&shared, pkt);
+
+			for (size_t i = encoder->callbacks.num; i > 0; i--) {
+				struct encoder_callback *cb;
+				cb = encoder->callbacks.array + (i - 1);
+				send_packet(encoder, cb, &shared, found_ept ? &ept_local : NULL);
+			}
+
+			obs_encoder_packet_release(&shared);
 		}
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
@@ -1737,14 +1744,37 @@ void obs_encoder_remove_output(struct obs_encoder *encoder, struct obs_output *o
 	pthread_mutex_unlock(&encoder->outputs_mutex);
 }
 
-void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src)
+/* ------------------------------------------------------------------------- */
+/* packet buffer pool                                                        */
+
+void obs_encoder_packet_pool_init(void)
 {
-	long *p_refs;
+	packet_pool_init(&packet_pool);
+}
+
+void obs_encoder_packet_pool_free(void)
+{
+	struct obs_encoder_packet_pool_stats stats;
+
+	packet_pool_free(&packet_pool, &stats);
 
+	blog(LOG_DEBUG,
+	     "Encoder packet pool: %" PRIu64 " allocations, %" PRIu64 " reuses, %" PRIu64 " unpooled",
+	     stats.allocations, stats.reuses, stats.unpooled);
+}
+
+void obs_encoder_packet_pool_get_stats(struct obs_encoder_packet_pool_stats *stats)
+{
+	if (!stats)
+		return;
+
+	packet_pool_get_stats(&packet_pool, stats);
+}
+
+void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src)
+{
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
+	dst->data = packet_pool_alloc(&packet_pool, src->size);
 	memcpy(dst->data, src->data, src->size);
 }
 
@@ -1766,11 +1796,8 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 	if (!pkt)
 		return;
 
-	if (pkt->data) {
-		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
-			bfree(p_refs);
-	}
+	if (pkt->data)
+		packet_pool_release(&packet_pool, pkt->data);
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
 }
@@ -464,6 +464,9 @@ static inline void create_binding(obs_hotkey_t *hotkey, obs_key_combination_t co
 	binding->key = combo;
 	binding->hotkey_id = hotkey->id;
 	binding->hotkey = hotkey;
+
+	/* bindings are saved with their registerer */
+	obs_save_changed_all();
 }
 
 static inline void load_binding(obs_hotkey_t *hotkey, obs_data_t *data)
@@ -814,6 +817,9 @@ static inline bool remove_bindings(obs_hotkey_id id)
 		removed = true;
 	}
 
+	if (removed)
+		obs_save_changed_all();
+
 	return removed;
 }
 
@@ -0,0 +1,392 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#include "obs.h"
+#include "obs-internal.h"
+
+#define IMAGE_CACHE_DEFAULT_BUDGET (256ULL * 1024ULL * 1024ULL)
+
+enum cached_image_state {
+	CACHED_IMAGE_PENDING,
+	CACHED_IMAGE_DECODING,
+	CACHED_IMAGE_DECODED,
+};
+
+struct obs_cached_image {
+	/* path, modification time and alpha mode */
+	char *key;
+	char *path;
+	enum gs_image_alpha_mode alpha_mode;
+
+	/* guarded by the cache mutex, the decode task holds a reference until
+	 * decoding finished */
+	long refs;
+	struct obs_cached_image *prev_unused;
+	struct obs_cached_image *next_unused;
+
+	/* taken by whoever waits on the image first, so a pending decode task
+	 * can be canceled and run on the waiting thread instead */
+	os_task_handle_t *volatile task;
+	volatile long state;
+	os_event_t *decoded_event;
+
+	/* set before the state changes to decoded */
+	uint8_t *data;
+	enum gs_color_format format;
+	enum gs_color_space space;
+	uint32_t cx;
+	uint32_t cy;
+	uint64_t size;
+
+	/* created from the data on first use, guarded by the cache mutex */
+	gs_texture_t *volatile texture;
+
+	UT_hash_handle hh;
+};
+
+static struct {
+	pthread_mutex_t mutex;
+	struct obs_cached_image *images;
+
+	/* images no longer in use, least recently used first */
+	struct obs_cached_image *first_unused;
+	struct obs_cached_image *last_unused;
+
+	struct obs_image_cache_stats stats;
+} cache = {.mutex = PTHREAD_MUTEX_INITIALIZER, .stats = {.budget = IMAGE_CACHE_DEFAULT_BUDGET}};
+
+static void cached_image_destroy(struct obs_cached_image *image)
+{
+	if (image->texture) {
+		obs_enter_graphics();
+		gs_texture_destroy(image->texture);
+		obs_leave_graphics();
+	}
+
+	if (image->task)
+		os_task_handle_release(image->task);
+
+	os_event_destroy(image->decoded_event);
+	bfree(image->data);
+	bfree(image->path);
+	bfree(image->key);
+	bfree(image);
+}
+
+static void destroy_list(struct obs_cached_image *image)
+{
+	while (image) {
+		struct obs_cached_image *next = image->next_unused;
+		cached_image_destroy(image);
+		image = next;
+	}
+}
+
+/* Called with the cache mutex held */
+static void remove_unused(struct obs_cached_image *image)
+{
+	if (image->prev_unused)
+		image->prev_unused->next_unused = image->next_unused;
+	else
+		cache.first_unused = image->next_unused;
+
+	if (image->next_unused)
+		image->next_unused->prev_unused = image->prev_unused;
+	else
+		cache.last_unused = image->prev_unused;
+
+	image->prev_unused = NULL;
+	image->next_unused = NULL;
+	cache.stats.bytes_unused -= image->size;
+}
+
+/* Called with the cache mutex held */
+static void add_unused(struct obs_cached_image *image)
+{
+	image->prev_unused = cache.last_unused;
+	image->next_unused = NULL;
+
+	if (cache.last_unused)
+		cache.last_unused->next_unused = image;
+	else
+		cache.first_unused = image;
+
+	cache.last_unused = image;
+	cache.stats.bytes_unused += image->size;
+}
+
+/* Called with the cache mutex held, evicted images are returned as a list so
+ * they can be destroyed without holding the mutex */
+static struct obs_cached_image *evict(bool all)
+{
+	struct obs_cached_image *evicted = NULL;
+
+	while (cache.first_unused && (all || cache.stats.bytes > cache.stats.budget)) {
+		struct obs_cached_image *image = cache.first_unused;
+
+		remove_unused(image);
+		HASH_DEL(cache.images, image);
+
+		cache.stats.bytes -= image->size;
+		cache.stats.images--;
+		cache.stats.evictions++;
+
+		image->next_unused = evicted;
+		evicted = image;
+	}
+
+	return evicted;
+}
+
+/* Called with the cache mutex held, returns the images to destroy */
+static struct obs_cached_image *release_locked(struct obs_cached_image *image)
+{
+	if (--image->refs != 0)
+		return NULL;
+
+	if (!image->size) {
+		/* images that failed to load are not kept */
+		HASH_DEL(cache.images, image);
+		cache.stats.images--;
+		image->next_unused = NULL;
+		return image;
+	}
+
+	add_unused(image);
+	return evict(false);
+}
+
+/* Returns false if the image was already being decoded elsewhere.  When
+ * called from the decode task, the reference of the task is dropped together
+ * with publishing the result, so whoever waited on the image sees the final
+ * reference count. */
+static bool cached_image_decode(struct obs_cached_image *image, bool from_task)
+{
+	struct obs_cached_image *evicted = NULL;
+
+	if (!os_atomic_compare_swap_long(&image->state, CACHED_IMAGE_PENDING, CACHED_IMAGE_DECODING))
+		return false;
+
+	image->data = gs_create_texture_file_data3(image->path, image->alpha_mode, &image->format, &image->cx,
+						   &image->cy, &image->space);
+	if (image->data) {
+		image->size = (uint64_t)image->cx * image->cy * gs_get_format_bpp(image->format) / 8;
+	} else {
+		blog(LOG_WARNING, "Image cache: Failed to load file '%s'", image->path);
+		image->cx = 0;
+		image->cy = 0;
+	}
+
+	pthread_mutex_lock(&cache.mutex);
+	cache.stats.bytes += image->size;
+	os_atomic_set_long(&image->state, CACHED_IMAGE_DECODED);
+	os_event_signal(image->decoded_event);
+	if (from_task)
+		evicted = release_locked(image);
+	pthread_mutex_unlock(&cache.mutex);
+
+	destroy_list(evicted);
+	return true;
+}
+
+static void decode_task(void *param)
+{
+	struct obs_cached_image *image = param;
+
+	if (!cached_image_decode(image, true))
+		obs_cached_image_release(image);
+}
+
+static inline int64_t get_modified_time(const char *path)
+{
+	struct stat stats;
+	if (os_stat(path, &stats) != 0)
+		return -1;
+	return (int64_t)stats.st_mtime;
+}
+
+obs_cached_image_t *obs_image_cache_get(const char *path, enum gs_image_alpha_mode alpha_mode)
+{
+	struct obs_cached_image *image;
+	struct dstr key = {0};
+	bool created = false;
+
+	if (!path || !*path)
+		return NULL;
+
+	dstr_printf(&key, "%d:%" PRId64 ":%s", (int)alpha_mode, get_modified_time(path), path);
+
+	pthread_mutex_lock(&cache.mutex);
+
+	HASH_FIND_STR(cache.images, key.array, image);
+	if (image) {
+		if (image->refs++ == 0)
+			remove_unused(image);
+
+		cache.stats.hits++;
+		dstr_free(&key);
+	} else {
+		image = bzalloc(sizeof(struct obs_cached_image));
+		image->key = key.array;
+		image->path = bstrdup(path);
+		image->alpha_mode = alpha_mode;
+		image->refs = 2;
+		os_event_init(&image->decoded_event, OS_EVENT_TYPE_MANUAL);
+
+		HASH_ADD_KEYPTR(hh, cache.images, image->key, key.len, image);
+		cache.stats.misses++;
+		cache.stats.images++;
+		created = true;
+	}
+
+	pthread_mutex_unlock(&cache.mutex);
+
+	if (created) {
+		os_task_pool_t *pool = obs_get_task_pool();
+		os_task_handle_t *task = NULL;
+
+		if (pool)
+			task = os_task_pool_schedule(pool, OS_TASK_PRIORITY_NORMAL, 0, 0, decode_task, image);
+
+		if (task)
+			os_atomic_store_ptr((void *volatile *)&image->task, task);
+		else
+			decode_task(image);
+	}
+
+	return image;
+}
+
+void obs_cached_image_release(obs_cached_image_t *image)
+{
+	struct obs_cached_image *evicted = NULL;
+
+	if (!image)
+		return;
+
+	pthread_mutex_lock(&cache.mutex);
+	evicted = release_locked(image);
+	pthread_mutex_unlock(&cache.mutex);
+
+	destroy_list(evicted);
+}
+
+bool obs_cached_image_decoded(obs_cached_image_t *image)
+{
+	return image && os_atomic_load_long(&image->state) == CACHED_IMAGE_DECODED;
+}
+
+void obs_cached_image_wait(obs_cached_image_t *image)
+{
+	if (!image)
+		return;
+
+	os_task_handle_t *task = os_atomic_exchange_ptr((void *volatile *)&image->task, NULL);
+
+	/* a running task is waited for by the cancel, a pending one is run
+	 * here instead of waiting for a worker to pick it up */
+	if (task && os_task_cancel(task))
+		decode_task(image);
+	else
+		cached_image_decode(image, false);
+
+	os_event_wait(image->decoded_event);
+}
+
+bool obs_cached_image_loaded(obs_cached_image_t *image)
+{
+	return obs_cached_image_decoded(image) && image->size;
+}
+
+uint32_t obs_cached_image_get_width(obs_cached_image_t *image)
+{
+	return obs_cached_image_decoded(image) ? image->cx : 0;
+}
+
+uint32_t obs_cached_image_get_height(obs_cached_image_t *image)
+{
+	return obs_cached_image_decoded(image) ? image->cy : 0;
+}
+
+enum gs_color_space obs_cached_image_get_color_space(obs_cached_image_t *image)
+{
+	return obs_cached_image_decoded(image) ? image->space : GS_CS_SRGB;
+}
+
+uint64_t obs_cached_image_get_mem_usage(obs_cached_image_t *image)
+{
+	return obs_cached_image_decoded(image) ? image->size : 0;
+}
+
+gs_texture_t *obs_cached_image_get_texture(obs_cached_image_t *image)
+{
+	gs_texture_t *texture;
+
+	if (!obs_cached_image_decoded(image))
+		return NULL;
+
+	texture = os_atomic_load_ptr((void *const volatile *)&image->texture);
+	if (texture || !image->size)
+		return texture;
+
+	pthread_mutex_lock(&cache.mutex);
+	texture = image->texture;
+	if (!texture && image->data) {
+		texture = gs_texture_create(image->cx, image->cy, image->format, 1, (const uint8_t **)&image->data, 0);
+		os_atomic_store_ptr((void *volatile *)&image->texture, texture);
+
+		/* the texture is the only copy from now on */
+		bfree(image->data);
+		image->data = NULL;
+	}
+	pthread_mutex_unlock(&cache.mutex);
+
+	return texture;
+}
+
+void obs_image_cache_set_budget(uint64_t bytes)
+{
+	struct obs_cached_image *evicted;
+
+	pthread_mutex_lock(&cache.mutex);
+	cache.stats.budget = bytes;
+	evicted = evict(false);
+	pthread_mutex_unlock(&cache.mutex);
+
+	destroy_list(evicted);
+}
+
+void obs_image_cache_get_stats(struct obs_image_cache_stats *stats)
+{
+	if (!stats)
+		return;
+
+	pthread_mutex_lock(&cache.mutex);
+	*stats = cache.stats;
+	pthread_mutex_unlock(&cache.mutex);
+}
+
+/* Called on shutdown once the task pool has no more decode tasks, all
+ * sources are destroyed at this point */
+void obs_image_cache_free(void)
+{
+	struct obs_cached_image *evicted;
+	struct obs_image_cache_stats stats;
+
+	pthread_mutex_lock(&cache.mutex);
+	evicted = evict(true);
+	stats = cache.stats;
+	pthread_mutex_unlock(&cache.mutex);
+
+	destroy_list(evicted);
+
+	if (stats.images)
+		blog(LOG_WARNING, "Image cache: %" PRIu64 " images still in use on shutdown", stats.images);
+
+	blog(LOG_DEBUG, "Image cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions", stats.hits,
+	     stats.misses, stats.evictions);
+}
@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "util/bmem.h"
+#include "obs.h"
+
+/*
+ * Interleave buffer of an output: a ring of encoder packets kept sorted by
+ * DTS.  Insertion position is found with a binary search and only the shorter
+ * side of the ring is shifted, so packets that arrive (nearly) in order are
+ * inserted in constant time and sending from the front never moves the rest of
+ * the buffer.
+ */
+
+struct interleaved_packets {
+	struct encoder_packet *array;
+	size_t capacity; /* always a power of two */
+	size_t head;
+	size_t num;
+};
+
+static inline struct encoder_packet *interleaved_packet(const struct interleaved_packets *ip, size_t idx)
+{
+	return &ip->array[(ip->head + idx) & (ip->capacity - 1)];
+}
+
+/* Returns true if packet has to be placed before cur.  Video packets with the
+ * same DTS are sorted by track index (to prevent the pruning logic from
+ * removing additional video tracks) and placed before audio packets, audio
+ * packets with the same DTS stay in the order they arrived. */
+static inline bool interleave_before(const struct encoder_packet *packet, const struct encoder_packet *cur)
+{
+	if (packet->dts_usec != cur->dts_usec)
+		return packet->dts_usec < cur->dts_usec;
+	if (packet->type != OBS_ENCODER_VIDEO)
+		return false;
+
+	return cur->type != OBS_ENCODER_VIDEO || packet->track_idx <= cur->track_idx;
+}
+
+static inline void interleaved_packets_reserve(struct interleaved_packets *ip, size_t capacity)
+{
+	struct encoder_packet *array;
+	size_t new_capacity = ip->capacity ? ip->capacity : 16;
+
+	if (capacity <= ip->capacity)
+		return;
+	while (new_capacity < capacity)
+		new_capacity *= 2;
+
+	array = bmalloc(new_capacity * sizeof(struct encoder_packet));
+	for (size_t i = 0; i < ip->num; i++)
+		array[i] = *interleaved_packet(ip, i);
+
+	bfree(ip->array);
+	ip->array = array;
+	ip->capacity = new_capacity;
+	ip->head = 0;
+}
+
+static inline void interleaved_packets_insert(struct interleaved_packets *ip, const struct encoder_packet *packet)
+{
+	size_t lo = 0;
+	size_t hi = ip->num;
+
+	/* packets almost always arrive in order, check the back first */
+	if (ip->num && interleave_before(packet, interleaved_packet(ip, ip->num - 1))) {
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (interleave_before(packet, interleaved_packet(ip, mid)))
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+	} else {
+		lo = ip->num;
+	}
+
+	interleaved_packets_reserve(ip, ip->num + 1);
+
+	if (lo < ip->num - lo) {
+		ip->head = (ip->head - 1) & (ip->capacity - 1);
+		for (size_t i = 0; i < lo; i++)
+			*interleaved_packet(ip, i) = *interleaved_packet(ip, i + 1);
+	} else {
+		for (size_t i = ip->num; i > lo; i--)
+			*interleaved_packet(ip, i) = *interleaved_packet(ip, i - 1);
+	}
+
+	*interleaved_packet(ip, lo) = *packet;
+	ip->num++;
+}
+
+/* removes packets from the front without releasing them */
+static inline void interleaved_packets_pop_front(struct interleaved_packets *ip, size_t count)
+{
+	if (count > ip->num)
+		count = ip->num;
+
+	ip->head = (ip->head + count) & (ip->capacity - 1);
+	ip->num -= count;
+}
+
+static inline void interleaved_packets_free(struct interleaved_packets *ip)
+{
+	bfree(ip->array);
+	memset(ip, 0, sizeof(*ip));
+}
@@ -24,6 +24,7 @@
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
+#include "util/frame-timeline.h"
 #include "util/task.h"
 #include "util/uthash.h"
 #include "util/array-serializer.h"
@@ -38,6 +39,7 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-interleave.h"
 
 #include <obsversion.h>
 #include <caption/caption.h>
@@ -296,6 +298,11 @@ struct obs_core_video_mix {
 	struct deque vframe_info_buffer;
 	struct deque vframe_info_buffer_gpu;
 	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
+	bool mapped_surfaces_shared;
+	os_event_t *mapped_surfaces_released;
+	gs_stagesurf_t *held_surfaces[NUM_CHANNELS];
+	gs_stagesurf_t *spare_surfaces[NUM_CHANNELS];
+	bool holding_surfaces;
 	int cur_texture;
 	volatile long raw_active;
 	volatile long gpu_encoder_active;
@@ -371,6 +378,14 @@ struct obs_core_video {
 	float sdr_white_level;
 	float hdr_nominal_peak_level;
 
+	volatile bool zero_copy;
+
+	volatile bool parallel_tick;
+	os_work_pool_t *tick_pool;
+
+	/* kept across video resets, applied when graphics are initialized */
+	char *effect_cache_path;
+
 	pthread_mutex_t task_mutex;
 	struct deque tasks;
 
@@ -440,12 +455,21 @@ struct obs_core_data {
 
 	long long unnamed_index;
 
+	/* number of obs_load_sources_parallel calls in progress */
+	volatile long sources_loading;
+
+	/* increasing counter for changes to the saved state of sources, and the
+	 * value it had when all saved state was last invalidated */
+	volatile long save_gen;
+	volatile long save_reset_gen;
+
 	obs_data_t *private_data;
 
 	volatile bool valid;
 
 	DARRAY(char *) protocols;
 	DARRAY(obs_source_t *) sources_to_tick;
+	DARRAY(uint64_t) source_tick_times;
 };
 
 /* user hotkeys */
@@ -514,6 +538,7 @@ struct obs_core {
 	struct obs_core_hotkeys hotkeys;
 
 	os_task_queue_t *destruction_task_thread;
+	os_task_pool_t *task_pool;
 
 	obs_task_handler_t ui_task_handler;
 };
@@ -688,12 +713,61 @@ extern void obs_canvas_rename_source(obs_source_t *source, const char *name);
 /* ------------------------------------------------------------------------- */
 /* sources  */
 
+/* capacity of the per-source async frame queue, must be a power of two */
+#define MAX_ASYNC_FRAMES 64
+#define DEFAULT_ASYNC_FRAMES 30
+#define ASYNC_CACHE_SIZE (MAX_ASYNC_FRAMES + 8)
+
 struct async_frame {
 	struct obs_source_frame *frame;
 	long unused_count;
-	bool used;
+	volatile bool used;
+};
+
+/* Single-producer/single-consumer ring of queued async frames.  The producer
+ * side is only touched with async_output_mutex held, the consumer side only
+ * with async_mutex held, so the two never contend with each other. */
+struct async_frame_queue {
+	struct obs_source_frame *frames[MAX_ASYNC_FRAMES];
+	volatile long head;
+	volatile long tail;
 };
 
+static inline size_t async_queue_size(const struct async_frame_queue *queue)
+{
+	unsigned long tail = (unsigned long)os_atomic_load_long(&queue->tail);
+	unsigned long head = (unsigned long)os_atomic_load_long(&queue->head);
+	return (size_t)(head - tail);
+}
+
+static inline struct obs_source_frame *async_queue_peek(const struct async_frame_queue *queue, size_t idx)
+{
+	unsigned long tail = (unsigned long)os_atomic_load_long(&queue->tail);
+	return queue->frames[(tail + idx) & (MAX_ASYNC_FRAMES - 1)];
+}
+
+static inline struct obs_source_frame *async_queue_pop(struct async_frame_queue *queue)
+{
+	unsigned long tail = (unsigned long)os_atomic_load_long(&queue->tail);
+	struct obs_source_frame *frame = queue->frames[tail & (MAX_ASYNC_FRAMES - 1)];
+
+	os_atomic_set_long(&queue->tail, (long)(tail + 1));
+	return frame;
+}
+
+static inline bool async_queue_push(struct async_frame_queue *queue, struct obs_source_frame *frame)
+{
+	unsigned long head = (unsigned long)os_atomic_load_long(&queue->head);
+	unsigned long tail = (unsigned long)os_atomic_load_long(&queue->tail);
+
+	if (head - tail >= MAX_ASYNC_FRAMES)
+		return false;
+
+	queue->frames[head & (MAX_ASYNC_FRAMES - 1)] = frame;
+	os_atomic_set_long(&queue->head, (long)(head + 1));
+	return true;
+}
+
 enum audio_action_type {
 	AUDIO_ACTION_VOL,
 	AUDIO_ACTION_MUTE,
@@ -816,11 +890,15 @@ struct obs_source {
 	pthread_mutex_t audio_mutex;
 	pthread_mutex_t audio_cb_mutex;
 	DARRAY(struct audio_cb_info) audio_cb_list;
+	/* level analysis shared by the volume meters of the source, guarded
+	 * by a mutex in obs-audio-controls.c */
+	struct obs_audio_analysis *audio_analysis;
 	struct obs_audio_data audio_data;
 	size_t audio_storage_size;
 	uint32_t audio_mixers;
 	float user_volume;
 	float volume;
+	signal_t *volume_signal;
 	int64_t sync_offset;
 	int64_t last_sync_offset;
 	float balance;
@@ -846,9 +924,14 @@ struct obs_source {
 	bool async_unbuffered;
 	bool async_decoupled;
 	struct obs_source_frame *async_preload_frame;
-	DARRAY(struct async_frame) async_cache;
-	DARRAY(struct obs_source_frame *) async_frames;
+	struct async_frame async_cache[ASYNC_CACHE_SIZE];
+	struct async_frame_queue async_frames;
 	pthread_mutex_t async_mutex;
+	pthread_mutex_t async_output_mutex;
+	volatile long async_queue_depth;
+	volatile long async_drop_policy;
+	volatile long async_frames_dropped;
+	volatile long async_frames_late;
 	uint32_t async_width;
 	uint32_t async_height;
 	uint32_t async_cache_width;
@@ -936,6 +1019,12 @@ struct obs_source {
 	/* private data */
 	obs_data_t *private_settings;
 
+	/* last change to the saved state of the source, and the data saved by
+	 * obs_save_sources_filtered which is reused until the next change */
+	volatile long save_gen;
+	long saved_gen;
+	obs_data_t *save_data;
+
 	/* canvas this source belongs to (only used for scenes) */
 	obs_weak_canvas_t *canvas;
 };
@@ -965,6 +1054,10 @@ extern obs_source_t *obs_source_create_set_last_ver(obs_canvas_t *canvas, const
 extern void obs_source_destroy(struct obs_source *source);
 extern void obs_source_addref(obs_source_t *source);
 
+extern void obs_source_save_changed(obs_source_t *source);
+extern void obs_save_changed_all(void);
+extern long obs_scene_get_groups_save_gen(obs_scene_t *scene);
+
 static inline void obs_source_dosignal(struct obs_source *source, const char *signal_obs, const char *signal_source)
 {
 	struct calldata data;
@@ -1058,6 +1151,10 @@ extern void obs_source_set_texcoords_centered(obs_source_t *source, bool centere
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
+extern bool obs_source_tick_thread_safe(const obs_source_t *source);
+extern void obs_source_video_tick_select_frames(obs_source_t *source);
+extern void obs_source_video_tick_main(obs_source_t *source, float seconds, bool defer_tick);
+extern void obs_source_video_tick_deferred(obs_source_t *source, float seconds);
 extern float obs_source_get_target_volume(obs_source_t *source, obs_source_t *target);
 extern uint64_t obs_source_get_last_async_ts(const obs_source_t *source);
 
@@ -1164,7 +1261,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct interleaved_packets interleaved_packets;
 	int stop_code;
 
 	int reconnect_retry_sec;
@@ -1172,10 +1269,9 @@ struct obs_output {
 	int reconnect_retries;
 	uint32_t reconnect_retry_cur_msec;
 	float reconnect_retry_exp;
-	pthread_t reconnect_thread;
+	os_task_handle_t *reconnect_task;
 	os_event_t *reconnect_stop_event;
 	volatile bool reconnecting;
-	volatile bool reconnect_thread_active;
 
 	uint32_t starting_drawn_count;
 	uint32_t starting_lagged_count;
@@ -1259,6 +1355,8 @@ extern const struct obs_output_info *find_output(const char *id);
 extern void obs_output_remove_encoder(struct obs_output *output, struct obs_encoder *encoder);
 
 extern void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src);
+extern void obs_encoder_packet_pool_init(void);
+extern void obs_encoder_packet_pool_free(void);
 void obs_output_destroy(obs_output_t *output);
 
 /* ------------------------------------------------------------------------- */
@@ -1449,6 +1547,10 @@ extern void source_profiler_async_frame_received(obs_source_t *source);
 extern uint64_t source_profiler_source_tick_start(void);
 /* Submit start timestamp for source */
 extern void source_profiler_source_tick_end(obs_source_t *source, uint64_t start);
+/* Submit tick duration for source (for ticks split across threads) */
+extern void source_profiler_source_tick_record(obs_source_t *source, uint64_t duration);
+/* Submit the time it took to tick all sources this frame */
+extern void source_profiler_frame_tick(uint64_t duration);
 
 /* Obtain GPU timer and start timestamp for render start of a source. */
 extern uint64_t source_profiler_source_render_begin(gs_timer_t **timer);
@@ -1457,3 +1559,32 @@ extern void source_profiler_source_render_end(obs_source_t *source, uint64_t sta
 
 /* Remove source from profiler hashmaps */
 extern void source_profiler_remove_source(obs_source_t *source);
+
+/** Internal Frame Timeline functions **/
+
+/* Resize the ring buffer for the frame rate and clear the histograms */
+extern void frame_timeline_reset_video(uint32_t fps_num, uint32_t fps_den);
+extern void frame_timeline_free(void);
+
+/* Start of frame in graphics loop */
+extern void frame_timeline_frame_begin(uint64_t start);
+/* Get timestamp for start of a phase (0 when not recording) */
+extern uint64_t frame_timeline_phase_begin(void);
+/* Submit start timestamp of a phase, repeated phases are summed */
+extern void frame_timeline_phase_end(enum frame_timeline_stat phase, uint64_t start);
+/* Time the thread finished its work for the frame */
+extern void frame_timeline_work_end(uint64_t end);
+/* Time the thread was supposed to and did wake up, and frames lagged */
+extern void frame_timeline_frame_end(uint64_t wake_target, uint64_t wake, int lagged);
+
+/* ------------------------------------------------------------------------- */
+/* data */
+
+/* Frees the interned obs_data key handles */
+extern void obs_data_free_keys(void);
+
+/* ------------------------------------------------------------------------- */
+/* image cache */
+
+/* Frees the cached images, called once no decode tasks are left */
+extern void obs_image_cache_free(void);
@@ -229,8 +229,8 @@ fail:
 static inline void free_packets(struct obs_output *output)
 {
 	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array + i);
-	da_free(output->interleaved_packets);
+		obs_encoder_packet_release(interleaved_packet(&output->interleaved_packets, i));
+	interleaved_packets_free(&output->interleaved_packets);
 }
 
 static inline void clear_raw_audio_buffers(obs_output_t *output)
@@ -263,6 +263,8 @@ void obs_output_destroy(obs_output_t *output)
 
 		if (output->valid && active(output))
 			obs_output_actual_stop(output, true, 0);
+		if (output->reconnect_task)
+			os_task_cancel(output->reconnect_task);
 
 		os_event_wait(output->stopping_event);
 		if (data_capture_ending(output))
@@ -450,8 +452,12 @@ void obs_output_actual_stop(obs_output_t *output, bool force, uint64_t ts)
 	was_reconnecting = reconnecting(output) && !delay_active(output);
 	if (reconnecting(output)) {
 		os_event_signal(output->reconnect_stop_event);
-		if (output->reconnect_thread_active)
-			pthread_join(output->reconnect_thread, NULL);
+		if (output->reconnect_task) {
+			/* the task clears the flag itself if it already ran */
+			if (os_task_cancel(output->reconnect_task))
+				os_atomic_set_bool(&output->reconnecting, false);
+			output->reconnect_task = NULL;
+		}
 	}
 
 	if (force) {
@@ -1646,7 +1652,7 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out = *interleaved_packet(&output->interleaved_packets, 0);
 	struct encoder_packet_time ept_local = {0};
 	bool found_ept = false;
 
@@ -1656,7 +1662,7 @@ static inline void send_interleaved(struct obs_output *output)
 	if (!has_higher_opposing_ts(output, &out))
 		return;
 
-	da_erase(output->interleaved_packets, 0);
+	interleaved_packets_pop_front(&output->interleaved_packets, 1);
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1753,7 +1759,7 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 	size_t idx = 0;
 
 	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+		struct encoder_packet *packet = interleaved_packet(&output->interleaved_packets, i);
 		int64_t diff;
 
 		if (packet->type != OBS_ENCODER_AUDIO) {
@@ -1792,7 +1798,7 @@ static int prune_premature_packets(struct obs_output *output)
 		return -1;
 
 	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
+	video = interleaved_packet(&output->interleaved_packets, video_idx);
 	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
 	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
@@ -1810,7 +1816,7 @@ static int prune_premature_packets(struct obs_output *output)
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
+		audio = interleaved_packet(&output->interleaved_packets, audio_idx);
 		if (audio_idx > max_idx)
 			max_idx = audio_idx;
 
@@ -1839,14 +1845,14 @@ static int prune_premature_packets(struct obs_output *output)
 static void discard_to_idx(struct obs_output *output, size_t idx)
 {
 	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+		struct encoder_packet *packet = interleaved_packet(&output->interleaved_packets, i);
 		if (packet->type == OBS_ENCODER_VIDEO) {
 			da_pop_front(output->encoder_packet_times[packet->track_idx]);
 		}
 		obs_encoder_packet_release(packet);
 	}
 
-	da_erase_range(output->interleaved_packets, 0, idx);
+	interleaved_packets_pop_front(&output->interleaved_packets, idx);
 }
 
 #define DEBUG_STARTING_PACKETS 0
@@ -1859,7 +1865,7 @@ static bool prune_interleaved_packets(struct obs_output *output)
 #if DEBUG_STARTING_PACKETS == 1
 	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
 	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+		struct encoder_packet *packet = interleaved_packet(&output->interleaved_packets, i);
 		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
 		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video", (int)packet->track_idx, packet->dts_usec,
 		     (int)i < prune_start ? "true" : "false");
@@ -1883,7 +1889,7 @@ static bool prune_interleaved_packets(struct obs_output *output)
 static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
 {
 	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+		struct encoder_packet *packet = interleaved_packet(&output->interleaved_packets, i);
 
 		if (packet->type == type && packet->track_idx == idx)
 			return (int)i;
@@ -1895,7 +1901,7 @@ static int find_first_packet_type_idx(struct obs_output *output, enum obs_encode
 static int find_last_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
 {
 	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i - 1];
+		struct encoder_packet *packet = interleaved_packet(&output->interleaved_packets, i - 1);
 
 		if (packet->type == type && packet->track_idx == idx)
 			return (int)(i - 1);
@@ -1908,14 +1914,14 @@ static inline struct encoder_packet *find_first_packet_type(struct obs_output *o
 							    size_t audio_idx)
 {
 	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return (idx != -1) ? interleaved_packet(&output->interleaved_packets, idx) : NULL;
 }
 
 static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
 							   size_t audio_idx)
 {
 	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return (idx != -1) ? interleaved_packet(&output->interleaved_packets, idx) : NULL;
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output, struct encoder_packet **video,
@@ -2015,7 +2021,7 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 
 	/* apply new offsets to all existing packet DTS/PTS values */
 	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+		struct encoder_packet *packet = interleaved_packet(&output->interleaved_packets, i);
 		apply_interleaved_packet_offset(output, packet, NULL);
 	}
 
@@ -2024,42 +2030,24 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 
 static inline void insert_interleaved_packet(struct obs_output *output, struct encoder_packet *out)
 {
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		// sort video packets with same DTS by track index,
-		// to prevent the pruning logic from removing additional
-		// video tracks
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
-		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
-			continue;
-
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
-	}
-
-	da_insert(output->interleaved_packets, idx, out);
+	interleaved_packets_insert(&output->interleaved_packets, out);
 }
 
 static void resort_interleaved_packets(struct obs_output *output)
 {
-	DARRAY(struct encoder_packet) old_array;
+	struct interleaved_packets old = output->interleaved_packets;
 
-	old_array.da = output->interleaved_packets.da;
 	memset(&output->interleaved_packets, 0, sizeof(output->interleaved_packets));
+	interleaved_packets_reserve(&output->interleaved_packets, old.num);
 
-	for (size_t i = 0; i < old_array.num; i++) {
-		set_higher_ts(output, &old_array.array[i]);
+	for (size_t i = 0; i < old.num; i++) {
+		struct encoder_packet *packet = interleaved_packet(&old, i);
 
-		insert_interleaved_packet(output, &old_array.array[i]);
+		set_higher_ts(output, packet);
+		insert_interleaved_packet(output, packet);
 	}
 
-	da_free(old_array);
+	interleaved_packets_free(&old);
 }
 
 static void discard_unused_audio_packets(struct obs_output *output, int64_t dts_usec)
@@ -2067,7 +2055,7 @@ static void discard_unused_audio_packets(struct obs_output *output, int64_t dts_
 	size_t idx = 0;
 
 	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p = &output->interleaved_packets.array[idx];
+		struct encoder_packet *p = interleaved_packet(&output->interleaved_packets, idx);
 
 		if (p->dts_usec >= dts_usec)
 			break;
@@ -2191,7 +2179,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 	if (output->active_delay_ns)
 		out = *packet;
 	else
-		obs_encoder_packet_create_instance(&out, packet);
+		obs_encoder_packet_ref(&out, packet);
 
 	if (packet_time) {
 		output_packet_time = da_push_back_new(output->encoder_packet_times[packet->track_idx]);
@@ -2805,28 +2793,19 @@ void obs_output_end_data_capture(obs_output_t *output)
 	obs_output_end_data_capture_internal(output, true);
 }
 
-static void *reconnect_thread(void *param)
+static void reconnect_task(void *param)
 {
 	struct obs_output *output = param;
 
-	output->reconnect_thread_active = true;
-
-	if (os_event_timedwait(output->reconnect_stop_event, output->reconnect_retry_cur_msec) == ETIMEDOUT)
+	if (os_event_try(output->reconnect_stop_event) == EAGAIN)
 		obs_output_actual_start(output);
 
-	if (os_event_try(output->reconnect_stop_event) == EAGAIN)
-		pthread_detach(output->reconnect_thread);
-	else
+	if (os_event_try(output->reconnect_stop_event) != EAGAIN)
 		os_atomic_set_bool(&output->reconnecting, false);
-
-	output->reconnect_thread_active = false;
-	return NULL;
 }
 
 static void output_reconnect(struct obs_output *output)
 {
-	int ret;
-
 	if (reconnecting(output) && os_event_try(output->reconnect_stop_event) != EAGAIN) {
 		os_atomic_set_bool(&output->reconnecting, false);
 		return;
@@ -2862,9 +2841,13 @@ static void output_reconnect(struct obs_output *output)
 	output->reconnect_retries++;
 
 	output->stop_code = OBS_OUTPUT_DISCONNECTED;
-	ret = pthread_create(&output->reconnect_thread, NULL, &reconnect_thread, output);
-	if (ret < 0) {
-		blog(LOG_WARNING, "Failed to create reconnect thread");
+
+	/* the previous attempt has already run if it's reconnecting again */
+	os_task_handle_release(output->reconnect_task);
+	output->reconnect_task = os_task_pool_schedule(obs->task_pool, OS_TASK_PRIORITY_NORMAL,
+						       output->reconnect_retry_cur_msec, 0, reconnect_task, output);
+	if (!output->reconnect_task) {
+		blog(LOG_WARNING, "Failed to schedule reconnect");
 		os_atomic_set_bool(&output->reconnecting, false);
 	} else {
 		blog(LOG_INFO, "Output '%s': Reconnecting in %.02f seconds..", output->context.name,
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "util/bmem.h"
+#include "util/threading.h"
+#include "obs.h"
+
+/*
+ * Buffer pool of encoder packets.  Buffers are kept in power-of-two size
+ * classes, the data of a packet is preceded by its reference count, as for
+ * buffers allocated anywhere else.
+ *
+ * Buffers that come from the pool start counting at PACKET_POOL_REF_BIAS so
+ * that they can be told apart from buffers that outputs and plugins allocate
+ * themselves, which keep counting down to zero and are freed with bfree.
+ */
+
+#define PACKET_POOL_REF_BIAS 0x40000000L
+#define PACKET_POOL_MIN_SHIFT 8
+#define PACKET_POOL_CLASSES 16
+#define PACKET_POOL_MAX_CACHED (32 * 1024 * 1024)
+
+struct packet_buffer {
+	struct packet_buffer *next;
+	size_t size_class;
+	volatile long refs;
+};
+
+struct packet_pool {
+	pthread_mutex_t mutex;
+	bool active;
+	struct packet_buffer *free[PACKET_POOL_CLASSES];
+	struct obs_encoder_packet_pool_stats stats;
+};
+
+static inline size_t packet_class_capacity(size_t size_class)
+{
+	return (size_t)1 << (size_class + PACKET_POOL_MIN_SHIFT);
+}
+
+static inline struct packet_buffer *packet_buffer_from_refs(long *p_refs)
+{
+	return (struct packet_buffer *)((uint8_t *)p_refs - offsetof(struct packet_buffer, refs));
+}
+
+/* returns packet data with a reference count of one */
+static inline uint8_t *packet_pool_alloc(struct packet_pool *pool, size_t size)
+{
+	struct packet_buffer *buf = NULL;
+	size_t size_class = 0;
+	long *p_refs;
+
+	while (size_class < PACKET_POOL_CLASSES && packet_class_capacity(size_class) < size)
+		size_class++;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (!pool->active || size_class == PACKET_POOL_CLASSES) {
+		pool->stats.unpooled++;
+		pthread_mutex_unlock(&pool->mutex);
+
+		p_refs = bmalloc(size + sizeof(long));
+		*p_refs = 1;
+		return (uint8_t *)(p_refs + 1);
+	}
+
+	buf = pool->free[size_class];
+	if (buf) {
+		pool->free[size_class] = buf->next;
+		pool->stats.bytes_cached -= packet_class_capacity(size_class);
+		pool->stats.reuses++;
+	} else {
+		pool->stats.allocations++;
+	}
+	pool->stats.bytes_in_use += packet_class_capacity(size_class);
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (!buf) {
+		buf = bmalloc(sizeof(struct packet_buffer) + packet_class_capacity(size_class));
+		buf->size_class = size_class;
+	}
+
+	buf->next = NULL;
+	buf->refs = PACKET_POOL_REF_BIAS + 1;
+	return (uint8_t *)(&buf->refs + 1);
+}
+
+static inline void packet_pool_recycle(struct packet_pool *pool, struct packet_buffer *buf)
+{
+	size_t capacity = packet_class_capacity(buf->size_class);
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stats.bytes_in_use -= capacity;
+
+	if (pool->active && pool->stats.bytes_cached + capacity <= PACKET_POOL_MAX_CACHED) {
+		buf->next = pool->free[buf->size_class];
+		pool->free[buf->size_class] = buf;
+		pool->stats.bytes_cached += capacity;
+		buf = NULL;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	bfree(buf);
+}
+
+/* drops a reference to packet data, whether it came from the pool or not */
+static inline void packet_pool_release(struct packet_pool *pool, uint8_t *data)
+{
+	long *p_refs = ((long *)data) - 1;
+	long refs = os_atomic_dec_long(p_refs);
+
+	if (refs == 0)
+		bfree(p_refs);
+	else if (refs == PACKET_POOL_REF_BIAS)
+		packet_pool_recycle(pool, packet_buffer_from_refs(p_refs));
+}
+
+static inline void packet_pool_init(struct packet_pool *pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->active = true;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+/* frees the cached buffers, buffers still in use are freed once released */
+static inline void packet_pool_free(struct packet_pool *pool, struct obs_encoder_packet_pool_stats *stats)
+{
+	struct packet_buffer *free_list[PACKET_POOL_CLASSES];
+
+	pthread_mutex_lock(&pool->mutex);
+	memcpy(free_list, pool->free, sizeof(free_list));
+	memset(pool->free, 0, sizeof(pool->free));
+	*stats = pool->stats;
+	pool->stats.bytes_cached = 0;
+	pool->active = false;
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (size_t i = 0; i < PACKET_POOL_CLASSES; i++) {
+		struct packet_buffer *buf = free_list[i];
+		while (buf) {
+			struct packet_buffer *next = buf->next;
+			bfree(buf);
+			buf = next;
+		}
+	}
+}
+
+static inline void packet_pool_get_stats(struct packet_pool *pool, struct obs_encoder_packet_pool_stats *stats)
+{
+	pthread_mutex_lock(&pool->mutex);
+	*stats = pool->stats;
+	pthread_mutex_unlock(&pool->mutex);
+}
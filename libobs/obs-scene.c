@@ -19,6 +19,7 @@
 #include "util/threading.h"
 #include "util/util_uint64.h"
 #include "graphics/math-defs.h"
+#include "media-io/audio-kernels.h"
 #include "obs-scene.h"
 #include "obs-internal.h"
 
@@ -27,6 +28,7 @@ const struct obs_source_info group_info;
 static void resize_group(obs_sceneitem_t *group, bool scene_resize);
 static void resize_scene(obs_scene_t *scene);
 static void signal_parent(obs_scene_t *parent, const char *name, calldata_t *params);
+static void signal_parent_emit(obs_scene_t *parent, signal_t *signal, calldata_t *params);
 static void get_ungrouped_transform(obs_sceneitem_t *group, obs_sceneitem_t *item, struct vec2 *pos, struct vec2 *scale,
 				    float *rot);
 static inline bool crop_enabled(const struct obs_sceneitem_crop *crop);
@@ -162,6 +164,7 @@ static void *scene_create(obs_data_t *settings, struct obs_source *source)
 	}
 
 	signal_handler_add_array(obs_source_get_signal_handler(source), obs_scene_signals);
+	scene->transform_signal = signal_handler_get_signal(obs_source_get_signal_handler(source), "item_transform");
 
 	if (pthread_mutex_init_recursive(&scene->audio_mutex) != 0) {
 		blog(LOG_ERROR, "scene_create: Couldn't initialize audio "
@@ -698,7 +701,7 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 
 	calldata_init_fixed(&params, stack, sizeof(stack));
 	calldata_set_ptr(&params, "item", item);
-	signal_parent(item->parent, "item_transform", &params);
+	signal_parent_emit(item->parent, item->parent->transform_signal, &params);
 
 	if (!update_tex)
 		return;
@@ -1460,6 +1463,27 @@ static void scene_save(void *data, obs_data_t *settings)
 	obs_data_array_release(array);
 }
 
+/* Groups are saved again as part of the scenes that contain them */
+long obs_scene_get_groups_save_gen(obs_scene_t *scene)
+{
+	struct obs_scene_item *item;
+	long gen = 0;
+
+	full_lock(scene);
+
+	for (item = scene->first_item; item; item = item->next) {
+		if (item->is_group) {
+			long group_gen = os_atomic_load_long(&item->source->save_gen);
+			if (gen < group_gen)
+				gen = group_gen;
+		}
+	}
+
+	full_unlock(scene);
+
+	return gen;
+}
+
 static uint32_t canvas_getwidth(obs_weak_canvas_t *weak)
 {
 	uint32_t width = 0;
@@ -1590,27 +1614,6 @@ static void process_all_audio_actions(struct obs_scene_item *item, size_t sample
 		;
 }
 
-static void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in, size_t pos, size_t count)
-{
-	register float *out = p_out + pos;
-	register float *buf = buf_in;
-	register float *in = p_in;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++) * *(buf++);
-}
-
-static inline void mix_audio(float *p_out, float *p_in, size_t pos, size_t count)
-{
-	register float *out = p_out + pos;
-	register float *in = p_in;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++);
-}
-
 static inline struct scene_source_mix *get_source_mix(struct obs_scene *scene, struct obs_source *source)
 {
 	for (size_t i = 0; i < scene->mix_sources.num; i++) {
@@ -1785,10 +1788,10 @@ static bool scene_audio_render_internal(struct obs_scene *scene, struct obs_scen
 				float *in = child_audio.output[mix].data[ch];
 
 				if (source_mix->apply_buf)
-					mix_audio_with_buf(out, in, source_mix->buf, source_mix->pos,
+					audio_mul_add_ramp(out + source_mix->pos, in, source_mix->buf,
 							   source_mix->count);
 				else
-					mix_audio(out, in, source_mix->pos, source_mix->count);
+					audio_add(out + source_mix->pos, in, source_mix->count);
 			}
 		}
 	}
@@ -2578,10 +2581,21 @@ obs_source_t *obs_sceneitem_get_source(const obs_sceneitem_t *item)
 
 static void signal_parent(obs_scene_t *parent, const char *command, calldata_t *params)
 {
+	/* every item change is signaled, including the ones that are saved */
+	obs_source_save_changed(parent->source);
+
 	calldata_set_ptr(params, "scene", parent);
 	signal_handler_signal(parent->source->context.signals, command, params);
 }
 
+static void signal_parent_emit(obs_scene_t *parent, signal_t *signal, calldata_t *params)
+{
+	obs_source_save_changed(parent->source);
+
+	calldata_set_ptr(params, "scene", parent);
+	signal_emit(signal, params);
+}
+
 struct passthrough {
 	obs_data_array_t *ids;
 	obs_data_array_t *scenes_and_groups;
@@ -3352,6 +3366,7 @@ void obs_sceneitem_set_blending_method(obs_sceneitem_t *item, enum obs_blending_
 		return;
 
 	item->blend_method = method;
+	obs_source_save_changed(item->parent ? item->parent->source : NULL);
 }
 
 enum obs_blending_method obs_sceneitem_get_blending_method(obs_sceneitem_t *item)
@@ -3419,6 +3434,7 @@ int64_t obs_sceneitem_get_id(const obs_sceneitem_t *item)
 void obs_sceneitem_set_id(obs_sceneitem_t *item, int64_t id)
 {
 	item->id = id;
+	obs_source_save_changed(item->parent ? item->parent->source : NULL);
 }
 
 obs_data_t *obs_sceneitem_get_private_settings(obs_sceneitem_t *item)
@@ -4127,6 +4143,8 @@ void obs_sceneitem_set_transition(obs_sceneitem_t *item, bool show, obs_source_t
 	if (*target)
 		obs_source_release(*target);
 	*target = obs_source_get_ref(transition);
+
+	obs_source_save_changed(item->parent ? item->parent->source : NULL);
 }
 
 obs_source_t *obs_sceneitem_get_transition(obs_sceneitem_t *item, bool show)
@@ -4145,6 +4163,8 @@ void obs_sceneitem_set_transition_duration(obs_sceneitem_t *item, bool show, uin
 		item->show_transition_duration = duration_ms;
 	else
 		item->hide_transition_duration = duration_ms;
+
+	obs_source_save_changed(item->parent ? item->parent->source : NULL);
 }
 
 uint32_t obs_sceneitem_get_transition_duration(obs_sceneitem_t *item, bool show)
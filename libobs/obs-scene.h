@@ -119,6 +119,8 @@ struct obs_scene {
 
 	int64_t id_counter;
 
+	signal_t *transform_signal;
+
 	pthread_mutex_t video_mutex;
 	pthread_mutex_t audio_mutex;
 	struct obs_scene_item *first_item;
@@ -19,7 +19,8 @@
 
 static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 {
-	struct obs_source_frame *next_frame = source->async_frames.array[0];
+	struct async_frame_queue *queue = &source->async_frames;
+	struct obs_source_frame *next_frame = async_queue_peek(queue, 0);
 	struct obs_source_frame *prev_frame = NULL;
 	struct obs_source_frame *frame = NULL;
 	uint64_t sys_offset = sys_time - source->last_sys_timestamp;
@@ -28,17 +29,17 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 	size_t idx = 1;
 
 	if (source->async_unbuffered) {
-		while (source->async_frames.num > 2) {
-			da_erase(source->async_frames, 0);
-			remove_async_frame(source, next_frame);
-			next_frame = source->async_frames.array[0];
+		while (async_queue_size(queue) > 2) {
+			remove_async_frame(source, async_queue_pop(queue));
+			os_atomic_inc_long(&source->async_frames_late);
+			next_frame = async_queue_peek(queue, 0);
 		}
 
-		if (source->async_frames.num == 2) {
+		if (async_queue_size(queue) == 2) {
 			bool prev_frame = true;
 			if (source->async_unbuffered && source->deinterlace_offset) {
-				const uint64_t timestamp = source->async_frames.array[0]->timestamp;
-				const uint64_t after_timestamp = source->async_frames.array[1]->timestamp;
+				const uint64_t timestamp = async_queue_peek(queue, 0)->timestamp;
+				const uint64_t after_timestamp = async_queue_peek(queue, 1)->timestamp;
 				const uint64_t duration = after_timestamp - timestamp;
 				const uint64_t frame_end = timestamp + source->deinterlace_offset + duration;
 				if (sys_time < frame_end) {
@@ -47,7 +48,7 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 					source->deinterlace_frame_ts = timestamp - duration;
 				}
 			}
-			source->async_frames.array[0]->prev_frame = prev_frame;
+			async_queue_peek(queue, 0)->prev_frame = prev_frame;
 		}
 		source->deinterlace_offset = 0;
 		source->last_frame_ts = next_frame->timestamp;
@@ -74,17 +75,18 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 			break;
 
 		if (prev_frame) {
-			da_erase(source->async_frames, 0);
+			async_queue_pop(queue);
 			remove_async_frame(source, prev_frame);
+			os_atomic_inc_long(&source->async_frames_late);
 		}
 
-		if (source->async_frames.num <= 2) {
+		if (async_queue_size(queue) <= 2) {
 			bool exit = true;
 
 			if (prev_frame) {
 				prev_frame->prev_frame = true;
 
-			} else if (!frame && source->async_frames.num == 2) {
+			} else if (!frame && async_queue_size(queue) == 2) {
 				exit = false;
 			}
 
@@ -101,7 +103,7 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 
 		prev_frame = frame;
 		frame = next_frame;
-		next_frame = source->async_frames.array[idx];
+		next_frame = async_queue_peek(queue, idx);
 
 		/* more timestamp checking and compensating */
 		if ((next_frame->timestamp - frame_time) > MAX_TS_VAR) {
@@ -124,8 +126,8 @@ static inline bool first_frame(obs_source_t *s)
 	if (s->last_frame_ts)
 		return false;
 
-	if (s->async_frames.num >= 2)
-		s->async_frames.array[0]->prev_frame = true;
+	if (async_queue_size(&s->async_frames) >= 2)
+		async_queue_peek(&s->async_frames, 0)->prev_frame = true;
 	return true;
 }
 
@@ -154,7 +156,7 @@ static inline void deinterlace_get_closest_frames(obs_source_t *s, uint64_t sys_
 		}
 	}
 
-	if (!s->async_frames.num)
+	if (!async_queue_size(&s->async_frames))
 		return;
 
 	half_interval = obs->video.video_half_frame_interval_ns;
@@ -163,15 +165,11 @@ static inline void deinterlace_get_closest_frames(obs_source_t *s, uint64_t sys_
 		uint64_t offset;
 
 		s->prev_async_frame = NULL;
-		s->cur_async_frame = s->async_frames.array[0];
+		s->cur_async_frame = async_queue_pop(&s->async_frames);
 
-		da_erase(s->async_frames, 0);
-
-		if ((s->async_frames.num > 0) && s->cur_async_frame->prev_frame) {
+		if (async_queue_size(&s->async_frames) > 0 && s->cur_async_frame->prev_frame) {
 			s->prev_async_frame = s->cur_async_frame;
-			s->cur_async_frame = s->async_frames.array[0];
-
-			da_erase(s->async_frames, 0);
+			s->cur_async_frame = async_queue_pop(&s->async_frames);
 
 			s->deinterlace_half_duration =
 				(uint32_t)((s->cur_async_frame->timestamp - s->prev_async_frame->timestamp) / 2);
@@ -445,6 +443,8 @@ void obs_source_set_deinterlace_mode(obs_source_t *source, enum obs_deinterlace_
 	if (source->deinterlace_mode == mode)
 		return;
 
+	obs_source_save_changed(source);
+
 	if (source->deinterlace_mode == OBS_DEINTERLACE_MODE_DISABLE) {
 		enable_deinterlacing(source, mode);
 	} else if (mode == OBS_DEINTERLACE_MODE_DISABLE) {
@@ -469,6 +469,7 @@ void obs_source_set_deinterlace_field_order(obs_source_t *source, enum obs_deint
 		return;
 
 	source->deinterlace_top_first = field_order == OBS_DEINTERLACE_FIELD_ORDER_TOP;
+	obs_source_save_changed(source);
 }
 
 enum obs_deinterlace_field_order obs_source_get_deinterlace_field_order(const obs_source_t *source)
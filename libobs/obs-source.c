@@ -21,6 +21,7 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-kernels.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/util_uint64.h"
@@ -121,7 +122,11 @@ bool obs_source_init_context(struct obs_source *source, obs_data_t *settings, co
 	if (!obs_context_data_init(&source->context, OBS_OBJ_TYPE_SOURCE, settings, name, uuid, hotkey_data, private))
 		return false;
 
-	return signal_handler_add_array(source->context.signals, source_signals);
+	if (!signal_handler_add_array(source->context.signals, source_signals))
+		return false;
+
+	source->volume_signal = signal_handler_get_signal(source->context.signals, "volume");
+	return true;
 }
 
 const char *obs_source_get_display_name(const char *id)
@@ -179,8 +184,11 @@ static bool obs_source_init(struct obs_source *source)
 	source->sync_offset = 0;
 	source->balance = 0.5f;
 	source->audio_active = true;
+	source->async_queue_depth = DEFAULT_ASYNC_FRAMES;
+	source->async_drop_policy = OBS_ASYNC_FRAME_DROP_OLDEST;
 	pthread_mutex_init_value(&source->filter_mutex);
 	pthread_mutex_init_value(&source->async_mutex);
+	pthread_mutex_init_value(&source->async_output_mutex);
 	pthread_mutex_init_value(&source->audio_mutex);
 	pthread_mutex_init_value(&source->audio_buf_mutex);
 	pthread_mutex_init_value(&source->audio_cb_mutex);
@@ -193,12 +201,14 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->audio_actions_mutex, NULL) != 0)
 		return false;
-	if (pthread_mutex_init(&source->audio_cb_mutex, NULL) != 0)
+	if (pthread_mutex_init_recursive(&source->audio_cb_mutex) != 0)
 		return false;
 	if (pthread_mutex_init(&source->audio_mutex, NULL) != 0)
 		return false;
 	if (pthread_mutex_init_recursive(&source->async_mutex) != 0)
 		return false;
+	if (pthread_mutex_init(&source->async_output_mutex, NULL) != 0)
+		return false;
 	if (pthread_mutex_init(&source->caption_cb_mutex, NULL) != 0)
 		return false;
 	if (pthread_mutex_init(&source->media_actions_mutex, NULL) != 0)
@@ -677,8 +687,10 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	obs_hotkey_unregister(source->push_to_mute_key);
 	obs_hotkey_pair_unregister(source->mute_unmute_key);
 
-	for (i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+	for (i = 0; i < ASYNC_CACHE_SIZE; i++) {
+		if (source->async_cache[i].frame)
+			obs_source_frame_decref(source->async_cache[i].frame);
+	}
 
 	gs_enter_context(obs->video.graphics);
 	if (source->async_texrender)
@@ -711,8 +723,6 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	da_free(source->audio_actions);
 	da_free(source->audio_cb_list);
 	da_free(source->caption_cb_list);
-	da_free(source->async_cache);
-	da_free(source->async_frames);
 	da_free(source->filters);
 	da_free(source->media_actions);
 	pthread_mutex_destroy(&source->filter_mutex);
@@ -722,8 +732,10 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	pthread_mutex_destroy(&source->audio_mutex);
 	pthread_mutex_destroy(&source->caption_cb_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
+	pthread_mutex_destroy(&source->async_output_mutex);
 	pthread_mutex_destroy(&source->media_actions_mutex);
 	obs_data_release(source->private_settings);
+	obs_data_release(source->save_data);
 	obs_context_data_free(&source->context);
 
 	if (source->owns_info_id) {
@@ -955,6 +967,18 @@ static void obs_source_deferred_update(obs_source_t *source)
 	}
 }
 
+static void obs_source_settings_changed(obs_source_t *source)
+{
+	obs_source_save_changed(source);
+
+	if (source->info.output_flags & OBS_SOURCE_VIDEO) {
+		os_atomic_inc_long(&source->defer_update_count);
+	} else if (source->context.data && source->info.update) {
+		source->info.update(source->context.data, source->context.settings);
+		obs_source_dosignal(source, "source_update", "update");
+	}
+}
+
 void obs_source_update(obs_source_t *source, obs_data_t *settings)
 {
 	if (!obs_source_valid(source, "obs_source_update"))
@@ -964,12 +988,16 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 		obs_data_apply(source->context.settings, settings);
 	}
 
-	if (source->info.output_flags & OBS_SOURCE_VIDEO) {
-		os_atomic_inc_long(&source->defer_update_count);
-	} else if (source->context.data && source->info.update) {
-		source->info.update(source->context.data, source->context.settings);
-		obs_source_dosignal(source, "source_update", "update");
-	}
+	obs_source_settings_changed(source);
+}
+
+void obs_source_update_values(obs_source_t *source, const struct obs_data_value *values, size_t count)
+{
+	if (!obs_source_valid(source, "obs_source_update_values"))
+		return;
+
+	obs_data_set_values(source->context.settings, values, count);
+	obs_source_settings_changed(source);
 }
 
 void obs_source_reset_settings(obs_source_t *source, obs_data_t *settings)
@@ -1217,12 +1245,25 @@ void process_media_actions(obs_source_t *source)
 	}
 }
 
-static void async_tick(obs_source_t *source)
+/* drops the oldest queued frames once the queue grows past its depth */
+static void trim_async_frames(obs_source_t *source)
+{
+	size_t depth = (size_t)os_atomic_load_long(&source->async_queue_depth);
+
+	while (async_queue_size(&source->async_frames) > depth) {
+		remove_async_frame(source, async_queue_pop(&source->async_frames));
+		os_atomic_inc_long(&source->async_frames_dropped);
+	}
+}
+
+static void select_async_frame(obs_source_t *source)
 {
 	uint64_t sys_time = obs->video.video_time;
 
 	pthread_mutex_lock(&source->async_mutex);
 
+	trim_async_frames(source);
+
 	if (deinterlacing_enabled(source)) {
 		deinterlace_process_last_frame(source, sys_time);
 	} else {
@@ -1236,6 +1277,15 @@ static void async_tick(obs_source_t *source)
 
 	source->last_sys_timestamp = sys_time;
 
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+/* Async filters always run on the graphics thread, even when the frames were
+ * selected on a tick worker, as filters are not expected to be thread-safe. */
+static void filter_async_frames(obs_source_t *source)
+{
+	pthread_mutex_lock(&source->async_mutex);
+
 	if (deinterlacing_enabled(source))
 		filter_frame(source, &source->prev_async_frame);
 	filter_frame(source, &source->cur_async_frame);
@@ -1246,18 +1296,26 @@ static void async_tick(obs_source_t *source)
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
-void obs_source_video_tick(obs_source_t *source, float seconds)
+bool obs_source_tick_thread_safe(const obs_source_t *source)
 {
-	bool now_showing, now_active;
+	return (source->info.output_flags & OBS_SOURCE_THREAD_SAFE_TICK) != 0;
+}
 
-	if (!obs_source_valid(source, "obs_source_video_tick"))
-		return;
+void obs_source_video_tick_select_frames(obs_source_t *source)
+{
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0)
+		select_async_frame(source);
+}
+
+void obs_source_video_tick_main(obs_source_t *source, float seconds, bool defer_tick)
+{
+	bool now_showing, now_active;
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source, seconds);
 
 	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0)
-		async_tick(source);
+		filter_async_frames(source);
 
 	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) != 0)
 		process_media_actions(source);
@@ -1315,13 +1373,28 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
+	if (!defer_tick && source->context.data && source->info.video_tick)
 		source->info.video_tick(source->context.data, seconds);
 
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
 }
 
+void obs_source_video_tick_deferred(obs_source_t *source, float seconds)
+{
+	if (source->context.data && source->info.video_tick)
+		source->info.video_tick(source->context.data, seconds);
+}
+
+void obs_source_video_tick(obs_source_t *source, float seconds)
+{
+	if (!obs_source_valid(source, "obs_source_video_tick"))
+		return;
+
+	obs_source_video_tick_select_frames(source);
+	obs_source_video_tick_main(source, seconds, false);
+}
+
 /* unless the value is 3+ hours worth of frames, this won't overflow */
 static inline uint64_t conv_frames_to_time(const size_t sample_rate, const size_t frames)
 {
@@ -3000,6 +3073,8 @@ void obs_source_filter_add(obs_source_t *source, obs_source_t *filter)
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_save_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -3037,6 +3112,8 @@ static bool obs_source_filter_remove_refless(obs_source_t *source, obs_source_t
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_save_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -3162,8 +3239,10 @@ void obs_source_filter_set_order(obs_source_t *source, obs_source_t *filter, enu
 	success = move_filter_dir(source, filter, movement);
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	if (success)
+	if (success) {
+		obs_source_save_changed(source);
 		obs_source_dosignal(source, NULL, "reorder_filters");
+	}
 }
 
 int obs_source_filter_get_index(obs_source_t *source, obs_source_t *filter)
@@ -3207,8 +3286,10 @@ void obs_source_filter_set_index(obs_source_t *source, obs_source_t *filter, siz
 	success = set_filter_index(source, filter, index);
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	if (success)
+	if (success) {
+		obs_source_save_changed(source);
 		obs_source_dosignal(source, NULL, "reorder_filters");
+	}
 }
 
 obs_data_t *obs_source_get_settings(const obs_source_t *source)
@@ -3364,13 +3445,21 @@ static inline bool async_texture_changed(struct obs_source *source, const struct
 	return source->async_cache_width != frame->width || source->async_cache_height != frame->height || prev != cur;
 }
 
+/* must be called with both async_output_mutex and async_mutex held */
 static inline void free_async_cache(struct obs_source *source)
 {
-	for (size_t i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+	for (size_t i = 0; i < ASYNC_CACHE_SIZE; i++) {
+		struct async_frame *af = &source->async_cache[i];
+		if (af->frame) {
+			obs_source_frame_decref(af->frame);
+			af->frame = NULL;
+		}
+		os_atomic_set_bool(&af->used, false);
+	}
+
+	while (async_queue_size(&source->async_frames))
+		async_queue_pop(&source->async_frames);
 
-	da_resize(source->async_cache, 0);
-	da_resize(source->async_frames, 0);
 	source->cur_async_frame = NULL;
 	source->prev_async_frame = NULL;
 }
@@ -3381,34 +3470,30 @@ static inline void free_async_cache(struct obs_source *source)
  * of time */
 static void clean_cache(obs_source_t *source)
 {
-	for (size_t i = source->async_cache.num; i > 0; i--) {
-		struct async_frame *af = &source->async_cache.array[i - 1];
-		if (!af->used) {
+	for (size_t i = 0; i < ASYNC_CACHE_SIZE; i++) {
+		struct async_frame *af = &source->async_cache[i];
+		if (af->frame && !os_atomic_load_bool(&af->used)) {
 			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
 				obs_source_frame_destroy(af->frame);
-				da_erase(source->async_cache, i - 1);
+				af->frame = NULL;
 			}
 		}
 	}
 }
 
-#define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
+/* Only called from the producer side (async_output_mutex held).  Cache entries
+ * that are not marked as used belong to the producer, so they can be reused
+ * without touching async_mutex. */
 static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 {
-	struct obs_source_frame *new_frame = NULL;
-
-	pthread_mutex_lock(&source->async_mutex);
+	struct async_frame *new_af = NULL;
+	struct async_frame *empty_af = NULL;
 
-	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
+	if (async_texture_changed(source, frame)) {
+		pthread_mutex_lock(&source->async_mutex);
 		free_async_cache(source);
-		source->last_frame_ts = 0;
 		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
-	}
 
-	if (async_texture_changed(source, frame)) {
-		free_async_cache(source);
 		source->async_cache_width = frame->width;
 		source->async_cache_height = frame->height;
 	}
@@ -3418,38 +3503,48 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 	source->async_cache_full_range = frame->full_range;
 	source->async_cache_trc = frame->trc;
 
-	for (size_t i = 0; i < source->async_cache.num; i++) {
-		struct async_frame *af = &source->async_cache.array[i];
-		if (!af->used) {
-			new_frame = af->frame;
-			new_frame->format = format;
-			af->used = true;
-			af->unused_count = 0;
+	for (size_t i = 0; i < ASYNC_CACHE_SIZE; i++) {
+		struct async_frame *af = &source->async_cache[i];
+		if (!af->frame) {
+			if (!empty_af)
+				empty_af = af;
+		} else if (!os_atomic_load_bool(&af->used)) {
+			new_af = af;
 			break;
 		}
 	}
 
-	clean_cache(source);
+	if (!new_af) {
+		/* every cache entry is still held by the consumer side */
+		if (!empty_af)
+			return NULL;
 
-	if (!new_frame) {
-		struct async_frame new_af;
+		new_af = empty_af;
+		new_af->frame = obs_source_frame_create(format, frame->width, frame->height);
+		new_af->frame->refs = 1;
+	}
 
-		new_frame = obs_source_frame_create(format, frame->width, frame->height);
-		new_af.frame = new_frame;
-		new_af.used = true;
-		new_af.unused_count = 0;
-		new_frame->refs = 1;
+	new_af->frame->format = format;
+	new_af->unused_count = 0;
+	os_atomic_set_bool(&new_af->used, true);
 
-		da_push_back(source->async_cache, &new_af);
-	}
+	clean_cache(source);
 
-	os_atomic_inc_long(&new_frame->refs);
+	copy_frame_data(new_af->frame, frame);
 
-	pthread_mutex_unlock(&source->async_mutex);
+	return new_af->frame;
+}
 
-	copy_frame_data(new_frame, frame);
+static inline bool async_queue_full(struct obs_source *source)
+{
+	size_t queued = async_queue_size(&source->async_frames);
 
-	return new_frame;
+	if (os_atomic_load_long(&source->async_drop_policy) == OBS_ASYNC_FRAME_DROP_NEWEST)
+		return queued >= (size_t)os_atomic_load_long(&source->async_queue_depth);
+
+	/* the consumer trims the oldest frames down to the queue depth, the
+	 * producer only has to give up once the ring itself is full */
+	return queued >= MAX_ASYNC_FRAMES;
 }
 
 static void obs_source_output_video_internal(obs_source_t *source, const struct obs_source_frame *frame)
@@ -3458,30 +3553,33 @@ static void obs_source_output_video_internal(obs_source_t *source, const struct
 		return;
 
 	if (!frame) {
+		pthread_mutex_lock(&source->async_output_mutex);
 		pthread_mutex_lock(&source->async_mutex);
 		source->async_active = false;
 		source->last_frame_ts = 0;
 		free_async_cache(source);
 		pthread_mutex_unlock(&source->async_mutex);
+		pthread_mutex_unlock(&source->async_output_mutex);
 		return;
 	}
 
 	source_profiler_async_frame_received(source);
 
-	struct obs_source_frame *output = cache_video(source, frame);
-
 	/* ------------------------------------------- */
-	pthread_mutex_lock(&source->async_mutex);
+	pthread_mutex_lock(&source->async_output_mutex);
+
+	struct obs_source_frame *output = NULL;
+	if (!async_queue_full(source))
+		output = cache_video(source, frame);
+
 	if (output) {
-		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		} else {
-			da_push_back(source->async_frames, &output);
-			source->async_active = true;
-		}
+		async_queue_push(&source->async_frames, output);
+		source->async_active = true;
+	} else {
+		os_atomic_inc_long(&source->async_frames_dropped);
 	}
-	pthread_mutex_unlock(&source->async_mutex);
+
+	pthread_mutex_unlock(&source->async_output_mutex);
 }
 
 void obs_source_output_video(obs_source_t *source, const struct obs_source_frame *frame)
@@ -3831,25 +3929,12 @@ static void copy_audio_data(obs_source_t *source, const uint8_t *const data[], u
 		source->audio_storage_size = size;
 }
 
-/* TODO: SSE optimization */
 static void downmix_to_mono_planar(struct obs_source *source, uint32_t frames)
 {
 	size_t channels = audio_output_get_channels(obs->audio.audio);
-	const float channels_i = 1.0f / (float)channels;
-	float **data = (float **)source->audio_data.data;
-
-	for (size_t channel = 1; channel < channels; channel++) {
-		for (uint32_t frame = 0; frame < frames; frame++)
-			data[0][frame] += data[channel][frame];
-	}
+	float *const *data = (float *const *)source->audio_data.data;
 
-	for (uint32_t frame = 0; frame < frames; frame++)
-		data[0][frame] *= channels_i;
-
-	for (size_t channel = 1; channel < channels; channel++) {
-		for (uint32_t frame = 0; frame < frames; frame++)
-			data[channel][frame] = data[0][frame];
-	}
+	audio_downmix_mono(data, channels, frames);
 }
 
 static void process_audio_balancing(struct obs_source *source, uint32_t frames, float balance,
@@ -3961,14 +4046,16 @@ void obs_source_output_audio(obs_source_t *source, const struct obs_source_audio
 
 void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 {
-	if (frame)
-		frame->prev_frame = false;
+	if (!frame)
+		return;
 
-	for (size_t i = 0; i < source->async_cache.num; i++) {
-		struct async_frame *f = &source->async_cache.array[i];
+	frame->prev_frame = false;
+
+	for (size_t i = 0; i < ASYNC_CACHE_SIZE; i++) {
+		struct async_frame *f = &source->async_cache[i];
 
 		if (f->frame == frame) {
-			f->used = false;
+			os_atomic_set_bool(&f->used, false);
 			break;
 		}
 	}
@@ -3978,17 +4065,18 @@ void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 
 static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 {
-	struct obs_source_frame *next_frame = source->async_frames.array[0];
+	struct async_frame_queue *queue = &source->async_frames;
+	struct obs_source_frame *next_frame = async_queue_peek(queue, 0);
 	struct obs_source_frame *frame = NULL;
 	uint64_t sys_offset = sys_time - source->last_sys_timestamp;
 	uint64_t frame_time = next_frame->timestamp;
 	uint64_t frame_offset = 0;
 
 	if (source->async_unbuffered) {
-		while (source->async_frames.num > 1) {
-			da_erase(source->async_frames, 0);
-			remove_async_frame(source, next_frame);
-			next_frame = source->async_frames.array[0];
+		while (async_queue_size(queue) > 1) {
+			remove_async_frame(source, async_queue_pop(queue));
+			os_atomic_inc_long(&source->async_frames_late);
+			next_frame = async_queue_peek(queue, 0);
 		}
 
 		source->last_frame_ts = next_frame->timestamp;
@@ -4001,7 +4089,7 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 	     "sys_offset: %llu, frame_offset: %llu, "
 	     "number of frames: %lu",
 	     source->last_frame_ts, frame_time, sys_offset, frame_time - source->last_frame_ts,
-	     (unsigned long)source->async_frames.num);
+	     (unsigned long)async_queue_size(queue));
 #endif
 
 	/* account for timestamp invalidation */
@@ -4025,8 +4113,10 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 		if (frame && (source->last_frame_ts - next_frame->timestamp) < 2000000)
 			break;
 
-		if (frame)
-			da_erase(source->async_frames, 0);
+		if (frame) {
+			async_queue_pop(queue);
+			os_atomic_inc_long(&source->async_frames_late);
+		}
 
 #if DEBUG_ASYNC_FRAMES
 		blog(LOG_DEBUG,
@@ -4038,11 +4128,11 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 
 		remove_async_frame(source, frame);
 
-		if (source->async_frames.num == 1)
+		if (async_queue_size(queue) == 1)
 			return true;
 
 		frame = next_frame;
-		next_frame = source->async_frames.array[1];
+		next_frame = async_queue_peek(queue, 1);
 
 		/* more timestamp checking and compensating */
 		if ((next_frame->timestamp - frame_time) > MAX_TS_VAR) {
@@ -4066,12 +4156,11 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 
 static inline struct obs_source_frame *get_closest_frame(obs_source_t *source, uint64_t sys_time)
 {
-	if (!source->async_frames.num)
+	if (!async_queue_size(&source->async_frames))
 		return NULL;
 
 	if (!source->last_frame_ts || ready_async_frame(source, sys_time)) {
-		struct obs_source_frame *frame = source->async_frames.array[0];
-		da_erase(source->async_frames, 0);
+		struct obs_source_frame *frame = async_queue_pop(&source->async_frames);
 
 		if (!source->last_frame_ts)
 			source->last_frame_ts = frame->timestamp;
@@ -4166,6 +4255,9 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 			calldata_free(&data);
 			bfree(prev_name);
 		}
+
+		/* scenes save the names of their items */
+		obs_save_changed_all();
 	}
 }
 
@@ -4416,7 +4508,7 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		calldata_set_ptr(&data, "source", source);
 		calldata_set_float(&data, "volume", volume);
 
-		signal_handler_signal(source->context.signals, "volume", &data);
+		signal_emit(source->volume_signal, &data);
 		if (!source->context.private)
 			signal_handler_signal(obs->signals, "source_volume", &data);
 
@@ -4427,6 +4519,7 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		pthread_mutex_unlock(&source->audio_actions_mutex);
 
 		source->user_volume = volume;
+		obs_source_save_changed(source);
 	}
 }
 
@@ -4448,6 +4541,7 @@ void obs_source_set_sync_offset(obs_source_t *source, int64_t offset)
 		signal_handler_signal(source->context.signals, "audio_sync", &data);
 
 		source->sync_offset = calldata_int(&data, "offset");
+		obs_source_save_changed(source);
 	}
 }
 
@@ -4688,6 +4782,7 @@ void obs_source_set_flags(obs_source_t *source, uint32_t flags)
 
 	if (flags != source->flags) {
 		source->flags = flags;
+		obs_source_save_changed(source);
 		signal_flags_updated(source);
 	}
 }
@@ -4727,6 +4822,7 @@ void obs_source_set_audio_mixers(obs_source_t *source, uint32_t mixers)
 	mixers = (uint32_t)calldata_int(&data, "mixers");
 
 	source->audio_mixers = mixers;
+	obs_source_save_changed(source);
 }
 
 uint32_t obs_source_get_audio_mixers(const obs_source_t *source)
@@ -4906,6 +5002,7 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 		return;
 
 	source->enabled = enabled;
+	obs_source_save_changed(source);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -4929,6 +5026,7 @@ void obs_source_set_muted(obs_source_t *source, bool muted)
 		return;
 
 	source->user_muted = muted;
+	obs_source_save_changed(source);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -4991,8 +5089,10 @@ void obs_source_enable_push_to_mute(obs_source_t *source, bool enabled)
 
 	source->push_to_mute_enabled = enabled;
 
-	if (changed)
+	if (changed) {
+		obs_source_save_changed(source);
 		source_signal_push_to_changed(source, "push_to_mute_changed", enabled);
+	}
 	pthread_mutex_unlock(&source->audio_mutex);
 }
 
@@ -5016,6 +5116,7 @@ void obs_source_set_push_to_mute_delay(obs_source_t *source, uint64_t delay)
 
 	pthread_mutex_lock(&source->audio_mutex);
 	source->push_to_mute_delay = delay;
+	obs_source_save_changed(source);
 
 	source_signal_push_to_delay(source, "push_to_mute_delay", delay);
 	pthread_mutex_unlock(&source->audio_mutex);
@@ -5047,8 +5148,10 @@ void obs_source_enable_push_to_talk(obs_source_t *source, bool enabled)
 
 	source->push_to_talk_enabled = enabled;
 
-	if (changed)
+	if (changed) {
+		obs_source_save_changed(source);
 		source_signal_push_to_changed(source, "push_to_talk_changed", enabled);
+	}
 	pthread_mutex_unlock(&source->audio_mutex);
 }
 
@@ -5072,6 +5175,7 @@ void obs_source_set_push_to_talk_delay(obs_source_t *source, uint64_t delay)
 
 	pthread_mutex_lock(&source->audio_mutex);
 	source->push_to_talk_delay = delay;
+	obs_source_save_changed(source);
 
 	source_signal_push_to_delay(source, "push_to_talk_delay", delay);
 	pthread_mutex_unlock(&source->audio_mutex);
@@ -5106,23 +5210,13 @@ static float get_source_volume(obs_source_t *source, uint64_t os_time)
 
 static inline void multiply_output_audio(obs_source_t *source, size_t mix, size_t channels, float vol)
 {
-	register float *out = source->audio_output_buf[mix][0];
-	register float *end = out + AUDIO_OUTPUT_FRAMES * channels;
-
-	while (out < end)
-		*(out++) *= vol;
+	audio_mul(source->audio_output_buf[mix][0], vol, AUDIO_OUTPUT_FRAMES * channels);
 }
 
 static inline void multiply_vol_data(obs_source_t *source, size_t mix, size_t channels, float *vol_data)
 {
-	for (size_t ch = 0; ch < channels; ch++) {
-		register float *out = source->audio_output_buf[mix][ch];
-		register float *end = out + AUDIO_OUTPUT_FRAMES;
-		register float *vol = vol_data;
-
-		while (out < end)
-			*(out++) *= *(vol++);
-	}
+	for (size_t ch = 0; ch < channels; ch++)
+		audio_mul_ramp(source->audio_output_buf[mix][ch], vol_data, AUDIO_OUTPUT_FRAMES);
 }
 
 static inline void apply_audio_action(obs_source_t *source, const struct audio_action *action)
@@ -5476,6 +5570,7 @@ void obs_source_set_monitoring_type(obs_source_t *source, enum obs_monitoring_ty
 	}
 
 	source->monitoring_type = type;
+	obs_source_save_changed(source);
 }
 
 enum obs_monitoring_type obs_source_get_monitoring_type(const obs_source_t *source)
@@ -5497,6 +5592,55 @@ bool obs_source_async_unbuffered(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_async_unbuffered") ? source->async_unbuffered : false;
 }
 
+void obs_source_set_async_queue_depth(obs_source_t *source, size_t depth)
+{
+	if (!obs_source_valid(source, "obs_source_set_async_queue_depth"))
+		return;
+
+	if (depth < 1)
+		depth = 1;
+	else if (depth > MAX_ASYNC_FRAMES)
+		depth = MAX_ASYNC_FRAMES;
+
+	os_atomic_set_long(&source->async_queue_depth, (long)depth);
+}
+
+size_t obs_source_get_async_queue_depth(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_queue_depth")
+		       ? (size_t)os_atomic_load_long(&source->async_queue_depth)
+		       : 0;
+}
+
+void obs_source_set_async_drop_policy(obs_source_t *source, enum obs_async_frame_drop policy)
+{
+	if (!obs_source_valid(source, "obs_source_set_async_drop_policy"))
+		return;
+
+	os_atomic_set_long(&source->async_drop_policy, (long)policy);
+}
+
+enum obs_async_frame_drop obs_source_get_async_drop_policy(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_drop_policy")
+		       ? (enum obs_async_frame_drop)os_atomic_load_long(&source->async_drop_policy)
+		       : OBS_ASYNC_FRAME_DROP_OLDEST;
+}
+
+uint32_t obs_source_get_async_frames_dropped(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_frames_dropped")
+		       ? (uint32_t)os_atomic_load_long(&source->async_frames_dropped)
+		       : 0;
+}
+
+uint32_t obs_source_get_async_frames_late(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_frames_late")
+		       ? (uint32_t)os_atomic_load_long(&source->async_frames_late)
+		       : 0;
+}
+
 obs_data_t *obs_source_get_private_settings(obs_source_t *source)
 {
 	if (!obs_ptr_valid(source, "obs_source_get_private_settings"))
@@ -5559,6 +5703,7 @@ void obs_source_set_balance_value(obs_source_t *source, float balance)
 		signal_handler_signal(source->context.signals, "audio_balance", &data);
 
 		source->balance = (float)calldata_float(&data, "balance");
+		obs_source_save_changed(source);
 	}
 }
 
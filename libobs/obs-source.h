@@ -208,6 +208,21 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_REQUIRES_CANVAS (1 << 17)
 
+/**
+ * Source's video_tick callback does not use the graphics subsystem and only
+ * touches the source's own data, so it may be called on a worker thread
+ * concurrently with the ticks of other sources.
+ */
+#define OBS_SOURCE_THREAD_SAFE_TICK (1 << 18)
+
+/**
+ * Source can be created on a worker thread by obs_load_sources_parallel.
+ * Its create callback must not require the UI thread or wait on it, and
+ * should push slow first-time work (decoding, opening files) to the
+ * background while obs_sources_loading() returns true.
+ */
+#define OBS_SOURCE_PARALLEL_LOAD (1 << 19)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent, obs_source_t *child, void *param);
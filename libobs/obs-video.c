@@ -29,6 +29,94 @@
 #include <windows.h>
 #endif
 
+struct tick_work {
+	obs_source_t **sources;
+	uint64_t *tick_times;
+	float seconds;
+	bool profile;
+};
+
+static void tick_select_frames(void *param, size_t idx)
+{
+	struct tick_work *work = param;
+	const uint64_t start = work->profile ? os_gettime_ns() : 0;
+
+	obs_source_video_tick_select_frames(work->sources[idx]);
+
+	if (work->profile)
+		work->tick_times[idx] += os_gettime_ns() - start;
+}
+
+static void tick_deferred(void *param, size_t idx)
+{
+	struct tick_work *work = param;
+	obs_source_t *source = work->sources[idx];
+
+	if (!obs_source_tick_thread_safe(source))
+		return;
+
+	const uint64_t start = work->profile ? os_gettime_ns() : 0;
+
+	obs_source_video_tick_deferred(source, work->seconds);
+
+	if (work->profile)
+		work->tick_times[idx] += os_gettime_ns() - start;
+}
+
+static inline os_work_pool_t *get_tick_pool(void)
+{
+	struct obs_core_video *video = &obs->video;
+	const bool parallel = os_atomic_load_bool(&video->parallel_tick);
+
+	if (parallel && !video->tick_pool) {
+		video->tick_pool = os_work_pool_create("libobs: tick worker", 0);
+	} else if (!parallel && video->tick_pool) {
+		os_work_pool_destroy(video->tick_pool);
+		video->tick_pool = NULL;
+	}
+
+	return video->tick_pool;
+}
+
+/* Ticks sources with the help of the tick worker pool.  Async frame selection
+ * and the video_tick of sources flagged with OBS_SOURCE_THREAD_SAFE_TICK run
+ * on the workers, everything else, including async filters, still runs on the
+ * graphics thread in the usual order. */
+static void tick_sources_parallel(os_work_pool_t *pool, float seconds)
+{
+	struct obs_core_data *data = &obs->data;
+	const size_t num = data->sources_to_tick.num;
+	const bool profile = source_profiler_source_tick_start() != 0;
+
+	da_resize(data->source_tick_times, num);
+	memset(data->source_tick_times.array, 0, num * sizeof(uint64_t));
+
+	struct tick_work work = {
+		.sources = data->sources_to_tick.array,
+		.tick_times = data->source_tick_times.array,
+		.seconds = seconds,
+		.profile = profile,
+	};
+
+	os_work_pool_run(pool, num, tick_select_frames, &work);
+
+	for (size_t i = 0; i < num; i++) {
+		obs_source_t *s = data->sources_to_tick.array[i];
+		const uint64_t start = source_profiler_source_tick_start();
+		obs_source_video_tick_main(s, seconds, obs_source_tick_thread_safe(s));
+		if (work.profile)
+			work.tick_times[i] += os_gettime_ns() - start;
+	}
+
+	os_work_pool_run(pool, num, tick_deferred, &work);
+
+	for (size_t i = 0; i < num; i++) {
+		obs_source_t *s = data->sources_to_tick.array[i];
+		source_profiler_source_tick_record(s, work.tick_times[i]);
+		obs_source_release(s);
+	}
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
@@ -36,6 +124,8 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	uint64_t delta_time;
 	float seconds;
 
+	const uint64_t tick_start = source_profiler_source_tick_start();
+
 	if (!last_time)
 		last_time = cur_time - obs->video.video_frame_interval_ns;
 
@@ -75,14 +165,22 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	/* ------------------------------------- */
 	/* call the tick function of each source */
 
-	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
-		obs_source_t *s = data->sources_to_tick.array[i];
-		const uint64_t start = source_profiler_source_tick_start();
-		obs_source_video_tick(s, seconds);
-		source_profiler_source_tick_end(s, start);
-		obs_source_release(s);
+	os_work_pool_t *pool = get_tick_pool();
+	if (pool) {
+		tick_sources_parallel(pool, seconds);
+	} else {
+		for (size_t i = 0; i < data->sources_to_tick.num; i++) {
+			obs_source_t *s = data->sources_to_tick.array[i];
+			const uint64_t start = source_profiler_source_tick_start();
+			obs_source_video_tick(s, seconds);
+			source_profiler_source_tick_end(s, start);
+			obs_source_release(s);
+		}
 	}
 
+	if (tick_start)
+		source_profiler_frame_tick(os_gettime_ns() - tick_start);
+
 	return cur_time;
 }
 
@@ -121,8 +219,79 @@ static inline void set_render_size(uint32_t width, uint32_t height)
 	gs_set_viewport(0, 0, width, height);
 }
 
+static void replace_copy_surface(struct obs_core_video_mix *video, size_t channel, gs_stagesurf_t *old_surface,
+				 gs_stagesurf_t *new_surface)
+{
+	for (size_t i = 0; i < NUM_TEXTURES; i++) {
+		if (video->copy_surfaces[i][channel] == old_surface)
+			video->copy_surfaces[i][channel] = new_surface;
+		if (video->active_copy_surfaces[i][channel] == old_surface)
+			video->active_copy_surfaces[i][channel] = new_surface;
+	}
+}
+
+/* the video output thread is still reading the surfaces shared with the last
+ * frame.  they stay mapped until it releases them, and spare surfaces take
+ * their place so the graphics thread can keep staging without waiting */
+static bool hold_mapped_surfaces(struct obs_core_video_mix *video)
+{
+	for (size_t c = 0; c < NUM_CHANNELS; c++) {
+		gs_stagesurf_t *surface = video->mapped_surfaces[c];
+		if (!surface || video->spare_surfaces[c])
+			continue;
+
+		video->spare_surfaces[c] = gs_stagesurface_create(gs_stagesurface_get_width(surface),
+								  gs_stagesurface_get_height(surface),
+								  gs_stagesurface_get_color_format(surface));
+		if (!video->spare_surfaces[c])
+			return false;
+	}
+
+	for (size_t c = 0; c < NUM_CHANNELS; c++) {
+		gs_stagesurf_t *surface = video->mapped_surfaces[c];
+		if (!surface)
+			continue;
+
+		replace_copy_surface(video, c, surface, video->spare_surfaces[c]);
+		video->held_surfaces[c] = surface;
+		video->spare_surfaces[c] = NULL;
+		video->mapped_surfaces[c] = NULL;
+	}
+
+	video->holding_surfaces = true;
+	return true;
+}
+
+static void release_held_surfaces(struct obs_core_video_mix *video)
+{
+	for (size_t c = 0; c < NUM_CHANNELS; c++) {
+		gs_stagesurf_t *surface = video->held_surfaces[c];
+		if (!surface)
+			continue;
+
+		gs_stagesurface_unmap(surface);
+		video->spare_surfaces[c] = surface;
+		video->held_surfaces[c] = NULL;
+	}
+
+	video->holding_surfaces = false;
+}
+
 static inline void unmap_last_surface(struct obs_core_video_mix *video)
 {
+	if (video->holding_surfaces && os_event_try(video->mapped_surfaces_released) == 0)
+		release_held_surfaces(video);
+
+	/* the surfaces may still be read by the video output thread */
+	if (video->mapped_surfaces_shared) {
+		video->mapped_surfaces_shared = false;
+
+		if (os_event_try(video->mapped_surfaces_released) != 0 && !hold_mapped_surfaces(video)) {
+			blog(LOG_WARNING, "Could not create spare stage surfaces, waiting for the video thread");
+			os_event_wait(video->mapped_surfaces_released);
+		}
+	}
+
 	for (int c = 0; c < NUM_CHANNELS; ++c) {
 		if (video->mapped_surfaces[c]) {
 			gs_stagesurface_unmap(video->mapped_surfaces[c]);
@@ -343,6 +512,7 @@ static void render_convert_texture(struct obs_core_video_mix *video, gs_texture_
 				   gs_texture_t *texture)
 {
 	profile_start(render_convert_texture_name);
+	uint64_t timeline_start = frame_timeline_phase_begin();
 
 	gs_effect_t *effect = obs->video.conversion_effect;
 	gs_eparam_t *color_vec0 = gs_effect_get_param_by_name(effect, "color_vec0");
@@ -398,6 +568,7 @@ static void render_convert_texture(struct obs_core_video_mix *video, gs_texture_
 
 	video->texture_converted = true;
 
+	frame_timeline_phase_end(FRAME_TIMELINE_GPU_CONVERSION, timeline_start);
 	profile_end(render_convert_texture_name);
 }
 
@@ -598,42 +769,33 @@ static inline bool download_frame(struct obs_core_video_mix *video, int prev_tex
 }
 
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height, uint32_t linesize_input,
-					      uint32_t linesize_output, const uint8_t *in, uint8_t *out)
+					      uint32_t linesize_output, const uint8_t *in, uint8_t *out,
+					      bool non_temporal)
 {
-	if ((width == linesize_input) && (width == linesize_output)) {
-		size_t total = (size_t)width * (size_t)height;
-		memcpy(out, in, total);
-		in += total;
-	} else {
-		for (size_t y = 0; y < height; y++) {
-			memcpy(out, in, width);
-			out += linesize_output;
-			in += linesize_input;
-		}
-	}
-
-	return in;
+	return video_frame_copy_plane(out, linesize_output, in, linesize_input, width, height, non_temporal);
 }
 
 static void set_gpu_converted_data(struct video_frame *output, const struct video_data *input,
 				   const struct video_output_info *info)
 {
+	const bool non_temporal = video_frame_use_non_temporal_copy(info->format, info->width, info->height);
+
 	switch (info->format) {
 	case VIDEO_FORMAT_I420: {
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
 		set_gpu_converted_plane(width, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+					output->data[0], non_temporal);
 
 		const uint32_t width_d2 = width / 2;
 		const uint32_t height_d2 = height / 2;
 
 		set_gpu_converted_plane(width_d2, height_d2, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+					output->data[1], non_temporal);
 
 		set_gpu_converted_plane(width_d2, height_d2, input->linesize[2], output->linesize[2], input->data[2],
-					output->data[2]);
+					output->data[2], non_temporal);
 
 		break;
 	}
@@ -643,15 +805,15 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height_d2 = height / 2;
 		if (input->linesize[1]) {
 			set_gpu_converted_plane(width, height, input->linesize[0], output->linesize[0], input->data[0],
-						output->data[0]);
+						output->data[0], non_temporal);
 			set_gpu_converted_plane(width, height_d2, input->linesize[1], output->linesize[1],
-						input->data[1], output->data[1]);
+						input->data[1], output->data[1], non_temporal);
 		} else {
 			const uint8_t *const in_uv = set_gpu_converted_plane(width, height, input->linesize[0],
 									     output->linesize[0], input->data[0],
-									     output->data[0]);
+									     output->data[0], non_temporal);
 			set_gpu_converted_plane(width, height_d2, input->linesize[0], output->linesize[1], in_uv,
-						output->data[1]);
+						output->data[1], non_temporal);
 		}
 
 		break;
@@ -661,13 +823,13 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height = info->height;
 
 		set_gpu_converted_plane(width, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+					output->data[0], non_temporal);
 
 		set_gpu_converted_plane(width, height, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+					output->data[1], non_temporal);
 
 		set_gpu_converted_plane(width, height, input->linesize[2], output->linesize[2], input->data[2],
-					output->data[2]);
+					output->data[2], non_temporal);
 
 		break;
 	}
@@ -676,15 +838,15 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height = info->height;
 
 		set_gpu_converted_plane(width * 2, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+					output->data[0], non_temporal);
 
 		const uint32_t height_d2 = height / 2;
 
 		set_gpu_converted_plane(width, height_d2, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+					output->data[1], non_temporal);
 
 		set_gpu_converted_plane(width, height_d2, input->linesize[2], output->linesize[2], input->data[2],
-					output->data[2]);
+					output->data[2], non_temporal);
 
 		break;
 	}
@@ -694,15 +856,15 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height_d2 = height / 2;
 		if (input->linesize[1]) {
 			set_gpu_converted_plane(width_x2, height, input->linesize[0], output->linesize[0],
-						input->data[0], output->data[0]);
+						input->data[0], output->data[0], non_temporal);
 			set_gpu_converted_plane(width_x2, height_d2, input->linesize[1], output->linesize[1],
-						input->data[1], output->data[1]);
+						input->data[1], output->data[1], non_temporal);
 		} else {
 			const uint8_t *const in_uv = set_gpu_converted_plane(width_x2, height, input->linesize[0],
 									     output->linesize[0], input->data[0],
-									     output->data[0]);
+									     output->data[0], non_temporal);
 			set_gpu_converted_plane(width_x2, height_d2, input->linesize[0], output->linesize[1], in_uv,
-						output->data[1]);
+						output->data[1], non_temporal);
 		}
 
 		break;
@@ -712,10 +874,10 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height = info->height;
 
 		set_gpu_converted_plane(width_x2, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+					output->data[0], non_temporal);
 
 		set_gpu_converted_plane(width_x2, height, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+					output->data[1], non_temporal);
 
 		break;
 	}
@@ -723,15 +885,17 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height = info->height;
 
 		set_gpu_converted_plane(info->width * 2, height, input->linesize[0], output->linesize[0],
-					input->data[0], output->data[0]);
+					input->data[0], output->data[0], non_temporal);
 
 		set_gpu_converted_plane(info->width * 4, height, input->linesize[1], output->linesize[1],
-					input->data[1], output->data[1]);
+					input->data[1], output->data[1], non_temporal);
 
 		break;
 	}
 
 	case VIDEO_FORMAT_NONE:
+		break;
+
 	case VIDEO_FORMAT_YVYU:
 	case VIDEO_FORMAT_YUY2:
 	case VIDEO_FORMAT_UYVY:
@@ -749,29 +913,58 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 	case VIDEO_FORMAT_YA2L:
 	case VIDEO_FORMAT_AYUV:
 	case VIDEO_FORMAT_V210:
-	case VIDEO_FORMAT_R10L:
-		/* unimplemented */
-		;
+	case VIDEO_FORMAT_R10L: {
+		/* not produced by GPU conversion, but copy any such frame
+		 * plane by plane using its regular layout */
+		struct video_frame frame;
+		memcpy(frame.data, input->data, sizeof(frame.data));
+		memcpy(frame.linesize, input->linesize, sizeof(frame.linesize));
+		video_frame_copy(output, &frame, info->format, info->height);
+	}
 	}
 }
 
 static inline void copy_rgbx_frame(struct video_frame *output, const struct video_data *input,
 				   const struct video_output_info *info)
 {
-	uint8_t *in_ptr = input->data[0];
-	uint8_t *out_ptr = output->data[0];
+	const bool non_temporal = video_frame_use_non_temporal_copy(info->format, info->width, info->height);
 
 	/* if the line sizes match, do a single copy */
-	if (input->linesize[0] == output->linesize[0]) {
-		memcpy(out_ptr, in_ptr, (size_t)input->linesize[0] * (size_t)info->height);
-	} else {
-		const size_t copy_size = (size_t)info->width * 4;
-		for (size_t y = 0; y < info->height; y++) {
-			memcpy(out_ptr, in_ptr, copy_size);
-			in_ptr += input->linesize[0];
-			out_ptr += output->linesize[0];
-		}
+	const uint32_t row_size = (input->linesize[0] == output->linesize[0]) ? input->linesize[0] : info->width * 4;
+
+	video_frame_copy_plane(output->data[0], output->linesize[0], input->data[0], input->linesize[0], row_size,
+			       info->height, non_temporal);
+}
+
+static void release_mapped_surfaces(void *param)
+{
+	struct obs_core_video_mix *video = param;
+	os_event_signal(video->mapped_surfaces_released);
+}
+
+/* hands the mapped staging surfaces straight to the video output thread.  this
+ * only works if the layout of the surfaces is the one the video output
+ * expects, which is not the case for packed NV12/P010 stage surfaces.  only one
+ * set of surfaces is shared at a time, while an earlier set is still held by
+ * the video output thread frames take the copy path */
+static inline bool share_mapped_surfaces(struct obs_core_video_mix *video, struct video_data *input_frame, int count)
+{
+	if (!os_atomic_load_bool(&obs->video.zero_copy))
+		return false;
+	if (video->gpu_conversion && !input_frame->linesize[1])
+		return false;
+	if (video->holding_surfaces)
+		return false;
+
+	os_event_reset(video->mapped_surfaces_released);
+	video->mapped_surfaces_shared = true;
+
+	if (!video_output_queue_external_frame(video->video, input_frame, count, release_mapped_surfaces, video)) {
+		video->mapped_surfaces_shared = false;
+		return false;
 	}
+
+	return true;
 }
 
 static inline void output_video_data(struct obs_core_video_mix *video, struct video_data *input_frame, int count)
@@ -780,6 +973,9 @@ static inline void output_video_data(struct obs_core_video_mix *video, struct vi
 	struct video_frame output_frame;
 	bool locked;
 
+	if (share_mapped_surfaces(video, input_frame, count))
+		return;
+
 	info = video_output_get_info(video->video);
 
 	locked = video_output_lock_frame(video->video, &output_frame, count, input_frame->timestamp);
@@ -821,6 +1017,8 @@ static inline void video_sleep(struct obs_core_video *video, uint64_t *p_time, u
 		*p_time = cur_time + interval_ns * count;
 	}
 
+	frame_timeline_frame_end(t, os_gettime_ns(), count - 1);
+
 	video->total_frames += count;
 	video->lagged_frames += count - 1;
 
@@ -874,6 +1072,7 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1 : cur_texture - 1;
 	struct video_data frame;
 	bool frame_ready = 0;
+	uint64_t timeline_start;
 
 	memset(&frame, 0, sizeof(struct video_data));
 
@@ -881,14 +1080,18 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	gs_enter_context(obs->video.graphics);
 
 	profile_start(output_frame_render_video_name);
+	timeline_start = frame_timeline_phase_begin();
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_RENDER_VIDEO, output_frame_render_video_name);
 	render_video(video, raw_active, gpu_active, cur_texture);
 	GS_DEBUG_MARKER_END();
+	frame_timeline_phase_end(FRAME_TIMELINE_RENDER, timeline_start);
 	profile_end(output_frame_render_video_name);
 
 	if (raw_active) {
 		profile_start(output_frame_download_frame_name);
+		timeline_start = frame_timeline_phase_begin();
 		frame_ready = download_frame(video, prev_texture, &frame);
+		frame_timeline_phase_end(FRAME_TIMELINE_STAGE_MAP, timeline_start);
 		profile_end(output_frame_download_frame_name);
 	}
 
@@ -905,7 +1108,9 @@ static inline void output_frame(struct obs_core_video_mix *video)
 
 		frame.timestamp = vframe_info.timestamp;
 		profile_start(output_frame_output_video_data_name);
+		timeline_start = frame_timeline_phase_begin();
 		output_video_data(video, &frame, vframe_info.count);
+		frame_timeline_phase_end(FRAME_TIMELINE_OUTPUT_COPY, timeline_start);
 		profile_end(output_frame_output_video_data_name);
 	}
 
@@ -1098,18 +1303,22 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 {
 	uint64_t frame_start = os_gettime_ns();
 	uint64_t frame_time_ns;
+	uint64_t timeline_start;
 
 	update_active_states();
 
 	profile_start(context->video_thread_name);
 	source_profiler_frame_begin();
+	frame_timeline_frame_begin(frame_start);
 
 	gs_enter_context(obs->video.graphics);
 	gs_begin_frame();
 	gs_leave_context();
 
 	profile_start(tick_sources_name);
+	timeline_start = frame_timeline_phase_begin();
 	context->last_time = tick_sources(obs->video.video_time, context->last_time);
+	frame_timeline_phase_end(FRAME_TIMELINE_TICK, timeline_start);
 	profile_end(tick_sources_name);
 
 #ifdef _WIN32
@@ -1126,13 +1335,16 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	profile_end(output_frame_name);
 
 	profile_start(render_displays_name);
+	timeline_start = frame_timeline_phase_begin();
 	render_displays();
+	frame_timeline_phase_end(FRAME_TIMELINE_DISPLAYS, timeline_start);
 	profile_end(render_displays_name);
 	source_profiler_render_end();
 
 	execute_graphics_tasks();
 
 	frame_time_ns = os_gettime_ns() - frame_start;
+	frame_timeline_work_end(frame_start + frame_time_ns);
 
 	source_profiler_frame_collect();
 	profile_end(context->video_thread_name);
@@ -1194,6 +1406,9 @@ void *obs_graphics_thread(void *param)
 #endif
 		;
 
+	os_work_pool_destroy(obs->video.tick_pool);
+	obs->video.tick_pool = NULL;
+
 #ifdef _WIN32
 	uninit_winrt_state(&winrt);
 #endif
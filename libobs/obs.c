@@ -19,6 +19,7 @@
 
 #include "graphics/matrix4.h"
 #include "callback/calldata.h"
+#include "media-io/format-conversion.h"
 
 #include "obs.h"
 #include "obs-internal.h"
@@ -504,6 +505,8 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 	profile_start(shader_comp_name);
 	gs_enter_context(video->graphics);
 
+	gs_set_effect_cache_path(video->effect_cache_path);
+
 	char *filename = obs_find_data_file("default.effect");
 	video->default_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
@@ -642,6 +645,8 @@ static int obs_init_video_mix(struct obs_video_info *ovi, struct obs_core_video_
 
 	if (pthread_mutex_init(&video->gpu_encoder_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (os_event_init(&video->mapped_surfaces_released, OS_EVENT_TYPE_MANUAL) != 0)
+		return OBS_VIDEO_FAIL;
 
 	gs_enter_context(obs->video.graphics);
 
@@ -754,7 +759,17 @@ static void obs_free_render_textures(struct obs_core_video_mix *video)
 			gs_stagesurface_unmap(video->mapped_surfaces[c]);
 			video->mapped_surfaces[c] = NULL;
 		}
+		if (video->held_surfaces[c]) {
+			gs_stagesurface_unmap(video->held_surfaces[c]);
+			gs_stagesurface_destroy(video->held_surfaces[c]);
+			video->held_surfaces[c] = NULL;
+		}
+		if (video->spare_surfaces[c]) {
+			gs_stagesurface_destroy(video->spare_surfaces[c]);
+			video->spare_surfaces[c] = NULL;
+		}
 	}
+	video->holding_surfaces = false;
 
 	for (size_t i = 0; i < NUM_TEXTURES; i++) {
 		for (size_t c = 0; c < NUM_CHANNELS; c++) {
@@ -812,6 +827,10 @@ void obs_free_video_mix(struct obs_core_video_mix *video)
 		pthread_mutex_init_value(&video->gpu_encoder_mutex);
 		da_free(video->gpu_encoders);
 
+		os_event_destroy(video->mapped_surfaces_released);
+		video->mapped_surfaces_released = NULL;
+		video->mapped_surfaces_shared = false;
+
 		video->gpu_encoder_active = 0;
 		video->cur_texture = 0;
 	}
@@ -1053,6 +1072,7 @@ static void obs_free_data(void)
 		bfree(data->protocols.array[i]);
 	da_free(data->protocols);
 	da_free(data->sources_to_tick);
+	da_free(data->source_tick_times);
 }
 
 static const char *obs_signals[] = {
@@ -1096,6 +1116,22 @@ static const char *obs_signals[] = {
 	NULL,
 };
 
+static void dump_frame_timeline_proc(void *data, calldata_t *cd)
+{
+	const char *path = calldata_string(cd, "path");
+	long long seconds = calldata_int(cd, "seconds");
+	bool success = false;
+
+	if (path && *path) {
+		if (seconds <= 0 || seconds > FRAME_TIMELINE_SECONDS)
+			seconds = FRAME_TIMELINE_SECONDS;
+		success = frame_timeline_save_chrome_trace(path, (uint32_t)seconds);
+	}
+
+	calldata_set_bool(cd, "success", success);
+	UNUSED_PARAMETER(data);
+}
+
 static inline bool obs_init_handlers(void)
 {
 	obs->signals = signal_handler_create();
@@ -1106,6 +1142,9 @@ static inline bool obs_init_handlers(void)
 	if (!obs->procs)
 		return false;
 
+	proc_handler_add(obs->procs, "void dump_frame_timeline(in string path, in int seconds, out bool success)",
+			 dump_frame_timeline_proc, NULL);
+
 	return signal_handler_add_array(obs->signals, obs_signals);
 }
 
@@ -1233,6 +1272,10 @@ static bool obs_init(const char *locale, const char *module_config_path, profile
 	if (!obs->destruction_task_thread)
 		return false;
 
+	obs->task_pool = os_task_pool_create("libobs: task pool", 0);
+	if (!obs->task_pool)
+		return false;
+
 	if (module_config_path)
 		obs->module_config_path = bstrdup(module_config_path);
 	obs->locale = bstrdup(locale);
@@ -1240,6 +1283,7 @@ static bool obs_init(const char *locale, const char *module_config_path, profile
 	obs_register_source(&group_info);
 	obs_register_source(&audio_line_info);
 	add_default_module_paths();
+	obs_encoder_packet_pool_init();
 	return true;
 }
 
@@ -1402,8 +1446,14 @@ void obs_shutdown(void)
 	obs->first_module = NULL;
 
 	obs_free_data();
+	os_task_pool_destroy(obs->task_pool);
+	obs_image_cache_free();
 	obs_free_audio();
 	obs_free_video();
+	frame_timeline_free();
+	format_conversion_free_pool();
+	obs_encoder_packet_pool_free();
+	obs_data_free_keys();
 	os_task_queue_destroy(obs->destruction_task_thread);
 	obs_free_hotkeys();
 	obs_free_graphics();
@@ -1423,6 +1473,7 @@ void obs_shutdown(void)
 	if (obs->name_store_owned)
 		profiler_name_store_free(obs->name_store);
 
+	bfree(obs->video.effect_cache_path);
 	bfree(obs->module_config_path);
 	bfree(obs->locale);
 	bfree(obs);
@@ -1548,6 +1599,7 @@ int obs_reset_video(struct obs_video_info *ovi)
 	     yuv ? yuv_range : "");
 
 	source_profiler_reset_video(ovi);
+	frame_timeline_reset_video(ovi->fps_num, ovi->fps_den);
 
 	return obs_init_video(ovi);
 }
@@ -1640,6 +1692,40 @@ void obs_set_video_levels(float sdr_white_level, float hdr_nominal_peak_level)
 	video->hdr_nominal_peak_level = hdr_nominal_peak_level;
 }
 
+void obs_set_video_zero_copy(bool enable)
+{
+	os_atomic_set_bool(&obs->video.zero_copy, enable);
+}
+
+bool obs_video_zero_copy_enabled(void)
+{
+	return os_atomic_load_bool(&obs->video.zero_copy);
+}
+
+void obs_set_parallel_tick(bool enable)
+{
+	os_atomic_set_bool(&obs->video.parallel_tick, enable);
+}
+
+bool obs_parallel_tick_enabled(void)
+{
+	return os_atomic_load_bool(&obs->video.parallel_tick);
+}
+
+void obs_set_effect_cache_path(const char *path)
+{
+	struct obs_core_video *video = &obs->video;
+
+	bfree(video->effect_cache_path);
+	video->effect_cache_path = path && *path ? bstrdup(path) : NULL;
+
+	if (video->graphics) {
+		gs_enter_context(video->graphics);
+		gs_set_effect_cache_path(video->effect_cache_path);
+		gs_leave_context();
+	}
+}
+
 bool obs_get_audio_info(struct obs_audio_info *oai)
 {
 	struct obs_core_audio *audio = &obs->audio;
@@ -2392,6 +2478,209 @@ void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb, void *priv
 	da_free(sources);
 }
 
+#define MAX_LOAD_THREADS 8
+#define LOAD_TIMES_LOGGED 10
+
+struct source_load_job {
+	obs_data_t *data;
+	obs_source_t *source;
+	uint64_t create_ns;
+	uint64_t load_ns;
+	bool parallel;
+};
+
+struct source_load_pool {
+	struct source_load_job *jobs;
+	size_t *parallel_jobs;
+	size_t num_parallel_jobs;
+	volatile long next;
+};
+
+static bool can_load_in_parallel(obs_data_t *source_data)
+{
+	const char *id = obs_data_get_string(source_data, "versioned_id");
+	if (!*id)
+		id = obs_data_get_string(source_data, "id");
+
+	/* unnamed sources take a name from a shared counter */
+	if (!*obs_data_get_string(source_data, "name"))
+		return false;
+
+	return (obs_get_source_output_flags(id) & OBS_SOURCE_PARALLEL_LOAD) != 0;
+}
+
+/* A source is created together with its filters, so all of them have to
+ * support being created off the calling thread. Scene items, transitions and
+ * other references between sources are only resolved when the sources are
+ * loaded, which stays serial and in order. */
+static bool can_load_unit_in_parallel(obs_data_t *source_data)
+{
+	obs_data_array_t *filters = obs_data_get_array(source_data, "filters");
+	bool parallel = can_load_in_parallel(source_data);
+
+	if (filters) {
+		size_t count = obs_data_array_count(filters);
+
+		for (size_t i = 0; parallel && i < count; i++) {
+			obs_data_t *filter_data = obs_data_array_item(filters, i);
+			parallel = can_load_in_parallel(filter_data);
+			obs_data_release(filter_data);
+		}
+
+		obs_data_array_release(filters);
+	}
+
+	return parallel;
+}
+
+static inline void create_load_job(struct source_load_job *job)
+{
+	uint64_t start = os_gettime_ns();
+	job->source = obs_load_source(job->data);
+	job->create_ns = os_gettime_ns() - start;
+}
+
+static void create_parallel_jobs(struct source_load_pool *pool)
+{
+	for (;;) {
+		size_t idx = (size_t)(os_atomic_inc_long(&pool->next) - 1);
+		if (idx >= pool->num_parallel_jobs)
+			break;
+
+		create_load_job(&pool->jobs[pool->parallel_jobs[idx]]);
+	}
+}
+
+static void *source_load_thread(void *param)
+{
+	os_set_thread_name("libobs: source load thread");
+	create_parallel_jobs(param);
+	return NULL;
+}
+
+static int compare_load_times(const void *a, const void *b)
+{
+	const struct source_load_job *job_a = *(const struct source_load_job *const *)a;
+	const struct source_load_job *job_b = *(const struct source_load_job *const *)b;
+	uint64_t time_a = job_a->create_ns + job_a->load_ns;
+	uint64_t time_b = job_b->create_ns + job_b->load_ns;
+
+	return time_a < time_b ? 1 : (time_a > time_b ? -1 : 0);
+}
+
+static void log_load_times(struct source_load_job *jobs, size_t count, size_t num_parallel, size_t num_threads,
+			   uint64_t total_ns)
+{
+	struct source_load_job **sorted = bmalloc(sizeof(*sorted) * count);
+
+	for (size_t i = 0; i < count; i++)
+		sorted[i] = &jobs[i];
+	qsort(sorted, count, sizeof(*sorted), compare_load_times);
+
+	blog(LOG_INFO, "Loaded %zu sources in %.1f ms (%zu created on %zu worker threads)", count,
+	     (double)total_ns / 1000000.0, num_parallel, num_threads);
+
+	for (size_t i = 0; i < count; i++) {
+		struct source_load_job *job = sorted[i];
+		if (!job->source)
+			continue;
+
+		blog(i < LOAD_TIMES_LOGGED ? LOG_INFO : LOG_DEBUG, "    %s '%s': create %.2f ms, load %.2f ms%s",
+		     job->source->info.id, obs_source_get_name(job->source), (double)job->create_ns / 1000000.0,
+		     (double)job->load_ns / 1000000.0, job->parallel ? " (parallel)" : "");
+	}
+
+	bfree(sorted);
+}
+
+void obs_load_sources_parallel(obs_data_array_t *array, obs_load_source_cb cb, void *private_data)
+{
+	struct source_load_pool pool = {0};
+	pthread_t threads[MAX_LOAD_THREADS];
+	size_t num_threads = 0;
+	size_t count = obs_data_array_count(array);
+	uint64_t start = os_gettime_ns();
+
+	if (!count)
+		return;
+
+	os_atomic_inc_long(&obs->data.sources_loading);
+
+	pool.jobs = bzalloc(sizeof(*pool.jobs) * count);
+	pool.parallel_jobs = bmalloc(sizeof(*pool.parallel_jobs) * count);
+
+	for (size_t i = 0; i < count; i++) {
+		struct source_load_job *job = &pool.jobs[i];
+
+		job->data = obs_data_array_item(array, i);
+		job->parallel = can_load_unit_in_parallel(job->data);
+		if (job->parallel)
+			pool.parallel_jobs[pool.num_parallel_jobs++] = i;
+	}
+
+	if (pool.num_parallel_jobs > 1) {
+		size_t max_threads = (size_t)os_get_logical_cores();
+
+		if (max_threads > MAX_LOAD_THREADS)
+			max_threads = MAX_LOAD_THREADS;
+		if (max_threads > pool.num_parallel_jobs)
+			max_threads = pool.num_parallel_jobs;
+
+		for (size_t i = 0; i < max_threads; i++) {
+			if (pthread_create(&threads[num_threads], NULL, source_load_thread, &pool) == 0)
+				num_threads++;
+		}
+	}
+
+	/* everything else is created here, in order, while the workers run */
+	for (size_t i = 0; i < count; i++) {
+		if (!pool.jobs[i].parallel)
+			create_load_job(&pool.jobs[i]);
+	}
+
+	/* picks up whatever the workers have not started yet, or everything
+	 * if no worker could be started */
+	create_parallel_jobs(&pool);
+
+	for (size_t i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	/* tell sources that we want to load */
+	for (size_t i = 0; i < count; i++) {
+		struct source_load_job *job = &pool.jobs[i];
+		obs_source_t *source = job->source;
+
+		if (source) {
+			uint64_t load_start = os_gettime_ns();
+
+			if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
+				obs_transition_load(source, job->data);
+			obs_source_load2(source);
+			job->load_ns = os_gettime_ns() - load_start;
+
+			if (cb)
+				cb(private_data, source);
+		}
+	}
+
+	log_load_times(pool.jobs, count, pool.num_parallel_jobs, num_threads, os_gettime_ns() - start);
+
+	for (size_t i = 0; i < count; i++) {
+		obs_source_release(pool.jobs[i].source);
+		obs_data_release(pool.jobs[i].data);
+	}
+
+	bfree(pool.parallel_jobs);
+	bfree(pool.jobs);
+
+	os_atomic_dec_long(&obs->data.sources_loading);
+}
+
+bool obs_sources_loading(void)
+{
+	return obs ? os_atomic_load_long(&obs->data.sources_loading) > 0 : false;
+}
+
 obs_data_t *obs_save_source(obs_source_t *source)
 {
 	obs_data_array_t *filters = obs_data_array_create();
@@ -2494,6 +2783,95 @@ obs_data_t *obs_save_source(obs_source_t *source)
 	return source_data;
 }
 
+static inline void raise_save_gen(volatile long *gen, long val)
+{
+	long cur = os_atomic_load_long(gen);
+	while (cur < val && !os_atomic_compare_exchange_long(gen, &cur, val))
+		;
+}
+
+void obs_source_save_changed(obs_source_t *source)
+{
+	if (source)
+		raise_save_gen(&source->save_gen, os_atomic_inc_long(&obs->data.save_gen));
+}
+
+/* For changes that can affect the saved data of any source, such as renames
+ * (scenes save the names of their items) or canvas resizes. */
+void obs_save_changed_all(void)
+{
+	raise_save_gen(&obs->data.save_reset_gen, os_atomic_inc_long(&obs->data.save_gen));
+}
+
+/* Gets the newest change to anything in the saved data of the source, returns
+ * false if the saved data can change without libobs knowing about it. Save
+ * generations come from a single increasing counter, so the maximum changes
+ * whenever any part changes. */
+static bool get_source_save_gen(obs_source_t *source, long *gen)
+{
+	long val = os_atomic_load_long(&obs->data.save_reset_gen);
+	bool cacheable = true;
+
+	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
+		return false;
+	if (source->info.type != OBS_SOURCE_TYPE_SCENE && source->info.save)
+		return false;
+
+	if (val < os_atomic_load_long(&source->save_gen))
+		val = os_atomic_load_long(&source->save_gen);
+
+	pthread_mutex_lock(&source->filter_mutex);
+	for (size_t i = 0; i < source->filters.num; i++) {
+		obs_source_t *filter = source->filters.array[i];
+		long filter_gen = os_atomic_load_long(&filter->save_gen);
+
+		if (filter->info.save)
+			cacheable = false;
+		if (val < filter_gen)
+			val = filter_gen;
+	}
+	pthread_mutex_unlock(&source->filter_mutex);
+
+	if (source->info.type == OBS_SOURCE_TYPE_SCENE && source->context.data) {
+		long groups_gen = obs_scene_get_groups_save_gen(source->context.data);
+		if (val < groups_gen)
+			val = groups_gen;
+	}
+
+	*gen = val;
+	return cacheable;
+}
+
+/* Only re-saves sources that changed since the last call. The cached data
+ * references the live settings of the source, so it stays up to date with
+ * direct changes to them. */
+static obs_data_t *get_source_save_data(obs_source_t *source)
+{
+	obs_data_t *source_data;
+	long gen;
+
+	if (!get_source_save_gen(source, &gen)) {
+		obs_data_release(source->save_data);
+		source->save_data = NULL;
+		return obs_save_source(source);
+	}
+
+	if (source->save_data && source->saved_gen == gen) {
+		obs_source_dosignal(source, "source_save", "save");
+		obs_data_addref(source->save_data);
+		return source->save_data;
+	}
+
+	source_data = obs_save_source(source);
+
+	obs_data_release(source->save_data);
+	obs_data_addref(source_data);
+	source->save_data = source_data;
+	source->saved_gen = gen;
+
+	return source_data;
+}
+
 obs_data_array_t *obs_save_sources_filtered(obs_save_source_filter_cb cb, void *data_)
 {
 	struct obs_core_data *data = &obs->data;
@@ -2509,7 +2887,7 @@ obs_data_array_t *obs_save_sources_filtered(obs_save_source_filter_cb cb, void *
 	while (source) {
 		if ((source->info.type != OBS_SOURCE_TYPE_FILTER) != 0 && !source->removed && !source->temp_removed &&
 		    !source->context.private && cb(data_, source)) {
-			obs_data_t *source_data = obs_save_source(source);
+			obs_data_t *source_data = get_source_save_data(source);
 
 			obs_data_array_push_back(array, source_data);
 			obs_data_release(source_data);
@@ -2558,6 +2936,8 @@ void obs_reset_source_uuids()
 	obs->data.sources = (struct obs_source *)new_ht;
 
 	pthread_mutex_unlock(&obs->data.sources_mutex);
+
+	obs_save_changed_all();
 }
 
 /* ensures that names are never blank */
@@ -3292,6 +3672,11 @@ void obs_queue_task(enum obs_task_type type, obs_task_t task, void *param, bool
 	}
 }
 
+os_task_pool_t *obs_get_task_pool(void)
+{
+	return obs ? obs->task_pool : NULL;
+}
+
 bool obs_wait_for_destroy_queue(void)
 {
 	struct task_wait_info info = {0};
@@ -20,6 +20,7 @@
 #include "util/c99defs.h"
 #include "util/bmem.h"
 #include "util/profiler.h"
+#include "util/task.h"
 #include "util/text-lookup.h"
 #include "graphics/graphics.h"
 #include "graphics/vec2.h"
@@ -176,7 +177,8 @@ struct obs_transform_info {
 struct obs_video_info {
 #ifndef SWIG
 	/**
-	 * Graphics module to use (usually "libobs-opengl" or "libobs-d3d11")
+	 * Graphics module to use (usually "libobs-opengl" or "libobs-d3d11",
+	 * or "libobs-null" for headless testing)
 	 */
 	const char *graphics_module;
 #endif
@@ -442,6 +444,27 @@ EXPORT float obs_get_video_hdr_nominal_peak_level(void);
 /** Sets the video levels */
 EXPORT void obs_set_video_levels(float sdr_white_level, float hdr_nominal_peak_level);
 
+/**
+ * Enables passing mapped staging surfaces directly to raw encoders and raw
+ * outputs instead of copying every frame into the video output's cache.
+ */
+EXPORT void obs_set_video_zero_copy(bool enable);
+EXPORT bool obs_video_zero_copy_enabled(void);
+
+/**
+ * Enables ticking sources with the help of a worker pool.  Async frame
+ * selection and the ticks of sources flagged with OBS_SOURCE_THREAD_SAFE_TICK
+ * run on the workers, all other tick work stays on the graphics thread.
+ */
+EXPORT void obs_set_parallel_tick(bool enable);
+EXPORT bool obs_parallel_tick_enabled(void);
+
+/**
+ * Sets the directory parsed effects are cached in, NULL disables the cache.
+ * Call before obs_reset_video to also cache the effects of libobs.
+ */
+EXPORT void obs_set_effect_cache_path(const char *path);
+
 /** Gets the current audio settings, returns false if no audio */
 EXPORT bool obs_get_audio_info(struct obs_audio_info *oai);
 
@@ -793,6 +816,17 @@ typedef void (*obs_load_source_cb)(void *private_data, obs_source_t *source);
 /** Loads sources from a data array */
 EXPORT void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb, void *private_data);
 
+/**
+ * Loads sources from a data array like obs_load_sources, but creates the
+ * sources whose types (and filter types) have OBS_SOURCE_PARALLEL_LOAD set on
+ * worker threads. Load signals and the callback still happen in array order
+ * on the calling thread. A breakdown of the load times is logged.
+ */
+EXPORT void obs_load_sources_parallel(obs_data_array_t *array, obs_load_source_cb cb, void *private_data);
+
+/** Returns true while obs_load_sources_parallel is running */
+EXPORT bool obs_sources_loading(void);
+
 /** Saves sources to a data array */
 EXPORT obs_data_array_t *obs_save_sources(void);
 
@@ -878,6 +912,10 @@ EXPORT bool obs_in_task_thread(enum obs_task_type type);
 
 EXPORT bool obs_wait_for_destroy_queue(void);
 
+/* Shared pool for delayed, periodic and background tasks, so they don't need
+ * threads of their own. Tasks must be canceled before their module unloads. */
+EXPORT os_task_pool_t *obs_get_task_pool(void);
+
 typedef void (*obs_task_handler_t)(obs_task_t task, void *param, bool wait);
 EXPORT void obs_set_ui_task_handler(obs_task_handler_t handler);
 
@@ -972,6 +1010,53 @@ EXPORT void obs_display_set_background_color(obs_display_t *display, uint32_t co
 
 EXPORT void obs_display_size(obs_display_t *display, uint32_t *width, uint32_t *height);
 
+/* ------------------------------------------------------------------------- */
+/* Image cache */
+
+/**
+ * Static images shared by everything that uses the same file.  Images are
+ * identified by path, modification time and alpha mode, decoded once in the
+ * background and uploaded to a single texture.  Images no longer in use stay
+ * cached until the cache exceeds its memory budget.
+ */
+typedef struct obs_cached_image obs_cached_image_t;
+
+/** Image cache counters */
+struct obs_image_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t images;       /**< images in the cache, including unused ones */
+	uint64_t bytes;        /**< decoded size of the images in the cache */
+	uint64_t bytes_unused; /**< decoded size of the images no longer in use */
+	uint64_t budget;
+};
+
+/** Gets a reference to an image, starts decoding it if not cached */
+EXPORT obs_cached_image_t *obs_image_cache_get(const char *path, enum gs_image_alpha_mode alpha_mode);
+EXPORT void obs_cached_image_release(obs_cached_image_t *image);
+
+/** Returns whether decoding has finished, whether or not it succeeded */
+EXPORT bool obs_cached_image_decoded(obs_cached_image_t *image);
+/** Waits for decoding, decodes on the calling thread if it has not started */
+EXPORT void obs_cached_image_wait(obs_cached_image_t *image);
+/** Returns whether the image was decoded successfully */
+EXPORT bool obs_cached_image_loaded(obs_cached_image_t *image);
+
+EXPORT uint32_t obs_cached_image_get_width(obs_cached_image_t *image);
+EXPORT uint32_t obs_cached_image_get_height(obs_cached_image_t *image);
+EXPORT enum gs_color_space obs_cached_image_get_color_space(obs_cached_image_t *image);
+EXPORT uint64_t obs_cached_image_get_mem_usage(obs_cached_image_t *image);
+
+/** Gets the texture, creating it if necessary (graphics context required).
+ * Returns NULL until the image is decoded, or if it failed to load. */
+EXPORT gs_texture_t *obs_cached_image_get_texture(obs_cached_image_t *image);
+
+/** Sets the memory budget in bytes, images no longer in use are evicted
+ * least recently used first while the cache exceeds it (256 MB by default) */
+EXPORT void obs_image_cache_set_budget(uint64_t bytes);
+EXPORT void obs_image_cache_get_stats(struct obs_image_cache_stats *stats);
+
 /* ------------------------------------------------------------------------- */
 /* Sources */
 
@@ -1053,6 +1138,12 @@ EXPORT obs_properties_t *obs_source_properties(const obs_source_t *source);
 EXPORT void obs_source_update(obs_source_t *source, obs_data_t *settings);
 EXPORT void obs_source_reset_settings(obs_source_t *source, obs_data_t *settings);
 
+/**
+ * Sets a batch of setting values by key and notifies the source once, without
+ * building and applying a separate settings object
+ */
+EXPORT void obs_source_update_values(obs_source_t *source, const struct obs_data_value *values, size_t count);
+
 /** Renders a video source. */
 EXPORT void obs_source_video_render(obs_source_t *source);
 
@@ -1478,6 +1569,26 @@ EXPORT void obs_source_get_audio_mix(const obs_source_t *source, struct obs_sour
 EXPORT void obs_source_set_async_unbuffered(obs_source_t *source, bool unbuffered);
 EXPORT bool obs_source_async_unbuffered(const obs_source_t *source);
 
+enum obs_async_frame_drop {
+	OBS_ASYNC_FRAME_DROP_OLDEST,
+	OBS_ASYNC_FRAME_DROP_NEWEST,
+};
+
+/** Sets the maximum number of async frames queued for a source (1-64) */
+EXPORT void obs_source_set_async_queue_depth(obs_source_t *source, size_t depth);
+EXPORT size_t obs_source_get_async_queue_depth(const obs_source_t *source);
+
+/** Sets which frames get dropped when the async frame queue is full */
+EXPORT void obs_source_set_async_drop_policy(obs_source_t *source, enum obs_async_frame_drop policy);
+EXPORT enum obs_async_frame_drop obs_source_get_async_drop_policy(const obs_source_t *source);
+
+/** Number of async frames dropped because the frame queue was full */
+EXPORT uint32_t obs_source_get_async_frames_dropped(const obs_source_t *source);
+
+/** Number of async frames skipped because they were already too late to be
+ * displayed */
+EXPORT uint32_t obs_source_get_async_frames_late(const obs_source_t *source);
+
 /** Used to decouple audio from video so that audio doesn't attempt to sync up
  * with video.  I.E. Audio acts independently.  Only works when in unbuffered
  * mode. */
@@ -2370,6 +2481,17 @@ EXPORT uint32_t obs_encoder_get_caps(const obs_encoder_t *encoder);
 EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst, struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+/** Encoder packet buffer pool counters, sample them to get allocation rates */
+struct obs_encoder_packet_pool_stats {
+	uint64_t allocations; /**< buffers allocated from the heap */
+	uint64_t reuses;      /**< buffers recycled from the pool */
+	uint64_t unpooled;    /**< buffers too large (or allocated while the pool is inactive) */
+	uint64_t bytes_in_use;
+	uint64_t bytes_cached;
+};
+
+EXPORT void obs_encoder_packet_pool_get_stats(struct obs_encoder_packet_pool_stats *stats);
+
 EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder, const char *reroute_id);
 
 /** Returns whether encoder is paused */
@@ -45,6 +45,10 @@ struct io_buffer {
 	FILE *output_file;
 	struct deque data;
 	uint64_t next_pos;
+	/* Total number of bytes that reached the file, regardless of seeks */
+	uint64_t bytes_written;
+	/* Set if chunks are flushed, signaled once they are */
+	os_event_t *flush_event;
 
 	size_t buffer_size;
 	size_t chunk_size;
@@ -64,6 +68,9 @@ static void *io_thread(void *opaque)
 	size_t chunk_used = 0;
 	size_t chunk_size = out->io.chunk_size;
 
+	// Fetched along with the data, see buffered_file_serializer_set_flush_event
+	os_event_t *flush_event = NULL;
+
 	unsigned char *chunk = bmalloc(chunk_size);
 	if (!chunk) {
 		os_atomic_set_bool(&out->io.output_error, true);
@@ -91,6 +98,7 @@ static void *io_thread(void *opaque)
 			pthread_mutex_lock(&out->io.data_mutex);
 
 			shutting_down = os_atomic_load_bool(&out->io.shutdown_requested);
+			flush_event = out->io.flush_event;
 
 			// Fetch as many writes as possible from the deque
 			// and fill up our local chunk. This may involve
@@ -148,9 +156,11 @@ static void *io_thread(void *opaque)
 			os_event_signal(out->io.buffer_space_available_event);
 
 			// Try to avoid lots of small writes unless this was the final
-			// data left in the buffer. The buffer might be entirely empty
-			// if we were woken up to exit.
-			if (!force_flush_chunk && (!chunk_used || (chunk_used < 65536 && !shutting_down))) {
+			// data left in the buffer or someone is waiting for the data
+			// to reach the file. The buffer might be entirely empty if we
+			// were woken up to exit.
+			if (!force_flush_chunk &&
+			    (!chunk_used || (chunk_used < 65536 && !shutting_down && !flush_event))) {
 				os_event_reset(out->io.new_data_available_event);
 				pthread_mutex_unlock(&out->io.data_mutex);
 				break;
@@ -186,6 +196,16 @@ static void *io_thread(void *opaque)
 				goto error;
 			}
 
+			if (flush_event)
+				fflush(out->io.output_file);
+
+			pthread_mutex_lock(&out->io.data_mutex);
+			out->io.bytes_written += chunk_used;
+			pthread_mutex_unlock(&out->io.data_mutex);
+
+			if (flush_event)
+				os_event_signal(flush_event);
+
 			chunk_used = 0;
 			force_flush_chunk = false;
 		}
@@ -200,6 +220,10 @@ error:
 		bfree(chunk);
 
 	fclose(out->io.output_file);
+
+	// Wake up readers waiting for data that is never going to come
+	if (flush_event)
+		os_event_signal(flush_event);
 	return NULL;
 }
 
@@ -319,6 +343,27 @@ static int64_t file_output_get_pos(void *opaque)
 	return (int64_t)out->io.next_pos;
 }
 
+void buffered_file_serializer_set_flush_event(struct serializer *s, os_event_t *event)
+{
+	struct file_output_data *out = s->data;
+
+	pthread_mutex_lock(&out->io.data_mutex);
+	out->io.flush_event = event;
+	pthread_mutex_unlock(&out->io.data_mutex);
+}
+
+uint64_t buffered_file_serializer_get_bytes_written(struct serializer *s)
+{
+	struct file_output_data *out = s->data;
+	uint64_t bytes_written;
+
+	pthread_mutex_lock(&out->io.data_mutex);
+	bytes_written = out->io.bytes_written;
+	pthread_mutex_unlock(&out->io.data_mutex);
+
+	return bytes_written;
+}
+
 bool buffered_file_serializer_init_defaults(struct serializer *s, const char *path)
 {
 	return buffered_file_serializer_init(s, path, 0, 0);
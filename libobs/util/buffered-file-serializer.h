@@ -17,6 +17,7 @@
 #pragma once
 
 #include "serializer.h"
+#include "threading.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,6 +28,17 @@ EXPORT bool buffered_file_serializer_init(struct serializer *s, const char *path
 					  size_t chunk_size);
 EXPORT void buffered_file_serializer_free(struct serializer *s);
 
+/* Writes out queued data as soon as the queue runs empty instead of waiting
+ * for a full chunk, and flushes the file after every chunk, so the data can
+ * be read back through a separate file handle shortly after it was written.
+ * Signals the event after each chunk and once the writer stopped.  Off by
+ * default, set it before writing. */
+EXPORT void buffered_file_serializer_set_flush_event(struct serializer *s, os_event_t *event);
+
+/* Number of bytes written to the file so far.  With a flush event set, data
+ * up to this point can be read back through a separate file handle. */
+EXPORT uint64_t buffered_file_serializer_get_bytes_written(struct serializer *s);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,428 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <string.h>
+
+#include "frame-timeline.h"
+#include "bmem.h"
+#include "dstr.h"
+#include "platform.h"
+#include "threading.h"
+
+struct frame_record {
+	/* odd while the record is being written */
+	volatile long seq;
+
+	/* frames are numbered from 1, 0 is an unused record */
+	uint64_t number;
+	uint64_t start;
+	uint64_t work_end;
+	uint64_t wake_target;
+	uint64_t wake;
+	uint32_t lagged;
+
+	/* relative to start, phases that run more than once per frame start at
+	 * the first run and last for the sum of all runs */
+	uint32_t phase_offset[FRAME_TIMELINE_PHASE_COUNT];
+	uint32_t phase_duration[FRAME_TIMELINE_PHASE_COUNT];
+};
+
+/* Histogram buckets are linear within each power of two, with 8 buckets per
+ * power of two. Values below 8 ns have a bucket each. */
+#define HIST_SUB_BITS 3
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+struct histogram {
+	volatile long long count;
+	volatile long long buckets[HIST_BUCKETS];
+};
+
+/* Ring buffer, only written by the graphics thread. Readers detect records
+ * that were overwritten while being read by their sequence, and records that
+ * were overwritten before being read by their frame number. */
+static struct frame_record *records = NULL;
+static size_t capacity = 0;
+static volatile long newest_record = 0;
+
+/* Guards against the ring buffer being reallocated while it is read, the
+ * graphics thread never runs while it is reallocated. */
+static pthread_mutex_t records_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct histogram histograms[FRAME_TIMELINE_STAT_COUNT];
+
+/* Graphics thread state */
+static struct frame_record cur;
+static uint64_t frame_number = 0;
+static uint64_t last_start = 0;
+static bool recording = false;
+static bool enabled = true;
+
+/* These can be set from other threads */
+static volatile bool enable_next = true;
+static volatile bool reset_next = false;
+
+static inline int msb64(uint64_t val)
+{
+	int msb = 0;
+
+	if (val >> 32) {
+		val >>= 32;
+		msb += 32;
+	}
+	if (val >> 16) {
+		val >>= 16;
+		msb += 16;
+	}
+	if (val >> 8) {
+		val >>= 8;
+		msb += 8;
+	}
+	if (val >> 4) {
+		val >>= 4;
+		msb += 4;
+	}
+	if (val >> 2) {
+		val >>= 2;
+		msb += 2;
+	}
+	if (val >> 1)
+		msb += 1;
+
+	return msb;
+}
+
+static inline size_t hist_bucket(uint64_t val)
+{
+	if (val < HIST_SUB_BUCKETS)
+		return (size_t)val;
+
+	int msb = msb64(val);
+	size_t sub = (size_t)(val >> (msb - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1);
+	return ((size_t)(msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) | sub;
+}
+
+/* Middle of the range of values of a bucket */
+static inline uint64_t hist_bucket_value(size_t bucket)
+{
+	if (bucket < HIST_SUB_BUCKETS)
+		return bucket;
+
+	int shift = (int)(bucket >> HIST_SUB_BITS) - 1;
+	uint64_t sub = (uint64_t)(bucket & (HIST_SUB_BUCKETS - 1));
+	uint64_t lower = (HIST_SUB_BUCKETS | sub) << shift;
+	return lower + (((uint64_t)1 << shift) >> 1);
+}
+
+static inline void hist_add(enum frame_timeline_stat stat, uint64_t val)
+{
+	struct histogram *hist = &histograms[stat];
+
+	/* only the graphics thread writes */
+	hist->buckets[hist_bucket(val)]++;
+	hist->count++;
+}
+
+static void hist_reset(void)
+{
+	for (size_t i = 0; i < FRAME_TIMELINE_STAT_COUNT; i++) {
+		histograms[i].count = 0;
+		memset((void *)histograms[i].buckets, 0, sizeof(histograms[i].buckets));
+	}
+}
+
+static inline uint32_t clamp32(uint64_t val)
+{
+	return val > UINT32_MAX ? UINT32_MAX : (uint32_t)val;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Graphics thread */
+
+void frame_timeline_reset_video(uint32_t fps_num, uint32_t fps_den)
+{
+	size_t new_capacity = 0;
+
+	if (fps_num && fps_den)
+		new_capacity = (size_t)(((uint64_t)fps_num * FRAME_TIMELINE_SECONDS + fps_den - 1) / fps_den);
+
+	/* the graphics thread is not running at this point */
+	pthread_mutex_lock(&records_mutex);
+	bfree(records);
+	records = new_capacity ? bzalloc(sizeof(struct frame_record) * new_capacity) : NULL;
+	capacity = new_capacity;
+	newest_record = 0;
+	frame_number = 0;
+	pthread_mutex_unlock(&records_mutex);
+
+	last_start = 0;
+	recording = false;
+	hist_reset();
+}
+
+void frame_timeline_free(void)
+{
+	frame_timeline_reset_video(0, 0);
+}
+
+void frame_timeline_frame_begin(uint64_t start)
+{
+	if (enabled != enable_next) {
+		enabled = enable_next;
+		last_start = 0;
+	}
+	if (reset_next) {
+		reset_next = false;
+		hist_reset();
+	}
+
+	recording = enabled && records;
+	if (!recording)
+		return;
+
+	memset(&cur, 0, sizeof(cur));
+	cur.start = start;
+}
+
+uint64_t frame_timeline_phase_begin(void)
+{
+	return recording ? os_gettime_ns() : 0;
+}
+
+void frame_timeline_phase_end(enum frame_timeline_stat phase, uint64_t start)
+{
+	if (!recording || !start)
+		return;
+
+	uint64_t end = os_gettime_ns();
+
+	if (!cur.phase_duration[phase])
+		cur.phase_offset[phase] = clamp32(start - cur.start);
+	cur.phase_duration[phase] = clamp32((uint64_t)cur.phase_duration[phase] + (end - start));
+}
+
+void frame_timeline_work_end(uint64_t end)
+{
+	if (recording)
+		cur.work_end = end;
+}
+
+static void commit_record(void)
+{
+	size_t idx = (size_t)(frame_number % capacity);
+	struct frame_record *rec = &records[idx];
+
+	cur.number = ++frame_number;
+
+	os_atomic_inc_long(&rec->seq);
+	memcpy((uint8_t *)rec + sizeof(rec->seq), (uint8_t *)&cur + sizeof(cur.seq), sizeof(cur) - sizeof(cur.seq));
+	os_atomic_inc_long(&rec->seq);
+
+	os_atomic_set_long(&newest_record, (long)idx);
+}
+
+void frame_timeline_frame_end(uint64_t wake_target, uint64_t wake, int lagged)
+{
+	if (!recording)
+		return;
+
+	cur.wake_target = wake_target;
+	cur.wake = wake;
+	cur.lagged = lagged > 0 ? (uint32_t)lagged : 0;
+
+	for (size_t i = 0; i < FRAME_TIMELINE_PHASE_COUNT; i++)
+		hist_add(i, cur.phase_duration[i]);
+
+	hist_add(FRAME_TIMELINE_FRAME, cur.work_end - cur.start);
+	hist_add(FRAME_TIMELINE_SLEEP_OVERSHOOT, wake > wake_target ? wake - wake_target : 0);
+	if (last_start)
+		hist_add(FRAME_TIMELINE_INTERVAL, cur.start - last_start);
+	last_start = cur.start;
+
+	commit_record();
+}
+
+/* ------------------------------------------------------------------------- */
+/* Readers */
+
+void frame_timeline_enable(bool enable)
+{
+	enable_next = enable;
+}
+
+bool frame_timeline_enabled(void)
+{
+	return enable_next;
+}
+
+void frame_timeline_reset_stats(void)
+{
+	reset_next = true;
+}
+
+bool frame_timeline_get_percentile(enum frame_timeline_stat stat, double percentile, uint64_t *value)
+{
+	if (stat >= FRAME_TIMELINE_STAT_COUNT || !value)
+		return false;
+
+	struct histogram *hist = &histograms[stat];
+	long long count = hist->count;
+	if (count <= 0)
+		return false;
+
+	if (percentile < 0.0)
+		percentile = 0.0;
+	else if (percentile > 100.0)
+		percentile = 100.0;
+
+	long long target = (long long)((double)count * percentile / 100.0 + 0.5);
+	long long total = 0;
+	size_t last = 0;
+
+	if (target < 1)
+		target = 1;
+
+	for (size_t i = 0; i < HIST_BUCKETS; i++) {
+		long long num = hist->buckets[i];
+		if (!num)
+			continue;
+
+		last = i;
+		total += num;
+		if (total >= target)
+			break;
+	}
+
+	*value = hist_bucket_value(last);
+	return true;
+}
+
+static bool read_record(struct frame_record *dst, size_t idx)
+{
+	const struct frame_record *src = &records[idx];
+	long seq = os_atomic_load_long(&src->seq);
+
+	if (seq & 1)
+		return false;
+
+	memcpy(dst, src, sizeof(*dst));
+	return os_atomic_load_long(&src->seq) == seq;
+}
+
+/* Copies the records of the last seconds, oldest first */
+static size_t read_records(struct frame_record **out, uint32_t seconds)
+{
+	struct frame_record *recs = NULL;
+	size_t num = 0;
+
+	pthread_mutex_lock(&records_mutex);
+
+	if (records) {
+		size_t idx = (size_t)os_atomic_load_long(&newest_record);
+
+		recs = bmalloc(sizeof(struct frame_record) * capacity);
+
+		for (size_t i = 0; i < capacity; i++) {
+			struct frame_record *rec = &recs[num];
+
+			/* stop at unused records and records that were
+			 * overwritten by newer frames */
+			if (!read_record(rec, idx) || !rec->number)
+				break;
+			if (num && rec->number != recs[num - 1].number - 1)
+				break;
+			if (recs[0].start - rec->start > (uint64_t)seconds * 1000000000ULL)
+				break;
+
+			num++;
+			idx = (idx + capacity - 1) % capacity;
+		}
+	}
+
+	pthread_mutex_unlock(&records_mutex);
+
+	for (size_t i = 0; i < num / 2; i++) {
+		struct frame_record tmp = recs[i];
+		recs[i] = recs[num - 1 - i];
+		recs[num - 1 - i] = tmp;
+	}
+
+	*out = recs;
+	return num;
+}
+
+static const char *stat_names[FRAME_TIMELINE_STAT_COUNT] = {
+	"tick",       "render", "gpu_conversion",  "stage_map", "output_copy",
+	"displays",   "frame",  "sleep_overshoot", "interval",
+};
+
+/* Chrome trace timestamps are in microseconds, written without floating point
+ * to not depend on the locale */
+static void cat_usec(struct dstr *json, uint64_t ns)
+{
+	dstr_catf(json, "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+}
+
+static void cat_event(struct dstr *json, const char *name, uint64_t ts, uint64_t dur)
+{
+	dstr_catf(json, ",\n{\"name\":\"%s\",\"cat\":\"video\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":", name);
+	cat_usec(json, ts);
+	dstr_cat(json, ",\"dur\":");
+	cat_usec(json, dur);
+}
+
+char *frame_timeline_get_chrome_trace(uint32_t seconds)
+{
+	struct frame_record *recs;
+	size_t num = read_records(&recs, seconds);
+	uint64_t base = num ? recs[0].start : 0;
+	struct dstr json = {0};
+
+	dstr_reserve(&json, 256 + num * 640);
+	dstr_cat(&json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+			"\"args\":{\"name\":\"libobs: graphics thread\"}}");
+
+	for (size_t i = 0; i < num; i++) {
+		const struct frame_record *rec = &recs[i];
+		uint64_t start = rec->start - base;
+
+		cat_event(&json, "frame", start, rec->work_end - rec->start);
+		dstr_catf(&json, ",\"args\":{\"lagged\":%u}}", rec->lagged);
+
+		for (size_t p = 0; p < FRAME_TIMELINE_PHASE_COUNT; p++) {
+			if (!rec->phase_duration[p])
+				continue;
+
+			cat_event(&json, stat_names[p], start + rec->phase_offset[p], rec->phase_duration[p]);
+			dstr_cat(&json, "}");
+		}
+
+		cat_event(&json, "sleep", rec->work_end - base, rec->wake - rec->work_end);
+		dstr_cat(&json, ",\"args\":{\"overshoot_us\":");
+		cat_usec(&json, rec->wake > rec->wake_target ? rec->wake - rec->wake_target : 0);
+		dstr_cat(&json, "}}");
+
+		if (rec->lagged) {
+			dstr_cat(&json, ",\n{\"name\":\"lagged frames\",\"cat\":\"video\",\"ph\":\"i\",\"s\":\"t\","
+					"\"pid\":1,\"tid\":1,\"ts\":");
+			cat_usec(&json, rec->wake - base);
+			dstr_catf(&json, ",\"args\":{\"count\":%u}}", rec->lagged);
+		}
+	}
+
+	dstr_cat(&json, "\n]}\n");
+
+	bfree(recs);
+	return json.array;
+}
+
+bool frame_timeline_save_chrome_trace(const char *path, uint32_t seconds)
+{
+	char *json = frame_timeline_get_chrome_trace(seconds);
+	bool success = os_quick_write_utf8_file(path, json, strlen(json), false);
+
+	bfree(json);
+	return success;
+}
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "c99defs.h"
+
+/*
+ * Frame timeline
+ *
+ *   Records the timing of every frame of the graphics thread into a ring
+ * buffer that holds the last FRAME_TIMELINE_SECONDS seconds, and keeps
+ * histograms of each value for percentiles. Recording is lock free, the
+ * timeline can be read from any thread.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_TIMELINE_SECONDS 30
+
+enum frame_timeline_stat {
+	/* Phases of a frame, phases that run once per canvas are summed */
+	FRAME_TIMELINE_TICK,
+	FRAME_TIMELINE_RENDER,
+	FRAME_TIMELINE_GPU_CONVERSION, /* part of the render phase */
+	FRAME_TIMELINE_STAGE_MAP,
+	FRAME_TIMELINE_OUTPUT_COPY,
+	FRAME_TIMELINE_DISPLAYS,
+
+	/* Time from the start of the frame until the thread goes to sleep */
+	FRAME_TIMELINE_FRAME,
+	/* Time the thread woke up after the time it was supposed to */
+	FRAME_TIMELINE_SLEEP_OVERSHOOT,
+	/* Time between the start of a frame and the start of the next one */
+	FRAME_TIMELINE_INTERVAL,
+
+	FRAME_TIMELINE_STAT_COUNT,
+};
+
+#define FRAME_TIMELINE_PHASE_COUNT (FRAME_TIMELINE_DISPLAYS + 1)
+
+/* Enables/disables recording (applied on next frame), enabled by default */
+EXPORT void frame_timeline_enable(bool enable);
+EXPORT bool frame_timeline_enabled(void);
+
+/* Gets a percentile (0.0-100.0) in ns of a value since the last reset, the
+ * histograms have a resolution of 12.5%. Returns false without samples. */
+EXPORT bool frame_timeline_get_percentile(enum frame_timeline_stat stat, double percentile, uint64_t *value);
+/* Clears the histograms (applied on next frame) */
+EXPORT void frame_timeline_reset_stats(void);
+
+/* Gets the last seconds of the timeline as Chrome trace event JSON, which
+ * can be opened with chrome://tracing or Perfetto (must be freed with bfree) */
+EXPORT char *frame_timeline_get_chrome_trace(uint32_t seconds);
+EXPORT bool frame_timeline_save_chrome_trace(const char *path, uint32_t seconds);
+
+#ifdef __cplusplus
+}
+#endif
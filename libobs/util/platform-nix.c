@@ -27,6 +27,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -553,6 +555,33 @@ int64_t os_get_free_space(const char *path)
 }
 #endif
 
+void *os_mmap_file(const char *path, size_t *size)
+{
+	struct stat st;
+	void *data = NULL;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (fd == -1)
+		return NULL;
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+			data = NULL;
+		else
+			*size = (size_t)st.st_size;
+	}
+
+	close(fd);
+	return data;
+}
+
+void os_munmap_file(void *data, size_t size)
+{
+	if (data)
+		munmap(data, size);
+}
+
 struct posix_glob_info {
 	struct os_glob_info base;
 	glob_t gl;
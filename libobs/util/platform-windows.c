@@ -672,6 +672,51 @@ int64_t os_get_free_space(const char *path)
 	return -1;
 }
 
+void *os_mmap_file(const char *path, size_t *size)
+{
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+	LARGE_INTEGER file_size;
+	wchar_t *wpath = NULL;
+	void *data = NULL;
+
+	if (!os_utf8_to_wcs_ptr(path, 0, &wpath))
+		return NULL;
+
+	file = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+			   FILE_ATTRIBUTE_NORMAL, NULL);
+	bfree(wpath);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 || (uint64_t)file_size.QuadPart > SIZE_MAX)
+		goto cleanup;
+
+	mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping)
+		goto cleanup;
+
+	/* the view keeps the mapping alive after the handles are closed */
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data)
+		*size = (size_t)file_size.QuadPart;
+
+cleanup:
+	if (mapping)
+		CloseHandle(mapping);
+	CloseHandle(file);
+	return data;
+}
+
+void os_munmap_file(void *data, size_t size)
+{
+	UNUSED_PARAMETER(size);
+
+	if (data)
+		UnmapViewOfFile(data);
+}
+
 static void make_globent(struct os_globent *ent, WIN32_FIND_DATA *wfd, const char *pattern)
 {
 	struct dstr name = {0};
@@ -57,6 +57,10 @@ EXPORT bool os_quick_write_mbs_file(const char *path, const char *str, size_t le
 EXPORT int64_t os_get_file_size(const char *path);
 EXPORT int64_t os_get_free_space(const char *path);
 
+/* maps a whole file read-only, returns NULL if the file is missing or empty */
+EXPORT void *os_mmap_file(const char *path, size_t *size);
+EXPORT void os_munmap_file(void *data, size_t size);
+
 EXPORT size_t os_mbs_to_wcs(const char *str, size_t str_len, wchar_t *dst, size_t dst_size);
 EXPORT size_t os_utf8_to_wcs(const char *str, size_t len, wchar_t *dst, size_t dst_size);
 EXPORT size_t os_wcs_to_mbs(const wchar_t *str, size_t len, char *dst, size_t dst_size);
@@ -10,10 +10,16 @@
 
 #include <zlib.h>
 
-//#define TRACK_OVERHEAD
+/*
+ * Profiled threads never lock or allocate while profiling. Each thread writes
+ * start/end events into its own single producer, single consumer ring buffer,
+ * and a background aggregator thread replays the events of each thread into
+ * the call trees. Times are counted in preallocated log-linear histograms.
+ */
 
 struct profiler_snapshot {
 	DARRAY(profiler_snapshot_entry_t) roots;
+	uint64_t dropped_calls;
 };
 
 struct profiler_snapshot_entry {
@@ -32,58 +38,81 @@ struct profiler_snapshot_entry {
 
 typedef struct profiler_time_entry profiler_time_entry;
 
-typedef struct profile_call profile_call;
-struct profile_call {
-	const char *name;
-#ifdef TRACK_OVERHEAD
-	uint64_t overhead_start;
-#endif
-	uint64_t start_time;
-	uint64_t end_time;
-#ifdef TRACK_OVERHEAD
-	uint64_t overhead_end;
-#endif
-	uint64_t expected_time_between_calls;
-	DARRAY(profile_call) children;
-	profile_call *parent;
-};
-
-typedef struct profile_times_table_entry profile_times_table_entry;
-struct profile_times_table_entry {
-	size_t probes;
-	profiler_time_entry entry;
-};
-
-typedef struct profile_times_table profile_times_table;
-struct profile_times_table {
-	size_t size;
-	size_t occupied;
-	size_t max_probe_count;
-	profile_times_table_entry *entries;
-
-	size_t old_start_index;
-	size_t old_occupied;
-	profile_times_table_entry *old_entries;
+/* Histogram buckets are linear within each power of two, with 32 buckets per
+ * power of two, so times below 64 µs are exact and larger times are within
+ * 1.6%. Times of 2^36 µs (19 hours) and above share the last bucket. */
+#define HIST_SUB_BITS 5
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 36
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+typedef struct profile_histogram profile_histogram;
+struct profile_histogram {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t *buckets;
 };
 
 typedef struct profile_entry profile_entry;
 struct profile_entry {
 	const char *name;
-	profile_times_table times;
-#ifdef TRACK_OVERHEAD
-	profile_times_table overhead;
-#endif
+	profile_histogram times;
 	uint64_t expected_time_between_calls;
-	profile_times_table times_between_calls;
-	DARRAY(profile_entry) children;
+	profile_histogram times_between_calls;
+	DARRAY(profile_entry *) children;
 };
 
 typedef struct profile_root_entry profile_root_entry;
 struct profile_root_entry {
-	pthread_mutex_t *mutex;
 	const char *name;
 	profile_entry *entry;
-	profile_call *prev_call;
+	uint64_t prev_start_time;
+};
+
+enum profile_event_type {
+	PROFILE_EVENT_START,
+	PROFILE_EVENT_END,
+	/* a root call that was left out by sampling, only its start time is
+	 * recorded for the time between calls */
+	PROFILE_EVENT_ROOT_SKIPPED,
+};
+
+struct profile_event {
+	const char *name;
+	uint64_t time;
+	enum profile_event_type type;
+};
+
+/* must be a power of two */
+#define PROFILE_THREAD_EVENTS 4096
+#define PROFILE_MAX_DEPTH 64
+
+typedef struct profile_thread profile_thread;
+struct profile_thread {
+	/* written by the profiled thread */
+	volatile long head;
+	volatile long dropped;
+	volatile bool exited;
+
+	/* written by the aggregator */
+	volatile long tail;
+
+	/* profiled thread only */
+	long cached_tail;
+	size_t depth;
+	size_t open_calls;
+	size_t skip_depth;
+	uint32_t sample_count;
+	const char *names[PROFILE_MAX_DEPTH];
+
+	/* aggregator only */
+	size_t replay_depth;
+	profile_entry *replay_entries[PROFILE_MAX_DEPTH];
+	uint64_t replay_start_times[PROFILE_MAX_DEPTH];
+
+	profile_thread *next;
+	struct profile_event events[PROFILE_THREAD_EVENTS];
 };
 
 static inline uint64_t diff_ns_to_usec(uint64_t prev, uint64_t next)
@@ -91,268 +120,383 @@ static inline uint64_t diff_ns_to_usec(uint64_t prev, uint64_t next)
 	return (next - prev + 500) / 1000;
 }
 
-static inline void update_max_probes(profile_times_table *map, size_t val)
+static inline int msb64(uint64_t val)
 {
-	map->max_probe_count = map->max_probe_count < val ? val : map->max_probe_count;
-}
+	int msb = 0;
+
+	if (val >> 32) {
+		val >>= 32;
+		msb += 32;
+	}
+	if (val >> 16) {
+		val >>= 16;
+		msb += 16;
+	}
+	if (val >> 8) {
+		val >>= 8;
+		msb += 8;
+	}
+	if (val >> 4) {
+		val >>= 4;
+		msb += 4;
+	}
+	if (val >> 2) {
+		val >>= 2;
+		msb += 2;
+	}
+	if (val >> 1)
+		msb += 1;
 
-static void migrate_old_entries(profile_times_table *map, bool limit_items);
-static void grow_hashmap(profile_times_table *map, uint64_t usec, uint64_t count);
+	return msb;
+}
 
-static void add_hashmap_entry(profile_times_table *map, uint64_t usec, uint64_t count)
+static inline size_t hist_bucket(uint64_t usec)
 {
-	size_t probes = 1;
+	if (usec < HIST_SUB_BUCKETS)
+		return (size_t)usec;
 
-	size_t start = usec % map->size;
-	for (;; probes += 1) {
-		size_t idx = (start + probes) % map->size;
-		profile_times_table_entry *entry = &map->entries[idx];
-		if (!entry->probes) {
-			entry->probes = probes;
-			entry->entry.time_delta = usec;
-			entry->entry.count = count;
-			map->occupied += 1;
-			update_max_probes(map, probes);
-			return;
-		}
+	int msb = msb64(usec);
+	if (msb >= HIST_MAX_BITS)
+		return HIST_BUCKETS - 1;
 
-		if (entry->entry.time_delta == usec) {
-			entry->entry.count += count;
-			return;
-		}
-
-		if (entry->probes >= probes)
-			continue;
+	size_t sub = (size_t)(usec >> (msb - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1);
+	return ((size_t)(msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) | sub;
+}
 
-		if (map->occupied / (double)map->size > 0.7) {
-			grow_hashmap(map, usec, count);
-			return;
-		}
+/* Middle of the range of times of a bucket */
+static inline uint64_t hist_bucket_value(size_t bucket)
+{
+	if (bucket < HIST_SUB_BUCKETS)
+		return bucket;
 
-		size_t old_probes = entry->probes;
-		uint64_t old_count = entry->entry.count;
-		uint64_t old_usec = entry->entry.time_delta;
+	int shift = (int)(bucket >> HIST_SUB_BITS) - 1;
+	uint64_t sub = (uint64_t)(bucket & (HIST_SUB_BUCKETS - 1));
+	uint64_t lower = (HIST_SUB_BUCKETS | sub) << shift;
+	return lower + (((uint64_t)1 << shift) >> 1);
+}
 
-		entry->probes = probes;
-		entry->entry.count = count;
-		entry->entry.time_delta = usec;
+static void init_histogram(profile_histogram *hist)
+{
+	hist->count = 0;
+	hist->min = 0;
+	hist->max = 0;
+	hist->buckets = bzalloc(sizeof(uint64_t) * HIST_BUCKETS);
+}
 
-		update_max_probes(map, probes);
+static void add_histogram_entry(profile_histogram *hist, uint64_t usec)
+{
+	if (!hist->count || usec < hist->min)
+		hist->min = usec;
+	if (usec > hist->max)
+		hist->max = usec;
 
-		probes = old_probes;
-		count = old_count;
-		usec = old_usec;
+	hist->buckets[hist_bucket(usec)]++;
+	hist->count++;
+}
 
-		start = usec % map->size;
-	}
+static profile_entry *create_entry(const char *name)
+{
+	profile_entry *entry = bzalloc(sizeof(profile_entry));
+	entry->name = name;
+	init_histogram(&entry->times);
+	return entry;
 }
 
-static void init_hashmap(profile_times_table *map, size_t size)
+static profile_entry *get_child(profile_entry *parent, const char *name)
 {
-	map->size = size;
-	map->occupied = 0;
-	map->max_probe_count = 0;
-	map->entries = bzalloc(sizeof(profile_times_table_entry) * size);
-	map->old_start_index = 0;
-	map->old_occupied = 0;
-	map->old_entries = NULL;
+	const size_t num = parent->children.num;
+	for (size_t i = 0; i < num; i++) {
+		profile_entry *child = parent->children.array[i];
+		if (child->name == name)
+			return child;
+	}
+
+	profile_entry *child = create_entry(name);
+	da_push_back(parent->children, &child);
+	return child;
 }
 
-static void migrate_old_entries(profile_times_table *map, bool limit_items)
+static volatile bool enabled = false;
+static volatile long sample_rate = 0;
+static volatile long generation = 0;
+
+/* Guards the call trees and the list of threads, never locked by profiled
+ * threads except once when they first profile */
+static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(profile_root_entry) root_entries;
+static profile_thread *threads = NULL;
+static uint64_t dropped_calls = 0;
+
+static pthread_t aggregator_thread;
+static os_event_t *aggregator_stop = NULL;
+static bool aggregator_active = false;
+
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_key;
+
+static THREAD_LOCAL profile_thread *thread_context = NULL;
+static THREAD_LOCAL long thread_generation = 0;
+static THREAD_LOCAL bool thread_enabled = true;
+
+/* ------------------------------------------------------------------------- */
+/* Aggregator */
+
+static profile_root_entry *get_root_entry(const char *name)
 {
-	if (!map->old_entries)
-		return;
+	profile_root_entry *r_entry = NULL;
 
-	if (!map->old_occupied) {
-		bfree(map->old_entries);
-		map->old_entries = NULL;
-		return;
+	for (size_t i = 0; i < root_entries.num; i++) {
+		if (root_entries.array[i].name == name) {
+			r_entry = &root_entries.array[i];
+			break;
+		}
 	}
 
-	for (size_t i = 0; !limit_items || i < 8; i++, map->old_start_index++) {
-		if (!map->old_occupied)
-			return;
+	if (!r_entry) {
+		r_entry = da_push_back_new(root_entries);
+		r_entry->name = name;
+		r_entry->entry = create_entry(name);
+	}
 
-		profile_times_table_entry *entry = &map->old_entries[map->old_start_index];
-		if (!entry->probes)
-			continue;
+	return r_entry;
+}
 
-		add_hashmap_entry(map, entry->entry.time_delta, entry->entry.count);
-		map->old_occupied -= 1;
-	}
+static void add_time_between_calls(profile_root_entry *r_entry, uint64_t start_time)
+{
+	profile_entry *entry = r_entry->entry;
+
+	if (entry->expected_time_between_calls != 0 && r_entry->prev_start_time)
+		add_histogram_entry(&entry->times_between_calls,
+				    diff_ns_to_usec(r_entry->prev_start_time, start_time));
+
+	r_entry->prev_start_time = start_time;
 }
 
-static void grow_hashmap(profile_times_table *map, uint64_t usec, uint64_t count)
+static void replay_event(profile_thread *thread, const struct profile_event *event)
 {
-	migrate_old_entries(map, false);
+	profile_root_entry *r_entry;
+	profile_entry *entry;
 
-	size_t old_size = map->size;
-	size_t old_occupied = map->occupied;
-	profile_times_table_entry *entries = map->entries;
+	switch (event->type) {
+	case PROFILE_EVENT_START:
+		if (thread->replay_depth) {
+			entry = get_child(thread->replay_entries[thread->replay_depth - 1], event->name);
+		} else {
+			r_entry = get_root_entry(event->name);
+			add_time_between_calls(r_entry, event->time);
+			entry = r_entry->entry;
+		}
 
-	init_hashmap(map, (old_size * 2 < 16) ? 16 : (old_size * 2));
+		thread->replay_entries[thread->replay_depth] = entry;
+		thread->replay_start_times[thread->replay_depth] = event->time;
+		thread->replay_depth++;
+		break;
 
-	map->old_occupied = old_occupied;
-	map->old_entries = entries;
+	case PROFILE_EVENT_END:
+		thread->replay_depth--;
+		entry = thread->replay_entries[thread->replay_depth];
+		add_histogram_entry(&entry->times,
+				    diff_ns_to_usec(thread->replay_start_times[thread->replay_depth], event->time));
+		break;
 
-	add_hashmap_entry(map, usec, count);
+	case PROFILE_EVENT_ROOT_SKIPPED:
+		add_time_between_calls(get_root_entry(event->name), event->time);
+		break;
+	}
 }
 
-static profile_entry *init_entry(profile_entry *entry, const char *name)
+/* Must be called with root_mutex locked */
+static void drain_thread(profile_thread *thread)
 {
-	entry->name = name;
-	init_hashmap(&entry->times, 1);
-#ifdef TRACK_OVERHEAD
-	init_hashmap(&entry->overhead, 1);
-#endif
-	entry->expected_time_between_calls = 0;
-	init_hashmap(&entry->times_between_calls, 1);
-	return entry;
-}
+	long head = os_atomic_load_long(&thread->head);
+	long tail = thread->tail;
 
-static profile_entry *get_child(profile_entry *parent, const char *name)
-{
-	const size_t num = parent->children.num;
-	for (size_t i = 0; i < num; i++) {
-		profile_entry *child = &parent->children.array[i];
-		if (child->name == name)
-			return child;
+	while (tail != head) {
+		replay_event(thread, &thread->events[(unsigned long)tail & (PROFILE_THREAD_EVENTS - 1)]);
+		tail = (long)((unsigned long)tail + 1);
 	}
 
-	return init_entry(da_push_back_new(parent->children), name);
+	os_atomic_store_long(&thread->tail, tail);
+	dropped_calls += (uint64_t)os_atomic_set_long(&thread->dropped, 0);
 }
 
-static void merge_call(profile_entry *entry, profile_call *call, profile_call *prev_call)
+/* Must be called with root_mutex locked */
+static void drain_threads(void)
 {
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++) {
-		profile_call *child = &call->children.array[i];
-		merge_call(get_child(entry, child->name), child, NULL);
-	}
+	profile_thread **prev_next = &threads;
+	profile_thread *thread = threads;
 
-	if (entry->expected_time_between_calls != 0 && prev_call) {
-		migrate_old_entries(&entry->times_between_calls, true);
-		uint64_t usec = diff_ns_to_usec(prev_call->start_time, call->start_time);
-		add_hashmap_entry(&entry->times_between_calls, usec, 1);
-	}
+	while (thread) {
+		profile_thread *next = thread->next;
 
-	migrate_old_entries(&entry->times, true);
-	uint64_t usec = diff_ns_to_usec(call->start_time, call->end_time);
-	add_hashmap_entry(&entry->times, usec, 1);
+		/* read before draining, a thread that exited has written
+		 * its last events */
+		bool exited = os_atomic_load_bool(&thread->exited);
 
-#ifdef TRACK_OVERHEAD
-	migrate_old_entries(&entry->overhead, true);
-	usec = diff_ns_to_usec(call->overhead_start, call->start_time);
-	usec += diff_ns_to_usec(call->end_time, call->overhead_end);
-	add_hashmap_entry(&entry->overhead, usec, 1);
-#endif
+		drain_thread(thread);
+
+		if (exited) {
+			*prev_next = next;
+			bfree(thread);
+		} else {
+			prev_next = &thread->next;
+		}
+
+		thread = next;
+	}
 }
 
-static bool enabled = false;
-static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
-static DARRAY(profile_root_entry) root_entries;
+static void *aggregator_thread_func(void *data)
+{
+	UNUSED_PARAMETER(data);
 
-static THREAD_LOCAL profile_call *thread_context = NULL;
-static THREAD_LOCAL bool thread_enabled = true;
+	os_set_thread_name("profiler: aggregator");
 
-void profiler_start(void)
+	while (os_event_timedwait(aggregator_stop, 10) == ETIMEDOUT) {
+		pthread_mutex_lock(&root_mutex);
+		drain_threads();
+		pthread_mutex_unlock(&root_mutex);
+	}
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Profiled threads */
+
+static void thread_exited(void *data)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = true;
+
+	/* the profiler may have been freed since the thread first profiled */
+	for (profile_thread *thread = threads; thread; thread = thread->next) {
+		if (thread == data) {
+			os_atomic_set_bool(&thread->exited, true);
+			break;
+		}
+	}
+
 	pthread_mutex_unlock(&root_mutex);
 }
 
-void profiler_stop(void)
+static void create_thread_key(void)
 {
-	pthread_mutex_lock(&root_mutex);
-	enabled = false;
-	pthread_mutex_unlock(&root_mutex);
+	pthread_key_create(&thread_key, thread_exited);
 }
 
-void profile_reenable_thread(void)
+static profile_thread *get_thread_context(void)
 {
-	if (thread_enabled)
-		return;
+	long cur_generation = os_atomic_load_long(&generation);
+
+	if (thread_context && thread_generation == cur_generation)
+		return thread_context;
+
+	pthread_once(&thread_key_once, create_thread_key);
+
+	profile_thread *thread = bzalloc(sizeof(profile_thread));
 
 	pthread_mutex_lock(&root_mutex);
-	thread_enabled = enabled;
+	thread->next = threads;
+	threads = thread;
 	pthread_mutex_unlock(&root_mutex);
+
+	pthread_setspecific(thread_key, thread);
+
+	thread_context = thread;
+	thread_generation = cur_generation;
+	return thread;
 }
 
-static bool lock_root(void)
+static inline bool push_event(profile_thread *thread, enum profile_event_type type, const char *name, uint64_t time,
+			      size_t reserved)
 {
-	pthread_mutex_lock(&root_mutex);
-	if (!enabled) {
-		pthread_mutex_unlock(&root_mutex);
-		thread_enabled = false;
-		return false;
+	long head = thread->head;
+	unsigned long used = (unsigned long)head - (unsigned long)thread->cached_tail;
+
+	if (used + reserved >= PROFILE_THREAD_EVENTS) {
+		thread->cached_tail = os_atomic_load_long(&thread->tail);
+		used = (unsigned long)head - (unsigned long)thread->cached_tail;
+		if (used + reserved >= PROFILE_THREAD_EVENTS)
+			return false;
 	}
 
+	struct profile_event *event = &thread->events[(unsigned long)head & (PROFILE_THREAD_EVENTS - 1)];
+	event->name = name;
+	event->time = time;
+	event->type = type;
+
+	os_atomic_store_long(&thread->head, (long)((unsigned long)head + 1));
 	return true;
 }
 
-static profile_root_entry *get_root_entry(const char *name)
+void profiler_start(void)
 {
-	profile_root_entry *r_entry = NULL;
+	pthread_mutex_lock(&root_mutex);
+	os_atomic_set_bool(&enabled, true);
 
-	for (size_t i = 0; i < root_entries.num; i++) {
-		if (root_entries.array[i].name == name) {
-			r_entry = &root_entries.array[i];
-			break;
+	if (!aggregator_active && os_event_init(&aggregator_stop, OS_EVENT_TYPE_MANUAL) == 0) {
+		aggregator_active = pthread_create(&aggregator_thread, NULL, aggregator_thread_func, NULL) == 0;
+		if (!aggregator_active) {
+			os_event_destroy(aggregator_stop);
+			aggregator_stop = NULL;
 		}
 	}
 
-	if (!r_entry) {
-		r_entry = da_push_back_new(root_entries);
-		r_entry->mutex = bmalloc(sizeof(pthread_mutex_t));
-		pthread_mutex_init(r_entry->mutex, NULL);
+	pthread_mutex_unlock(&root_mutex);
+}
 
-		r_entry->name = name;
-		r_entry->entry = bzalloc(sizeof(profile_entry));
-		init_entry(r_entry->entry, name);
-	}
+void profiler_stop(void)
+{
+	os_atomic_set_bool(&enabled, false);
+}
 
-	return r_entry;
+void profiler_set_sample_rate(uint32_t rate)
+{
+	os_atomic_set_long(&sample_rate, (long)rate);
 }
 
-void profile_register_root(const char *name, uint64_t expected_time_between_calls)
+void profile_reenable_thread(void)
 {
-	if (!lock_root())
+	if (thread_enabled)
 		return;
 
-	get_root_entry(name)->entry->expected_time_between_calls = (expected_time_between_calls + 500) / 1000;
-	pthread_mutex_unlock(&root_mutex);
+	thread_enabled = os_atomic_load_bool(&enabled);
 }
 
-static void free_call_context(profile_call *context);
-
-static void merge_context(profile_call *context)
+void profile_register_root(const char *name, uint64_t expected_time_between_calls)
 {
-	pthread_mutex_t *mutex = NULL;
-	profile_entry *entry = NULL;
-	profile_call *prev_call = NULL;
-
-	if (!lock_root()) {
-		free_call_context(context);
+	if (!os_atomic_load_bool(&enabled)) {
+		thread_enabled = false;
 		return;
 	}
 
-	profile_root_entry *r_entry = get_root_entry(context->name);
-
-	mutex = r_entry->mutex;
-	entry = r_entry->entry;
-	prev_call = r_entry->prev_call;
+	pthread_mutex_lock(&root_mutex);
 
-	r_entry->prev_call = context;
+	profile_entry *entry = get_root_entry(name)->entry;
+	entry->expected_time_between_calls = (expected_time_between_calls + 500) / 1000;
+	if (entry->expected_time_between_calls && !entry->times_between_calls.buckets)
+		init_histogram(&entry->times_between_calls);
 
-	pthread_mutex_lock(mutex);
 	pthread_mutex_unlock(&root_mutex);
+}
+
+static bool start_root(profile_thread **p_thread, const char *name, uint64_t *skipped_time)
+{
+	if (!os_atomic_load_bool(&enabled)) {
+		thread_enabled = false;
+		return false;
+	}
 
-	merge_call(entry, context, prev_call);
+	profile_thread *thread = get_thread_context();
+	long rate = os_atomic_load_long(&sample_rate);
 
-	pthread_mutex_unlock(mutex);
+	*p_thread = thread;
+	*skipped_time = 0;
 
-	free_call_context(prev_call);
+	if (rate > 1 && thread->sample_count++ % (uint32_t)rate != 0)
+		*skipped_time = os_gettime_ns();
+
+	return true;
 }
 
 void profile_start(const char *name)
@@ -360,26 +504,41 @@ void profile_start(const char *name)
 	if (!thread_enabled)
 		return;
 
-	profile_call new_call = {
-		.name = name,
-#ifdef TRACK_OVERHEAD
-		.overhead_start = os_gettime_ns(),
-#endif
-		.parent = thread_context,
-	};
+	profile_thread *thread = thread_generation == os_atomic_load_long(&generation) ? thread_context : NULL;
+	uint64_t skipped_time = 0;
 
-	profile_call *call = NULL;
+	if (!thread || !thread->depth) {
+		if (!start_root(&thread, name, &skipped_time))
+			return;
+	}
 
-	if (new_call.parent) {
-		size_t idx = da_push_back(new_call.parent->children, &new_call);
-		call = &new_call.parent->children.array[idx];
-	} else {
-		call = bmalloc(sizeof(profile_call));
-		memcpy(call, &new_call, sizeof(profile_call));
+	size_t depth = thread->depth++;
+
+	if (depth >= PROFILE_MAX_DEPTH) {
+		if (!thread->skip_depth)
+			os_atomic_inc_long(&thread->dropped);
+		return;
 	}
 
-	thread_context = call;
-	call->start_time = os_gettime_ns();
+	thread->names[depth] = name;
+
+	if (thread->skip_depth)
+		return;
+
+	if (skipped_time) {
+		push_event(thread, PROFILE_EVENT_ROOT_SKIPPED, name, skipped_time, 0);
+		thread->skip_depth = depth + 1;
+		return;
+	}
+
+	/* the end events of all open calls must always fit */
+	if (!push_event(thread, PROFILE_EVENT_START, name, os_gettime_ns(), thread->open_calls + 1)) {
+		os_atomic_inc_long(&thread->dropped);
+		thread->skip_depth = depth + 1;
+		return;
+	}
+
+	thread->open_calls++;
 }
 
 void profile_end(const char *name)
@@ -388,45 +547,46 @@ void profile_end(const char *name)
 	if (!thread_enabled)
 		return;
 
-	profile_call *call = thread_context;
-	if (!call) {
+	profile_thread *thread = thread_generation == os_atomic_load_long(&generation) ? thread_context : NULL;
+	if (!thread || !thread->depth) {
 		blog(LOG_ERROR, "Called profile end with no active profile");
 		return;
 	}
 
-	if (!call->name)
-		call->name = name;
+	size_t depth = thread->depth - 1;
+
+	if (depth < PROFILE_MAX_DEPTH && thread->names[depth] != name) {
+		const char *call_name = thread->names[depth];
 
-	if (call->name != name) {
 		blog(LOG_ERROR,
 		     "Called profile end with mismatching name: "
 		     "start(\"%s\"[%p]) <-> end(\"%s\"[%p])",
-		     call->name, call->name, name, name);
+		     call_name, call_name, name, name);
 
-		profile_call *parent = call->parent;
-		while (parent && parent->parent && parent->name != name)
-			parent = parent->parent;
+		size_t parent = depth;
+		while (parent > 0 && thread->names[parent - 1] != name)
+			parent--;
 
-		if (!parent || parent->name != name)
+		if (!parent)
 			return;
 
-		while (call->name != name) {
-			profile_end(call->name);
-			call = call->parent;
-		}
+		while (thread->names[thread->depth - 1] != name)
+			profile_end(thread->names[thread->depth - 1]);
+		depth = thread->depth - 1;
 	}
 
-	thread_context = call->parent;
-
-	call->end_time = end;
-#ifdef TRACK_OVERHEAD
-	call->overhead_end = os_gettime_ns();
-#endif
+	thread->depth = depth;
 
-	if (call->parent)
+	if (thread->skip_depth) {
+		if (thread->skip_depth == depth + 1)
+			thread->skip_depth = 0;
+		return;
+	}
+	if (depth >= PROFILE_MAX_DEPTH)
 		return;
 
-	merge_context(call);
+	push_event(thread, PROFILE_EVENT_END, name, end, 0);
+	thread->open_calls--;
 }
 
 static int profiler_time_entry_compare(const void *first, const void *second)
@@ -435,37 +595,36 @@ static int profiler_time_entry_compare(const void *first, const void *second)
 	return diff < 0 ? -1 : (diff > 0 ? 1 : 0);
 }
 
-static uint64_t copy_map_to_array(profile_times_table *map, profiler_time_entries_t *entry_buffer, uint64_t *min_,
-				  uint64_t *max_)
+static uint64_t copy_histogram_to_array(profile_histogram *hist, profiler_time_entries_t *entry_buffer,
+					uint64_t *min_, uint64_t *max_)
 {
-	migrate_old_entries(map, false);
-
-	da_reserve(*entry_buffer, map->occupied);
 	da_resize(*entry_buffer, 0);
 
-	uint64_t min__ = ~(uint64_t)0;
-	uint64_t max__ = 0;
+	if (min_)
+		*min_ = hist->count ? hist->min : ~(uint64_t)0;
+	if (max_)
+		*max_ = hist->max;
 
-	uint64_t calls = 0;
-	for (size_t i = 0; i < map->size; i++) {
-		if (!map->entries[i].probes)
-			continue;
+	if (!hist->buckets)
+		return 0;
 
-		profiler_time_entry *entry = &map->entries[i].entry;
+	for (size_t i = 0; i < HIST_BUCKETS; i++) {
+		if (!hist->buckets[i])
+			continue;
 
-		da_push_back(*entry_buffer, entry);
+		/* the exact min/max are known, keep the bucket values within */
+		uint64_t usec = hist_bucket_value(i);
+		if (usec < hist->min)
+			usec = hist->min;
+		if (usec > hist->max)
+			usec = hist->max;
 
-		calls += entry->count;
-		min__ = (min__ < entry->time_delta) ? min__ : entry->time_delta;
-		max__ = (max__ > entry->time_delta) ? max__ : entry->time_delta;
+		profiler_time_entry *entry = da_push_back_new(*entry_buffer);
+		entry->time_delta = usec;
+		entry->count = hist->buckets[i];
 	}
 
-	if (min_)
-		*min_ = min__;
-	if (max_)
-		*max_ = max__;
-
-	return calls;
+	return hist->count;
 }
 
 typedef void (*profile_entry_print_func)(profiler_snapshot_entry_t *entry, struct dstr *indent_buffer,
@@ -702,6 +861,8 @@ void profile_print_func(const char *intro, profile_entry_print_func print, profi
 		snap = profile_snapshot_create();
 
 	blog(LOG_INFO, "%s", intro);
+	if (snap->dropped_calls)
+		blog(LOG_INFO, "%" PRIu64 " calls were not recorded, the profiler could not keep up", snap->dropped_calls);
 	for (size_t i = 0; i < snap->roots.num; i++) {
 		print(&snap->roots.array[i], &indent_buffer, &output_buffer, 0, 0, 0);
 	}
@@ -724,74 +885,62 @@ void profiler_print_time_between_calls(profiler_snapshot_t *snap)
 	profile_print_func("== Profiler Time Between Calls ==================", profile_print_entry_expected, snap);
 }
 
-static void free_call_children(profile_call *call)
-{
-	if (!call)
-		return;
-
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++)
-		free_call_children(&call->children.array[i]);
-
-	da_free(call->children);
-}
-
-static void free_call_context(profile_call *context)
-{
-	free_call_children(context);
-	bfree(context);
-}
-
-static void free_hashmap(profile_times_table *map)
+static void free_histogram(profile_histogram *hist)
 {
-	map->size = 0;
-	bfree(map->entries);
-	map->entries = NULL;
-	bfree(map->old_entries);
-	map->old_entries = NULL;
+	bfree(hist->buckets);
+	hist->buckets = NULL;
 }
 
 static void free_profile_entry(profile_entry *entry)
 {
 	for (size_t i = 0; i < entry->children.num; i++)
-		free_profile_entry(&entry->children.array[i]);
+		free_profile_entry(entry->children.array[i]);
 
-	free_hashmap(&entry->times);
-#ifdef TRACK_OVERHEAD
-	free_hashmap(&entry->overhead);
-#endif
-	free_hashmap(&entry->times_between_calls);
+	free_histogram(&entry->times);
+	free_histogram(&entry->times_between_calls);
 	da_free(entry->children);
+	bfree(entry);
 }
 
 void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
+	profile_thread *old_threads;
+	bool stop_aggregator;
 
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
-	da_move(old_root_entries, root_entries);
+	os_atomic_set_bool(&enabled, false);
+	stop_aggregator = aggregator_active;
+	aggregator_active = false;
 	pthread_mutex_unlock(&root_mutex);
 
-	for (size_t i = 0; i < old_root_entries.num; i++) {
-		profile_root_entry *entry = &old_root_entries.array[i];
-
-		pthread_mutex_lock(entry->mutex);
-		pthread_mutex_unlock(entry->mutex);
+	if (stop_aggregator) {
+		os_event_signal(aggregator_stop);
+		pthread_join(aggregator_thread, NULL);
+		os_event_destroy(aggregator_stop);
+		aggregator_stop = NULL;
+	}
 
-		pthread_mutex_destroy(entry->mutex);
-		bfree(entry->mutex);
-		entry->mutex = NULL;
+	pthread_mutex_lock(&root_mutex);
+	da_move(old_root_entries, root_entries);
+	old_threads = threads;
+	threads = NULL;
+	dropped_calls = 0;
 
-		free_call_context(entry->prev_call);
+	/* threads that profiled before have to register again */
+	os_atomic_inc_long(&generation);
+	pthread_mutex_unlock(&root_mutex);
 
-		free_profile_entry(entry->entry);
-		bfree(entry->entry);
+	while (old_threads) {
+		profile_thread *next = old_threads->next;
+		bfree(old_threads);
+		old_threads = next;
 	}
 
-	da_free(old_root_entries);
+	for (size_t i = 0; i < old_root_entries.num; i++)
+		free_profile_entry(old_root_entries.array[i].entry);
 
-	pthread_mutex_destroy(&root_mutex);
+	da_free(old_root_entries);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -859,16 +1008,16 @@ static void add_entry_to_snapshot(profile_entry *entry, profiler_snapshot_entry_
 	s_entry->name = entry->name;
 
 	s_entry->overall_count =
-		copy_map_to_array(&entry->times, &s_entry->times, &s_entry->min_time, &s_entry->max_time);
+		copy_histogram_to_array(&entry->times, &s_entry->times, &s_entry->min_time, &s_entry->max_time);
 
 	if ((s_entry->expected_time_between_calls = entry->expected_time_between_calls))
 		s_entry->overall_between_calls_count =
-			copy_map_to_array(&entry->times_between_calls, &s_entry->times_between_calls,
-					  &s_entry->min_time_between_calls, &s_entry->max_time_between_calls);
+			copy_histogram_to_array(&entry->times_between_calls, &s_entry->times_between_calls,
+						&s_entry->min_time_between_calls, &s_entry->max_time_between_calls);
 
 	da_reserve(s_entry->children, entry->children.num);
 	for (size_t i = 0; i < entry->children.num; i++)
-		add_entry_to_snapshot(&entry->children.array[i], da_push_back_new(s_entry->children));
+		add_entry_to_snapshot(entry->children.array[i], da_push_back_new(s_entry->children));
 }
 
 static void sort_snapshot_entry(profiler_snapshot_entry_t *entry)
@@ -888,12 +1037,13 @@ profiler_snapshot_t *profile_snapshot_create(void)
 	profiler_snapshot_t *snap = bzalloc(sizeof(profiler_snapshot_t));
 
 	pthread_mutex_lock(&root_mutex);
+	drain_threads();
+
 	da_reserve(snap->roots, root_entries.num);
-	for (size_t i = 0; i < root_entries.num; i++) {
-		pthread_mutex_lock(root_entries.array[i].mutex);
+	for (size_t i = 0; i < root_entries.num; i++)
 		add_entry_to_snapshot(root_entries.array[i].entry, da_push_back_new(snap->roots));
-		pthread_mutex_unlock(root_entries.array[i].mutex);
-	}
+
+	snap->dropped_calls = dropped_calls;
 	pthread_mutex_unlock(&root_mutex);
 
 	for (size_t i = 0; i < snap->roots.num; i++)
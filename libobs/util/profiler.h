@@ -27,6 +27,10 @@ EXPORT void profile_reenable_thread(void);
 EXPORT void profiler_start(void);
 EXPORT void profiler_stop(void);
 
+/* Records the calls of one in every rate root calls of each thread (0 or 1
+ * records all calls), the time between calls of roots is always recorded */
+EXPORT void profiler_set_sample_rate(uint32_t rate);
+
 EXPORT void profiler_print(profiler_snapshot_t *snap);
 EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
@@ -77,6 +77,9 @@ struct profiler_entry {
 struct source_samples *hm_samples = NULL;
 struct profiler_entry *hm_entries = NULL;
 
+/* Time spent ticking all sources, for last N frames */
+static struct ucirclebuf frame_tick = {0};
+
 /* GPU timer ranges (only required for DirectX) */
 static uint8_t timer_idx = 0;
 static gs_timer_range_t *timer_ranges[FRAME_BUFFER_SIZE] = {0};
@@ -215,6 +218,7 @@ static void profiler_shutdown(void)
 		HASH_DEL(hm_entries, ent);
 		entry_destroy(ent);
 	}
+	ucirclebuf_free(&frame_tick);
 	pthread_rwlock_unlock(&hm_rwlock);
 
 	reset_gpu_timers();
@@ -425,7 +429,13 @@ void source_profiler_source_tick_end(obs_source_t *source, uint64_t start)
 	if (!enabled)
 		return;
 
-	const uint64_t delta = os_gettime_ns() - start;
+	source_profiler_source_tick_record(source, os_gettime_ns() - start);
+}
+
+void source_profiler_source_tick_record(obs_source_t *source, uint64_t delta)
+{
+	if (!enabled)
+		return;
 
 	struct source_samples *smp = NULL;
 	HASH_FIND_PTR(hm_samples, &source, smp);
@@ -441,6 +451,19 @@ void source_profiler_source_tick_end(obs_source_t *source, uint64_t start)
 	smp->frames[smp->frame_idx]->tick = delta;
 }
 
+void source_profiler_frame_tick(uint64_t duration)
+{
+	if (!enabled)
+		return;
+
+	pthread_rwlock_wrlock(&hm_rwlock);
+	if (!frame_tick.capacity)
+		ucirclebuf_init(&frame_tick, profiler_samples);
+	if (frame_tick.capacity)
+		ucirclebuf_push(&frame_tick, duration);
+	pthread_rwlock_unlock(&hm_rwlock);
+}
+
 uint64_t source_profiler_source_render_begin(gs_timer_t **timer)
 {
 	if (!enabled)
@@ -619,6 +642,36 @@ bool source_profiler_fill_result(obs_source_t *source, struct profiler_result *r
 	return !!ent;
 }
 
+bool source_profiler_get_frame_tick_times(uint64_t *tick_avg, uint64_t *tick_max)
+{
+	uint64_t sum = 0;
+	uint64_t max = 0;
+	size_t num;
+
+	if (!enabled)
+		return false;
+
+	pthread_rwlock_rdlock(&hm_rwlock);
+
+	num = frame_tick.num;
+	for (size_t i = 0; i < num; i++) {
+		const uint64_t delta = frame_tick.array[i];
+		if (delta > max)
+			max = delta;
+
+		sum += delta;
+	}
+
+	pthread_rwlock_unlock(&hm_rwlock);
+
+	if (tick_avg)
+		*tick_avg = num ? sum / num : 0;
+	if (tick_max)
+		*tick_max = max;
+
+	return num != 0;
+}
+
 profiler_result_t *source_profiler_get_result(obs_source_t *source)
 {
 	profiler_result_t *ret = bmalloc(sizeof(profiler_result_t));
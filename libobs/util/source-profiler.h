@@ -60,6 +60,8 @@ EXPORT void source_profiler_gpu_enable(bool enable);
 EXPORT profiler_result_t *source_profiler_get_result(obs_source_t *source);
 /* Update existing profiler results object for source */
 EXPORT bool source_profiler_fill_result(obs_source_t *source, profiler_result_t *result);
+/* Get average and max time in ns spent ticking all sources per frame */
+EXPORT bool source_profiler_get_frame_tick_times(uint64_t *tick_avg, uint64_t *tick_max);
 
 #ifdef __cplusplus
 }
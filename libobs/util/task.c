@@ -1,5 +1,7 @@
 #include "task.h"
 #include "bmem.h"
+#include "dstr.h"
+#include "platform.h"
 #include "threading.h"
 #include "deque.h"
 
@@ -162,3 +164,798 @@ static void *tiny_tubular_task_thread(void *param)
 
 	return NULL;
 }
+
+/* ------------------------------------------------------------------------- */
+/* work pool                                                                 */
+
+struct work_range {
+	pthread_mutex_t mutex;
+	size_t begin;
+	size_t end;
+};
+
+struct work_thread {
+	struct os_work_pool *pool;
+	pthread_t thread;
+	os_sem_t *sem;
+	size_t idx;
+};
+
+struct os_work_pool {
+	char *name;
+	size_t num_threads;
+	struct work_thread *threads;
+
+	/* one range per participant, the calling thread uses the last one */
+	struct work_range *ranges;
+
+	pthread_mutex_t run_mutex;
+	os_event_t *done_event;
+	volatile long active;
+	volatile bool stop;
+
+	os_work_t work;
+	void *param;
+};
+
+static THREAD_LOCAL struct os_work_pool *current_pool = NULL;
+
+static inline bool take_work(struct work_range *range, size_t *idx)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&range->mutex);
+	if (range->begin < range->end) {
+		*idx = range->begin++;
+		found = true;
+	}
+	pthread_mutex_unlock(&range->mutex);
+
+	return found;
+}
+
+/* moves the back half of another participant's remaining range to our own */
+static bool steal_work(struct os_work_pool *pool, size_t self)
+{
+	const size_t participants = pool->num_threads + 1;
+
+	for (size_t i = 1; i < participants; i++) {
+		struct work_range *victim = &pool->ranges[(self + i) % participants];
+		size_t begin = 0;
+		size_t end = 0;
+
+		pthread_mutex_lock(&victim->mutex);
+		if (victim->begin < victim->end) {
+			size_t remaining = victim->end - victim->begin;
+			begin = victim->end - (remaining + 1) / 2;
+			end = victim->end;
+			victim->end = begin;
+		}
+		pthread_mutex_unlock(&victim->mutex);
+
+		if (begin < end) {
+			struct work_range *range = &pool->ranges[self];
+			pthread_mutex_lock(&range->mutex);
+			range->begin = begin;
+			range->end = end;
+			pthread_mutex_unlock(&range->mutex);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void process_work(struct os_work_pool *pool, size_t self)
+{
+	struct work_range *range = &pool->ranges[self];
+	size_t idx;
+
+	do {
+		while (take_work(range, &idx))
+			pool->work(pool->param, idx);
+	} while (steal_work(pool, self));
+}
+
+static void *work_pool_thread(void *data)
+{
+	struct work_thread *thread = data;
+	struct os_work_pool *pool = thread->pool;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "%s %d", pool->name, (int)thread->idx);
+	os_set_thread_name(name.array);
+	dstr_free(&name);
+
+	current_pool = pool;
+
+	while (os_sem_wait(thread->sem) == 0) {
+		if (os_atomic_load_bool(&pool->stop))
+			break;
+
+		process_work(pool, thread->idx);
+
+		if (os_atomic_dec_long(&pool->active) == 0)
+			os_event_signal(pool->done_event);
+	}
+
+	return NULL;
+}
+
+os_work_pool_t *os_work_pool_create(const char *name, size_t threads)
+{
+	struct os_work_pool *pool = bzalloc(sizeof(*pool));
+
+	if (!threads) {
+		int cores = os_get_logical_cores();
+		threads = cores > 1 ? (size_t)cores - 1 : 0;
+	}
+
+	pool->name = bstrdup(name ? name : "work pool");
+	pool->ranges = bzalloc(sizeof(struct work_range) * (threads + 1));
+	if (threads)
+		pool->threads = bzalloc(sizeof(struct work_thread) * threads);
+
+	for (size_t i = 0; i < threads + 1; i++)
+		pthread_mutex_init(&pool->ranges[i].mutex, NULL);
+
+	if (pthread_mutex_init(&pool->run_mutex, NULL) != 0)
+		goto fail;
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	for (size_t i = 0; i < threads; i++) {
+		struct work_thread *thread = &pool->threads[i];
+		thread->pool = pool;
+		thread->idx = i;
+
+		if (os_sem_init(&thread->sem, 0) != 0)
+			goto fail;
+		if (pthread_create(&thread->thread, NULL, work_pool_thread, thread) != 0) {
+			os_sem_destroy(thread->sem);
+			thread->sem = NULL;
+			goto fail;
+		}
+
+		pool->num_threads++;
+	}
+
+	return pool;
+
+fail:
+	os_work_pool_destroy(pool);
+	return NULL;
+}
+
+void os_work_pool_destroy(os_work_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	os_atomic_set_bool(&pool->stop, true);
+
+	for (size_t i = 0; i < pool->num_threads; i++) {
+		os_sem_post(pool->threads[i].sem);
+		pthread_join(pool->threads[i].thread, NULL);
+		os_sem_destroy(pool->threads[i].sem);
+	}
+
+	for (size_t i = 0; i < pool->num_threads + 1; i++)
+		pthread_mutex_destroy(&pool->ranges[i].mutex);
+
+	os_event_destroy(pool->done_event);
+	pthread_mutex_destroy(&pool->run_mutex);
+	bfree(pool->threads);
+	bfree(pool->ranges);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+size_t os_work_pool_get_thread_count(const os_work_pool_t *pool)
+{
+	return pool ? pool->num_threads : 0;
+}
+
+void os_work_pool_run(os_work_pool_t *pool, size_t count, os_work_t work, void *param)
+{
+	if (!count)
+		return;
+
+	/* no workers, or called recursively from inside a run of the same
+	 * pool: just run everything on this thread */
+	if (!pool || !pool->num_threads || count == 1 || current_pool == pool) {
+		for (size_t i = 0; i < count; i++)
+			work(param, i);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->run_mutex);
+
+	const size_t participants = pool->num_threads + 1;
+	const size_t per_thread = count / participants;
+	size_t extra = count % participants;
+	size_t begin = 0;
+
+	for (size_t i = 0; i < participants; i++) {
+		size_t size = per_thread + (extra ? 1 : 0);
+		if (extra)
+			extra--;
+
+		pool->ranges[i].begin = begin;
+		pool->ranges[i].end = begin + size;
+		begin += size;
+	}
+
+	pool->work = work;
+	pool->param = param;
+	os_atomic_set_long(&pool->active, (long)pool->num_threads);
+
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->threads[i].sem);
+
+	/* the calling thread takes part in the run as well */
+	struct os_work_pool *prev_pool = current_pool;
+	current_pool = pool;
+
+	process_work(pool, pool->num_threads);
+
+	current_pool = prev_pool;
+
+	/* workers may still be finishing items they took or stole */
+	os_event_wait(pool->done_event);
+
+	pthread_mutex_unlock(&pool->run_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+/* task pool                                                                 */
+
+#define NUM_PRIORITIES (OS_TASK_PRIORITY_HIGH + 1)
+
+/* 4 levels of 64 slots of 1 ms ticks cover about 4.6 hours, tasks further
+ * away than that are moved down the wheel from the last slot */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+struct task_link {
+	struct task_link *prev;
+	struct task_link *next;
+};
+
+enum task_state {
+	TASK_SCHEDULED,
+	TASK_QUEUED,
+	TASK_RUNNING,
+	TASK_DONE,
+};
+
+struct os_task_handle {
+	/* first, so links can be cast to their handle */
+	struct task_link link;
+
+	volatile long refs;
+	struct os_task_pool *pool;
+	os_task_t task;
+	void *param;
+	enum os_task_priority priority;
+
+	uint64_t expires;
+	uint64_t period;
+
+	enum task_state state;
+	bool canceled;
+	os_event_t *finished_event;
+};
+
+struct os_task_pool {
+	char *name;
+	pthread_mutex_t mutex;
+	bool stop;
+
+	os_sem_t *sem;
+	size_t num_threads;
+	pthread_t *threads;
+	struct task_link queued[NUM_PRIORITIES];
+
+	pthread_t timer_thread;
+	bool timer_thread_active;
+	os_event_t *timer_event;
+	uint64_t start_time;
+	uint64_t cur_tick;
+	size_t num_scheduled;
+	struct task_link wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+static THREAD_LOCAL struct os_task_pool *current_task_pool = NULL;
+static THREAD_LOCAL struct os_task_handle *current_task = NULL;
+
+static inline void link_init(struct task_link *head)
+{
+	head->prev = head;
+	head->next = head;
+}
+
+static inline bool link_empty(const struct task_link *head)
+{
+	return head->next == head;
+}
+
+static inline void link_append(struct task_link *head, struct task_link *link)
+{
+	link->prev = head->prev;
+	link->next = head;
+	head->prev->next = link;
+	head->prev = link;
+}
+
+static inline void link_remove(struct task_link *link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+	link->prev = link;
+	link->next = link;
+}
+
+static void task_handle_release(struct os_task_handle *handle)
+{
+	if (os_atomic_dec_long(&handle->refs) == 0) {
+		if (handle->finished_event)
+			os_event_destroy(handle->finished_event);
+		bfree(handle);
+	}
+}
+
+static inline uint64_t pool_now_tick(struct os_task_pool *pool)
+{
+	return (os_gettime_ns() - pool->start_time) / 1000000;
+}
+
+/* Must be called with the pool mutex locked */
+static void queue_handle(struct os_task_pool *pool, struct os_task_handle *handle)
+{
+	handle->state = TASK_QUEUED;
+	link_append(&pool->queued[handle->priority], &handle->link);
+	os_sem_post(pool->sem);
+}
+
+/* Must be called with the pool mutex locked */
+static void wheel_insert(struct os_task_pool *pool, struct os_task_handle *handle)
+{
+	uint64_t expires = handle->expires;
+	uint64_t delta;
+	int level;
+
+	if (expires < pool->cur_tick) {
+		queue_handle(pool, handle);
+		return;
+	}
+
+	delta = expires - pool->cur_tick;
+	if (delta >= WHEEL_RANGE) {
+		expires = pool->cur_tick + WHEEL_RANGE - 1;
+		delta = WHEEL_RANGE - 1;
+	}
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++) {
+		if (delta < (uint64_t)1 << (WHEEL_BITS * (level + 1)))
+			break;
+	}
+
+	size_t slot = (size_t)(expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+	handle->state = TASK_SCHEDULED;
+	link_append(&pool->wheel[level][slot], &handle->link);
+	pool->num_scheduled++;
+}
+
+/* Moves the tasks of a slot down the wheel, returns the slot index */
+static size_t wheel_cascade(struct os_task_pool *pool, int level)
+{
+	size_t slot = (size_t)(pool->cur_tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	struct task_link tasks;
+	struct task_link *head = &pool->wheel[level][slot];
+
+	if (link_empty(head))
+		return slot;
+
+	/* take the whole list first, tasks may be inserted into the same
+	 * slot again if they are out of the range of the wheel */
+	tasks.next = head->next;
+	tasks.prev = head->prev;
+	tasks.next->prev = &tasks;
+	tasks.prev->next = &tasks;
+	link_init(head);
+
+	while (!link_empty(&tasks)) {
+		struct os_task_handle *handle = (struct os_task_handle *)tasks.next;
+		link_remove(&handle->link);
+		pool->num_scheduled--;
+		wheel_insert(pool, handle);
+	}
+
+	return slot;
+}
+
+/* Processes the current tick and moves to the next one */
+static void wheel_advance(struct os_task_pool *pool)
+{
+	size_t slot = (size_t)pool->cur_tick & WHEEL_MASK;
+
+	if (!slot) {
+		for (int level = 1; level < WHEEL_LEVELS; level++) {
+			if (wheel_cascade(pool, level) != 0)
+				break;
+		}
+	}
+
+	struct task_link *head = &pool->wheel[0][slot];
+	while (!link_empty(head)) {
+		struct os_task_handle *handle = (struct os_task_handle *)head->next;
+		link_remove(&handle->link);
+		pool->num_scheduled--;
+		queue_handle(pool, handle);
+	}
+
+	pool->cur_tick++;
+}
+
+/* Ticks until the timer thread has to run again, or 0 if nothing is
+ * scheduled */
+static uint64_t wheel_next_wait(struct os_task_pool *pool, uint64_t now)
+{
+	if (!pool->num_scheduled)
+		return 0;
+
+	/* the next task in the first level, or the next cascade */
+	uint64_t tick = pool->cur_tick;
+	uint64_t end = (tick | WHEEL_MASK) + 1;
+
+	for (; tick < end; tick++) {
+		if (!link_empty(&pool->wheel[0][tick & WHEEL_MASK]))
+			break;
+	}
+
+	return tick > now ? tick - now : 1;
+}
+
+static void *task_pool_timer_thread(void *data)
+{
+	struct os_task_pool *pool = data;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "%s timer", pool->name);
+	os_set_thread_name(name.array);
+	dstr_free(&name);
+
+	pthread_mutex_lock(&pool->mutex);
+
+	while (!pool->stop) {
+		uint64_t now = pool_now_tick(pool);
+
+		if (!pool->num_scheduled) {
+			pool->cur_tick = now + 1;
+		} else {
+			while (pool->cur_tick <= now)
+				wheel_advance(pool);
+		}
+
+		uint64_t wait = wheel_next_wait(pool, now);
+		pthread_mutex_unlock(&pool->mutex);
+
+		if (wait)
+			os_event_timedwait(pool->timer_event, wait > 60000 ? 60000 : (unsigned long)wait);
+		else
+			os_event_wait(pool->timer_event);
+
+		pthread_mutex_lock(&pool->mutex);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+static struct os_task_handle *take_queued(struct os_task_pool *pool)
+{
+	for (int i = NUM_PRIORITIES - 1; i >= 0; i--) {
+		struct task_link *head = &pool->queued[i];
+
+		if (!link_empty(head)) {
+			struct os_task_handle *handle = (struct os_task_handle *)head->next;
+			link_remove(&handle->link);
+			return handle;
+		}
+	}
+
+	return NULL;
+}
+
+static void *task_pool_thread(void *data)
+{
+	struct os_task_pool *pool = data;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "%s worker", pool->name);
+	os_set_thread_name(name.array);
+	dstr_free(&name);
+
+	current_task_pool = pool;
+
+	while (os_sem_wait(pool->sem) == 0) {
+		pthread_mutex_lock(&pool->mutex);
+		if (pool->stop) {
+			pthread_mutex_unlock(&pool->mutex);
+			break;
+		}
+
+		/* canceled tasks leave the semaphore higher than the number
+		 * of queued tasks */
+		struct os_task_handle *handle = take_queued(pool);
+		if (!handle) {
+			pthread_mutex_unlock(&pool->mutex);
+			continue;
+		}
+
+		handle->state = TASK_RUNNING;
+		pthread_mutex_unlock(&pool->mutex);
+
+		current_task = handle;
+		handle->task(handle->param);
+		current_task = NULL;
+
+		pthread_mutex_lock(&pool->mutex);
+		if (handle->finished_event)
+			os_event_signal(handle->finished_event);
+
+		if (handle->period && !handle->canceled && !pool->stop) {
+			uint64_t now = pool_now_tick(pool);
+
+			handle->expires += handle->period;
+			if (handle->expires <= now)
+				handle->expires = now + 1;
+
+			wheel_insert(pool, handle);
+			os_event_signal(pool->timer_event);
+			pthread_mutex_unlock(&pool->mutex);
+		} else {
+			handle->state = TASK_DONE;
+			pthread_mutex_unlock(&pool->mutex);
+			task_handle_release(handle);
+		}
+	}
+
+	current_task_pool = NULL;
+	return NULL;
+}
+
+os_task_pool_t *os_task_pool_create(const char *name, size_t threads)
+{
+	struct os_task_pool *pool = bzalloc(sizeof(*pool));
+
+	if (!threads) {
+		int cores = os_get_logical_cores() / 2;
+		threads = cores < 1 ? 1 : (cores > 4 ? 4 : (size_t)cores);
+	}
+
+	pool->name = bstrdup(name ? name : "task pool");
+	pool->start_time = os_gettime_ns();
+
+	for (size_t i = 0; i < NUM_PRIORITIES; i++)
+		link_init(&pool->queued[i]);
+	for (size_t level = 0; level < WHEEL_LEVELS; level++) {
+		for (size_t slot = 0; slot < WHEEL_SLOTS; slot++)
+			link_init(&pool->wheel[level][slot]);
+	}
+
+	if (pthread_mutex_init(&pool->mutex, NULL) != 0)
+		goto fail1;
+	if (os_sem_init(&pool->sem, 0) != 0)
+		goto fail2;
+	if (os_event_init(&pool->timer_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail3;
+
+	pool->threads = bzalloc(sizeof(pthread_t) * threads);
+	for (size_t i = 0; i < threads; i++) {
+		if (pthread_create(&pool->threads[i], NULL, task_pool_thread, pool) != 0)
+			goto fail4;
+		pool->num_threads++;
+	}
+
+	if (pthread_create(&pool->timer_thread, NULL, task_pool_timer_thread, pool) != 0)
+		goto fail4;
+	pool->timer_thread_active = true;
+
+	return pool;
+
+fail4:
+	os_task_pool_destroy(pool);
+	return NULL;
+
+fail3:
+	os_sem_destroy(pool->sem);
+fail2:
+	pthread_mutex_destroy(&pool->mutex);
+fail1:
+	bfree(pool->name);
+	bfree(pool);
+	return NULL;
+}
+
+static void cancel_all(struct task_link *head)
+{
+	while (!link_empty(head)) {
+		struct os_task_handle *handle = (struct os_task_handle *)head->next;
+		link_remove(&handle->link);
+		handle->canceled = true;
+		handle->state = TASK_DONE;
+		task_handle_release(handle);
+	}
+}
+
+void os_task_pool_destroy(os_task_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = true;
+
+	for (size_t i = 0; i < NUM_PRIORITIES; i++)
+		cancel_all(&pool->queued[i]);
+	for (size_t level = 0; level < WHEEL_LEVELS; level++) {
+		for (size_t slot = 0; slot < WHEEL_SLOTS; slot++)
+			cancel_all(&pool->wheel[level][slot]);
+	}
+	pool->num_scheduled = 0;
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (pool->timer_thread_active) {
+		os_event_signal(pool->timer_event);
+		pthread_join(pool->timer_thread, NULL);
+	}
+
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->sem);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	os_event_destroy(pool->timer_event);
+	os_sem_destroy(pool->sem);
+	pthread_mutex_destroy(&pool->mutex);
+	bfree(pool->threads);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+bool os_task_pool_inside(os_task_pool_t *pool)
+{
+	return pool && current_task_pool == pool;
+}
+
+static struct os_task_handle *create_handle(struct os_task_pool *pool, enum os_task_priority priority, os_task_t task,
+					    void *param)
+{
+	struct os_task_handle *handle = bzalloc(sizeof(*handle));
+
+	if (priority < OS_TASK_PRIORITY_LOW || priority > OS_TASK_PRIORITY_HIGH)
+		priority = OS_TASK_PRIORITY_NORMAL;
+
+	link_init(&handle->link);
+	handle->refs = 1;
+	handle->pool = pool;
+	handle->task = task;
+	handle->param = param;
+	handle->priority = priority;
+	return handle;
+}
+
+bool os_task_pool_queue_task(os_task_pool_t *pool, enum os_task_priority priority, os_task_t task, void *param)
+{
+	if (!pool || !task)
+		return false;
+
+	struct os_task_handle *handle = create_handle(pool, priority, task, param);
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->stop) {
+		pthread_mutex_unlock(&pool->mutex);
+		bfree(handle);
+		return false;
+	}
+
+	queue_handle(pool, handle);
+	pthread_mutex_unlock(&pool->mutex);
+	return true;
+}
+
+os_task_handle_t *os_task_pool_schedule(os_task_pool_t *pool, enum os_task_priority priority, uint32_t delay_ms,
+					uint32_t period_ms, os_task_t task, void *param)
+{
+	if (!pool || !task)
+		return NULL;
+
+	struct os_task_handle *handle = create_handle(pool, priority, task, param);
+
+	/* one reference for the caller, one for the pool */
+	handle->refs = 2;
+	handle->period = period_ms;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->stop) {
+		pthread_mutex_unlock(&pool->mutex);
+		bfree(handle);
+		return NULL;
+	}
+
+	if (!delay_ms) {
+		handle->expires = pool_now_tick(pool);
+		queue_handle(pool, handle);
+	} else {
+		uint64_t now = pool_now_tick(pool);
+
+		/* the timer thread doesn't advance an empty wheel */
+		if (!pool->num_scheduled && pool->cur_tick < now)
+			pool->cur_tick = now;
+
+		handle->expires = now + delay_ms;
+		wheel_insert(pool, handle);
+		os_event_signal(pool->timer_event);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return handle;
+}
+
+bool os_task_cancel(os_task_handle_t *handle)
+{
+	if (!handle)
+		return false;
+
+	struct os_task_pool *pool = handle->pool;
+	bool prevented = false;
+	bool release_pool_ref = false;
+	os_event_t *wait_event = NULL;
+
+	pthread_mutex_lock(&pool->mutex);
+	handle->canceled = true;
+
+	switch (handle->state) {
+	case TASK_SCHEDULED:
+		pool->num_scheduled--;
+		/* fall through */
+	case TASK_QUEUED:
+		link_remove(&handle->link);
+		handle->state = TASK_DONE;
+		prevented = true;
+		release_pool_ref = true;
+		break;
+
+	case TASK_RUNNING:
+		if (current_task == handle)
+			break;
+		if (!handle->finished_event)
+			os_event_init(&handle->finished_event, OS_EVENT_TYPE_MANUAL);
+		wait_event = handle->finished_event;
+		break;
+
+	case TASK_DONE:
+		break;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (wait_event)
+		os_event_wait(wait_event);
+	if (release_pool_ref)
+		task_handle_release(handle);
+
+	task_handle_release(handle);
+	return prevented;
+}
+
+void os_task_handle_release(os_task_handle_t *handle)
+{
+	if (handle)
+		task_handle_release(handle);
+}
@@ -17,6 +17,58 @@ EXPORT void os_task_queue_destroy(os_task_queue_t *tt);
 EXPORT bool os_task_queue_wait(os_task_queue_t *tt);
 EXPORT bool os_task_queue_inside(os_task_queue_t *tt);
 
+/* Fork/join worker pool.  os_work_pool_run splits [0, count) between the
+ * calling thread and the pool's workers and returns once every index has been
+ * processed.  Idle participants steal work from busy ones, so uneven items
+ * don't leave threads waiting. */
+struct os_work_pool;
+typedef struct os_work_pool os_work_pool_t;
+
+typedef void (*os_work_t)(void *param, size_t idx);
+
+/* threads == 0 creates one worker less than the number of logical cores */
+EXPORT os_work_pool_t *os_work_pool_create(const char *name, size_t threads);
+EXPORT void os_work_pool_destroy(os_work_pool_t *pool);
+EXPORT size_t os_work_pool_get_thread_count(const os_work_pool_t *pool);
+EXPORT void os_work_pool_run(os_work_pool_t *pool, size_t count, os_work_t work, void *param);
+
+/* Task pool with priorities and delayed/periodic tasks, for background work
+ * that doesn't need a thread of its own.  Delayed tasks are kept in a timing
+ * wheel with a resolution of 1 ms, driven by a single timer thread. */
+struct os_task_pool;
+typedef struct os_task_pool os_task_pool_t;
+
+struct os_task_handle;
+typedef struct os_task_handle os_task_handle_t;
+
+enum os_task_priority {
+	OS_TASK_PRIORITY_LOW,
+	OS_TASK_PRIORITY_NORMAL,
+	OS_TASK_PRIORITY_HIGH,
+};
+
+/* threads == 0 creates one worker per two logical cores, up to four */
+EXPORT os_task_pool_t *os_task_pool_create(const char *name, size_t threads);
+/* Pending tasks are canceled, running tasks are waited for */
+EXPORT void os_task_pool_destroy(os_task_pool_t *pool);
+EXPORT bool os_task_pool_inside(os_task_pool_t *pool);
+
+EXPORT bool os_task_pool_queue_task(os_task_pool_t *pool, enum os_task_priority priority, os_task_t task,
+				    void *param);
+
+/* Runs the task after delay_ms, and then every period_ms if period_ms is not
+ * 0.  A periodic task that runs late skips the periods it missed.  The handle
+ * must be canceled or released. */
+EXPORT os_task_handle_t *os_task_pool_schedule(os_task_pool_t *pool, enum os_task_priority priority,
+					       uint32_t delay_ms, uint32_t period_ms, os_task_t task, void *param);
+
+/* Cancels the task and releases the handle.  If the task is running on
+ * another thread, waits for it to return.  Returns true if a run of the task
+ * was prevented.  Must be called before the pool is destroyed. */
+EXPORT bool os_task_cancel(os_task_handle_t *handle);
+/* Releases the handle without canceling the task */
+EXPORT void os_task_handle_release(os_task_handle_t *handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -140,3 +140,32 @@ static inline bool os_atomic_load_bool(const volatile bool *ptr)
 
 	return b;
 }
+
+static inline void *os_atomic_exchange_ptr(void *volatile *ptr, void *val)
+{
+	return _InterlockedExchangePointer(ptr, val);
+}
+
+static inline void os_atomic_store_ptr(void *volatile *ptr, void *val)
+{
+	_InterlockedExchangePointer(ptr, val);
+}
+
+static inline void *os_atomic_load_ptr(void *const volatile *ptr)
+{
+#if defined(_M_ARM64)
+	void *const val = (void *)__ldar64((volatile unsigned __int64 *)ptr);
+#elif defined(_WIN64)
+	void *const val = (void *)__iso_volatile_load64((const volatile __int64 *)ptr);
+#else
+	void *const val = (void *)__iso_volatile_load32((const volatile __int32 *)ptr);
+#endif
+
+#if defined(_M_ARM)
+	__dmb(_ARM_BARRIER_ISH);
+#else
+	_ReadWriteBarrier();
+#endif
+
+	return val;
+}
@@ -3,6 +3,7 @@
 #include <util/threading.h>
 #include <util/platform.h>
 #include <util/dstr.h>
+#include <util/task.h>
 #include <sys/stat.h>
 
 #define blog(log_level, format, ...) \
@@ -12,6 +13,9 @@
 #define info(format, ...) blog(LOG_INFO, format, ##__VA_ARGS__)
 #define warn(format, ...) blog(LOG_WARNING, format, ##__VA_ARGS__)
 
+/* animated gifs with more decoded frames than this are streamed */
+#define GIF_MAX_MEMORY (64ULL * 1024ULL * 1024ULL)
+
 struct image_source {
 	obs_source_t *source;
 
@@ -27,9 +31,25 @@ struct image_source {
 	volatile bool file_decoded;
 	volatile bool texture_loaded;
 
-	gs_image_file4_t if4;
+	/* protects the image against background decoding */
+	pthread_mutex_t decode_mutex;
+	volatile long decode_generation;
+
+	/* background decodes are queued from the next tick, as the source's
+	 * data can't be looked up until it has been created */
+	struct decode_task *volatile pending_decode;
+
+	/* still images are shared through the image cache, gifs can be
+	 * animated and are decoded per source */
+	obs_cached_image_t *cached_image;
+	gs_image_file5_t if5;
+	uint32_t cx;
+	uint32_t cy;
 };
 
+/* decodes images in the background while a scene collection is loading */
+static os_task_queue_t *decode_queue = NULL;
+
 static time_t get_modified_timestamp(const char *filename)
 {
 	struct stat stats;
@@ -38,51 +58,134 @@ static time_t get_modified_timestamp(const char *filename)
 	return stats.st_mtime;
 }
 
+static inline bool is_gif(const char *file)
+{
+	size_t len = strlen(file);
+	return len > 4 && astrcmpi(file + len - 4, ".gif") == 0;
+}
+
+static inline enum gs_image_alpha_mode get_alpha_mode(struct image_source *context)
+{
+	return context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY;
+}
+
 static const char *image_source_get_name(void *unused)
 {
 	UNUSED_PARAMETER(unused);
 	return obs_module_text("ImageInput");
 }
 
-void image_source_preload_image(void *data)
+static void image_source_preload_file(struct image_source *context, const char *file,
+				      enum gs_image_alpha_mode alpha_mode)
 {
-	struct image_source *context = data;
 	if (os_atomic_load_bool(&context->file_decoded))
 		return;
 
-	context->file_timestamp = get_modified_timestamp(context->file);
-	gs_image_file4_init(&context->if4, context->file,
-			    context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY);
+	context->file_timestamp = get_modified_timestamp(file);
+
+	if (is_gif(file)) {
+		gs_image_file5_init(&context->if5, file, alpha_mode, GIF_MAX_MEMORY);
+		context->cx = context->if5.image4.image3.image2.image.cx;
+		context->cy = context->if5.image4.image3.image2.image.cy;
+	} else {
+		context->cached_image = obs_image_cache_get(file, alpha_mode);
+		obs_cached_image_wait(context->cached_image);
+		context->cx = obs_cached_image_get_width(context->cached_image);
+		context->cy = obs_cached_image_get_height(context->cached_image);
+	}
+
 	os_atomic_set_bool(&context->file_decoded, true);
 }
 
+void image_source_preload_image(void *data)
+{
+	struct image_source *context = data;
+	image_source_preload_file(context, context->file, get_alpha_mode(context));
+}
+
 static void image_source_load_texture(void *data)
 {
 	struct image_source *context = data;
+	bool loaded;
+
 	if (os_atomic_load_bool(&context->texture_loaded))
 		return;
 
 	debug("loading texture '%s'", context->file);
 
 	obs_enter_graphics();
-	gs_image_file4_init_texture(&context->if4);
+	if (context->cached_image) {
+		loaded = !!obs_cached_image_get_texture(context->cached_image);
+	} else {
+		gs_image_file5_init_texture(&context->if5);
+		loaded = context->if5.image4.image3.image2.image.loaded;
+	}
 	obs_leave_graphics();
 
-	if (!context->if4.image3.image2.image.loaded)
+	if (!loaded)
 		warn("failed to load texture '%s'", context->file);
 	context->update_time_elapsed = 0;
 	os_atomic_set_bool(&context->texture_loaded, true);
 }
 
+struct decode_task {
+	obs_weak_source_t *source;
+	long generation;
+	char *file;
+	enum gs_image_alpha_mode alpha_mode;
+};
+
+static void free_decode_task(struct decode_task *task)
+{
+	if (task) {
+		obs_weak_source_release(task->source);
+		bfree(task->file);
+		bfree(task);
+	}
+}
+
 static void image_source_unload(void *data)
 {
 	struct image_source *context = data;
+	obs_cached_image_t *cached_image;
+
+	/* invalidates pending background decodes */
+	os_atomic_inc_long(&context->decode_generation);
+	free_decode_task(os_atomic_exchange_ptr((void *volatile *)&context->pending_decode, NULL));
+
+	pthread_mutex_lock(&context->decode_mutex);
 	os_atomic_set_bool(&context->file_decoded, false);
 	os_atomic_set_bool(&context->texture_loaded, false);
 
 	obs_enter_graphics();
-	gs_image_file4_free(&context->if4);
+	gs_image_file5_free(&context->if5);
+	cached_image = context->cached_image;
+	context->cached_image = NULL;
+	context->cx = 0;
+	context->cy = 0;
 	obs_leave_graphics();
+	pthread_mutex_unlock(&context->decode_mutex);
+
+	obs_cached_image_release(cached_image);
+}
+
+static void decode_image(void *data)
+{
+	struct decode_task *task = data;
+
+	obs_source_t *source = obs_weak_source_get_source(task->source);
+	if (source) {
+		struct image_source *context = obs_obj_get_data(source);
+
+		pthread_mutex_lock(&context->decode_mutex);
+		if (os_atomic_load_long(&context->decode_generation) == task->generation)
+			image_source_preload_file(context, task->file, task->alpha_mode);
+		pthread_mutex_unlock(&context->decode_mutex);
+
+		obs_source_release(source);
+	}
+
+	free_decode_task(task);
 }
 
 static void image_source_load(struct image_source *context)
@@ -90,6 +193,17 @@ static void image_source_load(struct image_source *context)
 	image_source_unload(context);
 
 	if (context->file && *context->file) {
+		/* the texture is created on the first tick after decoding */
+		if (decode_queue && obs_sources_loading()) {
+			struct decode_task *task = bzalloc(sizeof(*task));
+			task->generation = os_atomic_load_long(&context->decode_generation);
+			task->file = bstrdup(context->file);
+			task->alpha_mode = get_alpha_mode(context);
+
+			free_decode_task(os_atomic_exchange_ptr((void *volatile *)&context->pending_decode, task));
+			return;
+		}
+
 		image_source_preload_image(context);
 		image_source_load_texture(context);
 	}
@@ -103,11 +217,17 @@ static void image_source_update(void *data, obs_data_t *settings)
 	const bool linear_alpha = obs_data_get_bool(settings, "linear_alpha");
 	const bool is_slide = obs_data_get_bool(settings, "is_slide");
 
+	/* background decodes of the previous file are no longer wanted */
+	os_atomic_inc_long(&context->decode_generation);
+
+	pthread_mutex_lock(&context->decode_mutex);
 	if (context->file)
 		bfree(context->file);
 	context->file = bstrdup(file);
-	context->persistent = !unload;
 	context->linear_alpha = linear_alpha;
+	pthread_mutex_unlock(&context->decode_mutex);
+
+	context->persistent = !unload;
 	context->is_slide = is_slide;
 
 	if (is_slide)
@@ -146,13 +266,13 @@ static void restart_gif(void *data)
 {
 	struct image_source *context = data;
 
-	if (context->if4.image3.image2.image.is_animated_gif) {
-		context->if4.image3.image2.image.cur_frame = 0;
-		context->if4.image3.image2.image.cur_loop = 0;
-		context->if4.image3.image2.image.cur_time = 0;
+	if (context->if5.image4.image3.image2.image.is_animated_gif) {
+		context->if5.image4.image3.image2.image.cur_frame = 0;
+		context->if5.image4.image3.image2.image.cur_loop = 0;
+		context->if5.image4.image3.image2.image.cur_time = 0;
 
 		obs_enter_graphics();
-		gs_image_file4_update_texture(&context->if4);
+		gs_image_file5_update_texture(&context->if5);
 		obs_leave_graphics();
 
 		context->restart_gif = false;
@@ -169,6 +289,7 @@ static void *image_source_create(obs_data_t *settings, obs_source_t *source)
 {
 	struct image_source *context = bzalloc(sizeof(struct image_source));
 	context->source = source;
+	pthread_mutex_init(&context->decode_mutex, NULL);
 
 	image_source_update(context, settings);
 	return context;
@@ -179,6 +300,7 @@ static void image_source_destroy(void *data)
 	struct image_source *context = data;
 
 	image_source_unload(context);
+	pthread_mutex_destroy(&context->decode_mutex);
 
 	if (context->file)
 		bfree(context->file);
@@ -188,13 +310,13 @@ static void image_source_destroy(void *data)
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cx;
+	return context->cx;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cy;
+	return context->cy;
 }
 
 static void image_source_render(void *data, gs_effect_t *effect)
@@ -203,8 +325,8 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	if (!os_atomic_load_bool(&context->texture_loaded))
 		return;
 
-	struct gs_image_file *const image = &context->if4.image3.image2.image;
-	gs_texture_t *const texture = image->texture;
+	gs_texture_t *const texture = context->cached_image ? obs_cached_image_get_texture(context->cached_image)
+							    : context->if5.image4.image3.image2.image.texture;
 	if (!texture)
 		return;
 
@@ -217,7 +339,7 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	gs_eparam_t *const param = gs_effect_get_param_by_name(effect, "image");
 	gs_effect_set_texture_srgb(param, texture);
 
-	gs_draw_sprite(texture, 0, image->cx, image->cy);
+	gs_draw_sprite(texture, 0, context->cx, context->cy);
 
 	gs_blend_state_pop();
 
@@ -227,6 +349,13 @@ static void image_source_render(void *data, gs_effect_t *effect)
 static void image_source_tick(void *data, float seconds)
 {
 	struct image_source *context = data;
+
+	struct decode_task *task = os_atomic_exchange_ptr((void *volatile *)&context->pending_decode, NULL);
+	if (task) {
+		task->source = obs_source_get_weak_source(context->source);
+		os_task_queue_queue_task(decode_queue, decode_image, task);
+	}
+
 	if (!os_atomic_load_bool(&context->texture_loaded)) {
 		if (os_atomic_load_bool(&context->file_decoded))
 			image_source_load_texture(context);
@@ -251,7 +380,7 @@ static void image_source_tick(void *data, float seconds)
 
 	if (obs_source_showing(context->source)) {
 		if (!context->active) {
-			if (context->if4.image3.image2.image.is_animated_gif)
+			if (context->if5.image4.image3.image2.image.is_animated_gif)
 				context->last_time = frame_time;
 			context->active = true;
 		}
@@ -268,13 +397,13 @@ static void image_source_tick(void *data, float seconds)
 		return;
 	}
 
-	if (context->last_time && context->if4.image3.image2.image.is_animated_gif) {
+	if (context->last_time && context->if5.image4.image3.image2.image.is_animated_gif) {
 		uint64_t elapsed = frame_time - context->last_time;
-		bool updated = gs_image_file4_tick(&context->if4, elapsed);
+		bool updated = gs_image_file5_tick(&context->if5, elapsed);
 
 		if (updated) {
 			obs_enter_graphics();
-			gs_image_file4_update_texture(&context->if4);
+			gs_image_file5_update_texture(&context->if5);
 			obs_leave_graphics();
 		}
 	}
@@ -316,7 +445,7 @@ static obs_properties_t *image_source_properties(void *data)
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
-	return s->if4.image3.image2.mem_usage;
+	return s->cached_image ? obs_cached_image_get_mem_usage(s->cached_image) : s->if5.image4.image3.image2.mem_usage;
 }
 
 static void missing_file_callback(void *src, const char *new_path, void *data)
@@ -356,14 +485,17 @@ static enum gs_color_space image_source_get_color_space(void *data, size_t count
 	UNUSED_PARAMETER(preferred_spaces);
 
 	struct image_source *const s = data;
-	gs_image_file4_t *const if4 = &s->if4;
+	if (s->cached_image)
+		return obs_cached_image_get_color_space(s->cached_image);
+
+	gs_image_file4_t *const if4 = &s->if5.image4;
 	return if4->image3.image2.image.texture ? if4->space : GS_CS_SRGB;
 }
 
 static struct obs_source_info image_source_info = {
 	.id = "image_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB | OBS_SOURCE_PARALLEL_LOAD,
 	.get_name = image_source_get_name,
 	.create = image_source_create,
 	.destroy = image_source_destroy,
@@ -397,6 +529,8 @@ extern struct obs_source_info color_source_info_v3;
 
 bool obs_module_load(void)
 {
+	decode_queue = os_task_queue_create();
+
 	obs_register_source(&image_source_info);
 	obs_register_source(&color_source_info_v1);
 	obs_register_source(&color_source_info_v2);
@@ -405,3 +539,9 @@ bool obs_module_load(void)
 	obs_register_source(&slideshow_info_mk2);
 	return true;
 }
+
+void obs_module_unload(void)
+{
+	os_task_queue_destroy(decode_queue);
+	decode_queue = NULL;
+}
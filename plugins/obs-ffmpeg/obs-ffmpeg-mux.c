@@ -53,6 +53,14 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	}
 
 	deque_free(&stream->packets);
+
+	if (stream->ring) {
+		/* a clip that is still being saved keeps its own reference */
+		replay_ring_close(stream->ring);
+		replay_ring_release(stream->ring);
+		stream->ring = NULL;
+	}
+
 	stream->cur_size = 0;
 	stream->cur_time = 0;
 	stream->max_size = 0;
@@ -71,6 +79,8 @@ static void ffmpeg_mux_destroy(void *data)
 	for (size_t i = 0; i < stream->mux_packets.num; i++)
 		obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	da_free(stream->mux_packets);
+	da_free(stream->ring_mux_packets);
+	replay_ring_release(stream->mux_ring);
 	deque_free(&stream->packets);
 
 	os_process_pipe_destroy(stream->pipe);
@@ -974,6 +984,85 @@ static void replay_buffer_destroy(void *data)
 	ffmpeg_mux_destroy(data);
 }
 
+/* used for time limited buffers when the bitrate is unknown */
+#define REPLAY_RING_DEFAULT_SIZE (4ULL * 1024 * 1024 * 1024)
+
+static int64_t get_encoder_bitrate(obs_encoder_t *encoder)
+{
+	obs_data_t *settings = obs_encoder_get_settings(encoder);
+	int64_t bitrate = obs_data_get_int(settings, "bitrate");
+	obs_data_release(settings);
+	return bitrate;
+}
+
+/* Amount of data a time limited buffer holds at the encoder bitrates */
+static uint64_t estimate_ring_data_size(struct ffmpeg_muxer *stream)
+{
+	int64_t kbps = 0;
+	obs_encoder_t *encoder;
+
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+		encoder = obs_output_get_video_encoder2(stream->output, i);
+		if (encoder)
+			kbps += get_encoder_bitrate(encoder);
+	}
+
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
+		encoder = obs_output_get_audio_encoder(stream->output, i);
+		if (encoder)
+			kbps += get_encoder_bitrate(encoder);
+	}
+
+	if (kbps <= 0 || stream->max_time <= 0)
+		return REPLAY_RING_DEFAULT_SIZE;
+
+	return (uint64_t)kbps * 125 * (uint64_t)(stream->max_time / 1000000);
+}
+
+static bool replay_buffer_create_ring(struct ffmpeg_muxer *stream, obs_data_t *settings)
+{
+	const char *dir = obs_data_get_string(settings, "disk_directory");
+	uint64_t limit, size;
+	struct dstr path = {0};
+
+	if (!dir || !*dir)
+		dir = obs_data_get_string(settings, "directory");
+
+	/* The file is half again as large as the data the buffer holds.  A
+	 * clip that is being saved is read from its oldest packet while
+	 * recording continues, so recording can go on for half the length of
+	 * the buffer before it overwrites unread data, while clips are read
+	 * back many times faster than real time.  Time limited buffers are
+	 * purged by time and may use the whole file, so the spare room also
+	 * takes bitrates above the estimate instead of shortening clips. */
+	if (stream->max_size > 0) {
+		limit = (uint64_t)stream->max_size;
+		size = limit + limit / 2;
+	} else {
+		size = estimate_ring_data_size(stream);
+		size += size / 2;
+		limit = size;
+	}
+
+	dstr_copy(&path, dir);
+	dstr_replace(&path, "\\", "/");
+	if (dstr_end(&path) != '/')
+		dstr_cat_ch(&path, '/');
+	os_mkdirs(path.array);
+	dstr_catf(&path, "replay-buffer-%llu.tmp", (unsigned long long)os_gettime_ns());
+
+	stream->ring = replay_ring_create(path.array, size, limit);
+	if (!stream->ring) {
+		set_file_not_readable_error(stream, settings, path.array);
+		warn("Failed to create replay buffer file '%s'", path.array);
+	} else {
+		info("Replay buffer on disk: '%s' (%llu MB)", path.array, (unsigned long long)(size / (1024 * 1024)));
+	}
+
+	dstr_free(&path);
+	return stream->ring != NULL;
+}
+
 static bool replay_buffer_start(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -986,6 +1075,11 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+
+	if (obs_data_get_bool(s, "use_disk") && !replay_buffer_create_ring(stream, s)) {
+		obs_data_release(s);
+		return false;
+	}
 	obs_data_release(s);
 
 	os_atomic_set_bool(&stream->active, true);
@@ -1059,6 +1153,20 @@ static inline void replay_buffer_purge(struct ffmpeg_muxer *stream, struct encod
 		purge(stream);
 }
 
+static void apply_packet_offsets(struct encoder_packet *pkt, int64_t video_offset, int64_t *audio_offsets,
+				 int64_t video_pts_offset, int64_t *audio_dts_offsets)
+{
+	if (pkt->type == OBS_ENCODER_VIDEO) {
+		pkt->dts_usec -= video_offset;
+		pkt->dts -= video_pts_offset;
+		pkt->pts -= video_pts_offset;
+	} else {
+		pkt->dts_usec -= audio_offsets[pkt->track_idx];
+		pkt->dts -= audio_dts_offsets[pkt->track_idx];
+		pkt->pts -= audio_dts_offsets[pkt->track_idx];
+	}
+}
+
 static void insert_packet(mux_packets_t *packets, struct encoder_packet *packet, int64_t video_offset,
 			  int64_t *audio_offsets, int64_t video_pts_offset, int64_t *audio_dts_offsets)
 {
@@ -1066,16 +1174,7 @@ static void insert_packet(mux_packets_t *packets, struct encoder_packet *packet,
 	size_t idx;
 
 	obs_encoder_packet_ref(&pkt, packet);
-
-	if (pkt.type == OBS_ENCODER_VIDEO) {
-		pkt.dts_usec -= video_offset;
-		pkt.dts -= video_pts_offset;
-		pkt.pts -= video_pts_offset;
-	} else {
-		pkt.dts_usec -= audio_offsets[pkt.track_idx];
-		pkt.dts -= audio_dts_offsets[pkt.track_idx];
-		pkt.pts -= audio_dts_offsets[pkt.track_idx];
-	}
+	apply_packet_offsets(&pkt, video_offset, audio_offsets, video_pts_offset, audio_dts_offsets);
 
 	for (idx = packets->num; idx > 0; idx--) {
 		struct encoder_packet *p = packets->array + (idx - 1);
@@ -1086,6 +1185,71 @@ static void insert_packet(mux_packets_t *packets, struct encoder_packet *packet,
 	da_insert(*packets, idx, &pkt);
 }
 
+static void insert_ring_packet(ring_packets_t *packets, struct replay_ring_packet *packet, int64_t video_offset,
+			       int64_t *audio_offsets, int64_t video_pts_offset, int64_t *audio_dts_offsets)
+{
+	struct replay_ring_packet rp = *packet;
+	size_t idx;
+
+	apply_packet_offsets(&rp.packet, video_offset, audio_offsets, video_pts_offset, audio_dts_offsets);
+
+	for (idx = packets->num; idx > 0; idx--) {
+		struct replay_ring_packet *p = packets->array + (idx - 1);
+		if (p->packet.dts_usec < rp.packet.dts_usec)
+			break;
+	}
+
+	da_insert(*packets, idx, &rp);
+}
+
+/* Writes the packets of a clip from the ring file, the data is read in large
+ * windows rather than per packet. Packets that were overwritten before they
+ * could be read are dropped, along with the video up to the next keyframe. */
+static bool write_ring_packets(struct ffmpeg_muxer *stream)
+{
+	struct replay_ring_reader reader;
+	bool wait_for_keyframe = false;
+	size_t skipped = 0;
+
+	if (!replay_ring_reader_init(&reader, stream->mux_ring)) {
+		warn("Could not open replay buffer file '%s'", stream->mux_ring->path.array);
+		return false;
+	}
+
+	for (size_t i = 0; i < stream->ring_mux_packets.num; i++) {
+		struct replay_ring_packet *rp = &stream->ring_mux_packets.array[i];
+		struct encoder_packet pkt = rp->packet;
+		bool is_video = pkt.type == OBS_ENCODER_VIDEO;
+
+		if (is_video && wait_for_keyframe) {
+			if (!pkt.keyframe) {
+				skipped++;
+				continue;
+			}
+			wait_for_keyframe = false;
+		}
+
+		pkt.data = (uint8_t *)replay_ring_read(&reader, rp->pos, pkt.size);
+		if (!pkt.data) {
+			if (is_video)
+				wait_for_keyframe = true;
+			skipped++;
+			continue;
+		}
+
+		if (!write_packet(stream, &pkt)) {
+			replay_ring_reader_free(&reader);
+			return false;
+		}
+	}
+
+	if (skipped)
+		warn("%zu packets of the replay buffer were overwritten before they could be saved", skipped);
+
+	replay_ring_reader_free(&reader);
+	return true;
+}
+
 static void *replay_buffer_mux_thread(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -1105,6 +1269,12 @@ static void *replay_buffer_mux_thread(void *data)
 		goto error;
 	}
 
+	if (stream->mux_ring && !write_ring_packets(stream)) {
+		warn("Could not write packet for file '%s'", stream->path.array);
+		error = true;
+		goto error;
+	}
+
 	for (size_t i = 0; i < stream->mux_packets.num; i++) {
 		struct encoder_packet *pkt = &stream->mux_packets.array[i];
 		if (!write_packet(stream, pkt)) {
@@ -1125,6 +1295,9 @@ error:
 			obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	}
 	da_free(stream->mux_packets);
+	da_free(stream->ring_mux_packets);
+	replay_ring_release(stream->mux_ring);
+	stream->mux_ring = NULL;
 	os_atomic_set_bool(&stream->muxing, false);
 
 	if (!error) {
@@ -1136,11 +1309,58 @@ error:
 	return NULL;
 }
 
+static void replay_buffer_save_ring(struct ffmpeg_muxer *stream)
+{
+	struct replay_ring *ring = stream->ring;
+	const size_t size = sizeof(struct replay_ring_packet);
+	size_t num_packets = ring->packets.size / size;
+	size_t start = replay_ring_snapshot_start(ring);
+
+	da_reserve(stream->ring_mux_packets, num_packets - start);
+
+	bool found_video = false;
+	bool found_audio[MAX_AUDIO_MIXES] = {0};
+	int64_t video_offset = 0;
+	int64_t video_pts_offset = 0;
+	int64_t audio_offsets[MAX_AUDIO_MIXES] = {0};
+	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
+
+	for (size_t i = start; i < num_packets; i++) {
+		struct replay_ring_packet *rp = deque_data(&ring->packets, i * size);
+		struct encoder_packet *pkt = &rp->packet;
+
+		if (pkt->type == OBS_ENCODER_VIDEO) {
+			if (!found_video) {
+				video_pts_offset = pkt->pts;
+				video_offset = video_pts_offset * 1000000 / pkt->timebase_den;
+				found_video = true;
+			}
+		} else {
+			if (!found_audio[pkt->track_idx]) {
+				found_audio[pkt->track_idx] = true;
+				audio_offsets[pkt->track_idx] = pkt->dts_usec;
+				audio_dts_offsets[pkt->track_idx] = pkt->dts;
+			}
+		}
+
+		insert_ring_packet(&stream->ring_mux_packets, rp, video_offset, audio_offsets, video_pts_offset,
+				   audio_dts_offsets);
+	}
+
+	replay_ring_addref(ring);
+	stream->mux_ring = ring;
+}
+
 static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
 	const size_t size = sizeof(struct encoder_packet);
 	size_t num_packets = stream->packets.size / size;
 
+	if (stream->ring) {
+		replay_buffer_save_ring(stream);
+		num_packets = 0;
+	}
+
 	da_reserve(stream->mux_packets, num_packets);
 
 	/* ---------------------------- */
@@ -1220,6 +1440,18 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 		}
 	}
 
+	if (stream->ring) {
+		replay_ring_purge(stream->ring, packet, stream->max_time);
+
+		if (!replay_ring_push(stream->ring, packet)) {
+			warn("Failed to write to replay buffer file '%s'", stream->ring->path.array);
+			deactivate_replay_buffer(stream, OBS_OUTPUT_ERROR);
+			return;
+		}
+
+		goto save;
+	}
+
 	obs_encoder_packet_ref(&pkt, packet);
 	replay_buffer_purge(stream, &pkt);
 
@@ -1232,6 +1464,7 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
 		stream->keyframes++;
 
+save:
 	if (stream->save_ts && packet->sys_dts_usec >= stream->save_ts) {
 		if (os_atomic_load_bool(&stream->muxing))
 			return;
@@ -1250,6 +1483,7 @@ static void replay_buffer_defaults(obs_data_t *s)
 {
 	obs_data_set_default_int(s, "max_time_sec", 15);
 	obs_data_set_default_int(s, "max_size_mb", 500);
+	obs_data_set_default_bool(s, "use_disk", false);
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
@@ -6,11 +6,55 @@
 #include <util/darray.h>
 #include <util/dstr.h>
 #include <util/pipe.h>
+#include <util/serializer.h>
 #include <util/platform.h>
 #include <util/threading.h>
 
 typedef DARRAY(struct encoder_packet) mux_packets_t;
 
+/* replay buffer packets stored on disk, data is NULL and pos is the logical
+ * offset of the payload in the ring file */
+struct replay_ring_packet {
+	struct encoder_packet packet;
+	uint64_t pos;
+};
+
+typedef DARRAY(struct replay_ring_packet) ring_packets_t;
+
+struct replay_ring {
+	volatile long refs;
+	struct dstr path;
+	struct serializer writer;
+	uint64_t prealloc_bytes;
+	uint64_t size;
+	uint64_t limit;
+
+	/* protects write_pos and the writer once the ring has been closed,
+	 * both are used by the muxer thread */
+	pthread_mutex_t mutex;
+	uint64_t write_pos;
+	uint64_t bytes_written;
+	bool closed;
+
+	/* signaled when more data reached the file or the writer stopped, the
+	 * ring is read by one clip at a time */
+	os_event_t *written_event;
+
+	struct deque packets;
+	/* sequence numbers of the video keyframes in packets */
+	struct deque keyframes;
+	uint64_t first_seq;
+};
+
+struct replay_ring_reader {
+	struct replay_ring *ring;
+	FILE *file;
+	uint8_t *buf;
+	size_t capacity;
+	uint64_t start;
+	size_t len;
+};
+
 struct ffmpeg_muxer {
 	obs_output_t *output;
 	os_process_pipe_t *pipe;
@@ -38,6 +82,11 @@ struct ffmpeg_muxer {
 	volatile bool muxing;
 	mux_packets_t mux_packets;
 
+	/* replay buffer on disk */
+	struct replay_ring *ring;
+	struct replay_ring *mux_ring;
+	ring_packets_t ring_mux_packets;
+
 	/* split file */
 	bool found_video;
 	bool found_audio[MAX_AUDIO_MIXES];
@@ -74,3 +123,15 @@ bool send_headers(struct ffmpeg_muxer *stream);
 int deactivate(struct ffmpeg_muxer *stream, int code);
 void ffmpeg_mux_stop(void *data, uint64_t ts);
 uint64_t ffmpeg_mux_total_bytes(void *data);
+
+struct replay_ring *replay_ring_create(const char *path, uint64_t size, uint64_t limit);
+void replay_ring_addref(struct replay_ring *ring);
+void replay_ring_close(struct replay_ring *ring);
+void replay_ring_release(struct replay_ring *ring);
+void replay_ring_purge(struct replay_ring *ring, const struct encoder_packet *pkt, int64_t max_time);
+bool replay_ring_push(struct replay_ring *ring, const struct encoder_packet *pkt);
+size_t replay_ring_snapshot_start(struct replay_ring *ring);
+
+bool replay_ring_reader_init(struct replay_ring_reader *reader, struct replay_ring *ring);
+void replay_ring_reader_free(struct replay_ring_reader *reader);
+const uint8_t *replay_ring_read(struct replay_ring_reader *reader, uint64_t pos, size_t size);
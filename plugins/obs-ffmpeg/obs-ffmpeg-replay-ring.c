@@ -0,0 +1,348 @@
+#include "obs-ffmpeg-mux.h"
+
+#include <util/buffered-file-serializer.h>
+
+/*
+ * Disk backed storage for the replay buffer. Packet data is written through
+ * the buffered (asynchronous) file serializer into a preallocated file that is
+ * used as a ring, only the packet headers and an index of the video keyframes
+ * are kept in memory.
+ */
+
+#define READ_WINDOW_SIZE (8 * 1024 * 1024)
+
+struct replay_ring *replay_ring_create(const char *path, uint64_t size, uint64_t limit)
+{
+	struct replay_ring *ring = bzalloc(sizeof(*ring));
+
+	dstr_copy(&ring->path, path);
+	ring->size = size;
+	ring->limit = limit < size ? limit : size;
+	ring->refs = 1;
+	pthread_mutex_init(&ring->mutex, NULL);
+	os_event_init(&ring->written_event, OS_EVENT_TYPE_AUTO);
+
+	if (!buffered_file_serializer_init(&ring->writer, path, 0, 0)) {
+		blog(LOG_WARNING, "replay_ring_create: Failed to open '%s'", path);
+		dstr_free(&ring->path);
+		os_event_destroy(ring->written_event);
+		pthread_mutex_destroy(&ring->mutex);
+		bfree(ring);
+		return NULL;
+	}
+
+	/* clips are read back while recording continues */
+	buffered_file_serializer_set_flush_event(&ring->writer, ring->written_event);
+
+	/* Extend the file to its full size so that it does not have to grow
+	 * while recording. */
+	serializer_seek(&ring->writer, (int64_t)size - 1, SERIALIZE_SEEK_START);
+	s_w8(&ring->writer, 0);
+	serializer_seek(&ring->writer, 0, SERIALIZE_SEEK_START);
+	ring->prealloc_bytes = 1;
+
+	return ring;
+}
+
+void replay_ring_addref(struct replay_ring *ring)
+{
+	os_atomic_inc_long(&ring->refs);
+}
+
+/* Flushes all pending data to the file and stops writing, a clip that is
+ * still being saved can read everything that was written up to this point. */
+void replay_ring_close(struct replay_ring *ring)
+{
+	pthread_mutex_lock(&ring->mutex);
+	if (!ring->closed) {
+		/* after a failed write only the data before it is valid */
+		if (serializer_get_pos(&ring->writer) == -1)
+			ring->bytes_written = buffered_file_serializer_get_bytes_written(&ring->writer);
+		else
+			ring->bytes_written = ring->prealloc_bytes + ring->write_pos;
+		buffered_file_serializer_free(&ring->writer);
+		ring->closed = true;
+	}
+	pthread_mutex_unlock(&ring->mutex);
+
+	os_event_signal(ring->written_event);
+}
+
+void replay_ring_release(struct replay_ring *ring)
+{
+	if (!ring || os_atomic_dec_long(&ring->refs) > 0)
+		return;
+
+	replay_ring_close(ring);
+	os_unlink(ring->path.array);
+
+	deque_free(&ring->packets);
+	deque_free(&ring->keyframes);
+	os_event_destroy(ring->written_event);
+	pthread_mutex_destroy(&ring->mutex);
+	dstr_free(&ring->path);
+	bfree(ring);
+}
+
+static inline uint64_t get_write_pos(struct replay_ring *ring)
+{
+	uint64_t pos;
+
+	pthread_mutex_lock(&ring->mutex);
+	pos = ring->write_pos;
+	pthread_mutex_unlock(&ring->mutex);
+
+	return pos;
+}
+
+/* Number of bytes that reached the file, including the preallocation.  No
+ * more are coming if the writer failed or the ring was closed. */
+static uint64_t get_bytes_written(struct replay_ring *ring, bool *final)
+{
+	uint64_t bytes;
+
+	pthread_mutex_lock(&ring->mutex);
+	if (ring->closed) {
+		bytes = ring->bytes_written;
+		*final = true;
+	} else {
+		bytes = buffered_file_serializer_get_bytes_written(&ring->writer);
+		*final = serializer_get_pos(&ring->writer) == -1;
+	}
+	pthread_mutex_unlock(&ring->mutex);
+
+	return bytes;
+}
+
+static inline struct replay_ring_packet *front_packet(struct replay_ring *ring)
+{
+	return deque_data(&ring->packets, 0);
+}
+
+static size_t replay_ring_keyframes(const struct replay_ring *ring)
+{
+	return ring->keyframes.size / sizeof(uint64_t);
+}
+
+/* Bytes between the oldest packet that is still indexed and the write
+ * position */
+static uint64_t replay_ring_used(struct replay_ring *ring)
+{
+	if (!ring->packets.size)
+		return 0;
+
+	return ring->write_pos - front_packet(ring)->pos;
+}
+
+static int64_t replay_ring_duration(struct replay_ring *ring, const struct encoder_packet *pkt)
+{
+	if (!ring->packets.size)
+		return 0;
+
+	return pkt->dts_usec - front_packet(ring)->packet.dts_usec;
+}
+
+static void replay_ring_pop_front(struct replay_ring *ring)
+{
+	struct replay_ring_packet rp;
+
+	if (!ring->packets.size)
+		return;
+
+	deque_pop_front(&ring->packets, &rp, sizeof(rp));
+
+	if (ring->keyframes.size) {
+		uint64_t seq;
+		deque_peek_front(&ring->keyframes, &seq, sizeof(seq));
+		if (seq == ring->first_seq)
+			deque_pop_front(&ring->keyframes, NULL, sizeof(seq));
+	}
+
+	ring->first_seq++;
+}
+
+/* Removes the oldest group of pictures, i.e. everything up to the second
+ * keyframe in the index. */
+static void replay_ring_purge_gop(struct replay_ring *ring)
+{
+	uint64_t next_keyframe;
+
+	if (replay_ring_keyframes(ring) < 2) {
+		replay_ring_pop_front(ring);
+		return;
+	}
+
+	next_keyframe = *(uint64_t *)deque_data(&ring->keyframes, sizeof(uint64_t));
+
+	while (ring->packets.size && ring->first_seq < next_keyframe)
+		replay_ring_pop_front(ring);
+}
+
+void replay_ring_purge(struct replay_ring *ring, const struct encoder_packet *pkt, int64_t max_time)
+{
+	if (!max_time)
+		return;
+
+	while (replay_ring_keyframes(ring) > 2 && replay_ring_duration(ring, pkt) > max_time)
+		replay_ring_purge_gop(ring);
+}
+
+static void write_wrapped(struct replay_ring *ring, const uint8_t *data, size_t size)
+{
+	uint64_t offset = ring->write_pos % ring->size;
+	size_t first = size;
+
+	if (offset + size > ring->size)
+		first = (size_t)(ring->size - offset);
+
+	s_write(&ring->writer, data, first);
+
+	if (first < size) {
+		serializer_seek(&ring->writer, 0, SERIALIZE_SEEK_START);
+		s_write(&ring->writer, data + first, size - first);
+	} else if (offset + size == ring->size) {
+		serializer_seek(&ring->writer, 0, SERIALIZE_SEEK_START);
+	}
+}
+
+bool replay_ring_push(struct replay_ring *ring, const struct encoder_packet *pkt)
+{
+	struct replay_ring_packet rp;
+
+	if (pkt->size > ring->limit)
+		return false;
+
+	/* Keep the indexed data within the limit, the remaining space of the
+	 * file is headroom for clips that are being saved while recording
+	 * continues. */
+	while (ring->packets.size && replay_ring_used(ring) + pkt->size > ring->limit) {
+		if (replay_ring_keyframes(ring) > 2)
+			replay_ring_purge_gop(ring);
+		else
+			replay_ring_pop_front(ring);
+	}
+
+	rp.packet = *pkt;
+	rp.packet.data = NULL;
+	rp.pos = ring->write_pos;
+
+	write_wrapped(ring, pkt->data, pkt->size);
+
+	pthread_mutex_lock(&ring->mutex);
+	ring->write_pos += pkt->size;
+	pthread_mutex_unlock(&ring->mutex);
+
+	if (pkt->type == OBS_ENCODER_VIDEO && pkt->keyframe) {
+		uint64_t seq = ring->first_seq + ring->packets.size / sizeof(rp);
+		deque_push_back(&ring->keyframes, &seq, sizeof(seq));
+	}
+
+	deque_push_back(&ring->packets, &rp, sizeof(rp));
+	return serializer_get_pos(&ring->writer) != -1;
+}
+
+size_t replay_ring_snapshot_start(struct replay_ring *ring)
+{
+	uint64_t seq;
+
+	/* Clips start at the oldest keyframe that is still indexed */
+	if (!ring->keyframes.size)
+		return 0;
+
+	deque_peek_front(&ring->keyframes, &seq, sizeof(seq));
+	return (size_t)(seq - ring->first_seq);
+}
+
+/* ------------------------------------------------------------------------ */
+
+bool replay_ring_reader_init(struct replay_ring_reader *reader, struct replay_ring *ring)
+{
+	memset(reader, 0, sizeof(*reader));
+
+	reader->file = os_fopen(ring->path.array, "rb");
+	if (!reader->file)
+		return false;
+
+	reader->ring = ring;
+	reader->buf = bmalloc(READ_WINDOW_SIZE);
+	reader->capacity = READ_WINDOW_SIZE;
+	return true;
+}
+
+void replay_ring_reader_free(struct replay_ring_reader *reader)
+{
+	if (reader->file)
+		fclose(reader->file);
+	bfree(reader->buf);
+	memset(reader, 0, sizeof(*reader));
+}
+
+static bool read_wrapped(struct replay_ring_reader *reader, uint64_t pos, size_t size)
+{
+	struct replay_ring *ring = reader->ring;
+	uint64_t offset = pos % ring->size;
+	size_t first = size;
+
+	if (offset + size > ring->size)
+		first = (size_t)(ring->size - offset);
+
+	if (os_fseeki64(reader->file, (int64_t)offset, SEEK_SET) != 0 ||
+	    fread(reader->buf, 1, first, reader->file) != first)
+		return false;
+
+	if (first < size) {
+		if (os_fseeki64(reader->file, 0, SEEK_SET) != 0 ||
+		    fread(reader->buf + first, 1, size - first, reader->file) != size - first)
+			return false;
+	}
+
+	return true;
+}
+
+const uint8_t *replay_ring_read(struct replay_ring_reader *reader, uint64_t pos, size_t size)
+{
+	struct replay_ring *ring = reader->ring;
+
+	if (pos < reader->start || pos + size > reader->start + reader->len) {
+		uint64_t written;
+		bool final;
+
+		/* Wait for the writer to get the data onto the disk */
+		for (;;) {
+			written = get_bytes_written(ring, &final);
+			if (written >= pos + size + ring->prealloc_bytes) {
+				written -= ring->prealloc_bytes;
+				break;
+			}
+			if (final)
+				return NULL;
+			os_event_wait(ring->written_event);
+		}
+
+		/* Read ahead as much as is available, clips are mostly read
+		 * front to back */
+		size_t len = reader->capacity;
+		if (size > len) {
+			reader->buf = brealloc(reader->buf, size);
+			reader->capacity = len = size;
+		}
+		if (written - pos < len)
+			len = (size_t)(written - pos);
+
+		reader->start = pos;
+		reader->len = 0;
+
+		if (!read_wrapped(reader, pos, len))
+			return NULL;
+
+		reader->len = len;
+	}
+
+	/* The writer may have wrapped around and overwritten the data while it
+	 * was being read. */
+	uint64_t write_pos = get_write_pos(ring);
+	if (write_pos > ring->size && pos < write_pos - ring->size)
+		return NULL;
+
+	return reader->buf + (pos - reader->start);
+}
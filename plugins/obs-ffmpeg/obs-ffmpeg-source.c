@@ -544,6 +544,20 @@ static void get_nb_frames(void *data, calldata_t *cd)
 	calldata_set_int(cd, "num_frames", frames);
 }
 
+static void get_decode_stats(void *data, calldata_t *cd)
+{
+	struct ffmpeg_source *s = data;
+	struct mp_task_stats stats;
+
+	media_playback_get_decode_stats(s->media, &stats);
+
+	calldata_set_int(cd, "steps", (long long)stats.steps);
+	calldata_set_int(cd, "avg_step_ns", stats.steps ? (long long)(stats.total_step_ns / stats.steps) : 0);
+	calldata_set_int(cd, "max_step_ns", (long long)stats.max_step_ns);
+	calldata_set_int(cd, "deadlines", (long long)stats.deadlines);
+	calldata_set_int(cd, "missed_deadlines", (long long)stats.missed_deadlines);
+}
+
 static bool ffmpeg_source_play_hotkey(void *data, obs_hotkey_pair_id id, obs_hotkey_t *hotkey, bool pressed)
 {
 	UNUSED_PARAMETER(id);
@@ -627,6 +641,10 @@ static void *ffmpeg_source_create(obs_data_t *settings, obs_source_t *source)
 	proc_handler_add(ph, "void preload_first_frame()", preload_first_frame_proc, s);
 	proc_handler_add(ph, "void get_duration(out int duration)", get_duration, s);
 	proc_handler_add(ph, "void get_nb_frames(out int num_frames)", get_nb_frames, s);
+	proc_handler_add(ph,
+			 "void get_decode_stats(out int steps, out int avg_step_ns, out int max_step_ns, "
+			 "out int deadlines, out int missed_deadlines)",
+			 get_decode_stats, s);
 
 	ffmpeg_source_update(s, settings);
 	return s;
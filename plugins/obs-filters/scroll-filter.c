@@ -319,7 +319,7 @@ static enum gs_color_space scroll_filter_get_color_space(void *data, size_t coun
 struct obs_source_info scroll_filter = {
 	.id = "scroll_filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB | OBS_SOURCE_THREAD_SAFE_TICK,
 	.get_name = scroll_filter_get_name,
 	.create = scroll_filter_create,
 	.destroy = scroll_filter_destroy,
@@ -1576,11 +1576,29 @@ ReadN(RTMP *r, char *buffer, int n)
     return nOriginalSize - n;
 }
 
+static void
+SendFailed(RTMP *r, int sockerr)
+{
+    struct linger l;
+
+    r->last_error_code = sockerr;
+
+    // Force-close the socket. Sometimes a send() error isn't fatal, so
+    // we could end up writing an unpublish message which some services
+    // treat as a clean shutdown. We need to disable lingering too so
+    // the remote side sees an abortive shutdown (RST).
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
+    RTMPSockBuf_Close(&r->m_sb);
+
+    RTMP_Close(r);
+}
+
 static int
 WriteN(RTMP *r, const char *buffer, int n)
 {
     const char *ptr = buffer;
-    struct linger l;
 
     while (n > 0)
     {
@@ -1603,18 +1621,7 @@ WriteN(RTMP *r, const char *buffer, int n)
             if (sockerr == EINTR && !RTMP_ctrlC)
                 continue;
 
-            r->last_error_code = sockerr;
-
-            // Force-close the socket. Sometimes a send() error isn't fatal, so
-            // we could end up writing an unpublish message which some services
-            // treat as a clean shutdown. We need to disable lingering too so
-            // the remote side sees an abortive shutdown (RST).
-            l.l_onoff = 1;
-            l.l_linger = 0;
-            setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
-            RTMPSockBuf_Close(&r->m_sb);
-
-            RTMP_Close(r);
+            SendFailed(r, sockerr);
             n = 1;
             break;
         }
@@ -4085,14 +4092,17 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+static int BatchAppend(RTMPBatch *batch, const char *header, int hSize,
+                       const char *data, int nSize);
+
+static int
+SendPacket(RTMP *r, RTMPPacket *packet, int queue, RTMPBatch *batch)
 {
     const RTMPPacket *prevPacket;
     uint32_t last = 0;
     int nSize;
     int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], cbuf[8], c;
     uint32_t t;
     char *buffer, *tbuf = NULL, *toff = NULL;
     int nChunkSize;
@@ -4250,6 +4260,11 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
             memcpy(toff, header, nChunkSize + hSize);
             toff += nChunkSize + hSize;
         }
+        else if (batch)
+        {
+            if (!BatchAppend(batch, header, hSize, buffer, nChunkSize))
+                return FALSE;
+        }
         else
         {
             wrote = WriteN(r, header, nChunkSize + hSize);
@@ -4263,18 +4278,13 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         // prepare to send off remaining data in Type 3 chunks
         if (nSize > 0)
         {
-            header = buffer - 1;
-            hSize = 1;
-            if (cSize)
-            {
-                header -= cSize;
-                hSize += cSize;
-            }
+            hSize = 1 + cSize;
             if (t >= 0xffffff)
-            {
                 hSize += 4;
-                header -= 4;
-            }
+
+            /* batched chunks are still referenced, so the header must not
+             * overwrite the end of the previous chunk */
+            header = batch ? cbuf : buffer - hSize;
             *header = (0xc0 | c);
             if (cSize)
             {
@@ -4320,6 +4330,12 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     return TRUE;
 }
 
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    return SendPacket(r, packet, queue, NULL);
+}
+
 void
 RTMP_Close(RTMP *r)
 {
@@ -5314,13 +5330,283 @@ fail:
     return total;
 }
 
+static int
+BatchGrow(void **ptr, int *alloc, int needed, size_t elem)
+{
+    void *p;
+    int n;
+
+    if (needed <= *alloc)
+        return TRUE;
+
+    n = *alloc ? *alloc * 2 : 64;
+    while (n < needed)
+        n *= 2;
+
+    p = realloc(*ptr, elem * n);
+    if (!p)
+        return FALSE;
+
+    *ptr = p;
+    *alloc = n;
+    return TRUE;
+}
+
+static int
+BatchAppend(RTMPBatch *batch, const char *header, int hSize, const char *data,
+            int nSize)
+{
+    RTMPBatchVec *vec;
+
+    if (!BatchGrow((void **)&batch->vecs, &batch->nVecsAlloc, batch->nVecs + 2,
+                   sizeof(RTMPBatchVec)))
+        return FALSE;
+
+    if (batch->nHeaders + hSize > batch->nHeadersAlloc)
+    {
+        size_t n = batch->nHeadersAlloc ? batch->nHeadersAlloc * 2 : 4096;
+        char *p;
+        while (n < batch->nHeaders + hSize)
+            n *= 2;
+        p = realloc(batch->headers, n);
+        if (!p)
+            return FALSE;
+        batch->headers = p;
+        batch->nHeadersAlloc = n;
+    }
+
+    memcpy(batch->headers + batch->nHeaders, header, hSize);
+
+    /* headers are contiguous in the buffer, extend the previous vector when
+     * it is a header as well */
+    vec = batch->nVecs ? &batch->vecs[batch->nVecs - 1] : NULL;
+    if (vec && !vec->base && vec->offset + vec->len == batch->nHeaders)
+    {
+        vec->len += hSize;
+    }
+    else
+    {
+        vec = &batch->vecs[batch->nVecs++];
+        vec->base = NULL;
+        vec->offset = batch->nHeaders;
+        vec->len = hSize;
+    }
+    batch->nHeaders += hSize;
+
+    if (nSize)
+    {
+        vec = &batch->vecs[batch->nVecs++];
+        vec->base = data;
+        vec->offset = 0;
+        vec->len = nSize;
+    }
+
+    batch->nBytes += hSize + nSize;
+    return TRUE;
+}
+
+static int
+BatchKeepBody(RTMPBatch *batch, char *body)
+{
+    if (!BatchGrow((void **)&batch->bodies, &batch->nBodiesAlloc,
+                   batch->nBodies + 1, sizeof(char *)))
+        return FALSE;
+
+    batch->bodies[batch->nBodies++] = body;
+    return TRUE;
+}
+
+static void
+BatchReset(RTMPBatch *batch)
+{
+    int i;
+
+    for (i = 0; i < batch->nBodies; i++)
+        free(batch->bodies[i]);
+
+    batch->nBodies = 0;
+    batch->nVecs = 0;
+    batch->nHeaders = 0;
+    batch->nBytes = 0;
+    batch->bFailed = FALSE;
+}
+
+static inline const char *
+BatchVecData(const RTMPBatch *batch, const RTMPBatchVec *vec)
+{
+    return (vec->base ? vec->base : batch->headers) + vec->offset;
+}
+
+/* TLS, RTMPT and custom senders take a single buffer */
+static int
+BatchSendFlat(RTMP *r, RTMPBatch *batch)
+{
+    char *ptr;
+    int i;
+
+    if (batch->nBytes > batch->nFlatAlloc)
+    {
+        char *p = realloc(batch->flat, batch->nBytes);
+        if (!p)
+            return FALSE;
+        batch->flat = p;
+        batch->nFlatAlloc = batch->nBytes;
+    }
+
+    ptr = batch->flat;
+    for (i = 0; i < batch->nVecs; i++)
+    {
+        memcpy(ptr, BatchVecData(batch, &batch->vecs[i]), batch->vecs[i].len);
+        ptr += batch->vecs[i].len;
+    }
+
+    return WriteN(r, batch->flat, (int)batch->nBytes);
+}
+
+#define BATCH_MAX_IOV 64
+
+static int
+BatchSendVecs(RTMP *r, RTMPBatch *batch)
+{
+#ifdef _WIN32
+    WSABUF iov[BATCH_MAX_IOV];
+#else
+    struct iovec iov[BATCH_MAX_IOV];
+#endif
+    int idx = 0;
+    size_t skip = 0;
+
+    while (idx < batch->nVecs)
+    {
+        int i, n = 0;
+        long nBytes;
+
+        for (i = idx; i < batch->nVecs && n < BATCH_MAX_IOV; i++, n++)
+        {
+            const RTMPBatchVec *vec = &batch->vecs[i];
+            size_t offset = i == idx ? skip : 0;
+#ifdef _WIN32
+            iov[n].buf = (CHAR *)BatchVecData(batch, vec) + offset;
+            iov[n].len = (ULONG)(vec->len - offset);
+#else
+            iov[n].iov_base = (void *)(BatchVecData(batch, vec) + offset);
+            iov[n].iov_len = vec->len - offset;
+#endif
+        }
+
+#ifdef _WIN32
+        {
+            DWORD sent = 0;
+            nBytes = WSASend(r->m_sb.sb_socket, iov, n, &sent, 0, NULL, NULL) == 0
+                     ? (long)sent : -1;
+        }
+#else
+        {
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = n;
+            nBytes = (long)sendmsg(r->m_sb.sb_socket, &msg, MSG_NOSIGNAL);
+        }
+#endif
+
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d bytes)", __FUNCTION__,
+                     sockerr, (int)batch->nBytes);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            SendFailed(r, sockerr);
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        while (nBytes > 0)
+        {
+            size_t left = batch->vecs[idx].len - skip;
+            if ((size_t)nBytes >= left)
+            {
+                nBytes -= (long)left;
+                skip = 0;
+                idx++;
+            }
+            else
+            {
+                skip += nBytes;
+                nBytes = 0;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+void
+RTMP_BeginBatch(RTMP *r, RTMPBatch *batch)
+{
+    r->m_batch = batch;
+}
+
+/* Sends everything written since RTMP_BeginBatch and ends the batch */
+int
+RTMP_FlushBatch(RTMP *r)
+{
+    RTMPBatch *batch = r->m_batch;
+    int ret = TRUE;
+
+    r->m_batch = NULL;
+    if (!batch)
+        return TRUE;
+
+    if (batch->bFailed)
+    {
+        ret = FALSE;
+    }
+    else if (batch->nVecs)
+    {
+        int flat = r->m_bCustomSend && r->m_customSendFunc;
+#if defined(CRYPTO) && !defined(NO_SSL)
+        if (r->m_sb.sb_ssl)
+            flat = TRUE;
+#endif
+#if defined(RTMP_NETSTACK_DUMP)
+        flat = TRUE;
+#endif
+        ret = flat ? BatchSendFlat(r, batch) : BatchSendVecs(r, batch);
+    }
+
+    BatchReset(batch);
+    return ret;
+}
+
+void
+RTMP_FreeBatch(RTMPBatch *batch)
+{
+    BatchReset(batch);
+    free(batch->vecs);
+    free(batch->headers);
+    free(batch->bodies);
+    free(batch->flat);
+    memset(batch, 0, sizeof(*batch));
+}
+
 int
 RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
 {
     RTMPPacket *pkt = &r->m_write;
+    RTMPBatch *batch = r->m_batch;
     char *enc;
     int s2 = size, ret, num;
 
+    /* RTMPT already sends each message in a single request */
+    if (r->Link.protocol & RTMP_FEATURE_HTTP)
+        batch = NULL;
+
     pkt->m_nChannel = 0x04;	/* source channel */
     pkt->m_nInfoField2 = r->Link.streams[streamIdx].id;
 
@@ -5380,7 +5666,17 @@ RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
         buf += num;
         if (pkt->m_nBytesRead == pkt->m_nBodySize)
         {
-            ret = RTMP_SendPacket(r, pkt, FALSE);
+            ret = SendPacket(r, pkt, FALSE, batch);
+            if (batch)
+            {
+                /* the batch references the body until it is flushed */
+                if (ret)
+                    ret = BatchKeepBody(batch, pkt->m_body - RTMP_MAX_HEADER_SIZE);
+                if (ret)
+                    pkt->m_body = NULL;
+                else
+                    batch->bFailed = TRUE;
+            }
             RTMPPacket_Free(pkt);
             pkt->m_nBytesRead = 0;
             if (!ret)
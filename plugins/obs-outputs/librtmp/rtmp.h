@@ -397,6 +397,37 @@ extern "C"
 
     typedef int (*CUSTOMSEND)(RTMPSockBuf*, const char *, int, void*);
 
+    /* While a batch is active, messages written with RTMP_Write are chunked
+     * into a gather list and sent together by RTMP_FlushBatch. The chunk
+     * headers live in the batch, the payloads are referenced in place. */
+    typedef struct RTMPBatchVec
+    {
+        const char *base;	/* NULL for data in the header buffer */
+        size_t offset;
+        size_t len;
+    } RTMPBatchVec;
+
+    typedef struct RTMPBatch
+    {
+        RTMPBatchVec *vecs;
+        int nVecs;
+        int nVecsAlloc;
+
+        char *headers;
+        size_t nHeaders;
+        size_t nHeadersAlloc;
+
+        char **bodies;		/* packet bodies owned until the flush */
+        int nBodies;
+        int nBodiesAlloc;
+
+        char *flat;		/* contiguous copy for TLS, HTTP and custom sends */
+        size_t nFlatAlloc;
+
+        size_t nBytes;
+        int bFailed;
+    } RTMPBatch;
+
     typedef struct RTMP
     {
         int m_inChunkSize;
@@ -454,6 +485,7 @@ extern "C"
         RTMP_LNK Link;
         int connect_time_ms;
         int last_error_code;
+        RTMPBatch *m_batch;
 
 #ifdef CRYPTO
         TLS_CTX RTMP_TLS_ctx;
@@ -544,6 +576,10 @@ extern "C"
     int RTMP_Read(RTMP *r, char *buf, int size);
     int RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx);
 
+    void RTMP_BeginBatch(RTMP *r, RTMPBatch *batch);
+    int RTMP_FlushBatch(RTMP *r);
+    void RTMP_FreeBatch(RTMPBatch *batch);
+
 #ifdef USE_HASHSWF
     /* hashswf.c */
     int RTMP_HashSWF(const char *url, unsigned int *size, unsigned char *hash,
@@ -22,6 +22,7 @@
 #include <util/darray.h>
 #include <util/deque.h>
 #include <util/serializer.h>
+#include <util/array-serializer.h>
 
 /* Flavour for target compatibility */
 enum mp4_flavour {
@@ -78,6 +79,7 @@ struct fragment_sample {
 	uint32_t size;
 	int32_t offset;
 	uint32_t duration;
+	bool keyframe;
 };
 
 struct mp4_track {
@@ -148,6 +150,15 @@ struct mp4_mux {
 	/* Offset of placeholder atom/box to contain final mdat header */
 	size_t placeholder_offset;
 
+	/* CMAF mode: fragments are cut at least every fragment_duration and
+	 * handed to the callback instead of being written to a file. */
+	int64_t fragment_duration;
+	int64_t fragment_start_pts;
+	mp4_mux_fragment_cb fragment_cb;
+	void *fragment_param;
+	struct serializer fragment_serializer;
+	struct array_output_data fragment_data;
+
 	uint8_t track_ctr;
 	/* Audio/Video tracks */
 	DARRAY(struct mp4_track) tracks;
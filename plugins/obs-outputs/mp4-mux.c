@@ -112,6 +112,10 @@ static size_t mp4_write_ftyp(struct mp4_mux *mux, bool fragmented)
 
 	s_write(s, "iso2", 4);
 
+	/* CMAF track format brand */
+	if (mux->mode == CMAF)
+		s_write(s, "cmfc", 4);
+
 	/* Include H.264 brand if used */
 	for (size_t i = 0; i < mux->tracks.num; i++) {
 		struct mp4_track *track = &mux->tracks.array[i];
@@ -1991,7 +1995,14 @@ static size_t mp4_write_tfhd(struct mp4_mux *mux, struct mp4_track *track, size_
 	struct serializer *s = mux->serializer;
 	int64_t start = serializer_get_pos(s);
 
-	uint32_t flags = BASE_DATA_OFFSET_PRESENT | DEFAULT_SAMPLE_FLAGS_PRESENT;
+	uint32_t flags = DEFAULT_SAMPLE_FLAGS_PRESENT;
+
+	/* CMAF fragments are delivered on their own, so offsets have to be
+	 * relative to the moof rather than to the start of the file. */
+	if (mux->mode == CMAF)
+		flags |= DEFAULT_BASE_IS_MOOF;
+	else
+		flags |= BASE_DATA_OFFSET_PRESENT;
 
 	/* Add default size/duration if all samples match. */
 	bool durations_match = true;
@@ -2023,7 +2034,8 @@ static size_t mp4_write_tfhd(struct mp4_mux *mux, struct mp4_track *track, size_
 	write_fullbox(s, 0, "tfhd", 0, flags);
 
 	s_wb32(s, track->track_id); // track_ID
-	s_wb64(s, moof_start);      // base_data_offset
+	if (flags & BASE_DATA_OFFSET_PRESENT)
+		s_wb64(s, moof_start); // base_data_offset
 
 	// default_sample_duration
 	if (durations_match) {
@@ -2112,8 +2124,14 @@ static size_t mp4_write_trun(struct mp4_mux *mux, struct mp4_track *track, uint3
 	if (track->sample_size)
 		return write_box_size(s, start);
 
-	if (track->type == TRACK_VIDEO)
-		s_wb32(s, SAMPLE_FLAG_DEPENDS_NO); // first_sample_flags
+	// first_sample_flags
+	if (track->type == TRACK_VIDEO) {
+		/* Fragments in CMAF mode may be cut between keyframes */
+		if (track->fragment_samples.array[0].keyframe)
+			s_wb32(s, SAMPLE_FLAG_DEPENDS_NO);
+		else
+			s_wb32(s, SAMPLE_FLAG_DEPENDS_YES | SAMPLE_FLAG_IS_NON_SYNC);
+	}
 
 	for (size_t idx = 0; idx < sample_count; idx++) {
 		struct fragment_sample *smp = &track->fragment_samples.array[idx];
@@ -2276,6 +2294,7 @@ static void process_packets(struct mp4_mux *mux, struct mp4_track *track, uint64
 		smp->size = size;
 		smp->offset = offset;
 		smp->duration = duration;
+		smp->keyframe = pkt->keyframe;
 
 		*mdat_size += size;
 
@@ -2357,6 +2376,31 @@ static void write_packets(struct mp4_mux *mux, struct mp4_track *track)
 	da_clear(track->fragment_samples);
 }
 
+static void emit_fragment(struct mp4_mux *mux, struct mp4_mux_fragment *fragment)
+{
+	fragment->data = mux->fragment_data.bytes.array;
+	fragment->size = mux->fragment_data.bytes.num;
+
+	mux->fragment_cb(mux->fragment_param, fragment);
+	array_output_serializer_reset(&mux->fragment_data);
+}
+
+/* Timing of the fragment, based on the primary (first) track */
+static void get_fragment_info(struct mp4_mux *mux, struct mp4_mux_fragment *fragment)
+{
+	struct mp4_track *track = &mux->tracks.array[0];
+	uint64_t duration = 0;
+
+	for (size_t i = 0; i < track->fragment_samples.num; i++)
+		duration += track->fragment_samples.array[i].duration;
+
+	fragment->sequence = mux->fragments_written;
+	fragment->start_usec = (int64_t)util_mul_div64(track->duration - duration, 1000000, track->timebase_den);
+	fragment->duration_usec = (int64_t)util_mul_div64(duration, 1000000, track->timebase_den);
+	fragment->independent = track->type != TRACK_VIDEO ||
+				(track->fragment_samples.num && track->fragment_samples.array[0].keyframe);
+}
+
 static void mp4_flush_fragment(struct mp4_mux *mux)
 {
 	struct serializer *s = mux->serializer;
@@ -2365,8 +2409,10 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 	if (!mux->fragments_written) {
 		mp4_write_ftyp(mux, true);
 		/* Placeholder to write mdat header during soft-remux */
-		mux->placeholder_offset = serializer_get_pos(s);
-		mp4_write_free(mux);
+		if (mux->mode != CMAF) {
+			mux->placeholder_offset = serializer_get_pos(s);
+			mp4_write_free(mux);
+		}
 	}
 
 	// Array output as temporary buffer to avoid sending seeks to disk
@@ -2380,6 +2426,12 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 		mp4_write_moov(mux, true);
 		s_write(s, aod.bytes.array, aod.bytes.num);
 		array_output_serializer_reset(&aod);
+
+		/* ftyp + moov make up the CMAF initialisation segment */
+		if (mux->mode == CMAF) {
+			struct mp4_mux_fragment init = {.init = true};
+			emit_fragment(mux, &init);
+		}
 	}
 
 	mux->fragments_written++;
@@ -2404,6 +2456,10 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 		process_packets(mux, mux->chapter_track, &mdat_size);
 	}
 
+	struct mp4_mux_fragment fragment = {0};
+	if (mux->mode == CMAF)
+		get_fragment_info(mux, &fragment);
+
 	// write moof once to get size
 	int64_t moof_start = serializer_get_pos(s);
 	size_t moof_size = mp4_write_moof(mux, 0, moof_start);
@@ -2439,6 +2495,10 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 	if (!mux->next_frag_pts && mux->chapter_track)
 		write_packets(mux, mux->chapter_track);
 
+	if (mux->mode == CMAF)
+		emit_fragment(mux, &fragment);
+
+	mux->fragment_start_pts = mux->next_frag_pts;
 	mux->next_frag_pts = 0;
 }
 
@@ -2610,11 +2670,30 @@ struct mp4_mux *mp4_mux_create(obs_output_t *output, struct serializer *serializ
 	return mux;
 }
 
+struct mp4_mux *mp4_mux_create_cmaf(obs_output_t *output, enum mp4_mux_flags flags, int64_t fragment_duration_usec,
+				    mp4_mux_fragment_cb callback, void *param)
+{
+	struct mp4_mux *mux = mp4_mux_create(output, NULL, flags | MP4_SKIP_FINALISATION);
+
+	mux->mode = CMAF;
+	mux->fragment_duration = fragment_duration_usec;
+	mux->fragment_cb = callback;
+	mux->fragment_param = param;
+
+	array_output_serializer_init(&mux->fragment_serializer, &mux->fragment_data);
+	mux->serializer = &mux->fragment_serializer;
+
+	return mux;
+}
+
 void mp4_mux_destroy(struct mp4_mux *mux)
 {
 	for (size_t i = 0; i < mux->tracks.num; i++)
 		free_track(&mux->tracks.array[i]);
 
+	if (mux->mode == CMAF)
+		array_output_serializer_free(&mux->fragment_data);
+
 	free_track(mux->chapter_track);
 	bfree(mux->chapter_track);
 	da_free(mux->tracks);
@@ -2665,6 +2744,14 @@ bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt)
 		}
 	}
 
+	/* In CMAF mode also cut fragments between keyframes once the primary
+	 * track has reached the target fragment duration. */
+	if (mux->fragment_duration && track == mux->tracks.array && !mux->next_frag_pts) {
+		int64_t pts_usec = packet_pts_usec(&parsed_packet);
+		if (pts_usec - mux->fragment_start_pts >= mux->fragment_duration)
+			mux->next_frag_pts = pts_usec;
+	}
+
 	track_insert_packet(track, &parsed_packet);
 
 	return true;
@@ -2705,6 +2792,10 @@ bool mp4_mux_finalise(struct mp4_mux *mux)
 
 	info("Number of fragments: %u", mux->fragments_written);
 
+	/* Fragments have already been handed off, there is no file to fix up */
+	if (mux->mode == CMAF)
+		return true;
+
 	if (mux->flags & MP4_SKIP_FINALISATION) {
 		warn("Skipping MP4 finalization!");
 		return true;
@@ -33,7 +33,25 @@ enum mp4_mux_flags {
 	MP4_USE_NEGATIVE_CTS = 1 << 3,
 };
 
+/* Fragment emitted by a muxer in CMAF mode. The initialisation segment
+ * (ftyp + moov) is emitted once before the first media fragment. */
+struct mp4_mux_fragment {
+	const uint8_t *data;
+	size_t size;
+
+	bool init;
+	/* Fragment starts with a keyframe and can begin a new segment */
+	bool independent;
+	uint32_t sequence;
+	int64_t start_usec;
+	int64_t duration_usec;
+};
+
+typedef void (*mp4_mux_fragment_cb)(void *param, const struct mp4_mux_fragment *fragment);
+
 struct mp4_mux *mp4_mux_create(obs_output_t *output, struct serializer *serializer, enum mp4_mux_flags flags);
+struct mp4_mux *mp4_mux_create_cmaf(obs_output_t *output, enum mp4_mux_flags flags, int64_t fragment_duration_usec,
+				    mp4_mux_fragment_cb callback, void *param);
 void mp4_mux_destroy(struct mp4_mux *mux);
 bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt);
 bool mp4_mux_add_chapter(struct mp4_mux *mux, int64_t dts_usec, const char *name);
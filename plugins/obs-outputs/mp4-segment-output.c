@@ -0,0 +1,492 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mp4-mux.h"
+
+#include <inttypes.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+
+/*
+ * CMAF segmenter: writes fMP4 fragments of a configurable duration into
+ * rolling segment files next to an LL-HLS playlist, and hands every fragment
+ * to the "fragment" signal for consumers that serve it directly.
+ */
+
+#define do_log(level, format, ...) \
+	blog(level, "[mp4 segment output: '%s'] " format, obs_output_get_name(out->output), ##__VA_ARGS__)
+
+#define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+
+/* Fragment within a segment file, listed as an LL-HLS partial segment */
+struct segment_part {
+	uint64_t offset;
+	uint64_t size;
+	int64_t duration_usec;
+	bool independent;
+};
+
+struct segment {
+	uint32_t index;
+	int64_t duration_usec;
+	DARRAY(struct segment_part) parts;
+};
+
+struct mp4_segment_output {
+	obs_output_t *output;
+
+	struct dstr directory;
+	struct dstr prefix;
+	int64_t segment_duration;
+	int64_t fragment_duration;
+	size_t playlist_size;
+
+	volatile bool active;
+	volatile bool stopping;
+	uint64_t stop_ts;
+
+	pthread_mutex_t mutex;
+
+	struct mp4_mux *muxer;
+
+	FILE *file;
+	uint64_t file_size;
+	struct segment current;
+	/* Completed segments still listed in the playlist */
+	DARRAY(struct segment) segments;
+	uint32_t next_index;
+	int64_t target_duration;
+
+	uint64_t total_bytes;
+	bool write_error;
+};
+
+static inline bool stopping(struct mp4_segment_output *out)
+{
+	return os_atomic_load_bool(&out->stopping);
+}
+
+static inline bool active(struct mp4_segment_output *out)
+{
+	return os_atomic_load_bool(&out->active);
+}
+
+static inline void get_segment_path(struct mp4_segment_output *out, struct dstr *dst, uint32_t index)
+{
+	dstr_printf(dst, "%s/%s%" PRIu32 ".m4s", out->directory.array, out->prefix.array, index);
+}
+
+static inline void get_segment_name(struct mp4_segment_output *out, struct dstr *dst, uint32_t index)
+{
+	dstr_printf(dst, "%s%" PRIu32 ".m4s", out->prefix.array, index);
+}
+
+static const char *mp4_segment_output_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("MP4SegmentOutput");
+}
+
+static void *mp4_segment_output_create(obs_data_t *settings, obs_output_t *output)
+{
+	struct mp4_segment_output *out = bzalloc(sizeof(struct mp4_segment_output));
+	out->output = output;
+	pthread_mutex_init(&out->mutex, NULL);
+
+	signal_handler_t *sh = obs_output_get_signal_handler(output);
+	signal_handler_add(sh, "void fragment(ptr data, int size, bool init, bool independent, int sequence)");
+	signal_handler_add(sh, "void segment_complete(string file)");
+
+	UNUSED_PARAMETER(settings);
+	return out;
+}
+
+static inline void free_segment(struct segment *segment)
+{
+	da_free(segment->parts);
+}
+
+static void free_segments(struct mp4_segment_output *out)
+{
+	for (size_t i = 0; i < out->segments.num; i++)
+		free_segment(&out->segments.array[i]);
+	da_free(out->segments);
+
+	free_segment(&out->current);
+	memset(&out->current, 0, sizeof(out->current));
+}
+
+static void mp4_segment_output_destroy(void *data)
+{
+	struct mp4_segment_output *out = data;
+
+	free_segments(out);
+	pthread_mutex_destroy(&out->mutex);
+	dstr_free(&out->directory);
+	dstr_free(&out->prefix);
+	bfree(out);
+}
+
+/* ========================================================================== */
+/* Playlist                                                                   */
+
+static inline double usec_to_sec(int64_t usec)
+{
+	return (double)usec / 1000000.0;
+}
+
+static void write_parts(struct mp4_segment_output *out, struct dstr *m3u8, struct segment *segment)
+{
+	struct dstr name = {0};
+	get_segment_name(out, &name, segment->index);
+
+	for (size_t i = 0; i < segment->parts.num; i++) {
+		struct segment_part *part = &segment->parts.array[i];
+		dstr_catf(m3u8, "#EXT-X-PART:DURATION=%.5f,URI=\"%s\",BYTERANGE=%" PRIu64 "@%" PRIu64 "%s\n",
+			  usec_to_sec(part->duration_usec), name.array, part->size, part->offset,
+			  part->independent ? ",INDEPENDENT=YES" : "");
+	}
+
+	dstr_free(&name);
+}
+
+static void write_playlist(struct mp4_segment_output *out, bool end)
+{
+	struct dstr m3u8 = {0};
+	struct dstr name = {0};
+	struct dstr path = {0};
+
+	uint32_t media_sequence = out->segments.num ? out->segments.array[0].index : out->current.index;
+	double part_target = usec_to_sec(out->fragment_duration);
+
+	dstr_cat(&m3u8, "#EXTM3U\n");
+	dstr_cat(&m3u8, "#EXT-X-VERSION:9\n");
+	dstr_catf(&m3u8, "#EXT-X-TARGETDURATION:%" PRId64 "\n", out->target_duration);
+	dstr_catf(&m3u8, "#EXT-X-PART-INF:PART-TARGET=%.5f\n", part_target);
+	dstr_catf(&m3u8, "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%.5f\n", part_target * 3.0);
+	dstr_catf(&m3u8, "#EXT-X-MEDIA-SEQUENCE:%" PRIu32 "\n", media_sequence);
+	dstr_catf(&m3u8, "#EXT-X-MAP:URI=\"%sinit.mp4\"\n", out->prefix.array);
+
+	for (size_t i = 0; i < out->segments.num; i++) {
+		struct segment *segment = &out->segments.array[i];
+
+		/* Only keep parts of the most recent segments around */
+		if (!end && i + 2 >= out->segments.num)
+			write_parts(out, &m3u8, segment);
+
+		get_segment_name(out, &name, segment->index);
+		dstr_catf(&m3u8, "#EXTINF:%.5f,\n%s\n", usec_to_sec(segment->duration_usec), name.array);
+	}
+
+	if (end)
+		dstr_cat(&m3u8, "#EXT-X-ENDLIST\n");
+	else
+		write_parts(out, &m3u8, &out->current);
+
+	dstr_printf(&path, "%s/%s.m3u8", out->directory.array, out->prefix.array);
+	if (!os_quick_write_utf8_file_safe(path.array, m3u8.array, m3u8.len, false, "tmp", NULL))
+		warn("Unable to write playlist '%s'", path.array);
+
+	dstr_free(&path);
+	dstr_free(&name);
+	dstr_free(&m3u8);
+}
+
+/* ========================================================================== */
+/* Segment files                                                              */
+
+static void close_segment(struct mp4_segment_output *out)
+{
+	if (!out->file)
+		return;
+
+	fclose(out->file);
+	out->file = NULL;
+
+	int64_t duration_sec = (out->current.duration_usec + 999999) / 1000000;
+	if (duration_sec > out->target_duration)
+		out->target_duration = duration_sec;
+
+	da_push_back(out->segments, &out->current);
+	memset(&out->current, 0, sizeof(out->current));
+
+	struct dstr path = {0};
+	get_segment_path(out, &path, out->segments.array[out->segments.num - 1].index);
+
+	calldata_t cd = {0};
+	signal_handler_t *sh = obs_output_get_signal_handler(out->output);
+	calldata_set_string(&cd, "file", path.array);
+	signal_handler_signal(sh, "segment_complete", &cd);
+	calldata_free(&cd);
+
+	/* Remove segments that dropped out of the playlist window */
+	while (out->playlist_size && out->segments.num > out->playlist_size) {
+		get_segment_path(out, &path, out->segments.array[0].index);
+		os_unlink(path.array);
+
+		free_segment(&out->segments.array[0]);
+		da_erase(out->segments, 0);
+	}
+
+	dstr_free(&path);
+}
+
+static bool open_segment(struct mp4_segment_output *out)
+{
+	struct dstr path = {0};
+
+	out->current.index = out->next_index++;
+	get_segment_path(out, &path, out->current.index);
+
+	out->file = os_fopen(path.array, "wb");
+	out->file_size = 0;
+	if (!out->file)
+		warn("Unable to open segment file '%s'", path.array);
+
+	dstr_free(&path);
+	return out->file != NULL;
+}
+
+static void write_init_segment(struct mp4_segment_output *out, const struct mp4_mux_fragment *fragment)
+{
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/%sinit.mp4", out->directory.array, out->prefix.array);
+
+	FILE *file = os_fopen(path.array, "wb");
+	if (!file || fwrite(fragment->data, 1, fragment->size, file) != fragment->size) {
+		warn("Unable to write initialisation segment '%s'", path.array);
+		out->write_error = true;
+	}
+
+	if (file)
+		fclose(file);
+	dstr_free(&path);
+}
+
+static void write_fragment(struct mp4_segment_output *out, const struct mp4_mux_fragment *fragment)
+{
+	/* Segments have to start with an independent fragment */
+	bool new_segment = !out->file || out->current.duration_usec >= out->segment_duration;
+	if (new_segment && fragment->independent) {
+		close_segment(out);
+		if (!open_segment(out)) {
+			out->write_error = true;
+			return;
+		}
+	}
+
+	if (!out->file)
+		return;
+
+	if (fwrite(fragment->data, 1, fragment->size, out->file) != fragment->size) {
+		warn("Failed to write fragment %" PRIu32, fragment->sequence);
+		out->write_error = true;
+		return;
+	}
+	fflush(out->file);
+
+	struct segment_part *part = da_push_back_new(out->current.parts);
+	part->offset = out->file_size;
+	part->size = fragment->size;
+	part->duration_usec = fragment->duration_usec;
+	part->independent = fragment->independent;
+
+	out->file_size += fragment->size;
+	out->current.duration_usec += fragment->duration_usec;
+}
+
+static void mp4_segment_fragment(void *param, const struct mp4_mux_fragment *fragment)
+{
+	struct mp4_segment_output *out = param;
+
+	if (fragment->init)
+		write_init_segment(out, fragment);
+	else if (fragment->size)
+		write_fragment(out, fragment);
+
+	out->total_bytes += fragment->size;
+
+	calldata_t cd = {0};
+	signal_handler_t *sh = obs_output_get_signal_handler(out->output);
+	calldata_set_ptr(&cd, "data", (void *)fragment->data);
+	calldata_set_int(&cd, "size", (long long)fragment->size);
+	calldata_set_bool(&cd, "init", fragment->init);
+	calldata_set_bool(&cd, "independent", fragment->independent);
+	calldata_set_int(&cd, "sequence", fragment->sequence);
+	signal_handler_signal(sh, "fragment", &cd);
+	calldata_free(&cd);
+
+	if (!fragment->init && out->file)
+		write_playlist(out, false);
+}
+
+/* ========================================================================== */
+/* Output                                                                     */
+
+static bool mp4_segment_output_start(void *data)
+{
+	struct mp4_segment_output *out = data;
+
+	if (!obs_output_can_begin_data_capture(out->output, 0))
+		return false;
+	if (!obs_output_initialize_encoders(out->output, 0))
+		return false;
+
+	os_atomic_set_bool(&out->stopping, false);
+
+	obs_data_t *settings = obs_output_get_settings(out->output);
+	dstr_copy(&out->directory, obs_data_get_string(settings, "directory"));
+	dstr_copy(&out->prefix, obs_data_get_string(settings, "prefix"));
+	out->segment_duration = obs_data_get_int(settings, "segment_duration_ms") * 1000;
+	out->fragment_duration = obs_data_get_int(settings, "fragment_duration_ms") * 1000;
+	out->playlist_size = (size_t)obs_data_get_int(settings, "playlist_size");
+	obs_data_release(settings);
+
+	if (dstr_is_empty(&out->directory)) {
+		warn("Output directory not specified");
+		return false;
+	}
+
+	dstr_replace(&out->directory, "\\", "/");
+	if (dstr_end(&out->directory) == '/')
+		dstr_resize(&out->directory, out->directory.len - 1);
+	os_mkdirs(out->directory.array);
+
+	if (out->fragment_duration <= 0)
+		out->fragment_duration = 500000;
+	if (out->segment_duration < out->fragment_duration)
+		out->segment_duration = out->fragment_duration;
+
+	free_segments(out);
+	out->next_index = 0;
+	out->target_duration = (out->segment_duration + 999999) / 1000000;
+	out->total_bytes = 0;
+	out->write_error = false;
+
+	out->muxer = mp4_mux_create_cmaf(out->output, MP4_USE_NEGATIVE_CTS, out->fragment_duration,
+					 mp4_segment_fragment, out);
+	os_atomic_set_bool(&out->active, true);
+	obs_output_begin_data_capture(out->output, 0);
+
+	info("Writing CMAF segments to '%s' (segments: %" PRId64 " ms, fragments: %" PRId64 " ms)",
+	     out->directory.array, out->segment_duration / 1000, out->fragment_duration / 1000);
+	return true;
+}
+
+static void mp4_segment_output_stop(void *data, uint64_t ts)
+{
+	struct mp4_segment_output *out = data;
+	out->stop_ts = ts / 1000;
+	os_atomic_set_bool(&out->stopping, true);
+}
+
+static void mp4_mux_destroy_task(void *ptr)
+{
+	struct mp4_mux *muxer = ptr;
+	mp4_mux_destroy(muxer);
+}
+
+static void mp4_segment_output_actual_stop(struct mp4_segment_output *out, int code)
+{
+	os_atomic_set_bool(&out->active, false);
+
+	/* Flushes the remaining packets through the fragment callback */
+	mp4_mux_finalise(out->muxer);
+
+	close_segment(out);
+	write_playlist(out, true);
+
+	if (code) {
+		obs_output_signal_stop(out->output, code);
+	} else {
+		obs_output_end_data_capture(out->output);
+	}
+
+	obs_queue_task(OBS_TASK_DESTROY, mp4_mux_destroy_task, out->muxer, false);
+	out->muxer = NULL;
+
+	info("CMAF output complete, %" PRIu32 " segments written", out->next_index);
+}
+
+static void mp4_segment_output_packet(void *data, struct encoder_packet *packet)
+{
+	struct mp4_segment_output *out = data;
+
+	pthread_mutex_lock(&out->mutex);
+
+	if (!active(out))
+		goto unlock;
+
+	if (!packet) {
+		mp4_segment_output_actual_stop(out, OBS_OUTPUT_ENCODE_ERROR);
+		goto unlock;
+	}
+
+	if (stopping(out)) {
+		if (packet->sys_dts_usec >= (int64_t)out->stop_ts) {
+			mp4_segment_output_actual_stop(out, 0);
+			goto unlock;
+		}
+	}
+
+	mp4_mux_submit_packet(out->muxer, packet);
+
+	if (out->write_error)
+		mp4_segment_output_actual_stop(out, OBS_OUTPUT_ERROR);
+
+unlock:
+	pthread_mutex_unlock(&out->mutex);
+}
+
+static void mp4_segment_output_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_string(settings, "prefix", "stream");
+	obs_data_set_default_int(settings, "segment_duration_ms", 2000);
+	obs_data_set_default_int(settings, "fragment_duration_ms", 500);
+	obs_data_set_default_int(settings, "playlist_size", 6);
+}
+
+static obs_properties_t *mp4_segment_output_properties(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	obs_properties_t *props = obs_properties_create();
+
+	obs_properties_add_path(props, "directory", obs_module_text("MP4SegmentOutput.Directory"), OBS_PATH_DIRECTORY,
+				NULL, NULL);
+	obs_properties_add_text(props, "prefix", obs_module_text("MP4SegmentOutput.Prefix"), OBS_TEXT_DEFAULT);
+	obs_properties_add_int(props, "segment_duration_ms", obs_module_text("MP4SegmentOutput.SegmentDuration"), 100,
+			       60000, 100);
+	obs_properties_add_int(props, "fragment_duration_ms", obs_module_text("MP4SegmentOutput.FragmentDuration"),
+			       50, 10000, 50);
+	obs_properties_add_int(props, "playlist_size", obs_module_text("MP4SegmentOutput.PlaylistSize"), 0, 1000, 1);
+	return props;
+}
+
+static uint64_t mp4_segment_output_total_bytes(void *data)
+{
+	struct mp4_segment_output *out = data;
+	return out->total_bytes;
+}
+
+struct obs_output_info mp4_segment_output_info = {
+	.id = "mp4_segment_output",
+	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_MULTI_TRACK_AV,
+	.encoded_video_codecs = "h264;hevc;av1",
+	.encoded_audio_codecs = "aac;opus",
+	.get_name = mp4_segment_output_name,
+	.create = mp4_segment_output_create,
+	.destroy = mp4_segment_output_destroy,
+	.start = mp4_segment_output_start,
+	.stop = mp4_segment_output_stop,
+	.encoded_packet = mp4_segment_output_packet,
+	.get_defaults = mp4_segment_output_defaults,
+	.get_properties = mp4_segment_output_properties,
+	.get_total_bytes = mp4_segment_output_total_bytes,
+};
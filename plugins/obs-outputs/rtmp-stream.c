@@ -136,6 +136,8 @@ static void rtmp_stream_destroy(void *data)
 #endif
 	deque_free(&stream->dbr_frames);
 	pthread_mutex_destroy(&stream->dbr_mutex);
+	pthread_mutex_destroy(&stream->batch_stats_mutex);
+	RTMP_FreeBatch(&stream->batch);
 
 	os_event_destroy(stream->buffer_space_available_event);
 	os_event_destroy(stream->buffer_has_data_event);
@@ -148,6 +150,21 @@ static void rtmp_stream_destroy(void *data)
 	bfree(stream);
 }
 
+static void get_send_stats_proc(void *data, calldata_t *cd)
+{
+	struct rtmp_stream *stream = data;
+
+	pthread_mutex_lock(&stream->batch_stats_mutex);
+	calldata_set_int(cd, "batches", (long long)stream->batch_count);
+	calldata_set_int(cd, "packets", (long long)stream->batch_packets);
+	calldata_set_int(cd, "bytes", (long long)stream->batch_bytes);
+	calldata_set_int(cd, "max_batch_bytes", (long long)stream->batch_max_bytes);
+	calldata_set_int(cd, "avg_send_usec",
+			 stream->batch_count ? (long long)(stream->batch_send_ns / stream->batch_count / 1000) : 0);
+	calldata_set_int(cd, "max_send_usec", (long long)(stream->batch_max_send_ns / 1000));
+	pthread_mutex_unlock(&stream->batch_stats_mutex);
+}
+
 static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
@@ -172,6 +189,11 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	}
 
+	if (pthread_mutex_init(&stream->batch_stats_mutex, NULL) != 0) {
+		warn("Failed to initialize batch stats mutex");
+		goto fail;
+	}
+
 	if (os_event_init(&stream->buffer_space_available_event, OS_EVENT_TYPE_AUTO) != 0) {
 		warn("Failed to initialize write buffer event");
 		goto fail;
@@ -189,6 +211,12 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	}
 
+	proc_handler_t *ph = obs_output_get_proc_handler(output);
+	proc_handler_add(ph,
+			 "void get_send_stats(out int batches, out int packets, out int bytes, "
+			 "out int max_batch_bytes, out int avg_send_usec, out int max_send_usec)",
+			 get_send_stats_proc, stream);
+
 	UNUSED_PARAMETER(settings);
 	return stream;
 
@@ -626,6 +654,36 @@ static void log_sndbuf_size(struct rtmp_stream *stream)
 }
 #endif
 
+/* upper bound for a batch, enough for a large keyframe plus audio */
+#define MAX_BATCH_BYTES (2 * 1024 * 1024)
+
+static int send_stream_packet(struct rtmp_stream *stream, struct encoder_packet *packet)
+{
+	if (packet->type == OBS_ENCODER_VIDEO &&
+	    (stream->video_codec[packet->track_idx] != CODEC_H264 ||
+	     (stream->video_codec[packet->track_idx] == CODEC_H264 && packet->track_idx != 0))) {
+		return send_packet_ex(stream, packet, false, false, packet->track_idx);
+	} else if (packet->type == OBS_ENCODER_AUDIO && packet->track_idx != 0) {
+		return send_audio_packet_ex(stream, packet, false, packet->track_idx);
+	} else {
+		return send_packet(stream, packet, false);
+	}
+}
+
+static void update_batch_stats(struct rtmp_stream *stream, size_t packets, size_t bytes, uint64_t send_ns)
+{
+	pthread_mutex_lock(&stream->batch_stats_mutex);
+	stream->batch_count++;
+	stream->batch_packets += packets;
+	stream->batch_bytes += bytes;
+	stream->batch_send_ns += send_ns;
+	if (bytes > stream->batch_max_bytes)
+		stream->batch_max_bytes = bytes;
+	if (send_ns > stream->batch_max_send_ns)
+		stream->batch_max_send_ns = send_ns;
+	pthread_mutex_unlock(&stream->batch_stats_mutex);
+}
+
 static void *send_thread(void *data)
 {
 	struct rtmp_stream *stream = data;
@@ -639,6 +697,11 @@ static void *send_thread(void *data)
 	while (os_sem_wait(stream->send_sem) == 0) {
 		struct encoder_packet packet;
 		struct dbr_frame dbr_frame;
+		size_t num_packets = 0;
+		size_t batch_bytes;
+		uint64_t send_beg;
+		bool shutdown = false;
+		bool failed = false;
 
 		if (stopping(stream) && stream->stop_ts == 0) {
 			break;
@@ -657,31 +720,55 @@ static void *send_thread(void *data)
 		if (!stream->sent_headers) {
 			if (!send_headers(stream)) {
 				os_atomic_set_bool(&stream->disconnected, true);
+				obs_encoder_packet_release(&packet);
 				break;
 			}
 		}
 
-		if (stream->dbr_enabled) {
-			dbr_frame.send_beg = os_gettime_ns();
-			dbr_frame.size = packet.size;
-		}
+		send_beg = os_gettime_ns();
+		dbr_frame.send_beg = send_beg;
+		dbr_frame.size = 0;
 
-		int sent;
-		if (packet.type == OBS_ENCODER_VIDEO &&
-		    (stream->video_codec[packet.track_idx] != CODEC_H264 ||
-		     (stream->video_codec[packet.track_idx] == CODEC_H264 && packet.track_idx != 0))) {
-			sent = send_packet_ex(stream, &packet, false, false, packet.track_idx);
-		} else if (packet.type == OBS_ENCODER_AUDIO && packet.track_idx != 0) {
-			sent = send_audio_packet_ex(stream, &packet, false, packet.track_idx);
-		} else {
-			sent = send_packet(stream, &packet, false);
+		if (stream->batch_send)
+			RTMP_BeginBatch(&stream->rtmp, &stream->batch);
+
+		/* Drain whatever is already queued into the batch. Nothing is
+		 * waited for, so batches only grow when the socket falls behind
+		 * and a single packet goes out on its own otherwise. */
+		for (;;) {
+			dbr_frame.size += packet.size;
+
+			if (send_stream_packet(stream, &packet) < 0) {
+				failed = true;
+				break;
+			}
+
+			num_packets++;
+
+			if (!stream->batch_send || stream->batch.nBytes >= MAX_BATCH_BYTES)
+				break;
+			if (!get_next_packet(stream, &packet))
+				break;
+
+			if (stopping(stream) && can_shutdown_stream(stream, &packet)) {
+				obs_encoder_packet_release(&packet);
+				shutdown = true;
+				break;
+			}
 		}
 
-		if (sent < 0) {
+		batch_bytes = stream->batch.nBytes;
+		if (stream->batch_send && !RTMP_FlushBatch(&stream->rtmp))
+			failed = true;
+
+		if (failed) {
 			os_atomic_set_bool(&stream->disconnected, true);
 			break;
 		}
 
+		if (stream->batch_send)
+			update_batch_stats(stream, num_packets, batch_bytes, os_gettime_ns() - send_beg);
+
 		if (stream->dbr_enabled) {
 			dbr_frame.send_end = os_gettime_ns();
 
@@ -689,6 +776,9 @@ static void *send_thread(void *data)
 			dbr_add_frame(stream, &dbr_frame);
 			pthread_mutex_unlock(&stream->dbr_mutex);
 		}
+
+		if (shutdown)
+			break;
 	}
 
 	bool encode_error = os_atomic_load_bool(&stream->encode_error);
@@ -1252,6 +1342,15 @@ static bool init_connect(struct rtmp_stream *stream)
 	os_atomic_set_bool(&stream->encode_error, false);
 	stream->total_bytes_sent = 0;
 	stream->dropped_frames = 0;
+
+	pthread_mutex_lock(&stream->batch_stats_mutex);
+	stream->batch_count = 0;
+	stream->batch_packets = 0;
+	stream->batch_bytes = 0;
+	stream->batch_max_bytes = 0;
+	stream->batch_send_ns = 0;
+	stream->batch_max_send_ns = 0;
+	pthread_mutex_unlock(&stream->batch_stats_mutex);
 	stream->min_priority = 0;
 	stream->got_first_packet = false;
 
@@ -1336,6 +1435,8 @@ static bool init_connect(struct rtmp_stream *stream)
 		stream->addrlen_hint = len;
 	}
 
+	stream->batch_send = obs_data_get_bool(settings, OPT_BATCH_SEND_ENABLED);
+
 #ifdef _WIN32
 	stream->new_socket_loop = obs_data_get_bool(settings, OPT_NEWSOCKETLOOP_ENABLED);
 	stream->low_latency_mode = obs_data_get_bool(settings, OPT_LOWLATENCY_ENABLED);
@@ -1350,6 +1451,11 @@ static bool init_connect(struct rtmp_stream *stream)
 	stream->low_latency_mode = false;
 #endif
 
+	/* the socket loop has its own send buffer, which a batch may not fit
+	 * into */
+	if (stream->new_socket_loop)
+		stream->batch_send = false;
+
 	obs_data_release(settings);
 	return true;
 }
@@ -1720,6 +1826,7 @@ static void rtmp_stream_defaults(obs_data_t *defaults)
 	obs_data_set_default_int(defaults, OPT_PFRAME_DROP_THRESHOLD, 900);
 	obs_data_set_default_int(defaults, OPT_MAX_SHUTDOWN_TIME_SEC, 30);
 	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
+	obs_data_set_default_bool(defaults, OPT_BATCH_SEND_ENABLED, true);
 #ifdef _WIN32
 	obs_data_set_default_bool(defaults, OPT_NEWSOCKETLOOP_ENABLED, false);
 	obs_data_set_default_bool(defaults, OPT_LOWLATENCY_ENABLED, false);
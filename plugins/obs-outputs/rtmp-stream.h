@@ -31,6 +31,7 @@
 #define OPT_NEWSOCKETLOOP_ENABLED "new_socket_loop_enabled"
 #define OPT_LOWLATENCY_ENABLED "low_latency_mode_enabled"
 #define OPT_METADATA_MULTITRACK "metadata_multitrack"
+#define OPT_BATCH_SEND_ENABLED "batch_send_enabled"
 
 //#define TEST_FRAMEDROPS
 //#define TEST_FRAMEDROPS_WITH_BITRATE_SHORTCUTS
@@ -113,6 +114,18 @@ struct rtmp_stream {
 	long dbr_inc_bitrate;
 	bool dbr_enabled;
 
+	/* batched sending, packets that are already queued are chunked
+	 * together and written with a single vectored send */
+	bool batch_send;
+	RTMPBatch batch;
+	pthread_mutex_t batch_stats_mutex;
+	uint64_t batch_count;
+	uint64_t batch_packets;
+	uint64_t batch_bytes;
+	uint64_t batch_max_bytes;
+	uint64_t batch_send_ns;
+	uint64_t batch_max_send_ns;
+
 	enum audio_id_t audio_codec[MAX_OUTPUT_AUDIO_ENCODERS];
 	enum video_id_t video_codec[MAX_OUTPUT_VIDEO_ENCODERS];
 
@@ -69,25 +69,14 @@ static void reset_ts(mp_cache_t *c)
 	c->next_ns = 0;
 }
 
-static inline bool mp_cache_sleep(mp_cache_t *c)
+static inline bool mp_cache_frame_due(mp_cache_t *c)
 {
-	bool timeout = false;
-
 	if (!c->next_ns) {
 		c->next_ns = os_gettime_ns();
-	} else {
-		const uint64_t t = os_gettime_ns();
-		if (c->next_ns > t) {
-			const uint32_t delta_ms = (uint32_t)((c->next_ns - t + 500000) / 1000000);
-			if (delta_ms > 0) {
-				static const uint32_t timeout_ms = 200;
-				timeout = delta_ms > timeout_ms;
-				os_sleep_ms(timeout ? timeout_ms : delta_ms);
-			}
-		}
+		return true;
 	}
 
-	return timeout;
+	return c->next_ns <= os_gettime_ns() + 500000;
 }
 
 static bool mp_cache_eof(mp_cache_t *c)
@@ -110,14 +99,23 @@ static bool mp_cache_eof(mp_cache_t *c)
 	return true;
 }
 
+/* maximum time spent decoding per step while filling the cache */
+#define DECODE_SLICE_NS 10000000ULL
+
+/* Decodes the file a slice at a time so filling the cache doesn't hold a
+ * decode thread for the whole file, sets decoded once done */
 bool mp_cache_decode(mp_cache_t *c)
 {
 	mp_media_t *m = &c->m;
+	uint64_t end = os_gettime_ns() + DECODE_SLICE_NS;
 	bool success = false;
 
-	m->full_decode = true;
+	if (!c->decoding) {
+		m->full_decode = true;
 
-	mp_media_reset(m);
+		mp_media_reset(m);
+		c->decoding = true;
+	}
 
 	while (!mp_media_eof(m)) {
 		if (m->has_video)
@@ -127,9 +125,12 @@ bool mp_cache_decode(mp_cache_t *c)
 
 		if (!mp_media_prepare_frames(m))
 			goto fail;
+		if (os_gettime_ns() >= end)
+			return true;
 	}
 
 	success = true;
+	c->decoded = true;
 
 	c->start_time = c->m.fmt->start_time;
 	if (c->start_time == AV_NOPTS_VALUE)
@@ -150,6 +151,10 @@ static void seek_to(mp_cache_t *c, int64_t pos)
 		return;
 	}
 
+	/* the position is in microseconds, the cached frames are timed in
+	 * nanoseconds */
+	pos *= 1000;
+
 	if (c->has_video) {
 		struct obs_source_frame *v;
 
@@ -365,104 +370,107 @@ static void mp_cache_calc_next_ns(mp_cache_t *c)
 	c->next_pts_ns = min_next_ns;
 }
 
-static inline bool mp_cache_thread(mp_cache_t *c)
+static uint64_t mp_cache_next_step(mp_cache_t *c)
 {
-	os_set_thread_name("mp_cache_thread");
+	bool is_active, pause;
 
-	if (!mp_cache_decode(c)) {
-		return false;
-	}
+	pthread_mutex_lock(&c->mutex);
+	is_active = c->active;
+	pause = c->pause;
+	pthread_mutex_unlock(&c->mutex);
 
-	for (;;) {
-		bool reset, kill, is_active, seek, pause, reset_time, preload_frame;
-		int64_t seek_pos;
-		bool timeout = false;
+	if (!is_active || pause)
+		return MP_TASK_IDLE;
+	return c->next_ns ? c->next_ns : MP_TASK_CONTINUE;
+}
 
-		pthread_mutex_lock(&c->mutex);
-		is_active = c->active;
-		pause = c->pause;
-		pthread_mutex_unlock(&c->mutex);
+/* Runs on the decode executor, fills the cache first and then handles
+ * pending requests and outputs the cached frames once they are due */
+static uint64_t mp_cache_step(void *opaque)
+{
+	mp_cache_t *c = opaque;
+	bool reset, is_active, seek, pause, reset_time, preload_frame;
+	int64_t seek_pos;
+	bool due = false;
+
+	if (c->failed)
+		return MP_TASK_IDLE;
+	if (!c->decoded) {
+		if (!mp_cache_decode(c))
+			goto fail;
+		if (!c->decoded)
+			return MP_TASK_CONTINUE;
+	}
 
-		if (!is_active || pause) {
-			if (os_sem_wait(c->sem) < 0)
-				return false;
-			if (pause)
-				reset_ts(c);
-		} else {
-			timeout = mp_cache_sleep(c);
-		}
+	pthread_mutex_lock(&c->mutex);
+	is_active = c->active;
+	pause = c->pause;
+	pthread_mutex_unlock(&c->mutex);
 
-		pthread_mutex_lock(&c->mutex);
+	if (!is_active || pause) {
+		if (pause)
+			reset_ts(c);
+	} else {
+		due = mp_cache_frame_due(c);
+	}
 
-		reset = c->reset;
-		kill = c->kill;
-		c->reset = false;
-		c->kill = false;
+	pthread_mutex_lock(&c->mutex);
 
-		preload_frame = c->preload_frame;
-		pause = c->pause;
-		seek_pos = c->seek_pos;
-		seek = c->seek;
-		reset_time = c->reset_ts;
-		c->preload_frame = false;
-		c->seek = false;
-		c->reset_ts = false;
+	reset = c->reset;
+	c->reset = false;
 
-		pthread_mutex_unlock(&c->mutex);
+	preload_frame = c->preload_frame;
+	pause = c->pause;
+	seek_pos = c->seek_pos;
+	seek = c->seek;
+	reset_time = c->reset_ts;
+	c->preload_frame = false;
+	c->seek = false;
+	c->reset_ts = false;
 
-		if (kill) {
-			break;
-		}
-		if (reset) {
-			mp_cache_reset(c);
-			continue;
-		}
+	pthread_mutex_unlock(&c->mutex);
 
-		if (seek) {
-			c->seek_next_ts = true;
-			seek_to(c, seek_pos);
-			continue;
-		}
+	if (reset) {
+		mp_cache_reset(c);
+		return mp_cache_next_step(c);
+	}
 
-		if (reset_time) {
-			reset_ts(c);
-			continue;
-		}
+	if (seek) {
+		c->seek_next_ts = true;
+		seek_to(c, seek_pos);
+		return mp_cache_next_step(c);
+	}
 
-		if (pause)
-			continue;
+	if (reset_time) {
+		reset_ts(c);
+		return mp_cache_next_step(c);
+	}
 
-		if (preload_frame)
-			c->v_preload_cb(c->opaque, &c->video_frames.array[0]);
+	if (pause)
+		return MP_TASK_IDLE;
 
-		/* frames are ready */
-		if (is_active && !timeout) {
-			if (c->has_video)
-				mp_cache_next_video(c, false);
-			if (c->has_audio)
-				mp_cache_next_audio(c);
+	if (preload_frame)
+		c->v_preload_cb(c->opaque, &c->video_frames.array[0]);
 
-			if (mp_cache_eof(c))
-				continue;
+	/* frames are ready */
+	if (is_active && due) {
+		if (c->has_video)
+			mp_cache_next_video(c, false);
+		if (c->has_audio)
+			mp_cache_next_audio(c);
 
+		if (!mp_cache_eof(c))
 			mp_cache_calc_next_ns(c);
-		}
 	}
 
-	return true;
-}
-
-static void *mp_cache_thread_start(void *opaque)
-{
-	mp_cache_t *c = opaque;
+	return mp_cache_next_step(c);
 
-	if (!mp_cache_thread(c)) {
-		if (c->stop_cb) {
-			c->stop_cb(c->opaque);
-		}
+fail:
+	c->failed = true;
+	if (c->stop_cb) {
+		c->stop_cb(c->opaque);
 	}
-
-	return NULL;
+	return MP_TASK_IDLE;
 }
 
 static void fill_video(void *data, struct obs_source_frame *frame)
@@ -515,20 +523,16 @@ static inline bool mp_cache_init_internal(mp_cache_t *c, const struct mp_media_i
 		blog(LOG_WARNING, "MP: Failed to init mutex");
 		return false;
 	}
-	if (os_sem_init(&c->sem, 0) != 0) {
-		blog(LOG_WARNING, "MP: Failed to init semaphore");
-		return false;
-	}
 
 	c->path = info->path ? bstrdup(info->path) : NULL;
 	c->format_name = info->format ? bstrdup(info->format) : NULL;
 
-	if (pthread_create(&c->thread, NULL, mp_cache_thread_start, c) != 0) {
-		blog(LOG_WARNING, "MP: Could not create media thread");
+	c->task = mp_task_create("mp_cache_thread", mp_cache_step, c, !c->m.is_file);
+	if (!c->task) {
+		blog(LOG_WARNING, "MP: Could not create media task");
 		return false;
 	}
 
-	c->thread_valid = true;
 	return true;
 }
 
@@ -582,15 +586,11 @@ bool mp_cache_init(mp_cache_t *c, const struct mp_media_info *info)
 	return true;
 }
 
-static void mp_kill_thread(mp_cache_t *c)
+static void mp_kill_task(mp_cache_t *c)
 {
-	if (c->thread_valid) {
-		pthread_mutex_lock(&c->mutex);
-		c->kill = true;
-		pthread_mutex_unlock(&c->mutex);
-		os_sem_post(c->sem);
-
-		pthread_join(c->thread, NULL);
+	if (c->task) {
+		mp_task_destroy(c->task);
+		c->task = NULL;
 	}
 }
 
@@ -600,7 +600,7 @@ void mp_cache_free(mp_cache_t *c)
 		return;
 
 	mp_cache_stop(c);
-	mp_kill_thread(c);
+	mp_kill_task(c);
 
 	if (c->m.fmt)
 		mp_media_free(&c->m);
@@ -619,7 +619,6 @@ void mp_cache_free(mp_cache_t *c)
 	bfree(c->path);
 	bfree(c->format_name);
 	pthread_mutex_destroy(&c->mutex);
-	os_sem_destroy(c->sem);
 	memset(c, 0, sizeof(*c));
 }
 
@@ -635,7 +634,7 @@ void mp_cache_play(mp_cache_t *c, bool loop)
 
 	pthread_mutex_unlock(&c->mutex);
 
-	os_sem_post(c->sem);
+	mp_task_wake(c->task);
 }
 
 void mp_cache_play_pause(mp_cache_t *c, bool pause)
@@ -647,7 +646,7 @@ void mp_cache_play_pause(mp_cache_t *c, bool pause)
 	}
 	pthread_mutex_unlock(&c->mutex);
 
-	os_sem_post(c->sem);
+	mp_task_wake(c->task);
 }
 
 void mp_cache_stop(mp_cache_t *c)
@@ -660,16 +659,16 @@ void mp_cache_stop(mp_cache_t *c)
 	}
 	pthread_mutex_unlock(&c->mutex);
 
-	os_sem_post(c->sem);
+	mp_task_wake(c->task);
 }
 
 void mp_cache_preload_frame(mp_cache_t *c)
 {
-	if (c->request_preload && c->thread_valid && c->v_preload_cb) {
+	if (c->request_preload && c->task && c->v_preload_cb) {
 		pthread_mutex_lock(&c->mutex);
 		c->preload_frame = true;
 		pthread_mutex_unlock(&c->mutex);
-		os_sem_post(c->sem);
+		mp_task_wake(c->task);
 	}
 }
 
@@ -687,7 +686,7 @@ void mp_cache_seek(mp_cache_t *c, int64_t pos)
 	}
 	pthread_mutex_unlock(&c->mutex);
 
-	os_sem_post(c->sem);
+	mp_task_wake(c->task);
 }
 
 int64_t mp_cache_get_frames(mp_cache_t *c)
@@ -40,16 +40,16 @@ struct mp_cache {
 	int speed;
 
 	pthread_mutex_t mutex;
-	os_sem_t *sem;
 	bool preload_frame;
 	bool stopping;
 	bool looping;
 	bool active;
 	bool reset;
-	bool kill;
 
-	bool thread_valid;
-	pthread_t thread;
+	mp_task_t *task;
+	bool decoding;
+	bool decoded;
+	bool failed;
 
 	DARRAY(struct obs_source_frame) video_frames;
 	DARRAY(struct obs_source_audio) audio_segments;
@@ -0,0 +1,392 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: ISC
+
+#include <inttypes.h>
+
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/task.h>
+#include <util/bmem.h>
+#include <util/base.h>
+
+#include "executor.h"
+
+/* a step starting this long after its deadline missed it, the task pool
+ * timer has a resolution of 1 ms */
+#define MISSED_DEADLINE_NS 5000000ULL
+
+struct mp_task {
+	mp_task_step_cb step;
+	void *param;
+	char *name;
+
+	pthread_mutex_t mutex;
+	os_task_pool_t *pool;
+	/* the scheduled or running step, owned by whoever takes it out */
+	os_task_handle_t *handle;
+	uint64_t due;
+	bool deadline;
+	bool running;
+	bool wake;
+	bool canceling;
+	bool removed;
+
+	bool thread_valid;
+	pthread_t thread;
+	os_event_t *event;
+
+	struct mp_task_stats stats;
+};
+
+/* the pool is created with the first pooled task and destroyed with the
+ * last one, stats of destroyed tasks are added up for the log */
+static struct {
+	pthread_mutex_t mutex;
+	os_task_pool_t *pool;
+	size_t tasks;
+	struct mp_task_stats stats;
+} executor = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static void add_stats(struct mp_task_stats *dst, const struct mp_task_stats *src)
+{
+	dst->steps += src->steps;
+	dst->total_step_ns += src->total_step_ns;
+	dst->deadlines += src->deadlines;
+	dst->missed_deadlines += src->missed_deadlines;
+	if (src->max_step_ns > dst->max_step_ns)
+		dst->max_step_ns = src->max_step_ns;
+	if (src->max_late_ns > dst->max_late_ns)
+		dst->max_late_ns = src->max_late_ns;
+}
+
+static os_task_pool_t *executor_acquire(void)
+{
+	os_task_pool_t *pool;
+
+	pthread_mutex_lock(&executor.mutex);
+	if (!executor.pool) {
+		executor.pool = os_task_pool_create("media-playback: decode", 0);
+		memset(&executor.stats, 0, sizeof(executor.stats));
+	}
+	pool = executor.pool;
+	if (pool)
+		executor.tasks++;
+	pthread_mutex_unlock(&executor.mutex);
+
+	return pool;
+}
+
+static void executor_release(const struct mp_task_stats *stats)
+{
+	os_task_pool_t *pool = NULL;
+	struct mp_task_stats total = {0};
+
+	pthread_mutex_lock(&executor.mutex);
+	add_stats(&executor.stats, stats);
+	if (--executor.tasks == 0) {
+		pool = executor.pool;
+		total = executor.stats;
+		executor.pool = NULL;
+	}
+	pthread_mutex_unlock(&executor.mutex);
+
+	if (!pool)
+		return;
+
+	os_task_pool_destroy(pool);
+
+	if (total.steps)
+		blog(LOG_INFO,
+		     "MP: Decode executor: %" PRIu64 " steps, %.3f ms average, "
+		     "%.3f ms max, %" PRIu64 "/%" PRIu64 " deadlines missed "
+		     "(%.3f ms max late)",
+		     total.steps, (double)total.total_step_ns / (double)total.steps / 1e6,
+		     (double)total.max_step_ns / 1e6, total.missed_deadlines, total.deadlines,
+		     (double)total.max_late_ns / 1e6);
+}
+
+static uint64_t run_step(struct mp_task *task, uint64_t due, bool deadline)
+{
+	uint64_t start = os_gettime_ns();
+	uint64_t next = task->step(task->param);
+	uint64_t time = os_gettime_ns() - start;
+	uint64_t late = deadline && start > due ? start - due : 0;
+
+	pthread_mutex_lock(&task->mutex);
+	task->stats.steps++;
+	task->stats.total_step_ns += time;
+	if (time > task->stats.max_step_ns)
+		task->stats.max_step_ns = time;
+	if (deadline) {
+		task->stats.deadlines++;
+		if (late > MISSED_DEADLINE_NS)
+			task->stats.missed_deadlines++;
+		if (late > task->stats.max_late_ns)
+			task->stats.max_late_ns = late;
+	}
+	pthread_mutex_unlock(&task->mutex);
+
+	return next;
+}
+
+static void pool_step(void *param);
+
+/* Called with the task mutex held */
+static inline void set_due(struct mp_task *task, uint64_t due)
+{
+	task->deadline = due > MP_TASK_CONTINUE;
+	task->due = due == MP_TASK_CONTINUE ? os_gettime_ns() : due;
+}
+
+/* Called with the task mutex held */
+static void schedule(struct mp_task *task, uint64_t due)
+{
+	uint64_t now = os_gettime_ns();
+	uint32_t delay_ms = 0;
+
+	set_due(task, due);
+
+	if (task->thread_valid) {
+		os_event_signal(task->event);
+		return;
+	}
+
+	/* rounded up so the step doesn't run before its deadline */
+	if (task->due > now)
+		delay_ms = (uint32_t)((task->due - now + 999999) / 1000000);
+
+	task->handle = os_task_pool_schedule(task->pool, OS_TASK_PRIORITY_NORMAL, delay_ms, 0, pool_step, task);
+	if (!task->handle)
+		blog(LOG_WARNING, "MP: Failed to schedule decode step for '%s'", task->name);
+}
+
+static void pool_step(void *param)
+{
+	struct mp_task *task = param;
+	os_task_handle_t *self;
+	uint64_t due;
+	bool deadline;
+	uint64_t next;
+
+	pthread_mutex_lock(&task->mutex);
+	self = task->handle;
+	due = task->due;
+	deadline = task->deadline;
+	task->running = true;
+	task->wake = false;
+	pthread_mutex_unlock(&task->mutex);
+
+	next = run_step(task, due, deadline);
+
+	pthread_mutex_lock(&task->mutex);
+	task->running = false;
+
+	/* a canceling wake or mp_task_destroy releases the handle instead */
+	if (task->handle == self)
+		task->handle = NULL;
+	else
+		self = NULL;
+
+	if (!task->removed) {
+		if (task->wake)
+			schedule(task, MP_TASK_CONTINUE);
+		else if (next != MP_TASK_IDLE)
+			schedule(task, next);
+	}
+	pthread_mutex_unlock(&task->mutex);
+
+	os_task_handle_release(self);
+}
+
+static void *thread_step(void *param)
+{
+	struct mp_task *task = param;
+
+	os_set_thread_name(task->name);
+
+	for (;;) {
+		uint64_t due;
+		bool deadline;
+		bool removed;
+		uint64_t next;
+
+		pthread_mutex_lock(&task->mutex);
+		due = task->due;
+		deadline = task->deadline;
+		removed = task->removed;
+		pthread_mutex_unlock(&task->mutex);
+
+		if (removed)
+			break;
+
+		if (due == MP_TASK_IDLE) {
+			os_event_wait(task->event);
+			continue;
+		}
+
+		uint64_t now = os_gettime_ns();
+		if (due > now) {
+			os_event_timedwait(task->event, (unsigned long)((due - now + 999999) / 1000000));
+			continue;
+		}
+
+		pthread_mutex_lock(&task->mutex);
+		task->running = true;
+		task->wake = false;
+		pthread_mutex_unlock(&task->mutex);
+
+		next = run_step(task, due, deadline);
+
+		pthread_mutex_lock(&task->mutex);
+		task->running = false;
+		set_due(task, task->wake ? MP_TASK_CONTINUE : next);
+		pthread_mutex_unlock(&task->mutex);
+	}
+
+	return NULL;
+}
+
+mp_task_t *mp_task_create(const char *name, mp_task_step_cb step, void *param, bool own_thread)
+{
+	struct mp_task *task = bzalloc(sizeof(struct mp_task));
+	task->step = step;
+	task->param = param;
+	task->name = bstrdup(name);
+	pthread_mutex_init_value(&task->mutex);
+
+	if (pthread_mutex_init(&task->mutex, NULL) != 0)
+		goto fail;
+
+	if (own_thread) {
+		if (os_event_init(&task->event, OS_EVENT_TYPE_AUTO) != 0)
+			goto fail;
+
+		task->thread_valid = true;
+		set_due(task, MP_TASK_CONTINUE);
+
+		if (pthread_create(&task->thread, NULL, thread_step, task) != 0) {
+			task->thread_valid = false;
+			goto fail;
+		}
+	} else {
+		task->pool = executor_acquire();
+		if (!task->pool)
+			goto fail;
+
+		pthread_mutex_lock(&task->mutex);
+		schedule(task, MP_TASK_CONTINUE);
+		bool scheduled = task->handle != NULL;
+		pthread_mutex_unlock(&task->mutex);
+
+		if (!scheduled)
+			goto fail;
+	}
+
+	return task;
+
+fail:
+	blog(LOG_WARNING, "MP: Failed to create decode task for '%s'", name);
+	mp_task_destroy(task);
+	return NULL;
+}
+
+void mp_task_destroy(mp_task_t *task)
+{
+	os_task_handle_t *pending;
+
+	if (!task)
+		return;
+
+	pthread_mutex_lock(&task->mutex);
+	task->removed = true;
+	pending = task->handle;
+	task->handle = NULL;
+	pthread_mutex_unlock(&task->mutex);
+
+	if (task->thread_valid) {
+		os_event_signal(task->event);
+		pthread_join(task->thread, NULL);
+	}
+
+	/* waits for a running step to return */
+	os_task_cancel(pending);
+
+	if (task->pool)
+		executor_release(&task->stats);
+
+	os_event_destroy(task->event);
+	pthread_mutex_destroy(&task->mutex);
+	bfree(task->name);
+	bfree(task);
+}
+
+void mp_task_wake(mp_task_t *task)
+{
+	os_task_handle_t *pending;
+	bool prevented;
+
+	if (!task)
+		return;
+
+	pthread_mutex_lock(&task->mutex);
+
+	while (!task->removed) {
+		/* a running step checks the flag when it returns, and so does
+		 * a wake that is canceling the pending step */
+		if (task->running || task->canceling) {
+			task->wake = true;
+			break;
+		}
+
+		/* already queued to run */
+		if (task->handle && !task->deadline)
+			break;
+
+		pending = task->handle;
+		task->handle = NULL;
+
+		if (!pending) {
+			schedule(task, MP_TASK_CONTINUE);
+			break;
+		}
+
+		/* the step may have started and be waiting for the mutex, so
+		 * the pending step is canceled without holding it */
+		task->canceling = true;
+		task->wake = false;
+		pthread_mutex_unlock(&task->mutex);
+
+		prevented = os_task_cancel(pending);
+
+		pthread_mutex_lock(&task->mutex);
+		task->canceling = false;
+
+		if (prevented) {
+			if (!task->removed && !task->running && !task->handle)
+				schedule(task, MP_TASK_CONTINUE);
+			break;
+		}
+
+		/* The step couldn't be prevented, so it ran after this wake
+		 * and has already scheduled the next one.  Wakes that came in
+		 * after it returned were only flagged, so start over for
+		 * them. */
+		if (!task->wake)
+			break;
+	}
+
+	pthread_mutex_unlock(&task->mutex);
+}
+
+void mp_task_get_stats(mp_task_t *task, struct mp_task_stats *stats)
+{
+	if (!task) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	pthread_mutex_lock(&task->mutex);
+	*stats = task->stats;
+	pthread_mutex_unlock(&task->mutex);
+}
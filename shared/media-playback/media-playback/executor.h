@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+//
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <util/c99defs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decode executor
+ *
+ *   Media sources register a step function that outputs and decodes whatever
+ * is due, and returns the time (os_gettime_ns) of its next frame deadline.
+ * Steps run on a task pool shared by all media sources, one step at a time
+ * per task, so a source only occupies a thread while it has work to do.
+ * Sources that may block on network reads get a thread of their own instead,
+ * with the same step semantics.
+ */
+
+/* wait for mp_task_wake */
+#define MP_TASK_IDLE 0
+/* run again as soon as possible, without a deadline */
+#define MP_TASK_CONTINUE 1
+
+typedef uint64_t (*mp_task_step_cb)(void *param);
+
+struct mp_task;
+typedef struct mp_task mp_task_t;
+
+struct mp_task_stats {
+	uint64_t steps;
+	uint64_t total_step_ns;
+	uint64_t max_step_ns;
+	uint64_t deadlines;
+	uint64_t missed_deadlines;
+	uint64_t max_late_ns;
+};
+
+/* the first step runs right away */
+extern mp_task_t *mp_task_create(const char *name, mp_task_step_cb step, void *param, bool own_thread);
+/* waits for a running step, must not be called at the same time as
+ * mp_task_wake on the same task */
+extern void mp_task_destroy(mp_task_t *task);
+
+/* runs the next step now instead of at the deadline */
+extern void mp_task_wake(mp_task_t *task);
+extern void mp_task_get_stats(mp_task_t *task, struct mp_task_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -174,3 +174,16 @@ bool media_playback_has_audio(media_playback_t *mp)
 	else
 		return mp->media.has_audio;
 }
+
+void media_playback_get_decode_stats(media_playback_t *mp, struct mp_task_stats *stats)
+{
+	if (!mp) {
+		mp_task_get_stats(NULL, stats);
+		return;
+	}
+
+	if (mp->is_cached)
+		mp_task_get_stats(mp->cache.task, stats);
+	else
+		mp_task_get_stats(mp->media.task, stats);
+}
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <obs.h>
+#include "executor.h"
 
 struct media_playback;
 typedef struct media_playback media_playback_t;
@@ -63,3 +64,4 @@ extern int64_t media_playback_get_frames(media_playback_t *mp);
 extern int64_t media_playback_get_duration(media_playback_t *mp);
 extern bool media_playback_has_video(media_playback_t *mp);
 extern bool media_playback_has_audio(media_playback_t *mp);
+extern void media_playback_get_decode_stats(media_playback_t *mp, struct mp_task_stats *stats);
@@ -179,6 +179,7 @@ static int mp_media_next_packet(mp_media_t *media)
 	if (ret < 0) {
 		if (ret != AVERROR_EOF && ret != AVERROR_EXIT)
 			blog(LOG_WARNING, "MP: av_read_frame failed: %s (%d)", av_err2str(ret), ret);
+		mp_media_free_packet(media, pkt);
 		return ret;
 	}
 
@@ -283,7 +284,7 @@ bool mp_media_prepare_frames(mp_media_t *m)
 		 * interrupted and restart playback, the request_preload signal
 		 * might happen when the current frame is invalid, so clear out
 		 * these pointers to signify they're not valid. (the obsframe
-		 * structure is only used in the media thread, so this isn't a
+		 * structure is only used by the media task, so this isn't a
 		 * threading issue) */
 		m->obsframe.data[0] = NULL;
 
@@ -596,25 +597,16 @@ bool mp_media_reset(mp_media_t *m)
 	return true;
 }
 
-static inline bool mp_media_sleep(mp_media_t *m)
+/* true if the next frame is due, the first frame after a reset is due right
+ * away */
+static inline bool mp_media_frame_due(mp_media_t *m)
 {
-	bool timeout = false;
-
 	if (!m->next_ns) {
 		m->next_ns = os_gettime_ns();
-	} else {
-		const uint64_t t = os_gettime_ns();
-		if (m->next_ns > t) {
-			const uint32_t delta_ms = (uint32_t)((m->next_ns - t + 500000) / 1000000);
-			if (delta_ms > 0) {
-				static const uint32_t timeout_ms = 200;
-				timeout = delta_ms > timeout_ms;
-				os_sleep_ms(timeout ? timeout_ms : delta_ms);
-			}
-		}
+		return true;
 	}
 
-	return timeout;
+	return m->next_ns <= os_gettime_ns() + 500000;
 }
 
 bool mp_media_eof(mp_media_t *m)
@@ -738,10 +730,22 @@ bool mp_media_init2(mp_media_t *m)
 	return true;
 }
 
-static inline bool mp_media_thread(mp_media_t *m)
+static uint64_t mp_media_next_step(mp_media_t *m)
 {
-	os_set_thread_name("mp_media_thread");
+	bool is_active, pause;
 
+	pthread_mutex_lock(&m->mutex);
+	is_active = m->active;
+	pause = m->pause;
+	pthread_mutex_unlock(&m->mutex);
+
+	if (!is_active || pause)
+		return MP_TASK_IDLE;
+	return m->next_ns ? m->next_ns : MP_TASK_CONTINUE;
+}
+
+static inline bool mp_media_open(mp_media_t *m)
+{
 	if (!mp_media_init2(m)) {
 		return false;
 	}
@@ -749,101 +753,98 @@ static inline bool mp_media_thread(mp_media_t *m)
 		return false;
 	}
 
-	for (;;) {
-		bool reset, kill, is_active, seek, pause, reset_time, preload_frame;
-		int64_t seek_pos;
-		bool timeout = false;
+	m->opened = true;
+	return true;
+}
 
-		pthread_mutex_lock(&m->mutex);
-		is_active = m->active;
-		pause = m->pause;
-		pthread_mutex_unlock(&m->mutex);
+/* Runs on the decode executor, handles pending requests and outputs the
+ * current frames and decodes the next ones once they are due */
+static uint64_t mp_media_step(void *opaque)
+{
+	mp_media_t *m = opaque;
+	bool reset, is_active, seek, pause, reset_time, preload_frame;
+	int64_t seek_pos;
+	bool due = false;
 
-		if (!is_active || pause) {
-			if (os_sem_wait(m->sem) < 0)
-				return false;
-			if (pause)
-				reset_ts(m);
-		} else {
-			timeout = mp_media_sleep(m);
-		}
+	if (m->failed)
+		return MP_TASK_IDLE;
+	if (!m->opened && !mp_media_open(m))
+		goto fail;
 
-		pthread_mutex_lock(&m->mutex);
+	pthread_mutex_lock(&m->mutex);
+	is_active = m->active;
+	pause = m->pause;
+	pthread_mutex_unlock(&m->mutex);
 
-		reset = m->reset;
-		kill = m->kill;
-		m->reset = false;
-		m->kill = false;
+	if (!is_active || pause) {
+		if (pause)
+			reset_ts(m);
+	} else {
+		due = mp_media_frame_due(m);
+	}
 
-		preload_frame = m->preload_frame;
-		pause = m->pause;
-		seek_pos = m->seek_pos;
-		seek = m->seek;
-		reset_time = m->reset_ts;
-		m->preload_frame = false;
-		m->seek = false;
-		m->reset_ts = false;
+	pthread_mutex_lock(&m->mutex);
 
-		pthread_mutex_unlock(&m->mutex);
+	reset = m->reset;
+	m->reset = false;
 
-		if (kill) {
-			break;
-		}
-		if (reset) {
-			mp_media_reset(m);
-			continue;
-		}
+	preload_frame = m->preload_frame;
+	pause = m->pause;
+	seek_pos = m->seek_pos;
+	seek = m->seek;
+	reset_time = m->reset_ts;
+	m->preload_frame = false;
+	m->seek = false;
+	m->reset_ts = false;
 
-		if (seek) {
-			m->seek_next_ts = true;
-			seek_to(m, seek_pos);
-			continue;
-		}
+	pthread_mutex_unlock(&m->mutex);
 
-		if (reset_time) {
-			reset_ts(m);
-			continue;
-		}
+	if (reset) {
+		mp_media_reset(m);
+		return mp_media_next_step(m);
+	}
 
-		if (pause)
-			continue;
+	if (seek) {
+		m->seek_next_ts = true;
+		seek_to(m, seek_pos);
+		return mp_media_next_step(m);
+	}
 
-		/* see note in mp_media_prepare_frames() for context on the
-		 * pointer check */
-		if (preload_frame && m->obsframe.data[0] && !is_active) {
-			m->v_preload_cb(m->opaque, &m->obsframe);
-		}
+	if (reset_time) {
+		reset_ts(m);
+		return mp_media_next_step(m);
+	}
 
-		/* frames are ready */
-		if (is_active && !timeout) {
-			if (m->has_video)
-				mp_media_next_video(m, false);
-			if (m->has_audio)
-				mp_media_next_audio(m);
+	if (pause)
+		return MP_TASK_IDLE;
 
-			if (!mp_media_prepare_frames(m))
-				return false;
-			if (mp_media_eof(m))
-				continue;
+	/* see note in mp_media_prepare_frames() for context on the
+	 * pointer check */
+	if (preload_frame && m->obsframe.data[0] && !is_active) {
+		m->v_preload_cb(m->opaque, &m->obsframe);
+	}
 
+	/* frames are ready */
+	if (is_active && due) {
+		if (m->has_video)
+			mp_media_next_video(m, false);
+		if (m->has_audio)
+			mp_media_next_audio(m);
+
+		if (!mp_media_prepare_frames(m))
+			goto fail;
+		if (!mp_media_eof(m))
 			mp_media_calc_next_ns(m);
-		}
 	}
 
-	return true;
-}
-
-static void *mp_media_thread_start(void *opaque)
-{
-	mp_media_t *m = opaque;
+	return mp_media_next_step(m);
 
-	if (!mp_media_thread(m)) {
-		if (m->stop_cb) {
-			m->stop_cb(m->opaque);
-		}
+fail:
+	m->failed = true;
+	if (m->stop_cb) {
+		m->stop_cb(m->opaque);
 	}
-
-	return NULL;
+	return MP_TASK_IDLE;
 }
 
 static inline bool mp_media_init_internal(mp_media_t *m, const struct mp_media_info *info)
@@ -852,24 +853,23 @@ static inline bool mp_media_init_internal(mp_media_t *m, const struct mp_media_i
 		blog(LOG_WARNING, "MP: Failed to init mutex");
 		return false;
 	}
-	if (os_sem_init(&m->sem, 0) != 0) {
-		blog(LOG_WARNING, "MP: Failed to init semaphore");
-		return false;
-	}
 
 	m->path = info->path ? bstrdup(info->path) : NULL;
 	m->format_name = info->format ? bstrdup(info->format) : NULL;
 	m->hw = info->hardware_decoding;
 
+	/* network reads can block, so only plain files share decode threads */
+	m->is_file = m->is_local_file && m->path && !strstr(m->path, "://");
+
 	if (info->full_decode)
 		return true;
 
-	if (pthread_create(&m->thread, NULL, mp_media_thread_start, m) != 0) {
-		blog(LOG_WARNING, "MP: Could not create media thread");
+	m->task = mp_task_create("mp_media_thread", mp_media_step, m, !m->is_file);
+	if (!m->task) {
+		blog(LOG_WARNING, "MP: Could not create media task");
 		return false;
 	}
 
-	m->thread_valid = true;
 	return true;
 }
 
@@ -913,15 +913,15 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 	return true;
 }
 
-static void mp_kill_thread(mp_media_t *m)
+static void mp_kill_task(mp_media_t *m)
 {
-	if (m->thread_valid) {
+	if (m->task) {
 		pthread_mutex_lock(&m->mutex);
 		m->kill = true;
 		pthread_mutex_unlock(&m->mutex);
-		os_sem_post(m->sem);
 
-		pthread_join(m->thread, NULL);
+		mp_task_destroy(m->task);
+		m->task = NULL;
 	}
 }
 
@@ -931,7 +931,7 @@ void mp_media_free(mp_media_t *media)
 		return;
 
 	mp_media_stop(media);
-	mp_kill_thread(media);
+	mp_kill_task(media);
 	mp_decode_free(&media->v);
 	mp_decode_free(&media->a);
 	for (size_t i = 0; i < media->packet_pool.num; i++)
@@ -939,7 +939,6 @@ void mp_media_free(mp_media_t *media)
 	da_free(media->packet_pool);
 	avformat_close_input(&media->fmt);
 	pthread_mutex_destroy(&media->mutex);
-	os_sem_destroy(media->sem);
 	sws_freeContext(media->swscale);
 	av_freep(&media->scale_pic[0]);
 	bfree(media->path);
@@ -961,7 +960,7 @@ void mp_media_play(mp_media_t *m, bool loop, bool reconnecting)
 
 	pthread_mutex_unlock(&m->mutex);
 
-	os_sem_post(m->sem);
+	mp_task_wake(m->task);
 }
 
 void mp_media_play_pause(mp_media_t *m, bool pause)
@@ -973,16 +972,16 @@ void mp_media_play_pause(mp_media_t *m, bool pause)
 	}
 	pthread_mutex_unlock(&m->mutex);
 
-	os_sem_post(m->sem);
+	mp_task_wake(m->task);
 }
 
 void mp_media_preload_frame(mp_media_t *m)
 {
-	if (m->request_preload && m->thread_valid && m->v_preload_cb) {
+	if (m->request_preload && m->task && m->v_preload_cb) {
 		pthread_mutex_lock(&m->mutex);
 		m->preload_frame = true;
 		pthread_mutex_unlock(&m->mutex);
-		os_sem_post(m->sem);
+		mp_task_wake(m->task);
 	}
 }
 
@@ -996,7 +995,7 @@ void mp_media_stop(mp_media_t *m)
 	}
 	pthread_mutex_unlock(&m->mutex);
 
-	os_sem_post(m->sem);
+	mp_task_wake(m->task);
 }
 
 int64_t mp_media_get_current_time(mp_media_t *m)
@@ -1049,5 +1048,5 @@ void mp_media_seek(mp_media_t *m, int64_t pos)
 	}
 	pthread_mutex_unlock(&m->mutex);
 
-	os_sem_post(m->sem);
+	mp_task_wake(m->task);
 }
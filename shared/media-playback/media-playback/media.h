@@ -18,6 +18,7 @@
 
 #include <obs.h>
 #include "decode.h"
+#include "executor.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -87,7 +88,6 @@ struct mp_media {
 	uint64_t interrupt_poll_ts;
 
 	pthread_mutex_t mutex;
-	os_sem_t *sem;
 	bool preload_frame;
 	bool stopping;
 	bool looping;
@@ -95,8 +95,9 @@ struct mp_media {
 	bool reset;
 	bool kill;
 
-	bool thread_valid;
-	pthread_t thread;
+	mp_task_t *task;
+	bool opened;
+	bool failed;
 
 	bool pause;
 	bool reset_ts;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* Benchmarks are skipped unless OBS_TEST_BENCHMARKS is set in the environment,
+ * so the regular test run stays fast and doesn't depend on machine load. They
+ * report their results with print_message and never fail on timings. */
+static inline bool benchmarks_enabled(void)
+{
+	const char *env = getenv("OBS_TEST_BENCHMARKS");
+	return env && *env && *env != '0';
+}
+
+#define skip_unless_benchmarks_enabled()   \
+	do {                               \
+		if (!benchmarks_enabled()) \
+			skip();            \
+	} while (false)
@@ -0,0 +1,304 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define WIDTH 4
+#define HEIGHT 4
+#define FRAME_INTERVAL 33333333ULL
+#define TICK_TIMEOUT_MS 5000
+
+/* the ring behind the queue, deeper queues are clamped to it */
+#define MAX_QUEUE_DEPTH 64
+
+/* The frames are selected by the video thread.  While held, the source stops
+ * the video thread in its own video_tick, which runs right after the frame of
+ * that tick was selected, so the queue can be filled and checked without
+ * racing the consumer. */
+struct async_source {
+	obs_source_t *source;
+	os_event_t *ticked;
+	os_event_t *resume;
+	volatile bool hold;
+};
+
+static const char *async_source_get_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "async frame test source";
+}
+
+static void *async_source_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct async_source *context = bzalloc(sizeof(*context));
+
+	context->source = source;
+	os_event_init(&context->ticked, OS_EVENT_TYPE_AUTO);
+	os_event_init(&context->resume, OS_EVENT_TYPE_AUTO);
+
+	UNUSED_PARAMETER(settings);
+	return context;
+}
+
+static void async_source_destroy(void *data)
+{
+	struct async_source *context = data;
+
+	os_event_destroy(context->ticked);
+	os_event_destroy(context->resume);
+	bfree(context);
+}
+
+static void async_source_tick(void *data, float seconds)
+{
+	struct async_source *context = data;
+
+	if (os_atomic_load_bool(&context->hold)) {
+		os_event_signal(context->ticked);
+		os_event_wait(context->resume);
+	}
+
+	UNUSED_PARAMETER(seconds);
+}
+
+static struct obs_source_info async_source_info = {
+	.id = "async_frame_test_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_ASYNC_VIDEO,
+	.get_name = async_source_get_name,
+	.create = async_source_create,
+	.destroy = async_source_destroy,
+	.video_tick = async_source_tick,
+};
+
+/* every frame is filled with its own index, so the consumer can tell which
+ * one it got */
+static void output_frames(obs_source_t *source, uint8_t first, uint8_t count)
+{
+	uint8_t data[WIDTH * 4 * HEIGHT];
+	struct obs_source_frame frame = {
+		.data = {data},
+		.linesize = {WIDTH * 4},
+		.width = WIDTH,
+		.height = HEIGHT,
+		.format = VIDEO_FORMAT_RGBA,
+	};
+
+	for (uint8_t i = first; i < first + count; i++) {
+		memset(data, i, sizeof(data));
+		frame.timestamp = (i + 1) * FRAME_INTERVAL;
+		obs_source_output_video(source, &frame);
+	}
+}
+
+/* creates a source and waits until the video thread is held in its tick */
+static obs_source_t *create_source(void)
+{
+	obs_source_t *source = obs_source_create_private(async_source_info.id, "async frames", NULL);
+	struct async_source *context;
+
+	assert_non_null(source);
+
+	context = obs_obj_get_data(source);
+	os_atomic_set_bool(&context->hold, true);
+	assert_int_equal(os_event_timedwait(context->ticked, TICK_TIMEOUT_MS), 0);
+	return source;
+}
+
+static void release_source(obs_source_t *source)
+{
+	struct async_source *context = obs_obj_get_data(source);
+
+	os_atomic_set_bool(&context->hold, false);
+	os_event_signal(context->resume);
+	obs_source_release(source);
+}
+
+/* lets the video thread run one more tick and returns the index of the frame
+ * it selected, or -1 if it did not select a frame */
+static int consume_frame(obs_source_t *source)
+{
+	struct async_source *context = obs_obj_get_data(source);
+	struct obs_source_frame *frame;
+	int index = -1;
+
+	os_event_signal(context->resume);
+	assert_int_equal(os_event_timedwait(context->ticked, TICK_TIMEOUT_MS), 0);
+
+	frame = obs_source_get_frame(source);
+	if (frame) {
+		index = frame->data[0][0];
+		obs_source_release_frame(source, frame);
+	}
+
+	return index;
+}
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct obs_video_info ovi = {
+		.graphics_module = NULL_GRAPHICS_MODULE,
+		.fps_num = 30,
+		.fps_den = 1,
+		.base_width = 64,
+		.base_height = 64,
+		.output_width = 64,
+		.output_height = 64,
+		.output_format = VIDEO_FORMAT_NV12,
+		.gpu_conversion = true,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+		.scale_type = OBS_SCALE_BICUBIC,
+	};
+
+	/* effects are loaded from the source tree rather than an install */
+	PRAGMA_WARN_PUSH
+	PRAGMA_WARN_DEPRECATION
+	obs_add_data_path(NULL_GRAPHICS_DATA);
+	PRAGMA_WARN_POP
+
+	if (!obs_startup("en-US", NULL, NULL) || obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS)
+		return -1;
+
+	obs_register_source(&async_source_info);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+	obs_shutdown();
+	return 0;
+}
+
+/* the depth is clamped to the ring, and an invalid source reports the
+ * defaults */
+static void queue_depth_clamp_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_source();
+
+	assert_int_equal(obs_source_get_async_queue_depth(source), 30);
+	assert_int_equal(obs_source_get_async_drop_policy(source), OBS_ASYNC_FRAME_DROP_OLDEST);
+
+	obs_source_set_async_queue_depth(source, 0);
+	assert_int_equal(obs_source_get_async_queue_depth(source), 1);
+
+	obs_source_set_async_queue_depth(source, MAX_QUEUE_DEPTH + 1);
+	assert_int_equal(obs_source_get_async_queue_depth(source), MAX_QUEUE_DEPTH);
+
+	obs_source_set_async_queue_depth(source, 8);
+	assert_int_equal(obs_source_get_async_queue_depth(source), 8);
+
+	assert_int_equal(obs_source_get_async_queue_depth(NULL), 0);
+	assert_int_equal(obs_source_get_async_frames_dropped(NULL), 0);
+	assert_int_equal(obs_source_get_async_frames_late(NULL), 0);
+
+	release_source(source);
+}
+
+/* a full queue keeps the newest frames, the oldest ones are dropped by the
+ * consumer once it catches up */
+static void drop_oldest_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_source();
+
+	obs_source_set_async_queue_depth(source, 4);
+
+	output_frames(source, 0, 10);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 0);
+
+	assert_int_equal(consume_frame(source), 6);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 6);
+	assert_int_equal(obs_source_get_async_frames_late(source), 0);
+
+	release_source(source);
+}
+
+/* a full queue refuses new frames, so the consumer still gets the first ones */
+static void drop_newest_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_source();
+
+	obs_source_set_async_queue_depth(source, 4);
+	obs_source_set_async_drop_policy(source, OBS_ASYNC_FRAME_DROP_NEWEST);
+	assert_int_equal(obs_source_get_async_drop_policy(source), OBS_ASYNC_FRAME_DROP_NEWEST);
+
+	output_frames(source, 0, 10);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 6);
+
+	assert_int_equal(consume_frame(source), 0);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 6);
+
+	/* room was made for one more frame */
+	output_frames(source, 10, 2);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 7);
+
+	release_source(source);
+}
+
+/* the ring itself is the limit of drop-oldest, the rest of a burst is dropped
+ * right away */
+static void full_ring_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_source();
+
+	obs_source_set_async_queue_depth(source, MAX_QUEUE_DEPTH + 1);
+
+	output_frames(source, 0, MAX_QUEUE_DEPTH + 10);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 10);
+
+	assert_int_equal(consume_frame(source), 0);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 10);
+
+	release_source(source);
+}
+
+/* unbuffered sources skip straight to the newest frame, and count the frames
+ * skipped on the way as late instead of dropped */
+static void late_frames_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_source();
+
+	obs_source_set_async_unbuffered(source, true);
+
+	output_frames(source, 0, 1);
+	assert_int_equal(consume_frame(source), 0);
+
+	output_frames(source, 1, 5);
+	assert_int_equal(consume_frame(source), 5);
+	assert_int_equal(obs_source_get_async_frames_late(source), 4);
+	assert_int_equal(obs_source_get_async_frames_dropped(source), 0);
+
+	assert_int_equal(consume_frame(source), -1);
+
+	release_source(source);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(queue_depth_clamp_test),
+		cmocka_unit_test(drop_oldest_test),
+		cmocka_unit_test(drop_newest_test),
+		cmocka_unit_test(full_ring_test),
+		cmocka_unit_test(late_frames_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
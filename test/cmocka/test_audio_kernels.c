@@ -0,0 +1,254 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <media-io/audio-kernels.h>
+
+#include "benchmark.h"
+
+#define MAX_COUNT 1031
+#define BENCH_FRAMES 1024
+#define BENCH_ITERATIONS 20000
+
+static void fill_samples(float *data, size_t count, unsigned seed)
+{
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = ((float)(seed >> 8 & 0xFFFF) / 32768.0f - 1.0f) * 1.5f;
+	}
+}
+
+static void ref_add(float *dst, const float *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] += src[i];
+}
+
+static void ref_mul(float *dst, float gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] *= gain;
+}
+
+static void ref_mul_ramp(float *dst, const float *gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] *= gain[i];
+}
+
+static void ref_mul_add_ramp(float *dst, const float *src, const float *gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		float val = src[i] * gain[i];
+		dst[i] += val;
+	}
+}
+
+static void ref_clamp(float *dst, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		float val = dst[i];
+		val = (val == val) ? val : 0.0f;
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+		dst[i] = val;
+	}
+}
+
+static void add_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float a[MAX_COUNT + 4], b[MAX_COUNT + 4], expected[MAX_COUNT + 4];
+
+	/* every remainder, at offsets that leave the buffers unaligned */
+	for (size_t count = 0; count < MAX_COUNT; count += 13) {
+		for (size_t offset = 0; offset < 4; offset++) {
+			fill_samples(a, MAX_COUNT + 4, 1);
+			fill_samples(b, MAX_COUNT + 4, 2);
+			memcpy(expected, a, sizeof(a));
+
+			ref_add(expected + offset, b, count);
+			audio_add(a + offset, b, count);
+			assert_memory_equal(a, expected, sizeof(a));
+		}
+	}
+}
+
+static void mul_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float a[MAX_COUNT + 4], ramp[MAX_COUNT + 4], expected[MAX_COUNT + 4];
+
+	/* every remainder, at offsets that leave the buffers unaligned */
+	for (size_t count = 0; count < MAX_COUNT; count += 13) {
+		for (size_t offset = 0; offset < 4; offset++) {
+			fill_samples(a, MAX_COUNT + 4, 3);
+			memcpy(expected, a, sizeof(a));
+
+			ref_mul(expected + offset, 0.37f, count);
+			audio_mul(a + offset, 0.37f, count);
+			assert_memory_equal(a, expected, sizeof(a));
+
+			fill_samples(ramp, MAX_COUNT + 4, 4);
+			ref_mul_ramp(expected + offset, ramp, count);
+			audio_mul_ramp(a + offset, ramp, count);
+			assert_memory_equal(a, expected, sizeof(a));
+		}
+	}
+}
+
+static void mul_add_ramp_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float a[MAX_COUNT + 4], b[MAX_COUNT + 4], ramp[MAX_COUNT + 4], expected[MAX_COUNT + 4];
+
+	/* every remainder, at offsets that leave the buffers unaligned */
+	for (size_t count = 0; count < MAX_COUNT; count += 13) {
+		for (size_t offset = 0; offset < 4; offset++) {
+			fill_samples(a, MAX_COUNT + 4, 5);
+			fill_samples(b, MAX_COUNT + 4, 6);
+			for (size_t i = 0; i < MAX_COUNT + 4; i++)
+				ramp[i] = (float)i / (float)MAX_COUNT;
+			memcpy(expected, a, sizeof(a));
+
+			ref_mul_add_ramp(expected + offset, b, ramp, count);
+			audio_mul_add_ramp(a + offset, b, ramp, count);
+			assert_memory_equal(a, expected, sizeof(a));
+		}
+	}
+}
+
+static void clamp_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float a[MAX_COUNT + 4], expected[MAX_COUNT + 4];
+
+	/* every remainder, at offsets that leave the buffers unaligned */
+	for (size_t count = 0; count < MAX_COUNT; count += 13) {
+		for (size_t offset = 0; offset < 4; offset++) {
+			fill_samples(a, MAX_COUNT + 4, 7);
+			for (size_t i = 0; i < MAX_COUNT + 4; i += 11)
+				a[i] = NAN;
+			for (size_t i = 5; i < MAX_COUNT + 4; i += 17)
+				a[i] = (i & 1) ? INFINITY : -INFINITY;
+			for (size_t i = 3; i < MAX_COUNT + 4; i += 29)
+				a[i] = -0.0f;
+			memcpy(expected, a, sizeof(a));
+
+			ref_clamp(expected + offset, count);
+			audio_clamp(a + offset, count);
+
+			/* NaN != NaN, so compare the bits */
+			assert_memory_equal(a, expected, sizeof(a));
+		}
+	}
+}
+
+static void downmix_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float data[6][MAX_COUNT];
+	float expected[6][MAX_COUNT];
+	float *planes[6];
+
+	for (size_t channels = 1; channels <= 6; channels++) {
+		for (size_t ch = 0; ch < channels; ch++) {
+			fill_samples(data[ch], MAX_COUNT, 8 + (unsigned)ch);
+			memcpy(expected[ch], data[ch], sizeof(data[ch]));
+			planes[ch] = data[ch];
+		}
+
+		const float channels_i = 1.0f / (float)channels;
+		for (size_t ch = 1; ch < channels; ch++)
+			ref_add(expected[0], expected[ch], MAX_COUNT);
+		for (size_t i = 0; i < MAX_COUNT; i++)
+			expected[0][i] *= channels_i;
+		for (size_t ch = 1; ch < channels; ch++)
+			memcpy(expected[ch], expected[0], sizeof(expected[0]));
+
+		audio_downmix_mono(planes, channels, MAX_COUNT);
+
+		for (size_t ch = 0; ch < channels; ch++)
+			assert_memory_equal(data[ch], expected[ch], sizeof(data[ch]));
+	}
+}
+
+static double samples_per_us(uint64_t ns)
+{
+	return (double)BENCH_FRAMES * BENCH_ITERATIONS / ((double)ns / 1000.0);
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	skip_unless_benchmarks_enabled();
+
+	float *a = bmalloc(BENCH_FRAMES * sizeof(float));
+	float *b = bmalloc(BENCH_FRAMES * sizeof(float));
+	uint64_t start, scalar, simd;
+
+	fill_samples(a, BENCH_FRAMES, 9);
+	fill_samples(b, BENCH_FRAMES, 10);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		ref_add(a, b, BENCH_FRAMES);
+		ref_clamp(a, BENCH_FRAMES);
+	}
+	scalar = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		audio_add(a, b, BENCH_FRAMES);
+		audio_clamp(a, BENCH_FRAMES);
+	}
+	simd = os_gettime_ns() - start;
+
+	print_message("add + clamp: scalar %.1f samples/us, simd %.1f samples/us\n", samples_per_us(scalar),
+		      samples_per_us(simd));
+
+	/* unity gain keeps the samples from decaying into denormals */
+	for (size_t i = 0; i < BENCH_FRAMES; i++)
+		b[i] = 1.0f;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++)
+		ref_mul_ramp(a, b, BENCH_FRAMES);
+	scalar = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++)
+		audio_mul_ramp(a, b, BENCH_FRAMES);
+	simd = os_gettime_ns() - start;
+
+	print_message("mul ramp: scalar %.1f samples/us, simd %.1f samples/us\n", samples_per_us(scalar),
+		      samples_per_us(simd));
+
+	bfree(a);
+	bfree(b);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(add_test),
+		cmocka_unit_test(mul_test),
+		cmocka_unit_test(mul_add_ramp_test),
+		cmocka_unit_test(clamp_test),
+		cmocka_unit_test(downmix_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,163 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <media-io/audio-loudness.h>
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+#define SAMPLE_RATE 48000
+#define CHUNK_FRAMES 1024
+
+/* reference values from ITU-R BS.1770: a 1 kHz sine at 0 dBFS in one channel
+ * reads -3.01 LKFS, so the same sine in both channels of stereo reads 0 */
+#define ONE_CHANNEL_OFFSET -3.01f
+#define TOLERANCE 0.05f
+
+static void fill_sine(float *data, size_t frames, uint32_t sample_rate, float db)
+{
+	const double amplitude = pow(10.0, db / 20.0);
+
+	for (size_t i = 0; i < frames; i++)
+		data[i] = (float)(amplitude * sin(2.0 * M_PI * 1000.0 * (double)i / (double)sample_rate));
+}
+
+/* measures 3 seconds of audio, with a sine in the channels that are set in
+ * the mask and silence in the others */
+static void measure(struct audio_loudness *loudness, uint32_t sample_rate, enum speaker_layout speakers,
+		    size_t channels, uint32_t mask, float db)
+{
+	const size_t frames = sample_rate * 3;
+	float *sine = bmalloc(frames * sizeof(float));
+	float *silence = bzalloc(frames * sizeof(float));
+	size_t blocks = 0;
+
+	fill_sine(sine, frames, sample_rate, db);
+	audio_loudness_init(loudness, sample_rate, speakers);
+
+	for (size_t frame = 0; frame < frames; frame += CHUNK_FRAMES) {
+		const float *planes[MAX_AUDIO_CHANNELS];
+		size_t count = frames - frame < CHUNK_FRAMES ? frames - frame : CHUNK_FRAMES;
+
+		for (size_t ch = 0; ch < channels; ch++)
+			planes[ch] = ((mask & (1 << ch)) ? sine : silence) + frame;
+
+		if (audio_loudness_process(loudness, planes, channels, count))
+			blocks++;
+	}
+
+	assert_int_equal(blocks, 3 * LOUDNESS_BLOCKS_PER_SEC);
+
+	bfree(sine);
+	bfree(silence);
+}
+
+static void stereo_sine_test(void **state)
+{
+	struct audio_loudness loudness;
+
+	UNUSED_PARAMETER(state);
+
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_STEREO, 2, 0x3, -20.0f);
+	assert_float_equal(loudness.momentary, -20.0f, TOLERANCE);
+	assert_float_equal(loudness.short_term, -20.0f, TOLERANCE);
+
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_STEREO, 2, 0x3, 0.0f);
+	assert_float_equal(loudness.momentary, 0.0f, TOLERANCE);
+	assert_float_equal(loudness.short_term, 0.0f, TOLERANCE);
+
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_STEREO, 2, 0x1, -20.0f);
+	assert_float_equal(loudness.momentary, -20.0f + ONE_CHANNEL_OFFSET, TOLERANCE);
+	assert_float_equal(loudness.short_term, -20.0f + ONE_CHANNEL_OFFSET, TOLERANCE);
+}
+
+static void sample_rate_test(void **state)
+{
+	static const uint32_t sample_rates[] = {44100, 48000, 96000};
+	struct audio_loudness loudness;
+
+	UNUSED_PARAMETER(state);
+
+	/* the filter coefficients are derived for every sample rate */
+	for (size_t i = 0; i < sizeof(sample_rates) / sizeof(sample_rates[0]); i++) {
+		measure(&loudness, sample_rates[i], SPEAKERS_STEREO, 2, 0x3, -20.0f);
+		assert_float_equal(loudness.momentary, -20.0f, TOLERANCE);
+	}
+}
+
+static void silence_test(void **state)
+{
+	struct audio_loudness loudness;
+
+	UNUSED_PARAMETER(state);
+
+	audio_loudness_init(&loudness, SAMPLE_RATE, SPEAKERS_STEREO);
+	assert_true(isinf(loudness.momentary) && loudness.momentary < 0.0f);
+	assert_true(isinf(loudness.short_term) && loudness.short_term < 0.0f);
+
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_STEREO, 2, 0x0, -20.0f);
+	assert_true(isinf(loudness.momentary) && loudness.momentary < 0.0f);
+	assert_true(isinf(loudness.short_term) && loudness.short_term < 0.0f);
+}
+
+static void channel_weights_test(void **state)
+{
+	/* FL, FR, FC, LFE, RL, RR */
+	static const float weights_5_1[] = {1.0f, 1.0f, 1.0f, 0.0f, 1.41f, 1.41f};
+
+	UNUSED_PARAMETER(state);
+
+	for (int ch = 0; ch < 6; ch++)
+		assert_float_equal(audio_loudness_channel_weight(SPEAKERS_5POINT1, ch), weights_5_1[ch], 0.0f);
+
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_STEREO, 0), 1.0f, 0.0f);
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_STEREO, 1), 1.0f, 0.0f);
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_2POINT1, 2), 0.0f, 0.0f);
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_4POINT0, 3), 1.41f, 0.0f);
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_7POINT1, 3), 0.0f, 0.0f);
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_7POINT1, 6), 1.41f, 0.0f);
+	assert_float_equal(audio_loudness_channel_weight(SPEAKERS_7POINT1, 7), 1.41f, 0.0f);
+}
+
+static void surround_test(void **state)
+{
+	const float surround_offset = 10.0f * log10f(1.41f);
+	struct audio_loudness loudness;
+
+	UNUSED_PARAMETER(state);
+
+	/* the LFE channel is not measured */
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_5POINT1, 6, 1 << 3, -20.0f);
+	assert_true(isinf(loudness.momentary) && loudness.momentary < 0.0f);
+
+	/* front channels */
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_5POINT1, 6, 1 << 2, -20.0f);
+	assert_float_equal(loudness.momentary, -20.0f + ONE_CHANNEL_OFFSET, TOLERANCE);
+
+	/* surround channels are 1.5 dB louder */
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_5POINT1, 6, 1 << 4, -20.0f);
+	assert_float_equal(loudness.momentary, -20.0f + ONE_CHANNEL_OFFSET + surround_offset, TOLERANCE);
+
+	/* every channel: three front channels and two surround channels */
+	measure(&loudness, SAMPLE_RATE, SPEAKERS_5POINT1, 6, 0x3F, -20.0f);
+	assert_float_equal(loudness.momentary, -20.0f + ONE_CHANNEL_OFFSET + 10.0f * log10f(3.0f + 2.0f * 1.41f),
+			   TOLERANCE);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(stereo_sine_test),
+		cmocka_unit_test(sample_rate_test),
+		cmocka_unit_test(silence_test),
+		cmocka_unit_test(channel_weights_test),
+		cmocka_unit_test(surround_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,312 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <graphics/effect.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+
+#include "benchmark.h"
+
+/* not named after the test, ctest runs it next to its executable */
+#define CACHE_DIR "test_effect_cache_entries"
+#define EFFECT_FILE "test_effect_cache.effect"
+#define INCLUDE_FILE "test_effect_cache_include.effect"
+
+static const char *test_effect = "#include \"" INCLUDE_FILE "\"\n"
+				 "\n"
+				 "uniform float4x4 ViewProj;\n"
+				 "\n"
+				 "float4 VSTest(float4 pos : POSITION) : POSITION\n"
+				 "{\n"
+				 "\treturn mul(float4(pos.xyz, 1.0), ViewProj);\n"
+				 "}\n"
+				 "\n"
+				 "float4 PSTest(float4 pos : POSITION) : TARGET\n"
+				 "{\n"
+				 "\treturn color;\n"
+				 "}\n"
+				 "\n"
+				 "technique Test\n"
+				 "{\n"
+				 "\tpass\n"
+				 "\t{\n"
+				 "\t\tvertex_shader = VSTest(pos);\n"
+				 "\t\tpixel_shader  = PSTest(pos);\n"
+				 "\t}\n"
+				 "}\n";
+
+static void clear_cache_dir(void)
+{
+	os_glob_t *glob;
+
+	if (os_glob(CACHE_DIR "/*", 0, &glob) == 0) {
+		for (size_t i = 0; i < glob->gl_pathc; i++)
+			os_unlink(glob->gl_pathv[i].path);
+		os_globfree(glob);
+	}
+}
+
+static size_t count_cache_entries(void)
+{
+	os_glob_t *glob;
+	size_t count = 0;
+
+	if (os_glob(CACHE_DIR "/*.v*", 0, &glob) == 0) {
+		count = glob->gl_pathc;
+		os_globfree(glob);
+	}
+
+	return count;
+}
+
+static graphics_t *create_graphics(void)
+{
+	graphics_t *graphics = NULL;
+
+	assert_int_equal(gs_create(&graphics, NULL_GRAPHICS_MODULE, 0), GS_SUCCESS);
+	gs_enter_context(graphics);
+
+	clear_cache_dir();
+	gs_set_effect_cache_path(CACHE_DIR);
+	return graphics;
+}
+
+static void destroy_graphics(graphics_t *graphics)
+{
+	clear_cache_dir();
+	gs_leave_context();
+	gs_destroy(graphics);
+}
+
+static void check_param(struct gs_effect_param *a, struct gs_effect_param *b)
+{
+	assert_string_equal(a->name, b->name);
+	assert_int_equal(a->section, b->section);
+	assert_int_equal(a->type, b->type);
+	assert_int_equal(a->default_val.num, b->default_val.num);
+	if (a->default_val.num)
+		assert_memory_equal(a->default_val.array, b->default_val.array, a->default_val.num);
+
+	assert_int_equal(a->annotations.num, b->annotations.num);
+	for (size_t i = 0; i < a->annotations.num; i++)
+		check_param(a->annotations.array + i, b->annotations.array + i);
+}
+
+static void check_shader_params(pass_shaderparam_array_t *a, pass_shaderparam_array_t *b)
+{
+	assert_int_equal(a->num, b->num);
+	for (size_t i = 0; i < a->num; i++) {
+		assert_non_null(b->array[i].sparam);
+		assert_string_equal(a->array[i].eparam->name, b->array[i].eparam->name);
+	}
+}
+
+/* a cached effect must have the same parameters and techniques as a parsed one */
+static void check_effects_equal(gs_effect_t *parsed, gs_effect_t *cached)
+{
+	assert_int_equal(parsed->params.num, cached->params.num);
+	for (size_t i = 0; i < parsed->params.num; i++)
+		check_param(parsed->params.array + i, cached->params.array + i);
+
+	assert_true(!parsed->view_proj || cached->view_proj);
+	assert_true(!parsed->world || cached->world);
+
+	assert_int_equal(parsed->techniques.num, cached->techniques.num);
+	for (size_t i = 0; i < parsed->techniques.num; i++) {
+		struct gs_effect_technique *a = parsed->techniques.array + i;
+		struct gs_effect_technique *b = cached->techniques.array + i;
+
+		assert_string_equal(a->name, b->name);
+		assert_int_equal(a->passes.num, b->passes.num);
+
+		for (size_t j = 0; j < a->passes.num; j++) {
+			struct gs_effect_pass *pass_a = a->passes.array + j;
+			struct gs_effect_pass *pass_b = b->passes.array + j;
+
+			assert_non_null(pass_b->vertshader);
+			assert_non_null(pass_b->pixelshader);
+			check_shader_params(&pass_a->vertshader_params, &pass_b->vertshader_params);
+			check_shader_params(&pass_a->pixelshader_params, &pass_b->pixelshader_params);
+		}
+	}
+}
+
+static gs_effect_t *create_effect(const char *file, uint64_t *time)
+{
+	char *str = os_quick_read_utf8_file(file);
+	uint64_t start;
+	gs_effect_t *effect;
+
+	assert_non_null(str);
+
+	start = os_gettime_ns();
+	effect = gs_effect_create(str, file, NULL);
+	*time += os_gettime_ns() - start;
+
+	bfree(str);
+	return effect;
+}
+
+/* Loads every libobs effect without the cache, when filling it and from it,
+ * and checks that the cached effects match.  With benchmarks enabled, also
+ * reports the time spent in each case. */
+static void effect_cache_startup_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	graphics_t *graphics = create_graphics();
+	uint64_t uncached_time = 0;
+	uint64_t cold_time = 0;
+	uint64_t warm_time = 0;
+	size_t num_effects = 0;
+	os_glob_t *glob;
+
+	assert_int_equal(os_glob(NULL_GRAPHICS_DATA "*.effect", 0, &glob), 0);
+
+	for (size_t i = 0; i < glob->gl_pathc; i++) {
+		const char *file = glob->gl_pathv[i].path;
+		gs_effect_t *uncached;
+		gs_effect_t *parsed;
+		gs_effect_t *cached;
+
+		gs_set_effect_cache_path(NULL);
+		uncached = create_effect(file, &uncached_time);
+		gs_set_effect_cache_path(CACHE_DIR);
+
+		/* effects that fail to build must fail the same way with the
+		 * cache */
+		parsed = create_effect(file, &cold_time);
+		cached = create_effect(file, &warm_time);
+		if (!uncached) {
+			assert_null(parsed);
+			assert_null(cached);
+			continue;
+		}
+
+		assert_non_null(parsed);
+		assert_non_null(cached);
+		check_effects_equal(parsed, cached);
+		num_effects++;
+	}
+
+	os_globfree(glob);
+
+	assert_true(num_effects > 0);
+	assert_int_equal(count_cache_entries(), num_effects);
+
+	if (benchmarks_enabled())
+		print_message("effect cache: %zu effects, %.2f ms without cache, %.2f ms filling cache, "
+			      "%.2f ms from cache\n",
+			      num_effects, (double)uncached_time / 1e6, (double)cold_time / 1e6,
+			      (double)warm_time / 1e6);
+
+	destroy_graphics(graphics);
+}
+
+static void write_include(const char *color)
+{
+	struct dstr str = {0};
+
+	dstr_printf(&str, "uniform float4 color = {%s};\n", color);
+	assert_true(os_quick_write_utf8_file(INCLUDE_FILE, str.array, str.len, false));
+	dstr_free(&str);
+}
+
+static void check_color(gs_effect_t *effect, float red)
+{
+	gs_eparam_t *param = gs_effect_get_param_by_name(effect, "color");
+	float *color;
+
+	assert_non_null(param);
+	color = gs_effect_get_default_val(param);
+	assert_non_null(color);
+	assert_true(color[0] == red);
+	bfree(color);
+}
+
+static gs_effect_t *create_test_effect(void)
+{
+	uint64_t time = 0;
+	return create_effect(EFFECT_FILE, &time);
+}
+
+static void effect_cache_invalidate_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	graphics_t *graphics = create_graphics();
+
+	assert_true(os_quick_write_utf8_file(EFFECT_FILE, test_effect, strlen(test_effect), false));
+	write_include("1.0, 0.0, 0.0, 1.0");
+
+	check_color(create_test_effect(), 1.0f);
+	assert_int_equal(count_cache_entries(), 1);
+	check_color(create_test_effect(), 1.0f);
+
+	/* changing an include must not use the stale entry */
+	write_include("0.5, 0.0, 0.0, 1.0");
+	check_color(create_test_effect(), 0.5f);
+	check_color(create_test_effect(), 0.5f);
+
+	/* damaged entries are parsed again and replaced */
+	os_glob_t *glob;
+	assert_int_equal(os_glob(CACHE_DIR "/*.v*", 0, &glob), 0);
+	assert_int_equal(glob->gl_pathc, 1);
+	assert_true(os_quick_write_utf8_file(glob->gl_pathv[0].path, "OEFC", 4, false));
+	os_globfree(glob);
+
+	check_color(create_test_effect(), 0.5f);
+	check_color(create_test_effect(), 0.5f);
+	assert_int_equal(count_cache_entries(), 1);
+
+	os_unlink(EFFECT_FILE);
+	os_unlink(INCLUDE_FILE);
+	destroy_graphics(graphics);
+}
+
+static void effect_cache_prune_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	graphics_t *graphics = create_graphics();
+	struct dstr text = {0};
+
+	write_include("1.0, 0.0, 0.0, 1.0");
+
+	/* every edit of the effect replaces the entry of the previous text */
+	dstr_copy(&text, test_effect);
+	for (int i = 0; i < 3; i++) {
+		dstr_catf(&text, "// edit %d\n", i);
+		assert_true(os_quick_write_utf8_file(EFFECT_FILE, text.array, text.len, false));
+		check_color(create_test_effect(), 1.0f);
+		assert_int_equal(count_cache_entries(), 1);
+	}
+
+	/* other files with the same text keep their own entries */
+	gs_effect_t *effect = gs_effect_create(text.array, "test_effect_cache_copy.effect", NULL);
+	assert_non_null(effect);
+	gs_effect_destroy(effect);
+	assert_int_equal(count_cache_entries(), 2);
+
+	check_color(create_test_effect(), 1.0f);
+	assert_int_equal(count_cache_entries(), 2);
+
+	dstr_free(&text);
+	os_unlink(EFFECT_FILE);
+	os_unlink(INCLUDE_FILE);
+	destroy_graphics(graphics);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(effect_cache_startup_test),
+		cmocka_unit_test(effect_cache_invalidate_test),
+		cmocka_unit_test(effect_cache_prune_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
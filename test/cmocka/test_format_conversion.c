@@ -0,0 +1,177 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <media-io/format-conversion.h>
+
+#include "benchmark.h"
+
+#define BENCH_ITERATIONS 10
+
+static void fill_pattern(uint8_t *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		data[i] = (uint8_t)(i * 7 + 3);
+}
+
+struct image {
+	uint32_t width;
+	uint32_t height;
+	uint8_t *uyvx;
+	uint32_t uyvx_linesize;
+	uint8_t *planes[3];
+	uint32_t linesizes[3];
+	uint8_t *packed;
+	uint32_t packed_linesize;
+};
+
+static void image_init(struct image *img, uint32_t width, uint32_t height)
+{
+	img->width = width;
+	img->height = height;
+	img->uyvx_linesize = width * 4;
+	img->uyvx = bmalloc((size_t)img->uyvx_linesize * height);
+	fill_pattern(img->uyvx, (size_t)img->uyvx_linesize * height);
+
+	for (size_t i = 0; i < 3; i++) {
+		img->linesizes[i] = width;
+		img->planes[i] = bzalloc((size_t)img->linesizes[i] * height);
+	}
+
+	img->packed_linesize = width * 4;
+	img->packed = bzalloc((size_t)img->packed_linesize * height);
+}
+
+static void image_free(struct image *img)
+{
+	bfree(img->uyvx);
+	for (size_t i = 0; i < 3; i++)
+		bfree(img->planes[i]);
+	bfree(img->packed);
+}
+
+static void image_clear(struct image *img)
+{
+	for (size_t i = 0; i < 3; i++)
+		memset(img->planes[i], 0, (size_t)img->linesizes[i] * img->height);
+	memset(img->packed, 0, (size_t)img->packed_linesize * img->height);
+}
+
+static void assert_images_equal(const struct image *a, const struct image *b)
+{
+	for (size_t i = 0; i < 3; i++)
+		assert_memory_equal(a->planes[i], b->planes[i], (size_t)a->linesizes[i] * a->height);
+	assert_memory_equal(a->packed, b->packed, (size_t)a->packed_linesize * a->height);
+}
+
+static void sliced_matches_serial_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct image serial;
+	struct image sliced;
+
+	format_conversion_set_threads(4);
+
+	/* 1082 rows leaves an uneven last slice */
+	image_init(&serial, 1920, 1082);
+	image_init(&sliced, 1920, 1082);
+
+	compress_uyvx_to_i420(serial.uyvx, serial.uyvx_linesize, 0, serial.height, serial.planes, serial.linesizes);
+	compress_uyvx_to_i420_threaded(sliced.uyvx, sliced.uyvx_linesize, sliced.height, sliced.planes,
+				       sliced.linesizes);
+	assert_images_equal(&serial, &sliced);
+
+	image_clear(&serial);
+	image_clear(&sliced);
+	compress_uyvx_to_nv12(serial.uyvx, serial.uyvx_linesize, 0, serial.height, serial.planes, serial.linesizes);
+	compress_uyvx_to_nv12_threaded(sliced.uyvx, sliced.uyvx_linesize, sliced.height, sliced.planes,
+				       sliced.linesizes);
+	assert_images_equal(&serial, &sliced);
+
+	image_clear(&serial);
+	image_clear(&sliced);
+	convert_uyvx_to_i444(serial.uyvx, serial.uyvx_linesize, 0, serial.height, serial.planes, serial.linesizes);
+	convert_uyvx_to_i444_threaded(sliced.uyvx, sliced.uyvx_linesize, sliced.height, sliced.planes,
+				      sliced.linesizes);
+	assert_images_equal(&serial, &sliced);
+
+	/* feed the planar results back through the decompressors */
+	const uint8_t *const serial_in[] = {serial.planes[0], serial.planes[1], serial.planes[2]};
+	const uint8_t *const sliced_in[] = {sliced.planes[0], sliced.planes[1], sliced.planes[2]};
+	const uint32_t *in_linesize = serial.linesizes;
+
+	decompress_420(serial_in, in_linesize, 0, serial.height, serial.packed, serial.packed_linesize);
+	decompress_420_threaded(sliced_in, in_linesize, sliced.height, sliced.packed, sliced.packed_linesize);
+	assert_images_equal(&serial, &sliced);
+
+	decompress_nv12(serial_in, in_linesize, 0, serial.height, serial.packed, serial.packed_linesize);
+	decompress_nv12_threaded(sliced_in, in_linesize, sliced.height, sliced.packed, sliced.packed_linesize);
+	assert_images_equal(&serial, &sliced);
+
+	decompress_422(serial.uyvx, serial.width, 0, serial.height, serial.packed, serial.packed_linesize, true);
+	decompress_422_threaded(sliced.uyvx, sliced.width, sliced.height, sliced.packed, sliced.packed_linesize,
+				true);
+	assert_images_equal(&serial, &sliced);
+
+	image_free(&serial);
+	image_free(&sliced);
+
+	format_conversion_set_threads(0);
+}
+
+static uint64_t bench_i420(struct image *img, size_t threads)
+{
+	format_conversion_set_threads(threads);
+
+	/* warm up the pool */
+	compress_uyvx_to_i420_threaded(img->uyvx, img->uyvx_linesize, img->height, img->planes, img->linesizes);
+
+	uint64_t start = os_gettime_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++)
+		compress_uyvx_to_i420_threaded(img->uyvx, img->uyvx_linesize, img->height, img->planes,
+					       img->linesizes);
+	return (os_gettime_ns() - start) / BENCH_ITERATIONS;
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	skip_unless_benchmarks_enabled();
+
+	static const uint32_t sizes[][2] = {{1920, 1080}, {3840, 2160}};
+	size_t max_threads = (size_t)os_get_logical_cores();
+	if (max_threads < 1)
+		max_threads = 1;
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		struct image img;
+		image_init(&img, sizes[i][0], sizes[i][1]);
+
+		for (size_t threads = 1; threads <= max_threads; threads++) {
+			uint64_t ns = bench_i420(&img, threads);
+			print_message("uyvx -> i420 %ux%u, %zu thread(s): %.3f ms\n", img.width, img.height, threads,
+				      (double)ns / 1000000.0);
+		}
+
+		image_free(&img);
+	}
+
+	format_conversion_set_threads(0);
+	format_conversion_free_pool();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(sliced_matches_serial_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
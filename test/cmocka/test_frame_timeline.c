@@ -0,0 +1,229 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <jansson.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/frame-timeline.h>
+
+#include "benchmark.h"
+
+#define BENCH_FRAMES 1000000
+#define MSEC 1000000ULL
+
+/* internal to libobs, called by the graphics thread */
+extern void frame_timeline_reset_video(uint32_t fps_num, uint32_t fps_den);
+extern void frame_timeline_free(void);
+extern void frame_timeline_frame_begin(uint64_t start);
+extern uint64_t frame_timeline_phase_begin(void);
+extern void frame_timeline_phase_end(enum frame_timeline_stat phase, uint64_t start);
+extern void frame_timeline_work_end(uint64_t end);
+extern void frame_timeline_frame_end(uint64_t wake_target, uint64_t wake, int lagged);
+
+static void add_frame(uint64_t start, uint64_t work, uint64_t overshoot, int lagged)
+{
+	frame_timeline_frame_begin(start);
+	frame_timeline_phase_end(FRAME_TIMELINE_TICK, frame_timeline_phase_begin());
+	frame_timeline_work_end(start + work);
+	frame_timeline_frame_end(start + 2 * work, start + 2 * work + overshoot, lagged);
+}
+
+static size_t count_events(json_t *trace, const char *name)
+{
+	json_t *events = json_object_get(trace, "traceEvents");
+	size_t count = 0;
+	size_t idx;
+	json_t *event;
+
+	json_array_foreach (events, idx, event) {
+		if (strcmp(json_string_value(json_object_get(event, "name")), name) == 0)
+			count++;
+	}
+
+	return count;
+}
+
+static json_t *get_trace(uint32_t seconds)
+{
+	char *str = frame_timeline_get_chrome_trace(seconds);
+	json_t *trace = json_loads(str, 0, NULL);
+
+	assert_non_null(trace);
+	bfree(str);
+	return trace;
+}
+
+static void percentile_test(void **state)
+{
+	uint64_t value;
+
+	frame_timeline_reset_video(60, 1);
+	assert_false(frame_timeline_get_percentile(FRAME_TIMELINE_FRAME, 50.0, &value));
+
+	for (uint64_t i = 1; i <= 1000; i++)
+		add_frame(i * 20 * MSEC, i * 10000, i == 1000 ? 5 * MSEC : 0, 0);
+
+	/* histogram buckets are within 12.5% of the value */
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_FRAME, 50.0, &value));
+	assert_in_range(value, 5000000 * 7 / 8, 5000000 * 9 / 8);
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_FRAME, 99.0, &value));
+	assert_in_range(value, 9900000 * 7 / 8, 9900000 * 9 / 8);
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_FRAME, 100.0, &value));
+	assert_in_range(value, 10000000 * 7 / 8, 10000000 * 9 / 8);
+
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_SLEEP_OVERSHOOT, 99.0, &value));
+	assert_int_equal(value, 0);
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_SLEEP_OVERSHOOT, 100.0, &value));
+	assert_in_range(value, 5 * MSEC * 7 / 8, 5 * MSEC * 9 / 8);
+
+	/* the first frame has no interval */
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_INTERVAL, 0.0, &value));
+	assert_in_range(value, 20 * MSEC * 7 / 8, 20 * MSEC * 9 / 8);
+
+	/* reset is applied with the next frame */
+	frame_timeline_reset_stats();
+	add_frame(30 * MSEC * 1000, MSEC, 0, 0);
+	assert_true(frame_timeline_get_percentile(FRAME_TIMELINE_FRAME, 0.0, &value));
+	assert_in_range(value, MSEC * 7 / 8, MSEC * 9 / 8);
+
+	frame_timeline_free();
+	UNUSED_PARAMETER(state);
+}
+
+static void trace_test(void **state)
+{
+	json_t *trace;
+
+	/* no video, no records */
+	trace = get_trace(FRAME_TIMELINE_SECONDS);
+	assert_int_equal(count_events(trace, "frame"), 0);
+	json_decref(trace);
+
+	/* 10 fps holds 300 frames, write more than that so it wraps */
+	frame_timeline_reset_video(10, 1);
+	for (uint64_t i = 1; i <= 400; i++)
+		add_frame(i * 100 * MSEC, 10 * MSEC, 0, i % 100 == 0 ? 2 : 0);
+
+	trace = get_trace(5);
+	assert_int_equal(count_events(trace, "frame"), 51);
+	assert_int_equal(count_events(trace, "sleep"), 51);
+	assert_int_equal(count_events(trace, "tick"), 51);
+	assert_int_equal(count_events(trace, "lagged frames"), 1);
+	json_decref(trace);
+
+	trace = get_trace(FRAME_TIMELINE_SECONDS);
+	assert_int_equal(count_events(trace, "frame"), 300);
+	assert_int_equal(count_events(trace, "lagged frames"), 3);
+	json_decref(trace);
+
+	/* disabling is applied with the next frame */
+	frame_timeline_enable(false);
+	assert_false(frame_timeline_enabled());
+	add_frame(401 * 100 * MSEC, 10 * MSEC, 0, 0);
+
+	/* the newest frame is still the lagged frame 400 */
+	trace = get_trace(0);
+	assert_int_equal(count_events(trace, "frame"), 1);
+	assert_int_equal(count_events(trace, "lagged frames"), 1);
+	json_decref(trace);
+
+	frame_timeline_enable(true);
+	frame_timeline_free();
+	UNUSED_PARAMETER(state);
+}
+
+/* the longest "sleep" event of the trace, in microseconds */
+static double max_sleep(json_t *trace)
+{
+	json_t *events = json_object_get(trace, "traceEvents");
+	double max = 0.0;
+	size_t idx;
+	json_t *event;
+
+	json_array_foreach (events, idx, event) {
+		if (strcmp(json_string_value(json_object_get(event, "name")), "sleep") == 0) {
+			double dur = json_number_value(json_object_get(event, "dur"));
+			if (dur > max)
+				max = dur;
+		}
+	}
+
+	return max;
+}
+
+/* frames recorded as the graphics thread does, toggling the timeline from
+ * another thread while a frame is in progress */
+static void toggle_test(void **state)
+{
+	json_t *trace;
+
+	frame_timeline_reset_video(60, 1);
+
+	for (int i = 0; i < 100; i++) {
+		uint64_t start = os_gettime_ns();
+
+		frame_timeline_frame_begin(start);
+		frame_timeline_phase_end(FRAME_TIMELINE_TICK, frame_timeline_phase_begin());
+
+		/* recording is only switched between frames */
+		if (i % 10 == 3)
+			frame_timeline_enable(false);
+		else if (i % 10 == 6)
+			frame_timeline_enable(true);
+
+		frame_timeline_work_end(os_gettime_ns());
+		frame_timeline_frame_end(start, os_gettime_ns(), 0);
+	}
+
+	/* frames 0-3 and 7-9 of every 10 are recorded, each with its wake */
+	trace = get_trace(FRAME_TIMELINE_SECONDS);
+	assert_int_equal(count_events(trace, "frame"), 70);
+	assert_int_equal(count_events(trace, "sleep"), 70);
+	assert_true(max_sleep(trace) < 1000000.0);
+	json_decref(trace);
+
+	frame_timeline_enable(true);
+	frame_timeline_free();
+	UNUSED_PARAMETER(state);
+}
+
+static void benchmark_test(void **state)
+{
+	uint64_t start;
+
+	skip_unless_benchmarks_enabled();
+
+	frame_timeline_reset_video(60, 1);
+
+	start = os_gettime_ns();
+	for (uint64_t i = 0; i < BENCH_FRAMES; i++) {
+		uint64_t frame_start = os_gettime_ns();
+
+		frame_timeline_frame_begin(frame_start);
+		for (int phase = 0; phase < FRAME_TIMELINE_PHASE_COUNT; phase++)
+			frame_timeline_phase_end(phase, frame_timeline_phase_begin());
+		frame_timeline_work_end(os_gettime_ns());
+		frame_timeline_frame_end(frame_start, os_gettime_ns(), 0);
+	}
+
+	print_message("frame timeline: %.1f ns per frame\n", (double)(os_gettime_ns() - start) / (double)BENCH_FRAMES);
+
+	frame_timeline_free();
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(percentile_test),
+		cmocka_unit_test(trace_test),
+		cmocka_unit_test(toggle_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,153 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <util/platform.h>
+
+#define IMAGE_A "test_image_cache_a.tga"
+#define IMAGE_B "test_image_cache_b.tga"
+
+/* uncompressed 32 bit tga */
+static void write_tga(const char *path, uint16_t cx, uint16_t cy)
+{
+	uint8_t header[18] = {0, 0, 2};
+	FILE *file = os_fopen(path, "wb");
+
+	assert_non_null(file);
+
+	header[12] = (uint8_t)cx;
+	header[13] = (uint8_t)(cx >> 8);
+	header[14] = (uint8_t)cy;
+	header[15] = (uint8_t)(cy >> 8);
+	header[16] = 32;
+	header[17] = 8;
+	fwrite(header, 1, sizeof(header), file);
+
+	for (size_t i = 0; i < (size_t)cx * cy; i++) {
+		const uint8_t pixel[4] = {0xFF, 0x80, 0x00, 0xFF};
+		fwrite(pixel, 1, sizeof(pixel), file);
+	}
+
+	fclose(file);
+}
+
+static int setup(void **state)
+{
+	write_tga(IMAGE_A, 16, 8);
+	write_tga(IMAGE_B, 32, 32);
+	UNUSED_PARAMETER(state);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	os_unlink(IMAGE_A);
+	os_unlink(IMAGE_B);
+	UNUSED_PARAMETER(state);
+	return 0;
+}
+
+static void shared_test(void **state)
+{
+	struct obs_image_cache_stats start, stats;
+	obs_image_cache_get_stats(&start);
+
+	obs_cached_image_t *a1 = obs_image_cache_get(IMAGE_A, GS_IMAGE_ALPHA_PREMULTIPLY);
+	obs_cached_image_t *a2 = obs_image_cache_get(IMAGE_A, GS_IMAGE_ALPHA_PREMULTIPLY);
+	obs_cached_image_t *a3 = obs_image_cache_get(IMAGE_A, GS_IMAGE_ALPHA_STRAIGHT);
+
+	/* same file and alpha mode share the image */
+	assert_true(a1 == a2);
+	assert_true(a1 != a3);
+
+	obs_cached_image_wait(a1);
+	obs_cached_image_wait(a3);
+	assert_true(obs_cached_image_decoded(a1));
+	assert_true(obs_cached_image_loaded(a1));
+	assert_int_equal(obs_cached_image_get_width(a1), 16);
+	assert_int_equal(obs_cached_image_get_height(a1), 8);
+	assert_int_equal(obs_cached_image_get_mem_usage(a1), 16 * 8 * 4);
+
+	obs_image_cache_get_stats(&stats);
+	assert_int_equal(stats.hits - start.hits, 1);
+	assert_int_equal(stats.misses - start.misses, 2);
+
+	obs_cached_image_release(a1);
+	obs_cached_image_release(a2);
+	obs_cached_image_release(a3);
+
+	/* unused images stay cached */
+	obs_cached_image_t *a4 = obs_image_cache_get(IMAGE_A, GS_IMAGE_ALPHA_PREMULTIPLY);
+	obs_image_cache_get_stats(&stats);
+	assert_int_equal(stats.hits - start.hits, 2);
+	obs_cached_image_release(a4);
+
+	UNUSED_PARAMETER(state);
+}
+
+static void eviction_test(void **state)
+{
+	struct obs_image_cache_stats stats;
+
+	obs_cached_image_t *a = obs_image_cache_get(IMAGE_A, GS_IMAGE_ALPHA_PREMULTIPLY);
+	obs_cached_image_t *b = obs_image_cache_get(IMAGE_B, GS_IMAGE_ALPHA_PREMULTIPLY);
+	obs_cached_image_wait(a);
+	obs_cached_image_wait(b);
+
+	/* images in use are never evicted */
+	obs_image_cache_set_budget(0);
+	obs_image_cache_get_stats(&stats);
+	assert_int_equal(stats.bytes_unused, 0);
+	assert_true(stats.bytes >= (16 * 8 + 32 * 32) * 4);
+
+	/* unused images are evicted least recently used first */
+	obs_image_cache_set_budget(32 * 32 * 4);
+	obs_cached_image_release(b);
+	obs_cached_image_release(a);
+
+	obs_image_cache_get_stats(&stats);
+	assert_int_equal(stats.bytes_unused, 16 * 8 * 4);
+
+	uint64_t evictions = stats.evictions;
+	obs_image_cache_set_budget(0);
+	obs_image_cache_get_stats(&stats);
+	assert_int_equal(stats.evictions - evictions, 1);
+	assert_int_equal(stats.bytes, 0);
+	assert_int_equal(stats.images, 0);
+
+	UNUSED_PARAMETER(state);
+}
+
+static void missing_test(void **state)
+{
+	struct obs_image_cache_stats stats;
+
+	assert_null(obs_image_cache_get("", GS_IMAGE_ALPHA_STRAIGHT));
+
+	obs_cached_image_t *image = obs_image_cache_get("test_image_cache_missing.tga", GS_IMAGE_ALPHA_STRAIGHT);
+	obs_cached_image_wait(image);
+	assert_true(obs_cached_image_decoded(image));
+	assert_false(obs_cached_image_loaded(image));
+	assert_int_equal(obs_cached_image_get_width(image), 0);
+
+	/* images that failed to load are not kept */
+	obs_cached_image_release(image);
+	obs_image_cache_get_stats(&stats);
+	assert_int_equal(stats.images, 0);
+
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(shared_test),
+		cmocka_unit_test(eviction_test),
+		cmocka_unit_test(missing_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,171 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <graphics/image-file.h>
+#include <util/platform.h>
+
+#define GIF_FILE "test_image_file.gif"
+#define GIF_SIZE 4
+#define GIF_FRAMES 16
+/* in 1/100 seconds */
+#define GIF_DELAY 2
+
+#define FRAME_NS ((uint64_t)GIF_DELAY * 10000000ULL)
+#define FRAME_BYTES (GIF_SIZE * GIF_SIZE * 4)
+
+struct bit_writer {
+	uint8_t data[64];
+	size_t bits;
+};
+
+static void write_code(struct bit_writer *bw, unsigned int code)
+{
+	for (int i = 0; i < 3; i++, bw->bits++) {
+		if (code & (1 << i))
+			bw->data[bw->bits / 8] |= (uint8_t)(1 << (bw->bits % 8));
+	}
+}
+
+/* Every frame is a solid color.  The image data is LZW with a minimum code
+ * size of 2, with a clear code every two pixels to keep codes at 3 bits. */
+static void write_gif(const char *path)
+{
+	static const uint8_t header[] = {'G', 'I', 'F', '8', '9', 'a', GIF_SIZE, 0, GIF_SIZE, 0, 0x81, 0, 0};
+	static const uint8_t palette[] = {0xFF, 0, 0, 0, 0xFF, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF};
+	static const uint8_t loop[] = {0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E',
+				       '2',  '.',  '0',  0x03, 0x01, 0, 0, 0};
+	FILE *file = os_fopen(path, "wb");
+
+	assert_non_null(file);
+	fwrite(header, 1, sizeof(header), file);
+	fwrite(palette, 1, sizeof(palette), file);
+	fwrite(loop, 1, sizeof(loop), file);
+
+	for (int frame = 0; frame < GIF_FRAMES; frame++) {
+		const uint8_t control[] = {0x21, 0xF9, 0x04, 0, GIF_DELAY, 0, 0, 0};
+		const uint8_t descriptor[] = {0x2C, 0, 0, 0, 0, GIF_SIZE, 0, GIF_SIZE, 0, 0, 2};
+		struct bit_writer bw = {{0}, 0};
+
+		for (int i = 0; i < GIF_SIZE * GIF_SIZE; i += 2) {
+			write_code(&bw, 4);
+			write_code(&bw, frame % 4);
+			write_code(&bw, frame % 4);
+		}
+		write_code(&bw, 5);
+
+		const uint8_t size = (uint8_t)((bw.bits + 7) / 8);
+
+		fwrite(control, 1, sizeof(control), file);
+		fwrite(descriptor, 1, sizeof(descriptor), file);
+		fwrite(&size, 1, 1, file);
+		fwrite(bw.data, 1, size, file);
+		fputc(0, file);
+	}
+
+	fputc(0x3B, file);
+	fclose(file);
+}
+
+static int setup(void **state)
+{
+	write_gif(GIF_FILE);
+	UNUSED_PARAMETER(state);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	os_unlink(GIF_FILE);
+	UNUSED_PARAMETER(state);
+	return 0;
+}
+
+/* updates the texture until the frame is decoded, ticks report pending frames */
+static bool wait_for_frame(gs_image_file5_t *if5)
+{
+	for (int i = 0; i < 500; i++) {
+		gs_image_file5_update_texture(if5);
+		if (!gs_image_file5_tick(if5, 0))
+			return true;
+		os_sleep_ms(2);
+	}
+
+	return false;
+}
+
+static void predecode_test(void **state)
+{
+	gs_image_file5_t if5 = {0};
+	gs_image_file_t *image = &if5.image4.image3.image2.image;
+
+	/* gifs that fit in the budget are decoded up front as before */
+	gs_image_file5_init(&if5, GIF_FILE, GS_IMAGE_ALPHA_PREMULTIPLY, UINT64_MAX);
+	assert_true(image->loaded);
+	assert_true(image->is_animated_gif);
+	assert_null(if5.stream);
+	assert_int_equal(image->gif.frame_count, GIF_FRAMES);
+	assert_true(if5.image4.image3.image2.mem_usage >= GIF_FRAMES * FRAME_BYTES);
+
+	gs_image_file5_free(&if5);
+	UNUSED_PARAMETER(state);
+}
+
+static void stream_test(void **state)
+{
+	gs_image_file5_t if5 = {0};
+	gs_image_file_t *image = &if5.image4.image3.image2.image;
+
+	gs_image_file5_init(&if5, GIF_FILE, GS_IMAGE_ALPHA_PREMULTIPLY, FRAME_BYTES * 4);
+	assert_true(image->loaded);
+	assert_true(image->is_animated_gif);
+	assert_non_null(if5.stream);
+	assert_int_equal(image->cx, GIF_SIZE);
+	assert_int_equal(image->cy, GIF_SIZE);
+
+	/* only the look-ahead window is kept decoded */
+	assert_true(if5.image4.image3.image2.mem_usage < GIF_FRAMES * FRAME_BYTES);
+
+	/* frames follow the frame delays */
+	assert_false(gs_image_file5_tick(&if5, FRAME_NS / 2));
+	assert_true(gs_image_file5_tick(&if5, FRAME_NS));
+	assert_int_equal(image->cur_frame, 1);
+	assert_true(wait_for_frame(&if5));
+
+	for (int i = 2; i < GIF_FRAMES; i++) {
+		assert_true(gs_image_file5_tick(&if5, FRAME_NS));
+		assert_int_equal(image->cur_frame, i);
+		assert_true(wait_for_frame(&if5));
+	}
+
+	assert_true(gs_image_file5_tick(&if5, FRAME_NS));
+	assert_int_equal(image->cur_frame, 0);
+	assert_true(wait_for_frame(&if5));
+
+	/* skipping several loops ahead jumps straight to the loop of the frame */
+	assert_true(gs_image_file5_tick(&if5, FRAME_NS * (GIF_FRAMES * 5 + 3)));
+	assert_int_equal(image->cur_frame, 3);
+	assert_true(wait_for_frame(&if5));
+
+	/* restarting goes back to the first frame */
+	image->cur_frame = 0;
+	image->cur_loop = 0;
+	image->cur_time = 0;
+	assert_true(wait_for_frame(&if5));
+
+	gs_image_file5_free(&if5);
+	assert_null(if5.stream);
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(predecode_test),
+		cmocka_unit_test(stream_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
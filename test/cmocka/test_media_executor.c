@@ -0,0 +1,176 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <media-playback/executor.h>
+
+#define WAKE_THREADS 4
+#define WAKES_PER_THREAD 2000
+#define DESTROY_ITERATIONS 200
+
+/* far enough that only a wake runs the step before the test times out */
+#define FAR_DEADLINE_NS 10000000000ULL
+
+struct step_state {
+	volatile long in_step;
+	volatile long overlaps;
+	volatile long steps;
+	volatile long requested;
+	volatile long seen;
+	volatile bool destroyed;
+	volatile long after_destroy;
+};
+
+static uint64_t race_step(void *param)
+{
+	struct step_state *state = param;
+	long steps;
+
+	if (os_atomic_inc_long(&state->in_step) != 1)
+		os_atomic_inc_long(&state->overlaps);
+	if (os_atomic_load_bool(&state->destroyed))
+		os_atomic_inc_long(&state->after_destroy);
+
+	os_atomic_set_long(&state->seen, os_atomic_load_long(&state->requested));
+	steps = os_atomic_inc_long(&state->steps);
+
+	os_atomic_dec_long(&state->in_step);
+
+	/* alternates between deadlines that race with wakes and ones that
+	 * are only reached by a wake */
+	return os_gettime_ns() + (steps % 2 ? 1000000ULL : FAR_DEADLINE_NS);
+}
+
+struct wake_args {
+	mp_task_t *task;
+	struct step_state *state;
+};
+
+/* spins for up to 100 us, so wakes land at every point of a step */
+static void spin(unsigned *seed)
+{
+	uint64_t until;
+
+	*seed = *seed * 1103515245 + 12345;
+	until = os_gettime_ns() + (*seed >> 8) % 100000;
+
+	while (os_gettime_ns() < until)
+		;
+}
+
+static void *request_thread(void *param)
+{
+	struct wake_args *args = param;
+	unsigned seed = (unsigned)(uintptr_t)&seed;
+
+	for (int i = 0; i < WAKES_PER_THREAD; i++) {
+		os_atomic_inc_long(&args->state->requested);
+		mp_task_wake(args->task);
+		spin(&seed);
+	}
+
+	return NULL;
+}
+
+/* every wake is followed by a step that sees it, even while wakes cancel
+ * pending deadline steps that are starting on a worker at the same time */
+static void wake_race(bool own_thread)
+{
+	struct step_state step_state = {0};
+	pthread_t threads[WAKE_THREADS];
+	struct wake_args args;
+	long requested;
+
+	args.state = &step_state;
+	args.task = mp_task_create("test task", race_step, &step_state, own_thread);
+	assert_non_null(args.task);
+
+	for (int i = 0; i < WAKE_THREADS; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, request_thread, &args), 0);
+	for (int i = 0; i < WAKE_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	requested = os_atomic_load_long(&step_state.requested);
+	for (int i = 0; i < 2000 && os_atomic_load_long(&step_state.seen) != requested; i++)
+		os_sleep_ms(1);
+
+	assert_int_equal(os_atomic_load_long(&step_state.seen), requested);
+	assert_int_equal(os_atomic_load_long(&step_state.overlaps), 0);
+
+	mp_task_destroy(args.task);
+}
+
+static void wake_race_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	wake_race(false);
+}
+
+static void wake_race_thread_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	wake_race(true);
+}
+
+/* a step that is pending, starting or running while the task is destroyed
+ * is either prevented or waited for */
+static void destroy_race(bool own_thread)
+{
+	unsigned seed = 1;
+
+	for (int i = 0; i < DESTROY_ITERATIONS; i++) {
+		struct step_state step_state = {0};
+		mp_task_t *task = mp_task_create("test task", race_step, &step_state, own_thread);
+
+		assert_non_null(task);
+
+		spin(&seed);
+		for (int j = 0; j < i % 4; j++) {
+			mp_task_wake(task);
+			spin(&seed);
+		}
+
+		mp_task_destroy(task);
+		os_atomic_set_bool(&step_state.destroyed, true);
+
+		/* gives a step that wasn't waited for the time to run */
+		if (i % 50 == 0)
+			os_sleep_ms(5);
+
+		assert_int_equal(os_atomic_load_long(&step_state.overlaps), 0);
+		assert_int_equal(os_atomic_load_long(&step_state.in_step), 0);
+		assert_int_equal(os_atomic_load_long(&step_state.after_destroy), 0);
+	}
+}
+
+static void destroy_race_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	destroy_race(false);
+}
+
+static void destroy_race_thread_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	destroy_race(true);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(wake_race_test),
+		cmocka_unit_test(wake_race_thread_test),
+		cmocka_unit_test(destroy_race_test),
+		cmocka_unit_test(destroy_race_thread_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
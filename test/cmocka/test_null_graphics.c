@@ -0,0 +1,334 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <graphics/vec4.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "benchmark.h"
+
+#define TARGET_SIZE 8
+
+#define BENCH_SOURCES 2000
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_SECONDS 2
+
+/* without benchmarks, a few sources are rendered until the first frame
+ * reaches the raw video callback */
+#define SMOKE_SOURCES 16
+#define SMOKE_TIMEOUT_MS 5000
+
+static void set_rasterize(bool rasterize)
+{
+#ifdef _WIN32
+	_putenv_s("OBS_NULL_RENDERER_RASTERIZE", rasterize ? "1" : "");
+#else
+	if (rasterize)
+		setenv("OBS_NULL_RENDERER_RASTERIZE", "1", 1);
+	else
+		unsetenv("OBS_NULL_RENDERER_RASTERIZE");
+#endif
+}
+
+static graphics_t *create_graphics(bool rasterize)
+{
+	graphics_t *graphics = NULL;
+
+	set_rasterize(rasterize);
+	assert_int_equal(gs_create(&graphics, NULL_GRAPHICS_MODULE, 0), GS_SUCCESS);
+	set_rasterize(false);
+
+	gs_enter_context(graphics);
+	assert_int_equal(gs_get_device_type(), GS_DEVICE_NULL);
+	return graphics;
+}
+
+static void destroy_graphics(graphics_t *graphics)
+{
+	gs_leave_context();
+	gs_destroy(graphics);
+}
+
+static uint32_t read_pixel(gs_stagesurf_t *stage, uint32_t x, uint32_t y)
+{
+	uint8_t *data;
+	uint32_t linesize;
+	uint32_t pixel;
+
+	assert_true(gs_stagesurface_map(stage, &data, &linesize));
+	memcpy(&pixel, data + y * linesize + x * 4, sizeof(pixel));
+	gs_stagesurface_unmap(stage);
+	return pixel;
+}
+
+static void null_texture_upload_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	graphics_t *graphics = create_graphics(false);
+	uint32_t pixels[TARGET_SIZE * TARGET_SIZE];
+	const uint8_t *data = (const uint8_t *)pixels;
+	uint8_t *ptr;
+	uint32_t linesize;
+
+	for (uint32_t i = 0; i < TARGET_SIZE * TARGET_SIZE; i++)
+		pixels[i] = i;
+
+	gs_texture_t *tex = gs_texture_create(TARGET_SIZE, TARGET_SIZE, GS_RGBA, 1, &data, GS_DYNAMIC);
+	gs_stagesurf_t *stage = gs_stagesurface_create(TARGET_SIZE, TARGET_SIZE, GS_RGBA);
+	assert_non_null(tex);
+	assert_non_null(stage);
+
+	gs_stage_texture(stage, tex);
+	assert_int_equal(read_pixel(stage, 3, 5), 5 * TARGET_SIZE + 3);
+
+	assert_true(gs_texture_map(tex, &ptr, &linesize));
+	assert_false(gs_texture_map(tex, &ptr, &linesize));
+	memset(ptr + linesize, 0xFF, linesize);
+	gs_texture_unmap(tex);
+
+	gs_stage_texture(stage, tex);
+	assert_int_equal(read_pixel(stage, 2, 1), 0xFFFFFFFF);
+	assert_int_equal(read_pixel(stage, 2, 2), 2 * TARGET_SIZE + 2);
+
+	gs_stagesurface_destroy(stage);
+	gs_texture_destroy(tex);
+	destroy_graphics(graphics);
+}
+
+static void null_texrender_clear_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	graphics_t *graphics = create_graphics(false);
+	gs_texrender_t *texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	gs_stagesurf_t *stage = gs_stagesurface_create(TARGET_SIZE, TARGET_SIZE, GS_RGBA);
+	struct vec4 color;
+
+	vec4_set(&color, 1.0f, 0.0f, 1.0f, 1.0f);
+
+	assert_true(gs_texrender_begin(texrender, TARGET_SIZE, TARGET_SIZE));
+	gs_clear(GS_CLEAR_COLOR, &color, 0.0f, 0);
+	gs_texrender_end(texrender);
+
+	gs_stage_texture(stage, gs_texrender_get_texture(texrender));
+	assert_int_equal(read_pixel(stage, 0, 0), 0xFFFF00FF);
+	assert_int_equal(read_pixel(stage, TARGET_SIZE - 1, TARGET_SIZE - 1), 0xFFFF00FF);
+
+	gs_stagesurface_destroy(stage);
+	gs_texrender_destroy(texrender);
+	destroy_graphics(graphics);
+}
+
+/* a solid sprite covering the top left quadrant of the target */
+static void null_rasterize_sprite_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	graphics_t *graphics = create_graphics(true);
+	char *path = os_get_abs_path_ptr(NULL_GRAPHICS_DATA "solid.effect");
+	gs_effect_t *solid = gs_effect_create_from_file(path, NULL);
+	gs_texrender_t *texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	gs_stagesurf_t *stage = gs_stagesurface_create(TARGET_SIZE, TARGET_SIZE, GS_RGBA);
+	struct vec4 clear_color;
+	struct vec4 color;
+
+	assert_non_null(solid);
+	vec4_zero(&clear_color);
+	vec4_set(&color, 0.0f, 1.0f, 0.0f, 1.0f);
+
+	assert_true(gs_texrender_begin(texrender, TARGET_SIZE, TARGET_SIZE));
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+	gs_ortho(0.0f, (float)TARGET_SIZE, 0.0f, (float)TARGET_SIZE, -100.0f, 100.0f);
+
+	gs_effect_set_vec4(gs_effect_get_param_by_name(solid, "color"), &color);
+	while (gs_effect_loop(solid, "Solid"))
+		gs_draw_sprite(NULL, 0, TARGET_SIZE / 2, TARGET_SIZE / 2);
+
+	gs_texrender_end(texrender);
+
+	gs_stage_texture(stage, gs_texrender_get_texture(texrender));
+	assert_int_equal(read_pixel(stage, 0, 0), 0xFF00FF00);
+	assert_int_equal(read_pixel(stage, TARGET_SIZE / 2 - 1, TARGET_SIZE / 2 - 1), 0xFF00FF00);
+	assert_int_equal(read_pixel(stage, TARGET_SIZE / 2, 0), 0);
+	assert_int_equal(read_pixel(stage, 0, TARGET_SIZE / 2), 0);
+
+	gs_stagesurface_destroy(stage);
+	gs_texrender_destroy(texrender);
+	gs_effect_destroy(solid);
+	bfree(path);
+	destroy_graphics(graphics);
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct bench_source {
+	obs_source_t *source;
+	struct vec4 color;
+};
+
+static const char *bench_source_get_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "Benchmark source";
+}
+
+static void *bench_source_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct bench_source *context = bzalloc(sizeof(struct bench_source));
+	uint32_t seed = (uint32_t)(uintptr_t)source;
+
+	UNUSED_PARAMETER(settings);
+
+	context->source = source;
+	vec4_set(&context->color, (float)(seed & 0xFF) / 255.0f, (float)((seed >> 8) & 0xFF) / 255.0f,
+		 (float)((seed >> 16) & 0xFF) / 255.0f, 1.0f);
+	return context;
+}
+
+static void bench_source_destroy(void *data)
+{
+	bfree(data);
+}
+
+static uint32_t bench_source_get_width(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return 64;
+}
+
+static uint32_t bench_source_get_height(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return 64;
+}
+
+static void bench_source_render(void *data, gs_effect_t *effect)
+{
+	struct bench_source *context = data;
+	gs_effect_t *solid = obs_get_base_effect(OBS_EFFECT_SOLID);
+
+	UNUSED_PARAMETER(effect);
+
+	gs_effect_set_vec4(gs_effect_get_param_by_name(solid, "color"), &context->color);
+	while (gs_effect_loop(solid, "Solid"))
+		gs_draw_sprite(NULL, 0, 64, 64);
+}
+
+static struct obs_source_info bench_source_info = {
+	.id = "null_graphics_bench_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_VIDEO,
+	.get_name = bench_source_get_name,
+	.create = bench_source_create,
+	.destroy = bench_source_destroy,
+	.get_width = bench_source_get_width,
+	.get_height = bench_source_get_height,
+	.video_render = bench_source_render,
+};
+
+static volatile long bench_frames = 0;
+
+static void bench_raw_video(void *param, struct video_data *frame)
+{
+	UNUSED_PARAMETER(param);
+	UNUSED_PARAMETER(frame);
+	os_atomic_inc_long(&bench_frames);
+}
+
+/* Renders a scene of synthetic sources through the regular graphics thread
+ * and output conversion.  With benchmarks enabled, renders a large scene for a
+ * fixed time and reports the throughput. */
+static void null_render_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const bool benchmark = benchmarks_enabled();
+	const int num_sources = benchmark ? BENCH_SOURCES : SMOKE_SOURCES;
+
+	struct obs_video_info ovi = {
+		.graphics_module = NULL_GRAPHICS_MODULE,
+		.fps_num = 60,
+		.fps_den = 1,
+		.base_width = BENCH_WIDTH,
+		.base_height = BENCH_HEIGHT,
+		.output_width = BENCH_WIDTH,
+		.output_height = BENCH_HEIGHT,
+		.output_format = VIDEO_FORMAT_NV12,
+		.gpu_conversion = true,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+		.scale_type = OBS_SCALE_BICUBIC,
+	};
+
+	/* effects are loaded from the source tree rather than an install */
+	PRAGMA_WARN_PUSH
+	PRAGMA_WARN_DEPRECATION
+	obs_add_data_path(NULL_GRAPHICS_DATA);
+	PRAGMA_WARN_POP
+
+	assert_true(obs_startup("en-US", NULL, NULL));
+	assert_int_equal(obs_reset_video(&ovi), OBS_VIDEO_SUCCESS);
+
+	obs_register_source(&bench_source_info);
+
+	obs_scene_t *scene = obs_scene_create("null graphics benchmark");
+	for (int i = 0; i < num_sources; i++) {
+		obs_source_t *source = obs_source_create(bench_source_info.id, "source", NULL, NULL);
+		obs_sceneitem_t *item = obs_scene_add(scene, source);
+		struct vec2 pos;
+
+		vec2_set(&pos, (float)((i * 37) % (BENCH_WIDTH - 64)), (float)((i * 53) % (BENCH_HEIGHT - 64)));
+		obs_sceneitem_set_pos(item, &pos);
+		obs_source_release(source);
+	}
+
+	obs_set_output_source(0, obs_scene_get_source(scene));
+	obs_add_raw_video_callback(NULL, bench_raw_video, NULL);
+
+	uint32_t lagged_start = obs_get_lagged_frames();
+	uint64_t start = os_gettime_ns();
+
+	if (benchmark) {
+		os_sleep_ms(BENCH_SECONDS * 1000);
+	} else {
+		for (int ms = 0; ms < SMOKE_TIMEOUT_MS && !os_atomic_load_long(&bench_frames); ms += 10)
+			os_sleep_ms(10);
+	}
+
+	uint64_t elapsed = os_gettime_ns() - start;
+	long frames = os_atomic_load_long(&bench_frames);
+	uint32_t lagged = obs_get_lagged_frames() - lagged_start;
+
+	obs_remove_raw_video_callback(bench_raw_video, NULL);
+
+	if (benchmark)
+		print_message("null renderer: %d sources, %ld frames in %.2f s (%.1f fps), %u lagged, "
+			      "%.3f ms average frame time\n",
+			      num_sources, frames, (double)elapsed / 1e9, (double)frames * 1e9 / (double)elapsed,
+			      lagged, (double)obs_get_average_frame_time_ns() / 1e6);
+
+	assert_true(frames > 0);
+
+	obs_set_output_source(0, NULL);
+	obs_scene_release(scene);
+	obs_shutdown();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(null_texture_upload_test),
+		cmocka_unit_test(null_texrender_clear_test),
+		cmocka_unit_test(null_rasterize_sprite_test),
+		cmocka_unit_test(null_render_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,593 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <cmocka.h>
+
+#include <jansson.h>
+#include <obs-data.h>
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#include "benchmark.h"
+
+#define BENCH_SOURCES 5000
+#define BENCH_ITERATIONS 5
+#define BENCH_UPDATES 200000
+
+/* ------------------------------------------------------------------------- */
+/* Reference: conversion through a jansson tree, as obs-data did before */
+
+static void dom_add_item(obs_data_t *data, const char *key, json_t *json);
+
+static void dom_add_object_data(obs_data_t *data, json_t *jobj)
+{
+	const char *key;
+	json_t *jitem;
+
+	json_object_foreach (jobj, key, jitem) {
+		dom_add_item(data, key, jitem);
+	}
+}
+
+static void dom_add_item(obs_data_t *data, const char *key, json_t *json)
+{
+	if (json_is_object(json)) {
+		obs_data_t *obj = obs_data_create();
+		dom_add_object_data(obj, json);
+		obs_data_set_obj(data, key, obj);
+		obs_data_release(obj);
+
+	} else if (json_is_array(json)) {
+		obs_data_array_t *array = obs_data_array_create();
+		size_t idx;
+		json_t *jitem;
+
+		json_array_foreach (json, idx, jitem) {
+			if (!json_is_object(jitem))
+				continue;
+
+			obs_data_t *obj = obs_data_create();
+			dom_add_object_data(obj, jitem);
+			obs_data_array_push_back(array, obj);
+			obs_data_release(obj);
+		}
+
+		obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+
+	} else if (json_is_string(json)) {
+		obs_data_set_string(data, key, json_string_value(json));
+	} else if (json_is_integer(json)) {
+		obs_data_set_int(data, key, json_integer_value(json));
+	} else if (json_is_real(json)) {
+		obs_data_set_double(data, key, json_real_value(json));
+	} else if (json_is_true(json)) {
+		obs_data_set_bool(data, key, true);
+	} else if (json_is_false(json)) {
+		obs_data_set_bool(data, key, false);
+	}
+}
+
+static obs_data_t *dom_create_from_json(const char *str)
+{
+	json_error_t error;
+	json_t *root = json_loads(str, JSON_REJECT_DUPLICATES, &error);
+	obs_data_t *data;
+
+	if (!root)
+		return NULL;
+
+	data = obs_data_create();
+	dom_add_object_data(data, root);
+	json_decref(root);
+	return data;
+}
+
+static json_t *dom_to_json(obs_data_t *data, bool with_defaults)
+{
+	json_t *json = json_object();
+	obs_data_item_t *item = obs_data_first(data);
+
+	for (; item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+
+		if (!with_defaults && !obs_data_item_has_user_value(item))
+			continue;
+
+		switch (obs_data_item_gettype(item)) {
+		case OBS_DATA_STRING:
+			json_object_set_new(json, name, json_string(obs_data_item_get_string(item)));
+			break;
+
+		case OBS_DATA_NUMBER:
+			if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+				json_object_set_new(json, name, json_integer(obs_data_item_get_int(item)));
+			else
+				json_object_set_new(json, name, json_real(obs_data_item_get_double(item)));
+			break;
+
+		case OBS_DATA_BOOLEAN:
+			json_object_set_new(json, name, obs_data_item_get_bool(item) ? json_true() : json_false());
+			break;
+
+		case OBS_DATA_OBJECT: {
+			obs_data_t *obj = obs_data_item_get_obj(item);
+			json_object_set_new(json, name, dom_to_json(obj, with_defaults));
+			obs_data_release(obj);
+			break;
+		}
+
+		case OBS_DATA_ARRAY: {
+			obs_data_array_t *array = obs_data_item_get_array(item);
+			json_t *jarray = json_array();
+
+			for (size_t i = 0; i < obs_data_array_count(array); i++) {
+				obs_data_t *obj = obs_data_array_item(array, i);
+				json_array_append_new(jarray, dom_to_json(obj, with_defaults));
+				obs_data_release(obj);
+			}
+
+			json_object_set_new(json, name, jarray);
+			obs_data_array_release(array);
+			break;
+		}
+
+		case OBS_DATA_NULL:
+			break;
+		}
+	}
+
+	return json;
+}
+
+/* returned string is allocated by jansson */
+static char *dom_get_json(obs_data_t *data, bool pretty, bool with_defaults)
+{
+	size_t flags = JSON_PRESERVE_ORDER | (pretty ? JSON_INDENT(4) : JSON_COMPACT);
+	json_t *root = dom_to_json(data, with_defaults);
+	char *json = json_dumps(root, flags);
+
+	json_decref(root);
+	return json;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static obs_data_t *create_settings(size_t idx)
+{
+	obs_data_t *settings = obs_data_create();
+	obs_data_t *crop = obs_data_create();
+	struct dstr path = {0};
+
+	dstr_printf(&path, "C:\\Users\\Streamer\\Pictures\\image_%zu.png", idx);
+	obs_data_set_string(settings, "file", path.array);
+	obs_data_set_bool(settings, "unload", idx % 3 == 0);
+	obs_data_set_int(settings, "color", 0xFF336699 + (long long)idx);
+	obs_data_set_double(settings, "opacity", 0.125 * (double)(idx % 8));
+	obs_data_set_default_int(settings, "width", 1920);
+
+	obs_data_set_int(crop, "left", (long long)idx % 100);
+	obs_data_set_int(crop, "right", -(long long)idx);
+	obs_data_set_obj(settings, "crop", crop);
+
+	obs_data_release(crop);
+	dstr_free(&path);
+	return settings;
+}
+
+static obs_data_t *create_source(size_t idx)
+{
+	obs_data_t *source = obs_data_create();
+	obs_data_t *settings = create_settings(idx);
+	obs_data_array_t *filters = obs_data_array_create();
+	struct dstr str = {0};
+
+	dstr_printf(&str, "Source \"%zu\" \xC3\xA9\xE2\x82\xAC\t/ \xF0\x9F\x8E\xA5", idx);
+	obs_data_set_string(source, "name", str.array);
+	dstr_printf(&str, "%08zx-0000-4000-8000-%012zx", idx, idx * 31);
+	obs_data_set_string(source, "uuid", str.array);
+	obs_data_set_string(source, "id", "image_source");
+	obs_data_set_int(source, "flags", (long long)idx * 7);
+	obs_data_set_double(source, "volume", 0.5 * (double)(idx % 4));
+	obs_data_set_double(source, "balance", 0.5);
+	obs_data_set_bool(source, "enabled", idx % 2 == 0);
+	obs_data_set_bool(source, "muted", false);
+	obs_data_set_obj(source, "settings", settings);
+
+	for (size_t i = 0; i < 2; i++) {
+		obs_data_t *filter = obs_data_create();
+		obs_data_t *filter_settings = create_settings(idx + i);
+
+		obs_data_set_string(filter, "name", i ? "Color Correction" : "Crop/Pad");
+		obs_data_set_string(filter, "id", i ? "color_filter_v2" : "crop_filter");
+		obs_data_set_obj(filter, "settings", filter_settings);
+		obs_data_array_push_back(filters, filter);
+
+		obs_data_release(filter_settings);
+		obs_data_release(filter);
+	}
+
+	obs_data_set_array(source, "filters", filters);
+
+	obs_data_array_release(filters);
+	obs_data_release(settings);
+	dstr_free(&str);
+	return source;
+}
+
+static obs_data_t *create_collection(size_t count)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *source = create_source(i);
+		obs_data_array_push_back(sources, source);
+		obs_data_release(source);
+	}
+
+	obs_data_set_string(collection, "name", "Benchmark");
+	obs_data_set_string(collection, "current_scene", "Scene\n\"Main\"\\\x01");
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_set_array(collection, "groups", NULL);
+
+	obs_data_array_release(sources);
+	return collection;
+}
+
+static void assert_same_json(obs_data_t *a, obs_data_t *b)
+{
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_string_equal(obs_data_get_json_with_defaults(a), obs_data_get_json_with_defaults(b));
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void writer_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *collection = create_collection(20);
+
+	for (int i = 0; i < 4; i++) {
+		bool pretty = i & 1;
+		bool with_defaults = i & 2;
+		const char *json = pretty ? (with_defaults ? obs_data_get_json_pretty_with_defaults(collection)
+							   : obs_data_get_json_pretty(collection))
+					  : (with_defaults ? obs_data_get_json_with_defaults(collection)
+							   : obs_data_get_json(collection));
+		char *expected = dom_get_json(collection, pretty, with_defaults);
+
+		assert_string_equal(json, expected);
+		free(expected);
+	}
+
+	obs_data_release(collection);
+}
+
+static void parser_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const char *docs[] = {
+		"{}",
+		" [ {\"a\": 1}, 2 ] ",
+		"{\"str\": \"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\u00e9\\u20AC\\ud83c\\udfa5\", \"raw\": \"\xC3\xA9\"}",
+		"{\"ints\": {\"zero\": -0, \"max\": 9223372036854775807, \"min\": -9223372036854775808, "
+		"\"long\": 123456789012345678}}",
+		"{\"reals\": {\"a\": 0.5, \"b\": -1.25e3, \"c\": 1E-3, \"d\": 1e-400, \"e\": 2.0}}",
+		"{\"n\": null, \"t\": true, \"f\": false, \"o\": {\"n\": null}}",
+		"{\"arr\": [1, \"x\", null, [ {\"a\": 1} ], {\"b\": [ ]}, {}], \"empty\": []}",
+		"\n{\n\t\"nested\": {\"a\": {\"b\": {\"c\": [{\"d\": {\"e\": \"deep\"}}]}}}\r\n}\n",
+	};
+
+	for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+		obs_data_t *data = obs_data_create_from_json(docs[i]);
+		obs_data_t *expected = dom_create_from_json(docs[i]);
+
+		assert_same_json(data, expected);
+		obs_data_release(data);
+		obs_data_release(expected);
+	}
+
+	obs_data_t *data = obs_data_create_from_json(docs[2]);
+	assert_string_equal(obs_data_get_string(data, "str"),
+			    "a\"b\\c/d\b\f\n\r\t\xC3\xA9\xE2\x82\xAC\xF0\x9F\x8E\xA5");
+	obs_data_release(data);
+
+	data = obs_data_create_from_json(docs[3]);
+	obs_data_t *ints = obs_data_get_obj(data, "ints");
+	assert_int_equal(obs_data_get_int(ints, "min"), LLONG_MIN);
+	assert_int_equal(obs_data_get_int(ints, "long"), 123456789012345678LL);
+	obs_data_release(ints);
+	obs_data_release(data);
+
+	obs_data_t *collection = create_collection(20);
+	const char *json = obs_data_get_json_pretty(collection);
+
+	data = obs_data_create_from_json(json);
+	obs_data_t *expected = dom_create_from_json(json);
+	assert_same_json(data, expected);
+	assert_string_equal(obs_data_get_json_pretty(data), json);
+
+	obs_data_release(expected);
+	obs_data_release(data);
+	obs_data_release(collection);
+}
+
+static void invalid_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const char *docs[] = {
+		"",
+		"   ",
+		"\"str\"",
+		"1",
+		"{",
+		"{\"a\": 1,}",
+		"[1, ]",
+		"{\"a\" 1}",
+		"{\"a\": 1} x",
+		"{\"a\": 1, \"a\": 2}",
+		"{\"a\": {\"b\": 1, \"b\": 1}}",
+		"{\"a\": tru}",
+		"{\"a\": nul}",
+		"{\"a\": 01}",
+		"{\"a\": 1.}",
+		"{\"a\": .5}",
+		"{\"a\": 1e}",
+		"{\"a\": -}",
+		"{\"a\": 9223372036854775808}",
+		"{\"a\": 1e400}",
+		"{\"a\": \"\\x\"}",
+		"{\"a\": \"\\u12\"}",
+		"{\"a\": \"\\u0000\"}",
+		"{\"a\": \"\\ud83c\"}",
+		"{\"a\": \"\\udfa5\"}",
+		"{\"a\": \"tab\there\"}",
+		"{\"a\": \"\xC3\"}",
+		"{\"a\": \"\xC0\xAF\"}",
+		"{\"a\": \"\xED\xA0\x80\"}",
+		"{\"a\": \"unterminated",
+		"{'a': 1}",
+	};
+
+	for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+		obs_data_t *expected = dom_create_from_json(docs[i]);
+		assert_null(expected);
+		assert_null(obs_data_create_from_json(docs[i]));
+	}
+
+	struct dstr deep = {0};
+	for (int i = 0; i < 3000; i++)
+		dstr_cat(&deep, "{\"a\":");
+	assert_null(obs_data_create_from_json(deep.array));
+	dstr_free(&deep);
+}
+
+static void arena_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create_from_json(
+		"{\"obj\": {\"name\": \"short\", \"value\": 1}, \"array\": [{\"name\": \"element\"}]}");
+	obs_data_t *obj = obs_data_get_obj(data, "obj");
+	obs_data_array_t *array = obs_data_get_array(data, "array");
+
+	/* the parsed data stays valid and writable after the document itself
+	 * is released */
+	obs_data_release(data);
+
+	obs_data_set_string(obj, "name", "a string that is much longer than the one it replaces");
+	obs_data_set_int(obj, "value", 2);
+	obs_data_set_default_string(obj, "value2", "default");
+	obs_data_set_obj(obj, "self", NULL);
+	obs_data_erase(obj, "self");
+
+	assert_string_equal(obs_data_get_string(obj, "name"), "a string that is much longer than the one it replaces");
+	assert_int_equal(obs_data_get_int(obj, "value"), 2);
+	assert_string_equal(obs_data_get_string(obj, "value2"), "default");
+
+	obs_data_item_t *item = obs_data_item_byname(obj, "name");
+	obs_data_release(obj);
+	assert_string_equal(obs_data_item_get_string(item), "a string that is much longer than the one it replaces");
+	obs_data_item_release(&item);
+
+	obs_data_t *element = obs_data_array_item(array, 0);
+	obs_data_array_release(array);
+	assert_string_equal(obs_data_get_string(element, "name"), "element");
+	obs_data_release(element);
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	skip_unless_benchmarks_enabled();
+
+	obs_data_t *collection = create_collection(BENCH_SOURCES);
+	char *json = bstrdup(obs_data_get_json_pretty(collection));
+	uint64_t start, stream_read = 0, dom_read = 0, stream_write = 0, dom_write = 0;
+	long long stream_allocs = 0, dom_allocs = 0;
+
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		long allocs = bnum_allocs();
+		start = os_gettime_ns();
+		obs_data_t *data = obs_data_create_from_json(json);
+		stream_read += os_gettime_ns() - start;
+		stream_allocs += bnum_allocs() - allocs;
+
+		start = os_gettime_ns();
+		obs_data_get_json_pretty(data);
+		stream_write += os_gettime_ns() - start;
+		obs_data_release(data);
+
+		allocs = bnum_allocs();
+		start = os_gettime_ns();
+		data = dom_create_from_json(json);
+		dom_read += os_gettime_ns() - start;
+		dom_allocs += bnum_allocs() - allocs;
+
+		start = os_gettime_ns();
+		free(dom_get_json(data, true, false));
+		dom_write += os_gettime_ns() - start;
+		obs_data_release(data);
+	}
+
+	print_message("%zu bytes of json, %d sources:\n", strlen(json), BENCH_SOURCES);
+	print_message("  read:  streaming %.3f ms, jansson tree %.3f ms\n",
+		      (double)stream_read / BENCH_ITERATIONS / 1000000.0,
+		      (double)dom_read / BENCH_ITERATIONS / 1000000.0);
+	print_message("  write: streaming %.3f ms, jansson tree %.3f ms\n",
+		      (double)stream_write / BENCH_ITERATIONS / 1000000.0,
+		      (double)dom_write / BENCH_ITERATIONS / 1000000.0);
+	print_message("  live allocations after read: streaming %lld, jansson tree %lld\n",
+		      stream_allocs / BENCH_ITERATIONS, dom_allocs / BENCH_ITERATIONS);
+
+	bfree(json);
+	obs_data_release(collection);
+}
+
+static void key_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const obs_data_key_t *name = obs_data_key("name");
+	const obs_data_key_t *width = obs_data_key("width");
+	const obs_data_key_t *opacity = obs_data_key("opacity");
+	const obs_data_key_t *unload = obs_data_key("unload");
+	const obs_data_key_t *crop = obs_data_key("crop");
+	const obs_data_key_t *filters = obs_data_key("filters");
+	const obs_data_key_t *missing = obs_data_key("missing");
+
+	assert_ptr_equal(name, obs_data_key("name"));
+	assert_string_equal(obs_data_key_name(name), "name");
+	assert_null(obs_data_key(NULL));
+
+	obs_data_t *settings = create_settings(3);
+	obs_data_t *crop_obj = obs_data_create();
+	obs_data_array_t *filter_array = obs_data_array_create();
+
+	assert_int_equal(obs_data_get_int_by_key(settings, width), 1920);
+	assert_false(obs_data_has_user_value_by_key(settings, width));
+	assert_true(obs_data_get_bool_by_key(settings, unload));
+	assert_int_equal(obs_data_get_int_by_key(settings, missing), 0);
+	assert_string_equal(obs_data_get_string_by_key(settings, missing), "");
+
+	struct obs_data_value values[] = {
+		obs_data_value_string(name, "updated"),
+		obs_data_value_int(width, 1280),
+		obs_data_value_double(opacity, 0.75),
+		obs_data_value_bool(unload, false),
+		obs_data_value_obj(crop, crop_obj),
+		obs_data_value_array(filters, filter_array),
+	};
+
+	obs_data_set_values(settings, values, sizeof(values) / sizeof(values[0]));
+
+	assert_string_equal(obs_data_get_string(settings, "name"), "updated");
+	assert_string_equal(obs_data_get_string_by_key(settings, name), "updated");
+	assert_int_equal(obs_data_get_int_by_key(settings, width), 1280);
+	assert_true(obs_data_has_user_value_by_key(settings, width));
+	assert_int_equal(obs_data_get_default_int(settings, "width"), 1920);
+	assert_float_equal(obs_data_get_double_by_key(settings, opacity), 0.75, 0.0);
+	assert_false(obs_data_get_bool(settings, "unload"));
+
+	obs_data_t *obj = obs_data_get_obj_by_key(settings, crop);
+	obs_data_array_t *array = obs_data_get_array_by_key(settings, filters);
+	assert_ptr_equal(obj, crop_obj);
+	assert_ptr_equal(array, filter_array);
+	obs_data_release(obj);
+	obs_data_array_release(array);
+
+	obs_data_array_release(filter_array);
+	obs_data_release(crop_obj);
+	obs_data_release(settings);
+}
+
+/* One update of a source with eight settings: the values are set, and then
+ * read back by the update callback. */
+static void update_benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	skip_unless_benchmarks_enabled();
+
+	static const char *names[] = {"file", "unload", "color", "opacity", "x", "y", "width", "height"};
+	const obs_data_key_t *keys[8];
+	obs_data_t *settings = create_settings(0);
+	uint64_t start, by_name, by_key;
+	long long sum = 0;
+
+	for (size_t i = 0; i < 8; i++)
+		keys[i] = obs_data_key(names[i]);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_UPDATES; i++) {
+		obs_data_t *update = obs_data_create();
+		obs_data_set_string(update, "file", "image.png");
+		obs_data_set_bool(update, "unload", i & 1);
+		obs_data_set_int(update, "color", i);
+		obs_data_set_double(update, "opacity", 0.5);
+		for (size_t j = 4; j < 8; j++)
+			obs_data_set_int(update, names[j], i + (int)j);
+		obs_data_apply(settings, update);
+		obs_data_release(update);
+
+		sum += (long long)strlen(obs_data_get_string(settings, "file"));
+		sum += obs_data_get_bool(settings, "unload");
+		sum += obs_data_get_int(settings, "color");
+		sum += (long long)obs_data_get_double(settings, "opacity");
+		for (size_t j = 4; j < 8; j++)
+			sum += obs_data_get_int(settings, names[j]);
+	}
+	by_name = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_UPDATES; i++) {
+		struct obs_data_value values[8] = {
+			obs_data_value_string(keys[0], "image.png"),
+			obs_data_value_bool(keys[1], i & 1),
+			obs_data_value_int(keys[2], i),
+			obs_data_value_double(keys[3], 0.5),
+		};
+		for (size_t j = 4; j < 8; j++)
+			values[j] = obs_data_value_int(keys[j], i + (int)j);
+		obs_data_set_values(settings, values, 8);
+
+		sum -= (long long)strlen(obs_data_get_string_by_key(settings, keys[0]));
+		sum -= obs_data_get_bool_by_key(settings, keys[1]);
+		sum -= obs_data_get_int_by_key(settings, keys[2]);
+		sum -= (long long)obs_data_get_double_by_key(settings, keys[3]);
+		for (size_t j = 4; j < 8; j++)
+			sum -= obs_data_get_int_by_key(settings, keys[j]);
+	}
+	by_key = os_gettime_ns() - start;
+
+	assert_int_equal(sum, 0);
+	print_message("update of 8 settings: apply + get by name %.1f ns, set values + get by key %.1f ns\n",
+		      (double)by_name / BENCH_UPDATES, (double)by_key / BENCH_UPDATES);
+
+	obs_data_release(settings);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(writer_test),
+		cmocka_unit_test(parser_test),
+		cmocka_unit_test(invalid_test),
+		cmocka_unit_test(arena_test),
+		cmocka_unit_test(benchmark_test),
+		cmocka_unit_test(key_test),
+		cmocka_unit_test(update_benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
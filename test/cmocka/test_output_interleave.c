@@ -0,0 +1,212 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <util/darray.h>
+#include <util/platform.h>
+#include <obs-interleave.h>
+
+#include "benchmark.h"
+
+#define VIDEO_TRACKS 4
+#define AUDIO_TRACKS 6
+#define PACKET_COUNT 20000
+#define BENCH_PACKETS 20000
+
+static unsigned next_rand(unsigned *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 8;
+}
+
+/* the linear scan the interleaver replaced, used as the reference */
+static void ref_insert(struct darray *da, const struct encoder_packet *out)
+{
+	DARRAY(struct encoder_packet) ref;
+	size_t idx;
+
+	ref.da = *da;
+	for (idx = 0; idx < ref.num; idx++) {
+		struct encoder_packet *cur_packet = ref.array + idx;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
+		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
+			continue;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
+			break;
+		} else if (out->dts_usec < cur_packet->dts_usec) {
+			break;
+		}
+	}
+
+	da_insert(ref, idx, out);
+	*da = ref.da;
+}
+
+static void make_packet(struct encoder_packet *packet, unsigned *seed, int64_t base, int64_t id)
+{
+	unsigned r = next_rand(seed);
+
+	memset(packet, 0, sizeof(*packet));
+
+	/* lots of equal timestamps to exercise the tie-breaking */
+	packet->dts_usec = base + (int64_t)(r % 64) * 1000;
+	packet->pts = id;
+
+	if ((r >> 8) & 1) {
+		packet->type = OBS_ENCODER_VIDEO;
+		packet->track_idx = (r >> 9) % VIDEO_TRACKS;
+	} else {
+		packet->type = OBS_ENCODER_AUDIO;
+		packet->track_idx = (r >> 9) % AUDIO_TRACKS;
+	}
+}
+
+static void assert_same_order(struct interleaved_packets *ip, struct darray *da)
+{
+	DARRAY(struct encoder_packet) ref;
+	ref.da = *da;
+
+	assert_int_equal(ip->num, ref.num);
+	for (size_t i = 0; i < ref.num; i++) {
+		struct encoder_packet *packet = interleaved_packet(ip, i);
+		assert_int_equal(packet->pts, ref.array[i].pts);
+		assert_int_equal(packet->dts_usec, ref.array[i].dts_usec);
+	}
+}
+
+static void matches_linear_insert_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct interleaved_packets ip = {0};
+	DARRAY(struct encoder_packet) ref;
+	unsigned seed = 1;
+	int64_t base = 0;
+
+	da_init(ref);
+
+	for (int64_t i = 0; i < PACKET_COUNT; i++) {
+		struct encoder_packet packet;
+
+		make_packet(&packet, &seed, base, i);
+		interleaved_packets_insert(&ip, &packet);
+		ref_insert(&ref.da, &packet);
+
+		/* the time window keeps moving so the ring wraps around */
+		if ((i & 7) == 0)
+			base += 1000;
+
+		unsigned r = next_rand(&seed);
+		if (r % 3 == 0 && ref.num) {
+			size_t count = 1 + (r >> 4) % 4;
+			if (count > ref.num)
+				count = ref.num;
+
+			interleaved_packets_pop_front(&ip, count);
+			da_erase_range(ref, 0, count);
+		}
+
+		if ((i & 255) == 0 || i == PACKET_COUNT - 1)
+			assert_same_order(&ip, &ref.da);
+	}
+
+	assert_same_order(&ip, &ref.da);
+
+	interleaved_packets_free(&ip);
+	da_free(ref);
+}
+
+static void resort_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct interleaved_packets ip = {0};
+	struct interleaved_packets resorted = {0};
+	unsigned seed = 2;
+
+	for (int64_t i = 0; i < PACKET_COUNT; i++) {
+		struct encoder_packet packet;
+		make_packet(&packet, &seed, 0, i);
+		interleaved_packets_insert(&ip, &packet);
+		if ((i & 3) == 0)
+			interleaved_packets_pop_front(&ip, 1);
+	}
+
+	/* shift one track, as applying the start offsets does, and re-insert */
+	for (size_t i = 0; i < ip.num; i++) {
+		struct encoder_packet *packet = interleaved_packet(&ip, i);
+		if (packet->type == OBS_ENCODER_AUDIO && packet->track_idx == 0)
+			packet->dts_usec -= 7000;
+	}
+
+	interleaved_packets_reserve(&resorted, ip.num);
+	for (size_t i = 0; i < ip.num; i++)
+		interleaved_packets_insert(&resorted, interleaved_packet(&ip, i));
+
+	assert_int_equal(resorted.num, ip.num);
+	for (size_t i = 1; i < resorted.num; i++) {
+		struct encoder_packet *prev = interleaved_packet(&resorted, i - 1);
+		struct encoder_packet *cur = interleaved_packet(&resorted, i);
+		assert_true(prev->dts_usec <= cur->dts_usec);
+		if (prev->dts_usec == cur->dts_usec && cur->type == OBS_ENCODER_VIDEO) {
+			assert_int_equal(prev->type, OBS_ENCODER_VIDEO);
+			assert_true(prev->track_idx <= cur->track_idx);
+		}
+	}
+
+	interleaved_packets_free(&ip);
+	interleaved_packets_free(&resorted);
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	skip_unless_benchmarks_enabled();
+
+	struct interleaved_packets ip = {0};
+	DARRAY(struct encoder_packet) ref;
+	unsigned seed = 3;
+	uint64_t start, ring_ns, linear_ns;
+
+	da_init(ref);
+
+	/* a deep buffer, as when one encoder stalls during startup */
+	start = os_gettime_ns();
+	for (int64_t i = 0; i < BENCH_PACKETS; i++) {
+		struct encoder_packet packet;
+		make_packet(&packet, &seed, i * 100, i);
+		interleaved_packets_insert(&ip, &packet);
+	}
+	ring_ns = os_gettime_ns() - start;
+
+	seed = 3;
+	start = os_gettime_ns();
+	for (int64_t i = 0; i < BENCH_PACKETS; i++) {
+		struct encoder_packet packet;
+		make_packet(&packet, &seed, i * 100, i);
+		ref_insert(&ref.da, &packet);
+	}
+	linear_ns = os_gettime_ns() - start;
+
+	print_message("%d packets: ring %.3f ms, linear insert %.3f ms\n", BENCH_PACKETS, (double)ring_ns / 1000000.0,
+		      (double)linear_ns / 1000000.0);
+
+	interleaved_packets_free(&ip);
+	da_free(ref);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(matches_linear_insert_test),
+		cmocka_unit_test(resort_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,167 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-packet-pool.h>
+
+#define MAX_CLASS_SIZE ((size_t)1 << (PACKET_POOL_MIN_SHIFT + PACKET_POOL_CLASSES - 1))
+
+static struct packet_pool pool = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static struct obs_encoder_packet_pool_stats get_stats(void)
+{
+	struct obs_encoder_packet_pool_stats stats;
+
+	packet_pool_get_stats(&pool, &stats);
+	return stats;
+}
+
+static void assert_stats(uint64_t allocations, uint64_t reuses, uint64_t unpooled, uint64_t bytes_in_use,
+			 uint64_t bytes_cached)
+{
+	struct obs_encoder_packet_pool_stats stats = get_stats();
+
+	assert_int_equal(stats.allocations, allocations);
+	assert_int_equal(stats.reuses, reuses);
+	assert_int_equal(stats.unpooled, unpooled);
+	assert_int_equal(stats.bytes_in_use, bytes_in_use);
+	assert_int_equal(stats.bytes_cached, bytes_cached);
+}
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	memset(&pool.stats, 0, sizeof(pool.stats));
+	packet_pool_init(&pool);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct obs_encoder_packet_pool_stats stats;
+
+	packet_pool_free(&pool, &stats);
+	return 0;
+}
+
+/* a buffer shared by two packets only goes back to the pool once both released
+ * it, and is then handed out again */
+static void shared_reuse_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct encoder_packet packet = {0};
+	struct encoder_packet ref;
+
+	packet.data = packet_pool_alloc(&pool, 1000);
+	packet.size = 1000;
+	memset(packet.data, 0xAB, packet.size);
+	assert_stats(1, 0, 0, 1024, 0);
+
+	obs_encoder_packet_ref(&ref, &packet);
+	assert_ptr_equal(ref.data, packet.data);
+
+	packet_pool_release(&pool, packet.data);
+	assert_stats(1, 0, 0, 1024, 0);
+	assert_int_equal(ref.data[999], 0xAB);
+
+	packet_pool_release(&pool, ref.data);
+	assert_stats(1, 0, 0, 0, 1024);
+
+	/* anything from 513 to 1024 bytes fits the same buffer */
+	assert_ptr_equal(packet_pool_alloc(&pool, 600), packet.data);
+	assert_stats(1, 1, 0, 1024, 0);
+
+	packet_pool_release(&pool, packet.data);
+	assert_stats(1, 1, 0, 0, 1024);
+}
+
+/* sizes are rounded up to the next class, and a class only reuses its own
+ * buffers */
+static void size_class_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	uint8_t *small = packet_pool_alloc(&pool, 1);
+	uint8_t *exact = packet_pool_alloc(&pool, 256);
+	uint8_t *next = packet_pool_alloc(&pool, 257);
+	uint8_t *largest = packet_pool_alloc(&pool, MAX_CLASS_SIZE);
+	uint8_t *unpooled = packet_pool_alloc(&pool, MAX_CLASS_SIZE + 1);
+	uint64_t in_use = 256 + 256 + 512 + MAX_CLASS_SIZE;
+
+	assert_stats(4, 0, 1, in_use, 0);
+
+	packet_pool_release(&pool, small);
+	packet_pool_release(&pool, exact);
+	packet_pool_release(&pool, next);
+	packet_pool_release(&pool, largest);
+	packet_pool_release(&pool, unpooled);
+	assert_stats(4, 0, 1, 0, in_use);
+
+	/* the most recently released buffer of a class is reused first */
+	assert_ptr_equal(packet_pool_alloc(&pool, 100), exact);
+	assert_ptr_equal(packet_pool_alloc(&pool, 200), small);
+	assert_stats(4, 2, 1, 512, in_use - 512);
+
+	/* class 0 is empty now, a larger class is not taken instead */
+	uint8_t *grown = packet_pool_alloc(&pool, 10);
+	assert_true(grown != next);
+	assert_stats(5, 2, 1, 768, in_use - 512);
+
+	assert_ptr_equal(packet_pool_alloc(&pool, 512), next);
+	assert_stats(5, 3, 1, 1280, in_use - 1024);
+
+	packet_pool_release(&pool, exact);
+	packet_pool_release(&pool, small);
+	packet_pool_release(&pool, grown);
+	packet_pool_release(&pool, next);
+	assert_stats(5, 3, 1, 0, in_use + 256);
+}
+
+/* the cache is capped, and buffers released after the pool was freed are not
+ * cached anymore */
+static void cache_limit_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const size_t count = PACKET_POOL_MAX_CACHED / MAX_CLASS_SIZE + 1;
+	struct obs_encoder_packet_pool_stats stats;
+	uint8_t *buffers[PACKET_POOL_MAX_CACHED / MAX_CLASS_SIZE + 1];
+
+	for (size_t i = 0; i < count; i++)
+		buffers[i] = packet_pool_alloc(&pool, MAX_CLASS_SIZE);
+	assert_stats(count, 0, 0, count * MAX_CLASS_SIZE, 0);
+
+	for (size_t i = 0; i < count; i++)
+		packet_pool_release(&pool, buffers[i]);
+	assert_stats(count, 0, 0, 0, PACKET_POOL_MAX_CACHED);
+
+	uint8_t *held = packet_pool_alloc(&pool, 1000);
+
+	packet_pool_free(&pool, &stats);
+	assert_int_equal(stats.bytes_cached, PACKET_POOL_MAX_CACHED);
+	assert_stats(count + 1, 0, 0, 1024, 0);
+
+	packet_pool_release(&pool, held);
+	assert_stats(count + 1, 0, 0, 0, 0);
+
+	/* without an active pool, buffers come straight from the heap */
+	uint8_t *data = packet_pool_alloc(&pool, 1000);
+	assert_stats(count + 1, 0, 1, 0, 0);
+	packet_pool_release(&pool, data);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(shared_reuse_test, setup, teardown),
+		cmocka_unit_test_setup_teardown(size_class_test, setup, teardown),
+		cmocka_unit_test_setup_teardown(cache_limit_test, setup, teardown),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
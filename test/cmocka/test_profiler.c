@@ -0,0 +1,218 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/platform.h>
+#include <util/profiler.h>
+#include <util/threading.h>
+
+#include "benchmark.h"
+
+#define NUM_THREADS 4
+/* stays below the size of the per-thread event buffers, so nothing is
+ * dropped even if the aggregator does not get to run */
+#define THREAD_ITERATIONS 400
+#define SAMPLED_CALLS 1000
+#define BENCH_CALLS 1000000
+
+static const char *root_name = "root";
+static const char *child_a_name = "child_a";
+static const char *child_b_name = "child_b";
+static const char *grandchild_name = "grandchild";
+
+struct find_data {
+	const char *name;
+	profiler_snapshot_entry_t *entry;
+};
+
+static bool find_entry(void *context, profiler_snapshot_entry_t *entry)
+{
+	struct find_data *data = context;
+
+	if (strcmp(profiler_snapshot_entry_name(entry), data->name) == 0) {
+		data->entry = entry;
+		return false;
+	}
+
+	return true;
+}
+
+static profiler_snapshot_entry_t *find_root(profiler_snapshot_t *snap, const char *name)
+{
+	struct find_data data = {name, NULL};
+	profiler_snapshot_enumerate_roots(snap, find_entry, &data);
+	return data.entry;
+}
+
+static profiler_snapshot_entry_t *find_child(profiler_snapshot_entry_t *entry, const char *name)
+{
+	struct find_data data = {name, NULL};
+	profiler_snapshot_enumerate_children(entry, find_entry, &data);
+	return data.entry;
+}
+
+static void *profile_thread(void *data)
+{
+	for (int i = 0; i < THREAD_ITERATIONS; i++) {
+		profile_start(root_name);
+
+		profile_start(child_a_name);
+		profile_end(child_a_name);
+
+		profile_start(child_b_name);
+		profile_start(grandchild_name);
+		profile_end(grandchild_name);
+		profile_end(child_b_name);
+
+		profile_end(root_name);
+	}
+
+	UNUSED_PARAMETER(data);
+	return NULL;
+}
+
+static void threads_test(void **state)
+{
+	pthread_t threads[NUM_THREADS];
+
+	profiler_start();
+
+	for (size_t i = 0; i < NUM_THREADS; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, profile_thread, NULL), 0);
+	for (size_t i = 0; i < NUM_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, root_name);
+
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), NUM_THREADS * THREAD_ITERATIONS);
+	assert_int_equal(profiler_snapshot_num_children(root), 2);
+
+	profiler_snapshot_entry_t *child_a = find_child(root, child_a_name);
+	profiler_snapshot_entry_t *child_b = find_child(root, child_b_name);
+	assert_non_null(child_a);
+	assert_non_null(child_b);
+	assert_int_equal(profiler_snapshot_entry_overall_count(child_a), NUM_THREADS * THREAD_ITERATIONS);
+	assert_int_equal(profiler_snapshot_num_children(child_a), 0);
+
+	profiler_snapshot_entry_t *grandchild = find_child(child_b, grandchild_name);
+	assert_non_null(grandchild);
+	assert_int_equal(profiler_snapshot_entry_overall_count(grandchild), NUM_THREADS * THREAD_ITERATIONS);
+
+	/* counts of the time entries add up to the number of calls */
+	profiler_time_entries_t *times = profiler_snapshot_entry_times(root);
+	uint64_t count = 0;
+	for (size_t i = 0; i < times->num; i++) {
+		count += times->array[i].count;
+		assert_in_range(times->array[i].time_delta, profiler_snapshot_entry_min_time(root),
+				profiler_snapshot_entry_max_time(root));
+		if (i)
+			assert_true(times->array[i].time_delta < times->array[i - 1].time_delta);
+	}
+	assert_int_equal(count, NUM_THREADS * THREAD_ITERATIONS);
+
+	profile_snapshot_free(snap);
+	profiler_free();
+	UNUSED_PARAMETER(state);
+}
+
+static void sampling_test(void **state)
+{
+	profiler_start();
+	profiler_set_sample_rate(10);
+	profile_register_root(root_name, 1000000);
+
+	for (int i = 0; i < SAMPLED_CALLS; i++) {
+		profile_start(root_name);
+		profile_start(child_a_name);
+		profile_end(child_a_name);
+		profile_end(root_name);
+	}
+
+	profiler_set_sample_rate(0);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, root_name);
+
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), SAMPLED_CALLS / 10);
+	assert_int_equal(profiler_snapshot_entry_overall_count(find_child(root, child_a_name)), SAMPLED_CALLS / 10);
+
+	/* skipped calls still count for the time between calls */
+	assert_int_equal(profiler_snapshot_entry_expected_time_between_calls(root), 1000);
+	assert_int_equal(profiler_snapshot_entry_overall_between_calls_count(root), SAMPLED_CALLS - 1);
+
+	profile_snapshot_free(snap);
+	profiler_free();
+	UNUSED_PARAMETER(state);
+}
+
+static void mismatch_test(void **state)
+{
+	profiler_start();
+
+	/* ending the root ends the open child too */
+	profile_start(root_name);
+	profile_start(child_a_name);
+	profile_end(root_name);
+
+	/* ending a call that was never started is ignored */
+	profile_start(root_name);
+	profile_end(child_b_name);
+	profile_end(root_name);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, root_name);
+
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), 2);
+	assert_int_equal(profiler_snapshot_num_children(root), 1);
+	assert_int_equal(profiler_snapshot_entry_overall_count(find_child(root, child_a_name)), 1);
+
+	profile_snapshot_free(snap);
+	profiler_free();
+	UNUSED_PARAMETER(state);
+}
+
+static void benchmark_test(void **state)
+{
+	skip_unless_benchmarks_enabled();
+
+	profiler_start();
+
+	uint64_t start = os_gettime_ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		profile_start(root_name);
+		profile_start(child_a_name);
+		profile_end(child_a_name);
+		profile_end(root_name);
+	}
+	uint64_t end = os_gettime_ns();
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, root_name);
+	uint64_t recorded = root ? profiler_snapshot_entry_overall_count(root) : 0;
+
+	print_message("profiler: %.1f ns per call, %llu of %d root calls recorded\n",
+		      (double)(end - start) / (BENCH_CALLS * 2.0), (unsigned long long)recorded, BENCH_CALLS);
+
+	profile_snapshot_free(snap);
+	profiler_free();
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(threads_test),
+		cmocka_unit_test(sampling_test),
+		cmocka_unit_test(mismatch_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
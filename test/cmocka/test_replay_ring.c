@@ -0,0 +1,165 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "obs-ffmpeg-mux.h"
+
+#define RING_FILE "test_replay_ring.bin"
+#define PACKET_SIZE 1000
+
+/* far below the 64 KB chunks of the file writer, a clip must not wait for
+ * more packets to be encoded before it can read the newest one */
+#define SAVE_TIMEOUT_MS 2000
+
+static void fill_packet(uint8_t *data, size_t size, int seq)
+{
+	for (size_t i = 0; i < size; i++)
+		data[i] = (uint8_t)(seq * 31 + i);
+}
+
+static bool push_packet(struct replay_ring *ring, int seq, bool keyframe)
+{
+	uint8_t data[PACKET_SIZE];
+	struct encoder_packet pkt = {0};
+
+	fill_packet(data, sizeof(data), seq);
+
+	pkt.data = data;
+	pkt.size = sizeof(data);
+	pkt.type = OBS_ENCODER_VIDEO;
+	pkt.keyframe = keyframe;
+	pkt.dts_usec = seq * 16667;
+
+	return replay_ring_push(ring, &pkt);
+}
+
+static void check_packet(const uint8_t *data, int seq)
+{
+	uint8_t expected[PACKET_SIZE];
+
+	assert_non_null(data);
+	fill_packet(expected, sizeof(expected), seq);
+	assert_memory_equal(data, expected, sizeof(expected));
+}
+
+struct read_args {
+	struct replay_ring_reader *reader;
+	uint64_t pos;
+	const uint8_t *data;
+	os_event_t *done;
+};
+
+static void *read_thread(void *param)
+{
+	struct read_args *args = param;
+
+	args->data = replay_ring_read(args->reader, args->pos, PACKET_SIZE);
+	os_event_signal(args->done);
+	return NULL;
+}
+
+/* the newest packet can be read while recording continues, even though it is
+ * much smaller than a chunk of the file writer */
+static void save_latency_test(void **state)
+{
+	struct replay_ring *ring = replay_ring_create(RING_FILE, 1024 * 1024, 1024 * 1024);
+	struct replay_ring_reader reader;
+	struct read_args args = {&reader, 0, NULL, NULL};
+	pthread_t thread;
+	int wait_result;
+
+	assert_non_null(ring);
+	assert_true(replay_ring_reader_init(&reader, ring));
+	assert_int_equal(os_event_init(&args.done, OS_EVENT_TYPE_MANUAL), 0);
+
+	assert_true(push_packet(ring, 0, true));
+	assert_int_equal(pthread_create(&thread, NULL, read_thread, &args), 0);
+
+	wait_result = os_event_timedwait(args.done, SAVE_TIMEOUT_MS);
+
+	/* stops a read that is still waiting */
+	replay_ring_close(ring);
+	pthread_join(thread, NULL);
+
+	assert_int_equal(wait_result, 0);
+	check_packet(args.data, 0);
+
+	os_event_destroy(args.done);
+	replay_ring_reader_free(&reader);
+	replay_ring_release(ring);
+	UNUSED_PARAMETER(state);
+}
+
+/* indexed packets read back intact after the ring wrapped around, and the
+ * packets they overwrote can no longer be read */
+static void wrap_test(void **state)
+{
+	struct replay_ring *ring = replay_ring_create(RING_FILE, 64 * 1024, 48 * 1024);
+	struct replay_ring_reader reader;
+	size_t num;
+
+	assert_non_null(ring);
+
+	for (int seq = 0; seq < 200; seq++)
+		assert_true(push_packet(ring, seq, seq % 10 == 0));
+
+	/* everything before the limit was purged */
+	num = ring->packets.size / sizeof(struct replay_ring_packet);
+	assert_in_range(ring->first_seq, 150, 160);
+	assert_true(num * PACKET_SIZE <= 48 * 1024);
+
+	assert_true(replay_ring_reader_init(&reader, ring));
+
+	for (size_t i = 0; i < num; i++) {
+		struct replay_ring_packet *rp = deque_data(&ring->packets, i * sizeof(*rp));
+
+		check_packet(replay_ring_read(&reader, rp->pos, PACKET_SIZE), (int)(ring->first_seq + i));
+	}
+
+	assert_null(replay_ring_read(&reader, 0, PACKET_SIZE));
+
+	replay_ring_reader_free(&reader);
+	replay_ring_release(ring);
+	UNUSED_PARAMETER(state);
+}
+
+/* a closed ring keeps its data readable, and reads past its end fail instead
+ * of waiting for data that is never written */
+static void closed_test(void **state)
+{
+	struct replay_ring *ring = replay_ring_create(RING_FILE, 64 * 1024, 64 * 1024);
+	struct replay_ring_reader reader;
+
+	assert_non_null(ring);
+
+	for (int seq = 0; seq < 10; seq++)
+		assert_true(push_packet(ring, seq, seq == 0));
+
+	replay_ring_close(ring);
+	assert_true(replay_ring_reader_init(&reader, ring));
+
+	for (int seq = 0; seq < 10; seq++)
+		check_packet(replay_ring_read(&reader, (uint64_t)seq * PACKET_SIZE, PACKET_SIZE), seq);
+
+	assert_null(replay_ring_read(&reader, 10 * PACKET_SIZE, PACKET_SIZE));
+
+	replay_ring_reader_free(&reader);
+	replay_ring_release(ring);
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(save_latency_test),
+		cmocka_unit_test(wrap_test),
+		cmocka_unit_test(closed_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,368 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#include <callback/signal.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "benchmark.h"
+
+#define BENCH_EMITS 1000000
+
+static const char *signals[] = {
+	"void first(int value)",
+	"void test(int value)",
+	"void last(int value)",
+	NULL,
+};
+
+static void count_callback(void *data, calldata_t *cd)
+{
+	long *count = data;
+	(*count)++;
+	UNUSED_PARAMETER(cd);
+}
+
+static void remove_callback(void *data, calldata_t *cd)
+{
+	count_callback(data, cd);
+	signal_handler_remove_current();
+}
+
+static void emit_test(void **state)
+{
+	signal_handler_t *handler = signal_handler_create();
+	long counts[3] = {0};
+	struct calldata cd;
+	uint8_t stack[128];
+
+	assert_true(signal_handler_add_array(handler, signals));
+	assert_false(signal_handler_add(handler, "void test(int value)"));
+	assert_null(signal_handler_get_signal(handler, "missing"));
+
+	signal_t *signal = signal_handler_get_signal(handler, "test");
+	assert_non_null(signal);
+
+	calldata_init_fixed(&cd, stack, sizeof(stack));
+	calldata_set_int(&cd, "value", 1);
+
+	signal_handler_connect(handler, "test", count_callback, &counts[0]);
+	signal_handler_connect(handler, "test", count_callback, &counts[0]);
+	signal_handler_connect(handler, "test", count_callback, &counts[1]);
+	signal_handler_connect(handler, "test", remove_callback, &counts[2]);
+
+	signal_handler_signal(handler, "test", &cd);
+	signal_emit(signal, &cd);
+	signal_handler_signal(handler, "first", &cd);
+
+	/* duplicates are only connected once, removed callbacks only called
+	 * once */
+	assert_int_equal(counts[0], 2);
+	assert_int_equal(counts[1], 2);
+	assert_int_equal(counts[2], 1);
+
+	signal_handler_disconnect(handler, "test", count_callback, &counts[0]);
+	signal_emit(signal, &cd);
+	assert_int_equal(counts[0], 2);
+	assert_int_equal(counts[1], 3);
+
+	signal_handler_destroy(handler);
+	UNUSED_PARAMETER(state);
+}
+
+struct disconnect_data {
+	signal_handler_t *handler;
+	long count;
+};
+
+static void disconnect_other_callback(void *data, calldata_t *cd)
+{
+	struct disconnect_data *dd = data;
+
+	signal_handler_disconnect(dd->handler, "test", count_callback, &dd->count);
+	signal_handler_disconnect(dd->handler, "test", disconnect_other_callback, dd);
+	UNUSED_PARAMETER(cd);
+}
+
+static void disconnect_in_callback_test(void **state)
+{
+	signal_handler_t *handler = signal_handler_create();
+	struct disconnect_data dd = {handler, 0};
+	struct calldata cd = {0};
+
+	signal_handler_add_array(handler, signals);
+
+	/* callbacks disconnected by earlier callbacks are no longer called */
+	signal_handler_connect(handler, "test", disconnect_other_callback, &dd);
+	signal_handler_connect(handler, "test", count_callback, &dd.count);
+
+	signal_handler_signal(handler, "test", &cd);
+	signal_handler_signal(handler, "test", &cd);
+	assert_int_equal(dd.count, 0);
+
+	calldata_free(&cd);
+	signal_handler_destroy(handler);
+	UNUSED_PARAMETER(state);
+}
+
+static void empty_callback(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(cd);
+}
+
+struct slow_data {
+	volatile bool started;
+	volatile bool finished;
+};
+
+static void slow_callback(void *data, calldata_t *cd)
+{
+	struct slow_data *slow = data;
+
+	os_atomic_set_bool(&slow->started, true);
+	os_sleep_ms(50);
+	os_atomic_set_bool(&slow->finished, true);
+	UNUSED_PARAMETER(cd);
+}
+
+static void *emit_thread(void *data)
+{
+	struct calldata cd = {0};
+
+	signal_handler_signal(data, "test", &cd);
+	calldata_free(&cd);
+	return NULL;
+}
+
+struct waiting_disconnect {
+	signal_handler_t *handler;
+	struct slow_data *slow;
+	void *data;
+	bool finished;
+	uint64_t cpu_time;
+};
+
+static uint64_t thread_cpu_time(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+		return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+	return 0;
+}
+
+static void *disconnect_thread(void *data)
+{
+	struct waiting_disconnect *wd = data;
+	uint64_t start = thread_cpu_time();
+
+	signal_handler_disconnect(wd->handler, "test", empty_callback, wd->data);
+	wd->finished = os_atomic_load_bool(&wd->slow->finished);
+	wd->cpu_time = thread_cpu_time() - start;
+	return NULL;
+}
+
+/* disconnects wait for emissions that may still call the callback, several
+ * of them at once, without spinning while they wait */
+static void disconnect_waits_test(void **state)
+{
+	signal_handler_t *handler = signal_handler_create();
+	struct slow_data slow = {false, false};
+	struct waiting_disconnect wd[2];
+	pthread_t disconnect_threads[2];
+	pthread_t thread;
+
+	signal_handler_add_array(handler, signals);
+	signal_handler_connect(handler, "test", slow_callback, &slow);
+	for (size_t i = 0; i < 2; i++)
+		signal_handler_connect(handler, "test", empty_callback, &wd[i]);
+
+	assert_int_equal(pthread_create(&thread, NULL, emit_thread, handler), 0);
+	while (!os_atomic_load_bool(&slow.started))
+		os_sleep_ms(1);
+
+	for (size_t i = 0; i < 2; i++) {
+		wd[i] = (struct waiting_disconnect){handler, &slow, &wd[i], false, 0};
+		assert_int_equal(pthread_create(&disconnect_threads[i], NULL, disconnect_thread, &wd[i]), 0);
+	}
+
+	signal_handler_disconnect(handler, "test", slow_callback, &slow);
+	assert_true(os_atomic_load_bool(&slow.finished));
+
+	for (size_t i = 0; i < 2; i++) {
+		pthread_join(disconnect_threads[i], NULL);
+		assert_true(wd[i].finished);
+		/* waiting takes next to no CPU time, spinning for the 50 ms of
+		 * the slow callback takes far more */
+		assert_true(wd[i].cpu_time < 1000000);
+	}
+
+	pthread_join(thread, NULL);
+	signal_handler_destroy(handler);
+	UNUSED_PARAMETER(state);
+}
+
+struct concurrent_disconnect_data {
+	signal_handler_t *handler;
+	volatile bool in_callback;
+	volatile bool disconnecting;
+	long count;
+};
+
+static void disconnect_from_callback(void *data, calldata_t *cd)
+{
+	struct concurrent_disconnect_data *cdd = data;
+
+	os_atomic_set_bool(&cdd->in_callback, true);
+	while (!os_atomic_load_bool(&cdd->disconnecting))
+		os_sleep_ms(1);
+
+	/* give the other thread time to start waiting for this emission */
+	os_sleep_ms(20);
+
+	signal_handler_disconnect(cdd->handler, "test", count_callback, &cdd->count);
+	UNUSED_PARAMETER(cd);
+}
+
+static void concurrent_disconnect_test(void **state)
+{
+	signal_handler_t *handler = signal_handler_create();
+	struct concurrent_disconnect_data cdd = {handler, false, false, 0};
+	pthread_t thread;
+
+	signal_handler_add_array(handler, signals);
+	signal_handler_connect(handler, "test", disconnect_from_callback, &cdd);
+	signal_handler_connect(handler, "test", count_callback, &cdd.count);
+	signal_handler_connect(handler, "test", empty_callback, NULL);
+
+	assert_int_equal(pthread_create(&thread, NULL, emit_thread, handler), 0);
+	while (!os_atomic_load_bool(&cdd.in_callback))
+		os_sleep_ms(1);
+
+	/* waits for the emission, while the emission's callback disconnects
+	 * another callback and must not wait for this disconnect in turn */
+	os_atomic_set_bool(&cdd.disconnecting, true);
+	signal_handler_disconnect(handler, "test", empty_callback, NULL);
+
+	pthread_join(thread, NULL);
+	assert_int_equal(cdd.count, 0);
+
+	signal_handler_destroy(handler);
+	UNUSED_PARAMETER(state);
+}
+
+struct stress_data {
+	signal_handler_t *handler;
+	volatile bool stop;
+	long count;
+};
+
+static void *stress_emit_thread(void *data)
+{
+	struct stress_data *sd = data;
+	signal_t *signal = signal_handler_get_signal(sd->handler, "test");
+	struct calldata cd = {0};
+
+	while (!os_atomic_load_bool(&sd->stop))
+		signal_emit(signal, &cd);
+
+	calldata_free(&cd);
+	return NULL;
+}
+
+static void atomic_count_callback(void *data, calldata_t *cd)
+{
+	os_atomic_inc_long(data);
+	UNUSED_PARAMETER(cd);
+}
+
+static void stress_test(void **state)
+{
+	struct stress_data sd = {signal_handler_create(), false, 0};
+	pthread_t threads[4];
+
+	signal_handler_add_array(sd.handler, signals);
+
+	for (size_t i = 0; i < 4; i++)
+		pthread_create(&threads[i], NULL, stress_emit_thread, &sd);
+
+	for (int i = 0; i < 10000; i++) {
+		signal_handler_connect(sd.handler, "test", atomic_count_callback, &sd.count);
+		signal_handler_disconnect(sd.handler, "test", atomic_count_callback, &sd.count);
+	}
+
+	/* nothing is called once disconnected */
+	long count = os_atomic_load_long(&sd.count);
+	os_sleep_ms(10);
+	assert_int_equal(os_atomic_load_long(&sd.count), count);
+
+	os_atomic_set_bool(&sd.stop, true);
+	for (size_t i = 0; i < 4; i++)
+		pthread_join(threads[i], NULL);
+
+	signal_handler_destroy(sd.handler);
+	UNUSED_PARAMETER(state);
+}
+
+static void benchmark_test(void **state)
+{
+	static const size_t listeners[] = {0, 1, 10};
+	uint8_t stack[128];
+
+	skip_unless_benchmarks_enabled();
+
+	for (size_t l = 0; l < sizeof(listeners) / sizeof(listeners[0]); l++) {
+		signal_handler_t *handler = signal_handler_create();
+		struct calldata cd;
+		uint64_t start;
+
+		signal_handler_add_array(handler, signals);
+		for (size_t i = 0; i < listeners[l]; i++)
+			signal_handler_connect(handler, "test", empty_callback, (void *)(uintptr_t)(i + 1));
+
+		signal_t *signal = signal_handler_get_signal(handler, "test");
+
+		calldata_init_fixed(&cd, stack, sizeof(stack));
+		calldata_set_int(&cd, "value", 1);
+
+		start = os_gettime_ns();
+		for (int i = 0; i < BENCH_EMITS; i++)
+			signal_handler_signal(handler, "test", &cd);
+		double by_name = (double)(os_gettime_ns() - start) / BENCH_EMITS;
+
+		start = os_gettime_ns();
+		for (int i = 0; i < BENCH_EMITS; i++)
+			signal_emit(signal, &cd);
+		double by_handle = (double)(os_gettime_ns() - start) / BENCH_EMITS;
+
+		print_message("signal: %d listeners, %.1f ns per emit by name, %.1f ns per emit by handle\n",
+			      (int)listeners[l], by_name, by_handle);
+
+		signal_handler_destroy(handler);
+	}
+
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(emit_test),
+		cmocka_unit_test(disconnect_in_callback_test),
+		cmocka_unit_test(disconnect_waits_test),
+		cmocka_unit_test(concurrent_disconnect_test),
+		cmocka_unit_test(stress_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
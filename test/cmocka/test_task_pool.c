@@ -0,0 +1,362 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/task.h>
+#include <util/threading.h>
+
+#define QUEUED_TASKS 10000
+
+struct counter {
+	volatile long count;
+	long target;
+	os_event_t *done;
+};
+
+static void count_task(void *param)
+{
+	struct counter *counter = param;
+
+	if (os_atomic_inc_long(&counter->count) == counter->target)
+		os_event_signal(counter->done);
+}
+
+static void queue_test(void **state)
+{
+	os_task_pool_t *pool = os_task_pool_create("test pool", 4);
+	struct counter counter = {0, QUEUED_TASKS, NULL};
+
+	assert_non_null(pool);
+	os_event_init(&counter.done, OS_EVENT_TYPE_MANUAL);
+
+	for (int i = 0; i < QUEUED_TASKS; i++)
+		assert_true(os_task_pool_queue_task(pool, OS_TASK_PRIORITY_NORMAL, count_task, &counter));
+
+	assert_int_equal(os_event_timedwait(counter.done, 5000), 0);
+	assert_int_equal(os_atomic_load_long(&counter.count), QUEUED_TASKS);
+
+	os_event_destroy(counter.done);
+	os_task_pool_destroy(pool);
+	UNUSED_PARAMETER(state);
+}
+
+struct order {
+	pthread_mutex_t mutex;
+	int ids[8];
+	int num;
+};
+
+struct order_task {
+	struct order *order;
+	int id;
+};
+
+static void order_task(void *param)
+{
+	struct order_task *task = param;
+
+	pthread_mutex_lock(&task->order->mutex);
+	task->order->ids[task->order->num++] = task->id;
+	pthread_mutex_unlock(&task->order->mutex);
+}
+
+static void block_task(void *param)
+{
+	os_event_wait(param);
+}
+
+static void priority_test(void **state)
+{
+	os_task_pool_t *pool = os_task_pool_create("test pool", 1);
+	struct order order = {.num = 0};
+	struct order_task low = {&order, OS_TASK_PRIORITY_LOW};
+	struct order_task normal = {&order, OS_TASK_PRIORITY_NORMAL};
+	struct order_task high = {&order, OS_TASK_PRIORITY_HIGH};
+	os_event_t *unblock;
+
+	pthread_mutex_init(&order.mutex, NULL);
+	os_event_init(&unblock, OS_EVENT_TYPE_MANUAL);
+
+	/* keep the only worker busy until everything is queued */
+	os_task_pool_queue_task(pool, OS_TASK_PRIORITY_NORMAL, block_task, unblock);
+	os_sleep_ms(20);
+
+	os_task_pool_queue_task(pool, OS_TASK_PRIORITY_LOW, order_task, &low);
+	os_task_pool_queue_task(pool, OS_TASK_PRIORITY_NORMAL, order_task, &normal);
+	os_task_pool_queue_task(pool, OS_TASK_PRIORITY_HIGH, order_task, &high);
+	os_event_signal(unblock);
+
+	for (int i = 0; i < 100 && order.num < 3; i++)
+		os_sleep_ms(10);
+
+	assert_int_equal(order.num, 3);
+	assert_int_equal(order.ids[0], OS_TASK_PRIORITY_HIGH);
+	assert_int_equal(order.ids[1], OS_TASK_PRIORITY_NORMAL);
+	assert_int_equal(order.ids[2], OS_TASK_PRIORITY_LOW);
+
+	os_task_pool_destroy(pool);
+	os_event_destroy(unblock);
+	pthread_mutex_destroy(&order.mutex);
+	UNUSED_PARAMETER(state);
+}
+
+struct delayed {
+	uint64_t run_time;
+	os_event_t *done;
+};
+
+static void delayed_task(void *param)
+{
+	struct delayed *delayed = param;
+
+	delayed->run_time = os_gettime_ns();
+	os_event_signal(delayed->done);
+}
+
+static void delay_test(void **state)
+{
+	os_task_pool_t *pool = os_task_pool_create("test pool", 1);
+	struct order order = {.num = 0};
+	struct order_task tasks[3] = {{&order, 200}, {&order, 70}, {&order, 130}};
+	os_task_handle_t *handles[3];
+
+	pthread_mutex_init(&order.mutex, NULL);
+
+	/* the delays span the first two levels of the wheel */
+	for (int i = 0; i < 3; i++)
+		handles[i] = os_task_pool_schedule(pool, OS_TASK_PRIORITY_NORMAL, tasks[i].id, 0, order_task, &tasks[i]);
+
+	struct delayed delayed = {0};
+	os_event_init(&delayed.done, OS_EVENT_TYPE_MANUAL);
+
+	uint64_t start = os_gettime_ns();
+	os_task_handle_t *handle = os_task_pool_schedule(pool, OS_TASK_PRIORITY_HIGH, 50, 0, delayed_task, &delayed);
+	assert_non_null(handle);
+	os_task_handle_release(handle);
+
+	assert_int_equal(os_event_timedwait(delayed.done, 5000), 0);
+	assert_true(delayed.run_time - start >= 50000000);
+	assert_true(delayed.run_time - start < 1000000000);
+
+	for (int i = 0; i < 100 && order.num < 3; i++)
+		os_sleep_ms(10);
+
+	assert_int_equal(order.num, 3);
+	assert_int_equal(order.ids[0], 70);
+	assert_int_equal(order.ids[1], 130);
+	assert_int_equal(order.ids[2], 200);
+
+	/* nothing left to prevent */
+	for (int i = 0; i < 3; i++)
+		assert_false(os_task_cancel(handles[i]));
+
+	os_event_destroy(delayed.done);
+	os_task_pool_destroy(pool);
+	pthread_mutex_destroy(&order.mutex);
+	UNUSED_PARAMETER(state);
+}
+
+static void periodic_test(void **state)
+{
+	os_task_pool_t *pool = os_task_pool_create("test pool", 2);
+	struct counter counter = {0, 5, NULL};
+
+	os_event_init(&counter.done, OS_EVENT_TYPE_MANUAL);
+
+	os_task_handle_t *handle = os_task_pool_schedule(pool, OS_TASK_PRIORITY_NORMAL, 10, 10, count_task, &counter);
+	assert_int_equal(os_event_timedwait(counter.done, 5000), 0);
+
+	os_task_cancel(handle);
+	long count = os_atomic_load_long(&counter.count);
+	os_sleep_ms(50);
+	assert_int_equal(os_atomic_load_long(&counter.count), count);
+
+	os_event_destroy(counter.done);
+	os_task_pool_destroy(pool);
+	UNUSED_PARAMETER(state);
+}
+
+struct slow {
+	volatile bool started;
+	volatile bool finished;
+};
+
+static void slow_task(void *param)
+{
+	struct slow *slow = param;
+
+	os_atomic_set_bool(&slow->started, true);
+	os_sleep_ms(50);
+	os_atomic_set_bool(&slow->finished, true);
+}
+
+static void cancel_test(void **state)
+{
+	os_task_pool_t *pool = os_task_pool_create("test pool", 1);
+	struct counter counter = {0, 1, NULL};
+	struct slow slow = {false, false};
+
+	os_event_init(&counter.done, OS_EVENT_TYPE_MANUAL);
+
+	/* pending tasks never run */
+	os_task_handle_t *handle = os_task_pool_schedule(pool, OS_TASK_PRIORITY_NORMAL, 100, 0, count_task, &counter);
+	assert_true(os_task_cancel(handle));
+	os_sleep_ms(200);
+	assert_int_equal(os_atomic_load_long(&counter.count), 0);
+
+	/* canceling a running task waits for it */
+	handle = os_task_pool_schedule(pool, OS_TASK_PRIORITY_NORMAL, 0, 0, slow_task, &slow);
+	while (!os_atomic_load_bool(&slow.started))
+		os_sleep_ms(1);
+	assert_false(os_task_cancel(handle));
+	assert_true(os_atomic_load_bool(&slow.finished));
+
+	/* destroying cancels pending tasks, handles can be released later */
+	handle = os_task_pool_schedule(pool, OS_TASK_PRIORITY_NORMAL, 60000, 0, count_task, &counter);
+	os_task_pool_destroy(pool);
+	os_task_handle_release(handle);
+	assert_int_equal(os_atomic_load_long(&counter.count), 0);
+
+	os_event_destroy(counter.done);
+	UNUSED_PARAMETER(state);
+}
+
+struct work_items {
+	volatile long *runs;
+	volatile long on_caller;
+	pthread_t caller;
+	volatile bool caller_slept;
+	os_work_pool_t *nested;
+};
+
+static void count_work(void *param, size_t idx)
+{
+	struct work_items *items = param;
+
+	os_atomic_inc_long(&items->runs[idx]);
+}
+
+static void work_pool_test(void **state)
+{
+	static const size_t counts[] = {0, 1, 2, 3, 5, 64, 1000, 10007};
+	os_work_pool_t *pool = os_work_pool_create("test work pool", 4);
+
+	assert_non_null(pool);
+	assert_int_equal(os_work_pool_get_thread_count(pool), 4);
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		const size_t count = counts[c];
+		struct work_items items = {0};
+
+		items.runs = bzalloc((count + 1) * sizeof(long));
+
+		/* every index runs exactly once per call, and only inside it */
+		for (int run = 0; run < 20; run++)
+			os_work_pool_run(pool, count, count_work, &items);
+
+		for (size_t i = 0; i < count; i++)
+			assert_int_equal(items.runs[i], 20);
+		assert_int_equal(items.runs[count], 0);
+
+		bfree((void *)items.runs);
+	}
+
+	/* without a pool everything runs on the calling thread */
+	struct work_items items = {0};
+	items.runs = bzalloc(10 * sizeof(long));
+	os_work_pool_run(NULL, 10, count_work, &items);
+	for (size_t i = 0; i < 10; i++)
+		assert_int_equal(items.runs[i], 1);
+	bfree((void *)items.runs);
+
+	os_work_pool_destroy(pool);
+	UNUSED_PARAMETER(state);
+}
+
+static void uneven_work(void *param, size_t idx)
+{
+	struct work_items *items = param;
+
+	if (pthread_equal(pthread_self(), items->caller)) {
+		os_atomic_inc_long(&items->on_caller);
+
+		/* the first item of the caller's share takes long enough that
+		 * the worker has to steal the rest of it */
+		if (!items->caller_slept) {
+			items->caller_slept = true;
+			os_sleep_ms(200);
+		}
+	}
+
+	os_atomic_inc_long(&items->runs[idx]);
+}
+
+static void work_pool_steal_test(void **state)
+{
+	os_work_pool_t *pool = os_work_pool_create("test work pool", 1);
+	struct work_items items = {0};
+	const size_t count = 100;
+
+	items.runs = bzalloc(count * sizeof(long));
+	items.caller = pthread_self();
+
+	os_work_pool_run(pool, count, uneven_work, &items);
+
+	for (size_t i = 0; i < count; i++)
+		assert_int_equal(items.runs[i], 1);
+
+	/* the caller started with half of the range but only got through a
+	 * few items before the worker took the rest */
+	assert_in_range(os_atomic_load_long(&items.on_caller), 1, count / 4);
+
+	bfree((void *)items.runs);
+	os_work_pool_destroy(pool);
+	UNUSED_PARAMETER(state);
+}
+
+static void nested_work(void *param, size_t idx)
+{
+	struct work_items *items = param;
+
+	/* runs inline on the worker instead of deadlocking on the pool */
+	os_work_pool_run(items->nested, 4, count_work, items);
+	UNUSED_PARAMETER(idx);
+}
+
+static void work_pool_nested_test(void **state)
+{
+	os_work_pool_t *pool = os_work_pool_create("test work pool", 2);
+	struct work_items items = {0};
+
+	items.runs = bzalloc(4 * sizeof(long));
+	items.nested = pool;
+
+	os_work_pool_run(pool, 16, nested_work, &items);
+
+	for (size_t i = 0; i < 4; i++)
+		assert_int_equal(items.runs[i], 16);
+
+	bfree((void *)items.runs);
+	os_work_pool_destroy(pool);
+	UNUSED_PARAMETER(state);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(queue_test),
+		cmocka_unit_test(priority_test),
+		cmocka_unit_test(delay_test),
+		cmocka_unit_test(periodic_test),
+		cmocka_unit_test(cancel_test),
+		cmocka_unit_test(work_pool_test),
+		cmocka_unit_test(work_pool_steal_test),
+		cmocka_unit_test(work_pool_nested_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
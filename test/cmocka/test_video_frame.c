@@ -0,0 +1,182 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <media-io/video-frame.h>
+#include <util/platform.h>
+
+#include "benchmark.h"
+
+#define BENCH_ITERATIONS 200
+#define BENCH_WORKING_SET (1024 * 1024)
+
+static void fill_pattern(uint8_t *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		data[i] = (uint8_t)(i * 7 + 3);
+}
+
+static void copy_plane_test(bool non_temporal)
+{
+	static const uint32_t row_sizes[] = {0, 1, 15, 16, 17, 63, 64, 65, 127, 128, 129, 1920, 3840 * 4};
+	const uint32_t rows = 4;
+
+	for (size_t i = 0; i < sizeof(row_sizes) / sizeof(row_sizes[0]); i++) {
+		for (uint32_t offset = 0; offset < 32; offset += 5) {
+			const uint32_t row_size = row_sizes[i];
+			const uint32_t src_linesize = row_size + (offset & 3);
+			const uint32_t dst_linesize = row_size + offset;
+			const size_t src_size = (size_t)src_linesize * rows + 32;
+			const size_t dst_size = (size_t)dst_linesize * rows + 32;
+
+			uint8_t *src = bmalloc(src_size);
+			uint8_t *dst = bzalloc(dst_size);
+			uint8_t *expected = bzalloc(dst_size);
+
+			fill_pattern(src, src_size);
+			for (uint32_t y = 0; y < rows; y++)
+				memcpy(expected + offset + y * dst_linesize, src + 1 + y * src_linesize, row_size);
+
+			const uint8_t *end = video_frame_copy_plane(dst + offset, dst_linesize, src + 1, src_linesize,
+								    row_size, rows, non_temporal);
+
+			assert_ptr_equal(end, src + 1 + (size_t)src_linesize * rows);
+			assert_memory_equal(dst, expected, dst_size);
+
+			bfree(src);
+			bfree(dst);
+			bfree(expected);
+		}
+	}
+}
+
+static void copy_plane_cached_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	copy_plane_test(false);
+}
+
+static void copy_plane_non_temporal_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	copy_plane_test(true);
+}
+
+static void copy_frame_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct video_frame src;
+	struct video_frame dst;
+
+	video_frame_init(&src, VIDEO_FORMAT_I420, 98, 50);
+	video_frame_init(&dst, VIDEO_FORMAT_I420, 98, 50);
+
+	fill_pattern(src.data[0], (size_t)src.linesize[0] * 50);
+	fill_pattern(src.data[1], (size_t)src.linesize[1] * 25);
+	fill_pattern(src.data[2], (size_t)src.linesize[2] * 25);
+
+	video_frame_copy(&dst, &src, VIDEO_FORMAT_I420, 50);
+
+	assert_memory_equal(dst.data[0], src.data[0], (size_t)src.linesize[0] * 50);
+	assert_memory_equal(dst.data[1], src.data[1], (size_t)src.linesize[1] * 25);
+	assert_memory_equal(dst.data[2], src.data[2], (size_t)src.linesize[2] * 25);
+
+	video_frame_free(&src);
+	video_frame_free(&dst);
+}
+
+/* frames are copied as one plane, NV12 and P010 are 1.5 rows per line */
+struct bench_size {
+	const char *name;
+	enum video_format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t row_size;
+	uint32_t rows;
+};
+
+/* reading back the working set after every copy shows how much of it the copy
+ * evicted, which is the other half of what streaming stores are for */
+static uint64_t bench_copy(const struct bench_size *size, bool non_temporal, const uint8_t *working_set,
+			   uint64_t *reload_ns)
+{
+	size_t frame_size = (size_t)size->row_size * size->rows;
+	uint8_t *src = bmalloc(frame_size);
+	uint8_t *dst = bmalloc(frame_size);
+	uint64_t copy = 0;
+	uint64_t reload = 0;
+	volatile uint64_t sum = 0;
+
+	fill_pattern(src, frame_size);
+	memset(dst, 0, frame_size);
+
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		uint64_t start = os_gettime_ns();
+		video_frame_copy_plane(dst, size->row_size, src, size->row_size, size->row_size, size->rows,
+				       non_temporal);
+		uint64_t mid = os_gettime_ns();
+
+		uint64_t total = 0;
+		for (size_t j = 0; j < BENCH_WORKING_SET; j += 64)
+			total += working_set[j];
+		sum += total;
+
+		copy += mid - start;
+		reload += os_gettime_ns() - mid;
+	}
+
+	bfree(src);
+	bfree(dst);
+
+	*reload_ns = reload / BENCH_ITERATIONS;
+	return copy / BENCH_ITERATIONS;
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	skip_unless_benchmarks_enabled();
+
+	static const struct bench_size sizes[] = {
+		{"720p NV12", VIDEO_FORMAT_NV12, 1280, 720, 1280, 1080},
+		{"1080p NV12", VIDEO_FORMAT_NV12, 1920, 1080, 1920, 1620},
+		{"1440p NV12", VIDEO_FORMAT_NV12, 2560, 1440, 2560, 2160},
+		{"1080p RGBA", VIDEO_FORMAT_RGBA, 1920, 1080, 1920 * 4, 1080},
+		{"4K NV12", VIDEO_FORMAT_NV12, 3840, 2160, 3840, 3240},
+		{"4K P010", VIDEO_FORMAT_P010, 3840, 2160, 3840 * 2, 3240},
+		{"4K RGBA", VIDEO_FORMAT_RGBA, 3840, 2160, 3840 * 4, 2160},
+	};
+
+	uint8_t *working_set = bmalloc(BENCH_WORKING_SET);
+	fill_pattern(working_set, BENCH_WORKING_SET);
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		uint64_t cached_reload, stream_reload;
+		uint64_t cached = bench_copy(&sizes[i], false, working_set, &cached_reload);
+		uint64_t stream = bench_copy(&sizes[i], true, working_set, &stream_reload);
+		bool selected = video_frame_use_non_temporal_copy(sizes[i].format, sizes[i].width, sizes[i].height);
+
+		print_message("%s: memcpy %.3f ms + %.1f us reload, streaming %.3f ms + %.1f us reload%s\n",
+			      sizes[i].name, (double)cached / 1e6, (double)cached_reload / 1e3, (double)stream / 1e6,
+			      (double)stream_reload / 1e3, selected ? " (selected)" : "");
+	}
+
+	bfree(working_set);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(copy_plane_cached_test),
+		cmocka_unit_test(copy_plane_non_temporal_test),
+		cmocka_unit_test(copy_frame_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
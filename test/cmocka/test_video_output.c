@@ -0,0 +1,241 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <media-io/video-io.h>
+#include <media-io/video-frame.h>
+
+#define WIDTH 64
+#define HEIGHT 4
+#define CACHE_SIZE 4
+
+struct consumer {
+	os_event_t *received;
+	os_event_t *resume;
+	const uint8_t *data;
+	uint32_t linesize;
+	uint8_t first;
+};
+
+struct external {
+	uint8_t data[WIDTH * 4 * HEIGHT];
+	volatile long releases;
+	os_event_t *released;
+};
+
+static void receive_frame(void *param, struct video_data *frame)
+{
+	struct consumer *consumer = param;
+
+	consumer->data = frame->data[0];
+	consumer->linesize = frame->linesize[0];
+	consumer->first = frame->data[0][0];
+	os_event_signal(consumer->received);
+
+	if (consumer->resume)
+		os_event_wait(consumer->resume);
+}
+
+static void release_external(void *param)
+{
+	struct external *external = param;
+
+	os_atomic_inc_long(&external->releases);
+	os_event_signal(external->released);
+}
+
+static video_t *open_output(void)
+{
+	struct video_output_info info = {
+		.name = "test video output",
+		.format = VIDEO_FORMAT_RGBA,
+		.fps_num = 30,
+		.fps_den = 1,
+		.width = WIDTH,
+		.height = HEIGHT,
+		.cache_size = CACHE_SIZE,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+	};
+	video_t *video = NULL;
+
+	assert_int_equal(video_output_open(&video, &info), VIDEO_OUTPUT_SUCCESS);
+	return video;
+}
+
+static void init_external(struct external *external, uint8_t value)
+{
+	memset(external->data, value, sizeof(external->data));
+	external->releases = 0;
+	assert_int_equal(os_event_init(&external->released, OS_EVENT_TYPE_MANUAL), 0);
+}
+
+static void external_frame(struct external *external, struct video_data *frame, uint64_t timestamp)
+{
+	memset(frame, 0, sizeof(*frame));
+	frame->data[0] = external->data;
+	frame->linesize[0] = WIDTH * 4;
+	frame->timestamp = timestamp;
+}
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+	return obs_startup("en-US", NULL, NULL) ? 0 : -1;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+	obs_shutdown();
+	return 0;
+}
+
+/* the consumer gets the caller's buffer itself, and the release callback runs
+ * once it is done with it */
+static void external_frame_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct consumer consumer = {0};
+	struct external external;
+	struct video_data frame;
+	video_t *video = open_output();
+
+	assert_int_equal(os_event_init(&consumer.received, OS_EVENT_TYPE_AUTO), 0);
+	assert_true(video_output_connect(video, NULL, receive_frame, &consumer));
+
+	init_external(&external, 0x5A);
+	external_frame(&external, &frame, 1000);
+
+	assert_true(video_output_queue_external_frame(video, &frame, 1, release_external, &external));
+	assert_int_equal(os_event_timedwait(external.released, 5000), 0);
+
+	assert_ptr_equal(consumer.data, external.data);
+	assert_int_equal(consumer.linesize, WIDTH * 4);
+	assert_int_equal(consumer.first, 0x5A);
+	assert_int_equal(os_atomic_load_long(&external.releases), 1);
+
+	video_output_disconnect(video, receive_frame, &consumer);
+	video_output_close(video);
+
+	assert_int_equal(os_atomic_load_long(&external.releases), 1);
+
+	os_event_destroy(external.released);
+	os_event_destroy(consumer.received);
+}
+
+/* while the video thread is busy, external frames are refused so the caller
+ * falls back to copying into the cache, and the shared buffer is only
+ * released after the consumer returns */
+static void busy_output_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct consumer consumer = {0};
+	struct external first;
+	struct external second;
+	struct video_data frame;
+	struct video_frame locked;
+	video_t *video = open_output();
+
+	assert_int_equal(os_event_init(&consumer.received, OS_EVENT_TYPE_AUTO), 0);
+	assert_int_equal(os_event_init(&consumer.resume, OS_EVENT_TYPE_MANUAL), 0);
+	assert_true(video_output_connect(video, NULL, receive_frame, &consumer));
+
+	init_external(&first, 1);
+	init_external(&second, 2);
+
+	external_frame(&first, &frame, 1000);
+	assert_true(video_output_queue_external_frame(video, &frame, 1, release_external, &first));
+	assert_int_equal(os_event_timedwait(consumer.received, 5000), 0);
+	assert_ptr_equal(consumer.data, first.data);
+
+	external_frame(&second, &frame, 2000);
+	assert_false(video_output_queue_external_frame(video, &frame, 1, release_external, &second));
+	assert_int_equal(os_atomic_load_long(&first.releases), 0);
+
+	assert_true(video_output_lock_frame(video, &locked, 1, 2000));
+	memset(locked.data[0], 3, (size_t)locked.linesize[0] * HEIGHT);
+	video_output_unlock_frame(video);
+
+	os_event_signal(consumer.resume);
+
+	assert_int_equal(os_event_timedwait(first.released, 5000), 0);
+	assert_int_equal(os_event_timedwait(consumer.received, 5000), 0);
+	assert_true(consumer.data != first.data);
+	assert_int_equal(consumer.first, 3);
+
+	video_output_disconnect(video, receive_frame, &consumer);
+	video_output_close(video);
+
+	assert_int_equal(os_atomic_load_long(&first.releases), 1);
+	assert_int_equal(os_atomic_load_long(&second.releases), 0);
+
+	os_event_destroy(first.released);
+	os_event_destroy(second.released);
+	os_event_destroy(consumer.resume);
+	os_event_destroy(consumer.received);
+}
+
+/* stopping the output right after queueing must still release the frame
+ * exactly once, whether or not the video thread got to it */
+static void stop_releases_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < 100; i++) {
+		struct external external;
+		struct video_data frame;
+		video_t *video = open_output();
+
+		init_external(&external, (uint8_t)i);
+		external_frame(&external, &frame, 1000);
+
+		assert_true(video_output_queue_external_frame(video, &frame, 1, release_external, &external));
+		video_output_close(video);
+
+		assert_int_equal(os_atomic_load_long(&external.releases), 1);
+		os_event_destroy(external.released);
+	}
+}
+
+static void invalid_params_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct external external;
+	struct video_data frame;
+	video_t *video = open_output();
+
+	init_external(&external, 0);
+	external_frame(&external, &frame, 1000);
+
+	assert_false(video_output_queue_external_frame(NULL, &frame, 1, release_external, &external));
+	assert_false(video_output_queue_external_frame(video, NULL, 1, release_external, &external));
+	assert_false(video_output_queue_external_frame(video, &frame, 1, NULL, &external));
+
+	video_output_stop(video);
+	assert_false(video_output_queue_external_frame(video, &frame, 1, release_external, &external));
+	video_output_close(video);
+
+	assert_int_equal(os_atomic_load_long(&external.releases), 0);
+	os_event_destroy(external.released);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(external_frame_test),
+		cmocka_unit_test(busy_output_test),
+		cmocka_unit_test(stop_releases_test),
+		cmocka_unit_test(invalid_params_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}